@@ -71,3 +71,50 @@ function(quic_add_test)
 
   set_tests_properties(${QUIC_TEST_CASES} PROPERTIES TIMEOUT 120)
 endfunction()
+
+# Benchmarks are built alongside the tests but are not registered with ctest,
+# they are meant to be run manually.
+function(quic_add_benchmark)
+  if(NOT BUILD_TESTS)
+    return()
+  endif()
+
+  set(options)
+  set(one_value_args TARGET)
+  set(multi_value_args SOURCES DEPENDS INCLUDES)
+  cmake_parse_arguments(PARSE_ARGV 0 QUIC_BENCH "${options}" "${one_value_args}" "${multi_value_args}")
+
+  if(NOT QUIC_BENCH_TARGET)
+    message(FATAL_ERROR "The TARGET parameter is mandatory.")
+  endif()
+
+  if(NOT QUIC_BENCH_SOURCES)
+    set(QUIC_BENCH_SOURCES "${QUIC_BENCH_TARGET}.cpp")
+  endif()
+
+  add_executable(${QUIC_BENCH_TARGET} "${QUIC_BENCH_SOURCES}")
+
+  target_include_directories(${QUIC_BENCH_TARGET} PUBLIC
+    "${QUIC_BENCH_INCLUDES}"
+    ${LIBGMOCK_INCLUDE_DIR}
+    ${LIBGTEST_INCLUDE_DIRS}
+    ${QUIC_EXTRA_INCLUDE_DIRECTORIES}
+  )
+
+  target_compile_definitions(${QUIC_BENCH_TARGET} PUBLIC
+    ${LIBGMOCK_DEFINES}
+  )
+
+  target_link_libraries(${QUIC_BENCH_TARGET} PUBLIC
+    "${QUIC_BENCH_DEPENDS}"
+    Folly::follybenchmark
+    ${LIBGMOCK_LIBRARIES}
+    ${GLOG_LIBRARY}
+  )
+
+  target_compile_options(
+    ${QUIC_BENCH_TARGET} PRIVATE
+    ${_QUIC_BASE_COMPILE_OPTIONS}
+    "-Wno-sign-compare"
+  )
+endfunction()
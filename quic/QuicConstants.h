@@ -83,6 +83,10 @@ constexpr uint32_t kRetryIntegrityTagLen = 16;
 constexpr uint64_t kDefaultBufferSpaceAvailable =
     std::numeric_limits<uint64_t>::max();
 
+// Max number of acked retransmission buffer nodes a connection keeps around for
+// the stream frames it writes next.
+constexpr size_t kMaxPooledStreamBuffers = 64;
+
 // The default min rtt to use for a new connection
 constexpr std::chrono::microseconds kDefaultMinRtt =
     std::chrono::microseconds::max();
@@ -122,6 +126,12 @@ enum class FrameType : uint64_t {
   // CONNECTION_CLOSE_APP_ERR frametype is use to indicate application errors
   CONNECTION_CLOSE_APP_ERR = 0x1D,
   HANDSHAKE_DONE = 0x1E,
+  // DATAGRAM frame without and with an explicit length (RFC 9221).
+  DATAGRAM = 0x30,
+  DATAGRAM_LEN = 0x31,
+  // Ack frequency extension (draft-ietf-quic-ack-frequency).
+  IMMEDIATE_ACK = 0xAC,
+  ACK_FREQUENCY = 0xAF,
   MIN_STREAM_DATA = 0xFE, // subject to change
   EXPIRED_STREAM_DATA = 0xFF, // subject to change
   KNOB = 0x1550,
@@ -202,6 +212,8 @@ enum class LocalErrorCode : uint32_t {
   CONNECTION_ABANDONED = 0x40000019,
   CALLBACK_ALREADY_INSTALLED = 0x4000001A,
   KNOB_FRAME_UNSUPPORTED = 0x4000001B,
+  DATAGRAM_UNSUPPORTED = 0x4000001C,
+  DATAGRAM_BUFFER_FULL = 0x4000001D,
 };
 
 enum class QuicNodeType : bool {
@@ -209,6 +221,17 @@ enum class QuicNodeType : bool {
   Server,
 };
 
+// ECN codepoints, carried in the two low bits of the IP TOS / IPv6 traffic
+// class field.
+enum class ECNCodepoint : uint8_t {
+  NotECT = 0x00,
+  ECT1 = 0x01,
+  ECT0 = 0x02,
+  CE = 0x03,
+};
+
+constexpr uint8_t kECNMask = 0x03;
+
 enum class QuicVersion : uint32_t {
   VERSION_NEGOTIATION = 0x00000000,
   MVFST_D24 = 0xfaceb001,
@@ -284,6 +307,18 @@ constexpr uint64_t kDefaultMinBurstPackets = 5;
 // but the notifications can get delayed if the event loop is busy
 // this is subject to testing but I would suggest a value >= 200usec
 constexpr std::chrono::microseconds kDefaultPacingTimerTickInterval{1000};
+// How far ahead of their departure time packets are handed to the kernel when
+// the fq qdisc paces them with SO_TXTIME.
+constexpr std::chrono::microseconds kDefaultTxTimeHorizon{4000};
+
+// Writes smaller than this are copied even with zerocopy sends enabled, the
+// page pinning and the completion cost more than the copy.
+constexpr size_t kMinZeroCopyWriteSize = 16 * 1024;
+// Maximum number of zerocopy writes on a socket waiting for their completion.
+// Writes beyond that are copied.
+constexpr size_t kMaxZeroCopyPinnedWrites = 256;
+// Maximum number of completed zerocopy write buffers kept for reuse.
+constexpr size_t kMaxZeroCopyFreeBuffers = 16;
 // Fraction of RTT that is used to limit how long a write function can loop
 constexpr DurationRep kDefaultWriteLimitRttFraction = 25;
 
@@ -356,6 +391,9 @@ constexpr float kCubicTCPFriendlyEstimateIncreaseFactor =
 // Default flow control window for HTTP/2 + 1K for headers
 constexpr uint64_t kDefaultStreamWindowSize = (64 + 1) * 1024;
 constexpr uint64_t kDefaultConnectionWindowSize = 1024 * 1024;
+// Caps of the windows when they are autotuned.
+constexpr uint64_t kDefaultMaxAutotuneStreamWindowSize = 16 * 1024 * 1024;
+constexpr uint64_t kDefaultMaxAutotuneConnectionWindowSize = 24 * 1024 * 1024;
 
 /* Stream Limits */
 constexpr uint64_t kDefaultMaxStreamsBidirectional = 2048;
@@ -363,6 +401,12 @@ constexpr uint64_t kDefaultMaxStreamsUnidirectional = 2048;
 constexpr uint64_t kMaxStreamId = 1ull << 62;
 constexpr uint64_t kMaxMaxStreams = 1ull << 60;
 
+/* Stream Priorities */
+// Urgency levels go from 0 (most urgent) to kDefaultMaxPriority, as in the
+// HTTP extensible priorities scheme.
+constexpr uint8_t kDefaultMaxPriority = 7;
+constexpr uint8_t kDefaultPriorityLevels = kDefaultMaxPriority + 1;
+
 /* Idle timeout parameters */
 // Default idle timeout to advertise.
 constexpr auto kDefaultIdleTimeout = 60000ms;
@@ -393,6 +437,9 @@ constexpr uint16_t kDefaultRxPacketsBeforeAckAfterInit = 10;
 constexpr double kAckTimerFactor = 0.25;
 // max ack timeout: 25ms
 constexpr std::chrono::microseconds kMaxAckTimeout = 25000us;
+// Largest packet tolerance we honor in a peer's ACK_FREQUENCY frame. Acking
+// less often than this buys little and delays loss detection on the peer.
+constexpr uint64_t kMaxAckFrequencyPacketTolerance = 1000;
 
 constexpr uint64_t kAckPurgingThresh = 10;
 
@@ -450,8 +497,34 @@ constexpr auto kExpectedNumOfParamsInTheTicket = 8;
 
 constexpr auto kStatelessResetTokenSecretLength = 32;
 
+constexpr auto kTokenSecretLength = 32;
+
+// How long a token sent in a Retry packet is accepted for.
+constexpr std::chrono::milliseconds kRetryTokenValidity = 10s;
+
+// How long a token sent in a NEW_TOKEN frame is accepted for.
+constexpr std::chrono::milliseconds kNewTokenValidity = 24h;
+
 constexpr uint64_t kDefaultActiveConnectionIdLimit = 2;
 
+// Largest DATAGRAM frame we advertise support for. Datagrams have to fit in a
+// single packet, so anything larger than a UDP payload is pointless.
+constexpr uint64_t kMaxDatagramFrameSize = 65535;
+
+// Number of datagrams buffered in each direction before the oldest incoming
+// ones are dropped or new outgoing ones are refused.
+constexpr uint32_t kDefaultMaxDatagramsBuffered = 75;
+
+// Worst case bytes of a DATAGRAM frame that are not payload: the frame type
+// and the length.
+constexpr uint16_t kMaxDatagramFrameOverhead = 1 + 4;
+
+// Worst case bytes of a 1-RTT packet that are not datagram payload: short
+// header with the longest connection id and packet number, the AEAD tag, and
+// the DATAGRAM frame type and length.
+constexpr uint16_t kMaxDatagramPacketOverhead =
+    1 + 20 + 4 + 16 + kMaxDatagramFrameOverhead;
+
 // default capability of QUIC partial reliability
 constexpr TransportPartialReliabilitySetting kDefaultPartialReliability = false;
 
@@ -503,6 +576,7 @@ enum class WriteDataReason {
   RESET,
   PATHCHALLENGE,
   PING,
+  DATAGRAM,
 };
 
 enum class NoWriteReason {
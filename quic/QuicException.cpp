@@ -120,6 +120,10 @@ folly::StringPiece toString(LocalErrorCode code) {
       return "Connection abandoned";
     case LocalErrorCode::KNOB_FRAME_UNSUPPORTED:
       return "Knob Frame Not Supported";
+    case LocalErrorCode::DATAGRAM_UNSUPPORTED:
+      return "Datagram Not Supported";
+    case LocalErrorCode::DATAGRAM_BUFFER_FULL:
+      return "Datagram Buffer Full";
   }
   LOG(WARNING) << "toString has unhandled ErrorCode";
   return "Unknown error";
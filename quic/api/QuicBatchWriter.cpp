@@ -8,12 +8,20 @@
 
 #include <quic/api/QuicBatchWriter.h>
 
+#include <quic/common/SocketUtil.h>
+#include <quic/state/QuicPacingFunctions.h>
+#include <quic/state/QuicStateFunctions.h>
+
 #if !FOLLY_MOBILE
 #define USE_THREAD_LOCAL_BATCH_WRITER 1
 #else
 #define USE_THREAD_LOCAL_BATCH_WRITER 0
 #endif
 
+#if defined(__linux__) && !defined(UDP_SEGMENT)
+#define UDP_SEGMENT 103
+#endif
+
 namespace {
 // There is a known problem in the CloningScheduler that it may write a packet
 // that's a few bytes larger than the original packet. If the original packet is
@@ -137,6 +145,109 @@ class ThreadLocalBatchWriterCache : public folly::AsyncTimeout {
 } // namespace
 
 namespace quic {
+
+namespace {
+
+// The socket marks every datagram it sends, which the connection has to stop
+// once the path failed ECN validation, RFC 9000 section 13.4.2.
+bool shouldClearEcnMarking(const QuicConnectionStateBase& conn) {
+  return conn.transportSettings.ecnMarking != ECNCodepoint::NotECT &&
+      conn.ecnState.validationFailed;
+}
+
+#ifdef UDP_SEGMENT
+// Sends each buffer chain as a message of its own, as a GSO train when its gso
+// size is set. Messages carry their departure time when departures is set,
+// and a cmsg overriding the ECN marking of the socket when clearEcn is set.
+int sendMessagesWithCmsgs(
+    folly::AsyncUDPSocket& sock,
+    const folly::SocketAddress& address,
+    const std::vector<std::unique_ptr<folly::IOBuf>>& bufs,
+    const std::vector<int>& gso,
+    const std::vector<TimePoint>* departures,
+    bool clearEcn) {
+  struct sockaddr_storage addrStorage;
+  socklen_t addrLen = address.getAddress(&addrStorage);
+  // IPv4 destinations, v4-mapped ones on a dual stack socket included, are
+  // sent by the IPv4 stack which only looks at IP_TOS.
+  bool ipv4 = address.getFamily() == AF_INET ||
+      address.getIPAddress().isIPv4Mapped();
+
+  folly::fbvector<struct iovec> iovs;
+  std::vector<size_t> iovStart;
+  iovStart.reserve(bufs.size() + 1);
+  for (const auto& buf : bufs) {
+    iovStart.push_back(iovs.size());
+    buf->appendToIov(&iovs);
+  }
+  iovStart.push_back(iovs.size());
+
+  union ControlBuffer {
+    struct cmsghdr hdr;
+    char buf[kSendCmsgSpace];
+  };
+  std::vector<ControlBuffer> control(bufs.size());
+  std::vector<struct mmsghdr> msgs(bufs.size());
+  for (size_t i = 0; i < bufs.size(); i++) {
+    auto& msg = msgs[i].msg_hdr;
+    memset(&msgs[i], 0, sizeof(msgs[i]));
+    msg.msg_name = &addrStorage;
+    msg.msg_namelen = addrLen;
+    msg.msg_iov = iovs.data() + iovStart[i];
+    msg.msg_iovlen = iovStart[i + 1] - iovStart[i];
+    memset(control[i].buf, 0, sizeof(control[i].buf));
+    msg.msg_control = control[i].buf;
+    msg.msg_controllen = sizeof(control[i].buf);
+
+    struct cmsghdr* cmsg = nullptr;
+    size_t controlLen = 0;
+    auto nextCmsg = [&]() {
+      cmsg = cmsg ? CMSG_NXTHDR(&msg, cmsg) : CMSG_FIRSTHDR(&msg);
+    };
+#ifdef SCM_TXTIME
+    if (departures) {
+      nextCmsg();
+      uint64_t txTime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            (*departures)[i].time_since_epoch())
+                            .count();
+      cmsg->cmsg_level = SOL_SOCKET;
+      cmsg->cmsg_type = SCM_TXTIME;
+      cmsg->cmsg_len = CMSG_LEN(sizeof(txTime));
+      memcpy(CMSG_DATA(cmsg), &txTime, sizeof(txTime));
+      controlLen += CMSG_SPACE(sizeof(txTime));
+    }
+#else
+    DCHECK(!departures);
+#endif
+    if (gso[i] > 0) {
+      nextCmsg();
+      uint16_t gsoSize = gso[i];
+      cmsg->cmsg_level = SOL_UDP;
+      cmsg->cmsg_type = UDP_SEGMENT;
+      cmsg->cmsg_len = CMSG_LEN(sizeof(gsoSize));
+      memcpy(CMSG_DATA(cmsg), &gsoSize, sizeof(gsoSize));
+      controlLen += CMSG_SPACE(sizeof(gsoSize));
+    }
+    if (clearEcn) {
+      nextCmsg();
+      int tos = static_cast<int>(ECNCodepoint::NotECT);
+      cmsg->cmsg_level = ipv4 ? IPPROTO_IP : IPPROTO_IPV6;
+      cmsg->cmsg_type = ipv4 ? IP_TOS : IPV6_TCLASS;
+      cmsg->cmsg_len = CMSG_LEN(sizeof(tos));
+      memcpy(CMSG_DATA(cmsg), &tos, sizeof(tos));
+      controlLen += CMSG_SPACE(sizeof(tos));
+    }
+    msg.msg_control = controlLen ? control[i].buf : nullptr;
+    msg.msg_controllen = controlLen;
+  }
+
+  return folly::netops::sendmmsg(
+      sock.getNetworkSocket(), msgs.data(), msgs.size(), 0);
+}
+#endif
+
+} // namespace
+
 // BatchWriter
 bool BatchWriter::needsFlush(size_t /*unused*/) {
   return false;
@@ -165,8 +276,10 @@ ssize_t SinglePacketBatchWriter::write(
 }
 
 // GSOPacketBatchWriter
-GSOPacketBatchWriter::GSOPacketBatchWriter(size_t maxBufs)
-    : maxBufs_(maxBufs) {}
+GSOPacketBatchWriter::GSOPacketBatchWriter(
+    size_t maxBufs,
+    ZeroCopySendTracker* zeroCopySendTracker)
+    : maxBufs_(maxBufs), zeroCopySendTracker_(zeroCopySendTracker) {}
 
 void GSOPacketBatchWriter::reset() {
   buf_.reset(nullptr);
@@ -218,6 +331,13 @@ bool GSOPacketBatchWriter::append(
 ssize_t GSOPacketBatchWriter::write(
     folly::AsyncUDPSocket& sock,
     const folly::SocketAddress& address) {
+  if (zeroCopySendTracker_ && zeroCopySendTracker_->canWrite(sock)) {
+    return zeroCopySendTracker_->write(
+        sock,
+        address,
+        std::move(buf_),
+        (currBufs_ > 1) ? static_cast<int>(prevSize_) : 0);
+  }
   return (currBufs_ > 1)
       ? sock.writeGSO(address, buf_, static_cast<int>(prevSize_))
       : sock.write(address, buf_);
@@ -294,6 +414,27 @@ ssize_t GSOInplacePacketBatchWriter::write(
     LOG(ERROR) << "Remaining buffer contents larger than udpSendPacketLen by "
                << (diffToEnd - conn_.udpSendPacketLen);
   }
+  auto zeroCopySendTracker = conn_.transportSettings.zeroCopyGSOWrites
+      ? conn_.zeroCopySendTracker
+      : nullptr;
+  if (zeroCopySendTracker && zeroCopySendTracker->canWrite(sock)) {
+    // The kernel reads the buffer after the write returns, so the accessor
+    // gets a new one holding the packet left out of this batch, if any.
+    auto nextBuf = zeroCopySendTracker->getBuffer(buf->capacity());
+    if (diffToEnd) {
+      memcpy(nextBuf->writableData(), lastPacketEnd_, diffToEnd);
+      nextBuf->append(diffToEnd);
+    }
+    buf->trimEnd(diffToEnd);
+    auto bytesWritten = zeroCopySendTracker->write(
+        sock,
+        address,
+        std::move(buf),
+        (numPackets_ > 1) ? static_cast<int>(prevSize_) : 0);
+    buf = std::move(nextBuf);
+    reset();
+    return bytesWritten;
+  }
   uint64_t diffToStart = lastPacketEnd_ - buf->data();
   buf->trimEnd(diffToEnd);
   auto bytesWritten = (numPackets_ > 1)
@@ -504,6 +645,177 @@ ssize_t SendmmsgGSOPacketBatchWriter::write(
   return 0;
 }
 
+// TxTimePacketBatchWriter
+TxTimePacketBatchWriter::TxTimePacketBatchWriter(
+    QuicConnectionStateBase& conn,
+    size_t maxBufs,
+    bool useGSO)
+    : conn_(conn), maxBufs_(maxBufs), useGSO_(useGSO) {
+  bufs_.reserve(maxBufs);
+}
+
+bool TxTimePacketBatchWriter::empty() const {
+  return !currSize_;
+}
+
+size_t TxTimePacketBatchWriter::size() const {
+  return currSize_;
+}
+
+void TxTimePacketBatchWriter::reset() {
+  bufs_.clear();
+  gso_.clear();
+  prevSize_.clear();
+  departures_.clear();
+
+  currBufs_ = 0;
+  currSize_ = 0;
+}
+
+bool TxTimePacketBatchWriter::append(
+    std::unique_ptr<folly::IOBuf>&& buf,
+    size_t size,
+    const folly::SocketAddress& /*unused*/,
+    folly::AsyncUDPSocket* /*unused*/) {
+  currSize_ += size;
+  currBufs_++;
+
+  bool newBurst = burstPackets_ == 0;
+  if (newBurst) {
+    burstDeparture_ = allocateTxTimeDeparture(conn_, Clock::now());
+  }
+  burstPackets_ = (burstPackets_ + 1) %
+      std::max<uint64_t>(conn_.pacer->getPacingRate().burstSize, 1);
+
+  // the packets of a burst share a departure time, so they can be appended to
+  // the same GSO train as long as none is larger than the one before
+  if (!newBurst && useGSO_ && !bufs_.empty() && size <= prevSize_.back() &&
+      (gso_.back() == 0 ||
+       static_cast<size_t>(gso_.back()) == prevSize_.back())) {
+    gso_.back() = prevSize_.back();
+    prevSize_.back() = size;
+    bufs_.back()->prependChain(std::move(buf));
+    return (currBufs_ == maxBufs_);
+  }
+
+  bufs_.emplace_back(std::move(buf));
+  gso_.emplace_back(0);
+  prevSize_.emplace_back(size);
+  departures_.emplace_back(burstDeparture_);
+
+  // flush if we reach maxBufs_
+  return (currBufs_ == maxBufs_);
+}
+
+ssize_t TxTimePacketBatchWriter::write(
+    folly::AsyncUDPSocket& sock,
+    const folly::SocketAddress& address) {
+  CHECK_GT(bufs_.size(), 0);
+#if defined(SCM_TXTIME) && defined(UDP_SEGMENT)
+  int ret = sendMessagesWithCmsgs(
+      sock, address, bufs_, gso_, &departures_, shouldClearEcnMarking(conn_));
+#else
+  // applyTxTimeSocketOption fails on platforms without SO_TXTIME, so this
+  // writer isn't used there.
+  int ret = sock.writemGSO(
+      folly::range(&address, &address + 1),
+      bufs_.data(),
+      bufs_.size(),
+      gso_.data());
+#endif
+
+  if (ret <= 0) {
+    return ret;
+  }
+
+  if (static_cast<size_t>(ret) == bufs_.size()) {
+    return currSize_;
+  }
+
+  // this is a partial write - we just need to
+  // return a different number than currSize_
+  return 0;
+}
+
+// UnmarkedPacketBatchWriter
+UnmarkedPacketBatchWriter::UnmarkedPacketBatchWriter(
+    size_t maxBufs,
+    bool useGSO)
+    : maxBufs_(maxBufs), useGSO_(useGSO) {
+  bufs_.reserve(maxBufs);
+}
+
+bool UnmarkedPacketBatchWriter::empty() const {
+  return !currSize_;
+}
+
+size_t UnmarkedPacketBatchWriter::size() const {
+  return currSize_;
+}
+
+void UnmarkedPacketBatchWriter::reset() {
+  bufs_.clear();
+  gso_.clear();
+  prevSize_.clear();
+
+  currBufs_ = 0;
+  currSize_ = 0;
+}
+
+bool UnmarkedPacketBatchWriter::append(
+    std::unique_ptr<folly::IOBuf>&& buf,
+    size_t size,
+    const folly::SocketAddress& /*unused*/,
+    folly::AsyncUDPSocket* /*unused*/) {
+  currSize_ += size;
+  currBufs_++;
+
+  // same GSO train rules as TxTimePacketBatchWriter, minus the bursts
+  if (useGSO_ && !bufs_.empty() && size <= prevSize_.back() &&
+      (gso_.back() == 0 ||
+       static_cast<size_t>(gso_.back()) == prevSize_.back())) {
+    gso_.back() = prevSize_.back();
+    prevSize_.back() = size;
+    bufs_.back()->prependChain(std::move(buf));
+    return (currBufs_ == maxBufs_);
+  }
+
+  bufs_.emplace_back(std::move(buf));
+  gso_.emplace_back(0);
+  prevSize_.emplace_back(size);
+
+  // flush if we reach maxBufs_
+  return (currBufs_ == maxBufs_);
+}
+
+ssize_t UnmarkedPacketBatchWriter::write(
+    folly::AsyncUDPSocket& sock,
+    const folly::SocketAddress& address) {
+  CHECK_GT(bufs_.size(), 0);
+#ifdef UDP_SEGMENT
+  int ret = sendMessagesWithCmsgs(sock, address, bufs_, gso_, nullptr, true);
+#else
+  // Without per-message cmsgs the packets keep the socket's marking.
+  int ret = sock.writemGSO(
+      folly::range(&address, &address + 1),
+      bufs_.data(),
+      bufs_.size(),
+      gso_.data());
+#endif
+
+  if (ret <= 0) {
+    return ret;
+  }
+
+  if (static_cast<size_t>(ret) == bufs_.size()) {
+    return currSize_;
+  }
+
+  // this is a partial write - we just need to
+  // return a different number than currSize_
+  return 0;
+}
+
 // BatchWriterDeleter
 void BatchWriterDeleter::operator()(BatchWriter* batchWriter) {
 #if USE_THREAD_LOCAL_BATCH_WRITER
@@ -523,8 +835,10 @@ BatchWriterPtr BatchWriterFactory::makeBatchWriter(
     const std::chrono::microseconds& threadLocalDelay,
     DataPathType dataPathType,
     QuicConnectionStateBase& conn) {
+  bool txTimePaced = isTxTimePaced(conn);
+  bool clearEcn = shouldClearEcnMarking(conn);
 #if USE_THREAD_LOCAL_BATCH_WRITER
-  if (useThreadLocal &&
+  if (useThreadLocal && !txTimePaced && !clearEcn &&
       (batchingMode == quic::QuicBatchingMode::BATCHING_MODE_SENDMMSG_GSO) &&
       sock.getGSO() >= 0) {
     BatchWriterPtr ret(
@@ -541,13 +855,32 @@ BatchWriterPtr BatchWriterFactory::makeBatchWriter(
   (void)useThreadLocal;
 #endif
 
+  if (txTimePaced) {
+    return BatchWriterPtr(new TxTimePacketBatchWriter(
+        conn,
+        batchSize,
+        batchingMode != quic::QuicBatchingMode::BATCHING_MODE_NONE &&
+            sock.getGSO() >= 0));
+  }
+
+  if (clearEcn) {
+    return BatchWriterPtr(new UnmarkedPacketBatchWriter(
+        batchSize,
+        batchingMode != quic::QuicBatchingMode::BATCHING_MODE_NONE &&
+            sock.getGSO() >= 0));
+  }
+
   switch (batchingMode) {
     case quic::QuicBatchingMode::BATCHING_MODE_NONE:
       return BatchWriterPtr(new SinglePacketBatchWriter());
     case quic::QuicBatchingMode::BATCHING_MODE_GSO: {
       if (sock.getGSO() >= 0) {
         if (dataPathType == DataPathType::ChainedMemory) {
-          return BatchWriterPtr(new GSOPacketBatchWriter(batchSize));
+          return BatchWriterPtr(new GSOPacketBatchWriter(
+              batchSize,
+              conn.transportSettings.zeroCopyGSOWrites
+                  ? conn.zeroCopySendTracker
+                  : nullptr));
         }
         return BatchWriterPtr(new GSOInplacePacketBatchWriter(conn, batchSize));
       }
@@ -106,7 +106,9 @@ class SinglePacketBatchWriter : public IOBufBatchWriter {
 
 class GSOPacketBatchWriter : public IOBufBatchWriter {
  public:
-  explicit GSOPacketBatchWriter(size_t maxBufs);
+  explicit GSOPacketBatchWriter(
+      size_t maxBufs,
+      ZeroCopySendTracker* zeroCopySendTracker = nullptr);
   ~GSOPacketBatchWriter() override = default;
 
   void reset() override;
@@ -127,6 +129,8 @@ class GSOPacketBatchWriter : public IOBufBatchWriter {
   size_t currBufs_{0};
   // size of the previous buffer chain appended to the buf_
   size_t prevSize_{0};
+  // sends the batch with MSG_ZEROCOPY if set
+  ZeroCopySendTracker* zeroCopySendTracker_{nullptr};
 };
 
 class GSOInplacePacketBatchWriter : public BatchWriter {
@@ -245,6 +249,93 @@ class SendmmsgGSOPacketBatchWriter : public BatchWriter {
   folly::F14FastMap<folly::SocketAddress, Index> addrMap_;
 };
 
+/**
+ * Writer for connections the kernel paces with SO_TXTIME. Every pacing burst
+ * is sent as its own message carrying the burst's departure time, and the fq
+ * qdisc holds it until then. The packets of a burst are sent as one GSO
+ * train when useGSO is set. Like UnmarkedPacketBatchWriter, messages are sent
+ * as Not-ECT once the connection failed ECN validation.
+ */
+class TxTimePacketBatchWriter : public BatchWriter {
+ public:
+  TxTimePacketBatchWriter(
+      QuicConnectionStateBase& conn,
+      size_t maxBufs,
+      bool useGSO);
+  ~TxTimePacketBatchWriter() override = default;
+
+  bool empty() const override;
+
+  size_t size() const override;
+
+  void reset() override;
+  bool append(
+      std::unique_ptr<folly::IOBuf>&& buf,
+      size_t size,
+      const folly::SocketAddress& /*unused*/,
+      folly::AsyncUDPSocket* /*unused*/) override;
+  ssize_t write(
+      folly::AsyncUDPSocket& sock,
+      const folly::SocketAddress& address) override;
+
+ private:
+  QuicConnectionStateBase& conn_;
+  // max number of buffer chains we can accumulate before we need to flush
+  size_t maxBufs_{1};
+  bool useGSO_{false};
+  // current number of buffer chains appended the buf_
+  size_t currBufs_{0};
+  // size of data in all the buffers
+  size_t currSize_{0};
+  // packets of the current burst appended so far, a burst can span flushes
+  uint64_t burstPackets_{0};
+  TimePoint burstDeparture_;
+  // one entry per message
+  std::vector<std::unique_ptr<folly::IOBuf>> bufs_;
+  std::vector<int> gso_;
+  std::vector<size_t> prevSize_;
+  std::vector<TimePoint> departures_;
+};
+
+/**
+ * Writer for connections whose ECN validation failed while the socket they
+ * send on marks every datagram, as the shared socket of a server worker does.
+ * Every message carries an IP_TOS or IPV6_TCLASS cmsg that sends it as
+ * Not-ECT. Packets are sent as GSO trains when useGSO is set.
+ */
+class UnmarkedPacketBatchWriter : public BatchWriter {
+ public:
+  UnmarkedPacketBatchWriter(size_t maxBufs, bool useGSO);
+  ~UnmarkedPacketBatchWriter() override = default;
+
+  bool empty() const override;
+
+  size_t size() const override;
+
+  void reset() override;
+  bool append(
+      std::unique_ptr<folly::IOBuf>&& buf,
+      size_t size,
+      const folly::SocketAddress& /*unused*/,
+      folly::AsyncUDPSocket* /*unused*/) override;
+  ssize_t write(
+      folly::AsyncUDPSocket& sock,
+      const folly::SocketAddress& address) override;
+
+ private:
+  // max number of buffer chains we can accumulate before we need to flush
+  size_t maxBufs_{1};
+  bool useGSO_{false};
+  // current number of buffer chains appended the buf_
+  size_t currBufs_{0};
+  // size of data in all the buffers
+  size_t currSize_{0};
+  // one entry per message
+  std::vector<std::unique_ptr<folly::IOBuf>> bufs_;
+  std::vector<int> gso_;
+  std::vector<size_t> prevSize_;
+};
+
 struct BatchWriterDeleter {
   void operator()(BatchWriter* batchWriter);
 };
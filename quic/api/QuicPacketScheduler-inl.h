@@ -35,6 +35,10 @@ inline folly::Optional<PacketNum> AckScheduler::writeNextAcks(
                  ackingTime - receivedTime)
            : 0us);
   AckFrameMetaData meta(ackState_.acks, ackDelay, ackDelayExponentToUse);
+  if (ackState_.ecnCounts.ect0 || ackState_.ecnCounts.ect1 ||
+      ackState_.ecnCounts.ce) {
+    meta.ecnCounts = ackState_.ecnCounts;
+  }
   auto ackWriteResult = writeAckFrame(meta, builder);
   if (!ackWriteResult) {
     return folly::none;
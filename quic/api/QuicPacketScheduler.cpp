@@ -87,6 +87,11 @@ FrameScheduler::Builder& FrameScheduler::Builder::pingFrames() {
   return *this;
 }
 
+FrameScheduler::Builder& FrameScheduler::Builder::datagramFrames() {
+  datagramFrameScheduler_ = true;
+  return *this;
+}
+
 FrameScheduler FrameScheduler::Builder::build() && {
   FrameScheduler scheduler(std::move(name_));
   if (retransmissionScheduler_) {
@@ -118,6 +123,9 @@ FrameScheduler FrameScheduler::Builder::build() && {
   if (pingFrameScheduler_) {
     scheduler.pingFrameScheduler_.emplace(PingFrameScheduler(conn_));
   }
+  if (datagramFrameScheduler_) {
+    scheduler.datagramFrameScheduler_.emplace(DatagramFrameScheduler(conn_));
+  }
   return scheduler;
 }
 
@@ -176,6 +184,12 @@ SchedulingResult FrameScheduler::scheduleFramesForPacket(
   if (pingFrameScheduler_ && pingFrameScheduler_->hasPingFrame()) {
     pingFrameScheduler_->writePing(wrapper);
   }
+  // Datagrams go before stream data since they are usually latency sensitive,
+  // whatever space they leave is filled with stream frames.
+  if (datagramFrameScheduler_ &&
+      datagramFrameScheduler_->hasPendingDatagramFrames()) {
+    datagramFrameScheduler_->writeDatagramFrames(wrapper);
+  }
   if (retransmissionScheduler_ && retransmissionScheduler_->hasPendingData()) {
     retransmissionScheduler_->writeRetransmissionStreams(wrapper);
   }
@@ -214,7 +228,9 @@ bool FrameScheduler::hasImmediateData() const {
       (blockedScheduler_ && blockedScheduler_->hasPendingBlockedFrames()) ||
       (simpleFrameScheduler_ &&
        simpleFrameScheduler_->hasPendingSimpleFrames()) ||
-      (pingFrameScheduler_ && pingFrameScheduler_->hasPingFrame());
+      (pingFrameScheduler_ && pingFrameScheduler_->hasPingFrame()) ||
+      (datagramFrameScheduler_ &&
+       datagramFrameScheduler_->hasPendingDatagramFrames());
 }
 
 std::string FrameScheduler::name() const {
@@ -274,7 +290,6 @@ StreamId StreamFrameScheduler::writeStreamsHelper(
   // stream id. The iterator will wrap around the collection at the end, and we
   // keep track of the value at the next iteration. This allows us to start
   // writing at the next stream when building the next packet.
-  // TODO experiment with writing streams with an actual prioritization scheme.
   while (writableStreamItr != wrapper.cend() && connWritableBytes > 0) {
     if (writeNextStreamFrame(builder, *writableStreamItr, connWritableBytes)) {
       writableStreamItr++;
@@ -288,6 +303,54 @@ StreamId StreamFrameScheduler::writeStreamsHelper(
   return *writableStreamItr;
 }
 
+void StreamFrameScheduler::writeStreamsHelper(
+    PacketBuilderInterface& builder,
+    PriorityQueue& writableStreams,
+    uint64_t& connWritableBytes,
+    bool streamPerPacket) {
+  for (auto& level : writableStreams.levels) {
+    if (level.streams.empty()) {
+      continue;
+    }
+    if (connWritableBytes == 0 || builder.remainingSpaceInPkt() == 0) {
+      return;
+    }
+    bool streamWritten = false;
+    if (level.incremental) {
+      MiddleStartingIterationWrapper wrapper(level.streams, level.next);
+      auto writableStreamItr = wrapper.cbegin();
+      while (writableStreamItr != wrapper.cend() && connWritableBytes > 0) {
+        if (!writeNextStreamFrame(
+                builder, *writableStreamItr, connWritableBytes)) {
+          break;
+        }
+        streamWritten = true;
+        writableStreamItr++;
+        if (streamPerPacket) {
+          break;
+        }
+      }
+      level.next = *writableStreamItr;
+    } else {
+      // A non-incremental stream gets all the space it can use before the
+      // next stream at the same level is considered.
+      for (auto streamId : level.streams) {
+        if (connWritableBytes == 0 ||
+            !writeNextStreamFrame(builder, streamId, connWritableBytes)) {
+          break;
+        }
+        streamWritten = true;
+        if (streamPerPacket) {
+          break;
+        }
+      }
+    }
+    if (streamWritten && streamPerPacket) {
+      return;
+    }
+  }
+}
+
 void StreamFrameScheduler::writeStreams(PacketBuilderInterface& builder) {
   DCHECK(conn_.streamManager->hasWritable());
   uint64_t connWritableBytes = getSendConnFlowControlBytesWire(conn_);
@@ -308,16 +371,15 @@ void StreamFrameScheduler::writeStreams(PacketBuilderInterface& builder) {
   if (connWritableBytes == 0) {
     return;
   }
-  const auto& writableStreams = conn_.streamManager->writableStreams();
+  auto& writableStreams = conn_.streamManager->writableStreams();
   if (!writableStreams.empty()) {
-    conn_.schedulingState.nextScheduledStream = writeStreamsHelper(
+    writeStreamsHelper(
         builder,
         writableStreams,
-        conn_.schedulingState.nextScheduledStream,
         connWritableBytes,
         conn_.transportSettings.streamFramePerPacket);
   }
-} // namespace quic
+}
 
 bool StreamFrameScheduler::hasPendingData() const {
   return conn_.streamManager->hasWritable() &&
@@ -430,6 +492,43 @@ bool PingFrameScheduler::writePing(PacketBuilderInterface& builder) {
   return 0 != writeFrame(PingFrame(), builder);
 }
 
+DatagramFrameScheduler::DatagramFrameScheduler(QuicConnectionStateBase& conn)
+    : conn_(conn) {}
+
+bool DatagramFrameScheduler::hasPendingDatagramFrames() const {
+  return !conn_.datagramState.writeBuffer.empty();
+}
+
+bool DatagramFrameScheduler::writeDatagramFrames(
+    PacketBuilderInterface& builder) {
+  bool framesWritten = false;
+  auto& writeBuffer = conn_.datagramState.writeBuffer;
+  while (!writeBuffer.empty()) {
+    auto len = writeBuffer.front()->computeChainDataLength();
+    if (len + kMaxDatagramPacketOverhead > conn_.udpSendPacketLen) {
+      // Can never fit in a packet, e.g. the packet size shrank after the
+      // datagram was buffered. Drop it rather than blocking the queue.
+      VLOG(4) << "Dropping datagram len=" << len << " " << conn_;
+      writeBuffer.pop_front();
+      continue;
+    }
+    QuicInteger frameLength(len);
+    auto frameSize = sizeof(uint8_t) + frameLength.getSize() + len;
+    if (frameSize > builder.remainingSpaceInPkt()) {
+      // Leave it for the next packet.
+      break;
+    }
+    // The space check above guarantees the write succeeds, so the payload can
+    // be moved into the packet rather than cloned.
+    auto bytesWritten = writeFrame(
+        DatagramFrame(len, std::move(writeBuffer.front())), builder);
+    DCHECK_EQ(frameSize, bytesWritten);
+    writeBuffer.pop_front();
+    framesWritten = true;
+  }
+  return framesWritten;
+}
+
 WindowUpdateScheduler::WindowUpdateScheduler(
     const QuicConnectionStateBase& conn)
     : conn_(conn) {}
@@ -571,7 +670,7 @@ SchedulingResult CloningScheduler::scheduleFramesForPacket(
     if (outstandingPacket.declaredLost) {
       continue;
     }
-    auto opPnSpace = outstandingPacket.packet.header.getPacketNumberSpace();
+    auto opPnSpace = outstandingPacket.packetNumberSpace;
     // Reusing the RegularQuicPacketBuilder throughout loop bodies will lead to
     // frames belong to different original packets being written into the same
     // clone packet. So re-create a RegularQuicPacketBuilder every time.
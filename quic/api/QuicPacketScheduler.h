@@ -15,6 +15,7 @@
 #include <quic/codec/QuicWriteCodec.h>
 #include <quic/codec/Types.h>
 #include <quic/flowcontrol/QuicFlowController.h>
+#include <quic/state/QuicPriorityQueue.h>
 #include <quic/state/QuicStreamFunctions.h>
 
 namespace quic {
@@ -169,6 +170,17 @@ class StreamFrameScheduler {
       uint64_t& connWritableBytes,
       bool streamPerPacket);
 
+  /**
+   * Writes the non-control streams in priority order. More urgent levels are
+   * drained first, incremental levels are round robined and non-incremental
+   * levels are written sequentially in stream id order.
+   */
+  void writeStreamsHelper(
+      PacketBuilderInterface& builder,
+      PriorityQueue& writableStreams,
+      uint64_t& connWritableBytes,
+      bool streamPerPacket);
+
   using WritableStreamItr =
       MiddleStartingIterationWrapper::MiddleStartingIterator;
 
@@ -253,6 +265,23 @@ class PingFrameScheduler {
   const QuicConnectionStateBase& conn_;
 };
 
+/*
+ * Writes buffered DATAGRAM frames. Datagrams are removed from the write buffer
+ * as soon as they are written into a packet since they are never
+ * retransmitted.
+ */
+class DatagramFrameScheduler {
+ public:
+  explicit DatagramFrameScheduler(QuicConnectionStateBase& conn);
+
+  FOLLY_NODISCARD bool hasPendingDatagramFrames() const;
+
+  bool writeDatagramFrames(PacketBuilderInterface& builder);
+
+ private:
+  QuicConnectionStateBase& conn_;
+};
+
 class WindowUpdateScheduler {
  public:
   explicit WindowUpdateScheduler(const QuicConnectionStateBase& conn);
@@ -320,6 +349,7 @@ class FrameScheduler : public QuicPacketScheduler {
     Builder& cryptoFrames();
     Builder& simpleFrames();
     Builder& pingFrames();
+    Builder& datagramFrames();
 
     FrameScheduler build() &&;
 
@@ -339,6 +369,7 @@ class FrameScheduler : public QuicPacketScheduler {
     bool cryptoStreamScheduler_{false};
     bool simpleFrameScheduler_{false};
     bool pingFrameScheduler_{false};
+    bool datagramFrameScheduler_{false};
   };
 
   explicit FrameScheduler(std::string name);
@@ -365,6 +396,7 @@ class FrameScheduler : public QuicPacketScheduler {
   folly::Optional<CryptoStreamScheduler> cryptoStreamScheduler_;
   folly::Optional<SimpleFrameScheduler> simpleFrameScheduler_;
   folly::Optional<PingFrameScheduler> pingFrameScheduler_;
+  folly::Optional<DatagramFrameScheduler> datagramFrameScheduler_;
   std::string name_;
 };
 
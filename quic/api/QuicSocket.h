@@ -546,6 +546,16 @@ class QuicSocket {
       StreamId id,
       size_t maxLen) = 0;
 
+  /**
+   * Same as read(), but the data is returned as a list of buffers, one per
+   * contiguous segment of the received packets, instead of a single chain.
+   * The buffers share memory with the packets the data arrived in, so the
+   * application can hand them to scatter/gather IO without coalescing them,
+   * and release each one as soon as it has been consumed.
+   */
+  virtual folly::Expected<std::pair<std::vector<Buf>, bool>, LocalErrorCode>
+  readChunks(StreamId id, size_t maxLen) = 0;
+
   /**
    * ===== Peek/Consume API =====
    */
@@ -1048,6 +1058,56 @@ class QuicSocket {
       PingCallback* callback,
       std::chrono::milliseconds pingTimeout) = 0;
 
+  /**
+   * ===== Datagram API =====
+   *
+   * Datagrams are sent in DATAGRAM frames (RFC 9221). They are delivered at
+   * most once, possibly out of order, and are never retransmitted. Both
+   * directions are buffered in bounded queues, see DatagramConfig.
+   */
+
+  /**
+   * Callback class for receiving datagrams
+   */
+  class DatagramCallback {
+   public:
+    virtual ~DatagramCallback() = default;
+
+    /**
+     * Invoked after reading from the network when there are datagrams waiting
+     * to be read with readDatagrams().
+     */
+    virtual void onDatagramsAvailable() noexcept = 0;
+  };
+
+  /**
+   * Set the callback notified when datagrams are received. Passing nullptr
+   * unsets it, received datagrams are still buffered and can be read.
+   */
+  virtual folly::Expected<folly::Unit, LocalErrorCode> setDatagramCallback(
+      DatagramCallback* cb) = 0;
+
+  /**
+   * Largest datagram payload that can currently be written. 0 means the peer
+   * does not support datagrams, or the handshake has not progressed far
+   * enough to know.
+   */
+  FOLLY_NODISCARD virtual uint16_t getDatagramSizeLimit() const = 0;
+
+  /**
+   * Queue a datagram for sending. Fails if datagrams are not supported, buf is
+   * larger than getDatagramSizeLimit(), or the write buffer is full. The
+   * buffer is handed to the packet builder without copying.
+   */
+  virtual WriteResult writeDatagram(Buf buf) = 0;
+
+  /**
+   * Returns up to atMost received datagrams in the order they were received,
+   * or all of them if atMost is 0.
+   */
+  virtual folly::Expected<std::vector<ReadDatagram>, LocalErrorCode>
+  readDatagrams(size_t atMost = 0) = 0;
+
   /**
    * Get information on the state of the quic connection. Should only be used
    * for logging.
@@ -1089,6 +1149,22 @@ class QuicSocket {
    */
   virtual folly::Optional<LocalErrorCode> setControlStream(StreamId id) = 0;
 
+  /**
+   * Set the send priority of a stream. Level is the urgency in the range
+   * [0, kDefaultMaxPriority], lower levels are sent first. Incremental streams
+   * of the same level share bandwidth round robin, non-incremental ones are
+   * sent one after another. Control streams are always sent first regardless
+   * of their priority.
+   */
+  virtual folly::Expected<folly::Unit, LocalErrorCode>
+  setStreamPriority(StreamId id, PriorityLevel level, bool incremental) = 0;
+
+  /**
+   * Get the send priority of a stream.
+   */
+  virtual folly::Expected<Priority, LocalErrorCode> getStreamPriority(
+      StreamId id) = 0;
+
   /**
    * Set congestion control type.
    */
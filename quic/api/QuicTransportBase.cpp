@@ -34,6 +34,7 @@ QuicTransportBase::QuicTransportBase(
       ackTimeout_(this),
       pathValidationTimeout_(this),
       idleTimeout_(this),
+      idleCompactionTimeout_(this),
       drainTimeout_(this),
       pingTimeout_(this),
       readLooper_(new FunctionLooper(
@@ -49,6 +50,9 @@ QuicTransportBase::QuicTransportBase(
           [this](bool fromTimer) { pacedWriteDataToSocket(fromTimer); },
           LooperType::WriteLooper)) {
   writeLooper_->setPacingFunction([this]() -> auto {
+    if (isTxTimePaced(*conn_)) {
+      return getTxTimeUntilNextWrite(*conn_, Clock::now());
+    }
     if (isConnectionPaced(*conn_)) {
       return conn_->pacer->getTimeUntilNextWrite();
     }
@@ -382,6 +386,9 @@ void QuicTransportBase::closeImpl(
   if (idleTimeout_.isScheduled()) {
     idleTimeout_.cancelTimeout();
   }
+  if (idleCompactionTimeout_.isScheduled()) {
+    idleCompactionTimeout_.cancelTimeout();
+  }
   if (pingTimeout_.isScheduled()) {
     pingTimeout_.cancelTimeout();
   }
@@ -445,6 +452,9 @@ void QuicTransportBase::closeImpl(
 
   // can't invoke connection callbacks any more.
   connCallback_ = nullptr;
+  datagramCallback_ = nullptr;
+  conn_->datagramState.readBuffer.clear();
+  conn_->datagramState.writeBuffer.clear();
 
   // Don't need outstanding packets.
   conn_->outstandings.packets.clear();
@@ -471,7 +481,8 @@ void QuicTransportBase::closeImpl(
   if (drainConnection) {
     // We ever drain once, and the object ever gets created once.
     DCHECK(!drainTimeout_.isScheduled());
-    getEventBase()->timer().scheduleTimeout(
+    connTimer_.scheduleTimeout(
+        getEventBase()->timer(),
         &drainTimeout_,
         folly::chrono::ceil<std::chrono::milliseconds>(
             kDrainFactor * calculatePTO(*conn_)));
@@ -610,9 +621,15 @@ uint64_t QuicTransportBase::bufferSpaceAvailable() const {
   auto bytesBuffered = conn_->flowControlState.sumCurStreamBufferLen;
   auto totalBufferSpaceAvailable =
       conn_->transportSettings.totalBufferSpaceAvailable;
-  return bytesBuffered > totalBufferSpaceAvailable
+  auto connBufferSpaceAvailable = bytesBuffered > totalBufferSpaceAvailable
       ? 0
       : totalBufferSpaceAvailable - bytesBuffered;
+  if (conn_->bufferMemoryPool) {
+    // Other connections of the worker may already use up the shared pool.
+    return std::min(
+        connBufferSpaceAvailable, conn_->bufferMemoryPool->available());
+  }
+  return connBufferSpaceAvailable;
 }
 
 folly::Expected<QuicSocket::FlowControlState, LocalErrorCode>
@@ -1428,6 +1445,16 @@ folly::Expected<std::pair<Buf, bool>, LocalErrorCode> QuicTransportBase::read(
   }
 }
 
+folly::Expected<std::pair<std::vector<Buf>, bool>, LocalErrorCode>
+QuicTransportBase::readChunks(StreamId id, size_t maxLen) {
+  auto result = read(id, maxLen);
+  if (result.hasError()) {
+    return folly::makeUnexpected(result.error());
+  }
+  return std::make_pair(
+      unchainBuf(std::move(result.value().first)), result.value().second);
+}
+
 folly::Expected<folly::Unit, LocalErrorCode> QuicTransportBase::peek(
     StreamId id,
     const folly::Function<void(StreamId id, const folly::Range<PeekIterator>&)
@@ -1623,6 +1650,12 @@ void QuicTransportBase::handleKnobCallbacks() {
   conn_->pendingEvents.knobs.clear();
 }
 
+void QuicTransportBase::handleDatagramCallbacks() {
+  if (datagramCallback_ && !conn_->datagramState.readBuffer.empty()) {
+    datagramCallback_->onDatagramsAvailable();
+  }
+}
+
 void QuicTransportBase::processCallbacksAfterNetworkData() {
   if (closeState_ != CloseState::OPEN) {
     return;
@@ -1657,6 +1690,14 @@ void QuicTransportBase::processCallbacksAfterNetworkData() {
   }
 
   handleKnobCallbacks();
+  if (closeState_ != CloseState::OPEN) {
+    return;
+  }
+
+  handleDatagramCallbacks();
+  if (closeState_ != CloseState::OPEN) {
+    return;
+  }
 
   // TODO: we're currently assuming that canceling write callbacks will not
   // cause reset of random streams. Maybe get rid of that assumption later.
@@ -1809,10 +1850,25 @@ void QuicTransportBase::onNetworkData(
   try {
     conn_->lossState.totalBytesRecvd += networkData.totalData;
     auto originalAckVersion = currentAckStateVersion(*conn_);
-    for (auto& packet : networkData.packets) {
+    // Unmask the short headers of the whole batch in one pass. The packets
+    // are still parsed one at a time, since one can install the keys the
+    // next one needs.
+    auto readCodec = conn_->readCodec.get();
+    if (readCodec && networkData.packets.size() > 1) {
+      readCodec->computeHeaderMasks(folly::range(networkData.packets));
+    }
+    SCOPE_EXIT {
+      if (readCodec && readCodec == conn_->readCodec.get()) {
+        readCodec->clearHeaderMasks();
+      }
+    };
+    for (size_t i = 0; i < networkData.packets.size(); ++i) {
       onReadData(
           peer,
-          NetworkDataSingle(std::move(packet), networkData.receiveTimePoint));
+          NetworkDataSingle(
+              std::move(networkData.packets[i]),
+              networkData.receiveTimePoint,
+              networkData.getEcnMark(i)));
     }
     processCallbacksAfterNetworkData();
     if (closeState_ != CloseState::CLOSED) {
@@ -1871,6 +1927,12 @@ void QuicTransportBase::setIdleTimer() {
   if (closeState_ == CloseState::CLOSED) {
     return;
   }
+  if (conn_->transportSettings.idleCompactionTimeout > 0ms) {
+    connTimer_.scheduleTimeout(
+        getEventBase()->timer(),
+        &idleCompactionTimeout_,
+        conn_->transportSettings.idleCompactionTimeout);
+  }
   if (idleTimeout_.isScheduled()) {
     idleTimeout_.cancelTimeout();
   }
@@ -1882,7 +1944,8 @@ void QuicTransportBase::setIdleTimer() {
   auto peerIdleTimeout =
       conn_->peerIdleTimeout > 0ms ? conn_->peerIdleTimeout : localIdleTimeout;
   auto idleTimeout = timeMin(localIdleTimeout, peerIdleTimeout);
-  getEventBase()->timer().scheduleTimeout(&idleTimeout_, idleTimeout);
+  connTimer_.scheduleTimeout(
+      getEventBase()->timer(), &idleTimeout_, idleTimeout);
 }
 
 uint64_t QuicTransportBase::getNumOpenableBidirectionalStreams() const {
@@ -2352,6 +2415,68 @@ void QuicTransportBase::sendPing(
   }
 }
 
+folly::Expected<folly::Unit, LocalErrorCode>
+QuicTransportBase::setDatagramCallback(DatagramCallback* cb) {
+  if (closeState_ != CloseState::OPEN) {
+    return folly::makeUnexpected(LocalErrorCode::CONNECTION_CLOSED);
+  }
+  VLOG(4) << "Setting datagram callback cb=" << cb << " " << *this;
+  datagramCallback_ = cb;
+  return folly::unit;
+}
+
+uint16_t QuicTransportBase::getDatagramSizeLimit() const {
+  CHECK(conn_);
+  // The peer's max_datagram_frame_size covers the frame type and length, on
+  // top of which the packet adds its header and AEAD tag.
+  auto maxWriteFrameSize = conn_->datagramState.maxWriteFrameSize;
+  if (maxWriteFrameSize <= kMaxDatagramFrameOverhead ||
+      conn_->udpSendPacketLen <= kMaxDatagramPacketOverhead) {
+    return 0;
+  }
+  return std::min<uint64_t>(
+      maxWriteFrameSize - kMaxDatagramFrameOverhead,
+      conn_->udpSendPacketLen - kMaxDatagramPacketOverhead);
+}
+
+QuicSocket::WriteResult QuicTransportBase::writeDatagram(Buf buf) {
+  if (closeState_ != CloseState::OPEN) {
+    return folly::makeUnexpected(LocalErrorCode::CONNECTION_CLOSED);
+  }
+  auto sizeLimit = getDatagramSizeLimit();
+  if (sizeLimit == 0) {
+    return folly::makeUnexpected(LocalErrorCode::DATAGRAM_UNSUPPORTED);
+  }
+  if (!buf || buf->computeChainDataLength() > sizeLimit) {
+    return folly::makeUnexpected(LocalErrorCode::INVALID_WRITE_DATA);
+  }
+  auto& datagramState = conn_->datagramState;
+  if (datagramState.writeBuffer.size() >= datagramState.maxWriteBufferSize) {
+    return folly::makeUnexpected(LocalErrorCode::DATAGRAM_BUFFER_FULL);
+  }
+  datagramState.writeBuffer.emplace_back(std::move(buf));
+  updateWriteLooper(true);
+  return folly::unit;
+}
+
+folly::Expected<std::vector<ReadDatagram>, LocalErrorCode>
+QuicTransportBase::readDatagrams(size_t atMost) {
+  CHECK(conn_);
+  if (closeState_ != CloseState::OPEN) {
+    return folly::makeUnexpected(LocalErrorCode::CONNECTION_CLOSED);
+  }
+  auto& readBuffer = conn_->datagramState.readBuffer;
+  if (atMost == 0 || atMost > readBuffer.size()) {
+    atMost = readBuffer.size();
+  }
+  std::vector<ReadDatagram> datagrams;
+  datagrams.reserve(atMost);
+  auto end = readBuffer.begin() + atMost;
+  std::move(readBuffer.begin(), end, std::back_inserter(datagrams));
+  readBuffer.erase(readBuffer.begin(), end);
+  return datagrams;
+}
+
 void QuicTransportBase::lossTimeoutExpired() noexcept {
   CHECK_NE(closeState_, CloseState::CLOSED);
   // onLossDetectionAlarm will set packetToSend in pending events
@@ -2432,13 +2557,18 @@ void QuicTransportBase::idleTimeoutExpired(bool drain) noexcept {
       !drain /* sendCloseImmediately */);
 }
 
+void QuicTransportBase::idleCompactionTimeoutExpired() noexcept {
+  VLOG(10) << __func__ << " " << *this;
+  compactIdleConnectionState(*conn_);
+}
+
 void QuicTransportBase::scheduleLossTimeout(std::chrono::milliseconds timeout) {
   if (closeState_ == CloseState::CLOSED) {
     return;
   }
   auto& wheelTimer = getEventBase()->timer();
   timeout = timeMax(timeout, wheelTimer.getTickInterval());
-  wheelTimer.scheduleTimeout(&lossTimeout_, timeout);
+  connTimer_.scheduleTimeout(wheelTimer, &lossTimeout_, timeout);
 }
 
 void QuicTransportBase::scheduleAckTimeout() {
@@ -2449,16 +2579,22 @@ void QuicTransportBase::scheduleAckTimeout() {
     if (!ackTimeout_.isScheduled()) {
       auto factoredRtt = std::chrono::duration_cast<std::chrono::microseconds>(
           kAckTimerFactor * conn_->lossState.srtt);
+      auto maxAckDelay = timeMin(kMaxAckTimeout, factoredRtt);
+      // The peer asked for a specific max ack delay with ACK_FREQUENCY.
+      if (conn_->ackFrequencyState.peerRequest) {
+        maxAckDelay = std::chrono::microseconds(
+            conn_->ackFrequencyState.peerRequest->updateMaxAckDelay);
+      }
       auto& wheelTimer = getEventBase()->timer();
       auto timeout = timeMax(
           std::chrono::duration_cast<std::chrono::microseconds>(
               wheelTimer.getTickInterval()),
-          timeMin(kMaxAckTimeout, factoredRtt));
+          maxAckDelay);
       auto timeoutMs = folly::chrono::ceil<std::chrono::milliseconds>(timeout);
       VLOG(10) << __func__ << " timeout=" << timeoutMs.count() << "ms"
                << " factoredRtt=" << factoredRtt.count() << "us"
                << " " << *this;
-      wheelTimer.scheduleTimeout(&ackTimeout_, timeoutMs);
+      connTimer_.scheduleTimeout(wheelTimer, &ackTimeout_, timeoutMs);
     }
   } else {
     if (ackTimeout_.isScheduled()) {
@@ -2478,7 +2614,7 @@ void QuicTransportBase::schedulePingTimeout(
 
   pingCallback_ = pingCb;
   auto& wheelTimer = getEventBase()->timer();
-  wheelTimer.scheduleTimeout(&pingTimeout_, timeout);
+  connTimer_.scheduleTimeout(wheelTimer, &pingTimeout_, timeout);
 }
 
 void QuicTransportBase::schedulePathValidationTimeout() {
@@ -2502,7 +2638,8 @@ void QuicTransportBase::schedulePathValidationTimeout() {
     auto timeoutMs =
         folly::chrono::ceil<std::chrono::milliseconds>(validationTimeout);
     VLOG(10) << __func__ << " timeout=" << timeoutMs.count() << "ms " << *this;
-    getEventBase()->timer().scheduleTimeout(&pathValidationTimeout_, timeoutMs);
+    connTimer_.scheduleTimeout(
+        getEventBase()->timer(), &pathValidationTimeout_, timeoutMs);
   }
 }
 
@@ -2734,6 +2871,11 @@ void QuicTransportBase::setTransportSettings(
         transportSettings.dataPathType != DataPathType::ContinuousMemory);
     conn_->transportSettings = std::move(transportSettings);
     conn_->streamManager->refreshTransportSettings(conn_->transportSettings);
+    const auto& datagramConfig = conn_->transportSettings.datagramConfig;
+    conn_->datagramState.maxReadFrameSize =
+        datagramConfig.enabled ? kMaxDatagramFrameSize : 0;
+    conn_->datagramState.maxReadBufferSize = datagramConfig.readBufSize;
+    conn_->datagramState.maxWriteBufferSize = datagramConfig.writeBufSize;
   }
 
   // A few values cannot be overridden to be lower than default:
@@ -2858,6 +3000,7 @@ void QuicTransportBase::detachEventBase() {
   ackTimeout_.cancelTimeout();
   pathValidationTimeout_.cancelTimeout();
   idleTimeout_.cancelTimeout();
+  idleCompactionTimeout_.cancelTimeout();
   drainTimeout_.cancelTimeout();
   readLooper_->detachEventBase();
   peekLooper_->detachEventBase();
@@ -2875,6 +3018,40 @@ folly::Optional<LocalErrorCode> QuicTransportBase::setControlStream(
   return folly::none;
 }
 
+folly::Expected<folly::Unit, LocalErrorCode>
+QuicTransportBase::setStreamPriority(
+    StreamId id,
+    PriorityLevel level,
+    bool incremental) {
+  if (closeState_ != CloseState::OPEN) {
+    return folly::makeUnexpected(LocalErrorCode::CONNECTION_CLOSED);
+  }
+  if (level > kDefaultMaxPriority) {
+    return folly::makeUnexpected(LocalErrorCode::INVALID_OPERATION);
+  }
+  if (!conn_->streamManager->streamExists(id)) {
+    return folly::makeUnexpected(LocalErrorCode::STREAM_NOT_EXISTS);
+  }
+  // Force the stream state to be created if it hasn't been yet.
+  conn_->streamManager->getStream(id);
+  if (conn_->streamManager->setStreamPriority(id, level, incremental)) {
+    updateWriteLooper(true);
+  }
+  return folly::unit;
+}
+
+folly::Expected<Priority, LocalErrorCode> QuicTransportBase::getStreamPriority(
+    StreamId id) {
+  if (closeState_ != CloseState::OPEN) {
+    return folly::makeUnexpected(LocalErrorCode::CONNECTION_CLOSED);
+  }
+  if (!conn_->streamManager->streamExists(id)) {
+    return folly::makeUnexpected(LocalErrorCode::STREAM_NOT_EXISTS);
+  }
+  auto stream = conn_->streamManager->getStream(id);
+  return stream->priority;
+}
+
 void QuicTransportBase::runOnEvbAsync(
     folly::Function<void(std::shared_ptr<QuicTransportBase>)> func) {
   auto evb = getEventBase();
@@ -11,6 +11,7 @@
 #include <quic/QuicConstants.h>
 #include <quic/QuicException.h>
 #include <quic/api/QuicSocket.h>
+#include <quic/common/ConnectionTimer.h>
 #include <quic/common/FunctionLooper.h>
 #include <quic/common/Timers.h>
 #include <quic/congestion_control/CongestionControllerFactory.h>
@@ -130,6 +131,9 @@ class QuicTransportBase : public QuicSocket {
       StreamId id,
       size_t maxLen) override;
 
+  folly::Expected<std::pair<std::vector<Buf>, bool>, LocalErrorCode>
+  readChunks(StreamId id, size_t maxLen) override;
+
   folly::Expected<folly::Unit, LocalErrorCode> setPeekCallback(
       StreamId id,
       PeekCallback* cb) override;
@@ -213,6 +217,16 @@ class QuicTransportBase : public QuicSocket {
   void sendPing(PingCallback* callback, std::chrono::milliseconds pingTimeout)
       override;
 
+  folly::Expected<folly::Unit, LocalErrorCode> setDatagramCallback(
+      DatagramCallback* cb) override;
+
+  uint16_t getDatagramSizeLimit() const override;
+
+  WriteResult writeDatagram(Buf buf) override;
+
+  folly::Expected<std::vector<ReadDatagram>, LocalErrorCode> readDatagrams(
+      size_t atMost = 0) override;
+
   const QuicConnectionStateBase* getState() const override {
     return conn_.get();
   }
@@ -240,6 +254,14 @@ class QuicTransportBase : public QuicSocket {
 
   folly::Optional<LocalErrorCode> setControlStream(StreamId id) override;
 
+  folly::Expected<folly::Unit, LocalErrorCode> setStreamPriority(
+      StreamId id,
+      PriorityLevel level,
+      bool incremental) override;
+
+  folly::Expected<Priority, LocalErrorCode> getStreamPriority(
+      StreamId id) override;
+
   /**
    * Set the initial flow control window for the connection.
    */
@@ -391,7 +413,7 @@ class QuicTransportBase : public QuicSocket {
       const StreamId id) const override;
 
   // Timeout functions
-  class LossTimeout : public folly::HHWheelTimer::Callback {
+  class LossTimeout : public ConnectionTimer::Callback {
    public:
     ~LossTimeout() override = default;
 
@@ -412,7 +434,7 @@ class QuicTransportBase : public QuicSocket {
     QuicTransportBase* transport_;
   };
 
-  class AckTimeout : public folly::HHWheelTimer::Callback {
+  class AckTimeout : public ConnectionTimer::Callback {
    public:
     ~AckTimeout() override = default;
 
@@ -432,7 +454,7 @@ class QuicTransportBase : public QuicSocket {
     QuicTransportBase* transport_;
   };
 
-  class PingTimeout : public folly::HHWheelTimer::Callback {
+  class PingTimeout : public ConnectionTimer::Callback {
    public:
     ~PingTimeout() override = default;
 
@@ -452,7 +474,7 @@ class QuicTransportBase : public QuicSocket {
     QuicTransportBase* transport_;
   };
 
-  class PathValidationTimeout : public folly::HHWheelTimer::Callback {
+  class PathValidationTimeout : public ConnectionTimer::Callback {
    public:
     ~PathValidationTimeout() override = default;
 
@@ -473,7 +495,7 @@ class QuicTransportBase : public QuicSocket {
     QuicTransportBase* transport_;
   };
 
-  class IdleTimeout : public folly::HHWheelTimer::Callback {
+  class IdleTimeout : public ConnectionTimer::Callback {
    public:
     ~IdleTimeout() override = default;
 
@@ -494,10 +516,30 @@ class QuicTransportBase : public QuicSocket {
     QuicTransportBase* transport_;
   };
 
+  class IdleCompactionTimeout : public ConnectionTimer::Callback {
+   public:
+    ~IdleCompactionTimeout() override = default;
+
+    explicit IdleCompactionTimeout(QuicTransportBase* transport)
+        : transport_(transport) {}
+
+    void timeoutExpired() noexcept override {
+      transport_->idleCompactionTimeoutExpired();
+    }
+
+    void callbackCanceled() noexcept override {
+      // ignore, there is nothing to release once the timer goes away
+      return;
+    }
+
+   private:
+    QuicTransportBase* transport_;
+  };
+
   // DrainTimeout is a bit different from other timeouts. It needs to hold a
   // shared_ptr to the transport, since if a DrainTimeout is scheduled,
   // transport cannot die.
-  class DrainTimeout : public folly::HHWheelTimer::Callback {
+  class DrainTimeout : public ConnectionTimer::Callback {
    public:
     ~DrainTimeout() override = default;
 
@@ -604,6 +646,7 @@ class QuicTransportBase : public QuicSocket {
   void updateWriteLooper(bool thisIteration);
   void handlePingCallback();
   void handleKnobCallbacks();
+  void handleDatagramCallbacks();
 
   void runOnEvbAsync(
       folly::Function<void(std::shared_ptr<QuicTransportBase>)> func);
@@ -665,6 +708,7 @@ class QuicTransportBase : public QuicSocket {
   void ackTimeoutExpired() noexcept;
   void pathValidationTimeoutExpired() noexcept;
   void idleTimeoutExpired(bool drain) noexcept;
+  void idleCompactionTimeoutExpired() noexcept;
   void drainTimeoutExpired() noexcept;
   void pingTimeoutExpired() noexcept;
 
@@ -752,16 +796,20 @@ class QuicTransportBase : public QuicSocket {
   folly::F14FastMap<StreamId, DataExpiredCallbackData> dataExpiredCallbacks_;
   folly::F14FastMap<StreamId, DataRejectedCallbackData> dataRejectedCallbacks_;
   PingCallback* pingCallback_;
+  DatagramCallback* datagramCallback_{nullptr};
 
   WriteCallback* connWriteCallback_{nullptr};
   std::map<StreamId, WriteCallback*> pendingWriteCallbacks_;
   CloseState closeState_{CloseState::OPEN};
   bool transportReadyNotified_{false};
 
+  // All the timeouts below share one wheel timer slot.
+  ConnectionTimer connTimer_;
   LossTimeout lossTimeout_;
   AckTimeout ackTimeout_;
   PathValidationTimeout pathValidationTimeout_;
   IdleTimeout idleTimeout_;
+  IdleCompactionTimeout idleCompactionTimeout_;
   DrainTimeout drainTimeout_;
   PingTimeout pingTimeout_;
   FunctionLooper::Ptr readLooper_;
@@ -17,6 +17,7 @@
 #include <quic/flowcontrol/QuicFlowController.h>
 #include <quic/happyeyeballs/QuicHappyEyeballsFunctions.h>
 #include <quic/logging/QuicLogger.h>
+#include <quic/loss/QuicLossFunctions.h>
 #include <quic/state/AckHandlers.h>
 #include <quic/state/QuicStateFunctions.h>
 #include <quic/state/QuicStreamFunctions.h>
@@ -157,7 +158,8 @@ uint64_t writeQuicDataToSocketImpl(
           .windowUpdateFrames()
           .blockedFrames()
           .simpleFrames()
-          .pingFrames();
+          .pingFrames()
+          .datagramFrames();
   if (!exceptCryptoStream) {
     schedulerBuilder.cryptoFrames();
   }
@@ -282,7 +284,51 @@ DataPathResult continuousMemoryBuildScheduleEncrypt(
   return DataPathResult::makeWriteResult(ret, std::move(result), encodedSize);
 }
 
-DataPathResult iobufChainBasedBuildScheduleEncrypt(
+/**
+ * Returns the header protection sample of a packet whose body has already been
+ * encrypted.
+ */
+Sample getHeaderProtectionSample(
+    uint8_t initialByte,
+    const uint8_t* encryptedBody,
+    size_t bodyLen) {
+  auto packetNumberLength = parsePacketNumberLength(initialByte);
+  Sample sample;
+  size_t sampleBytesToUse = kMaxPacketNumEncodingSize - packetNumberLength;
+  // If there were less than 4 bytes in the packet number, some of the payload
+  // bytes will also be skipped during sampling.
+  CHECK_GE(bodyLen, sampleBytesToUse + sample.size());
+  memcpy(sample.data(), encryptedBody + sampleBytesToUse, sample.size());
+  return sample;
+}
+
+/**
+ * Packets built by the chained memory data path that have not been encrypted
+ * yet. They are encrypted together by encryptAndWritePendingPackets(), so the
+ * cost of calling into the ciphers is paid once per batch instead of once per
+ * packet.
+ */
+struct PendingPackets {
+  std::vector<AeadEncryptRequest> requests;
+  // The plaintext headers, requests[i].associatedData points to headers[i].
+  std::vector<Buf> headers;
+  std::vector<HeaderForm> headerForms;
+  // Scratch space for the header protection, kept to reuse the allocations.
+  std::vector<Sample> samples;
+  std::vector<HeaderProtectionMask> masks;
+
+  size_t size() const {
+    return requests.size();
+  }
+
+  void clear() {
+    requests.clear();
+    headers.clear();
+    headerForms.clear();
+  }
+};
+
+DataPathResult iobufChainBasedBuildSchedule(
     QuicConnectionStateBase& connection,
     PacketHeader header,
     PacketNumberSpace pnSpace,
@@ -290,9 +336,7 @@ DataPathResult iobufChainBasedBuildScheduleEncrypt(
     uint64_t cipherOverhead,
     QuicPacketScheduler& scheduler,
     uint64_t writableBytes,
-    IOBufQuicBatch& ioBufBatch,
-    const Aead& aead,
-    const PacketNumberCipher& headerCipher) {
+    PendingPackets& pendingPackets) {
   RegularQuicPacketBuilder pktBuilder(
       connection.udpSendPacketLen,
       std::move(header),
@@ -303,7 +347,6 @@ DataPathResult iobufChainBasedBuildScheduleEncrypt(
       scheduler.scheduleFramesForPacket(std::move(pktBuilder), writableBytes);
   auto& packet = result.packet;
   if (!packet || packet->packet.frames.empty()) {
-    ioBufBatch.flush();
     if (connection.loopDetectorCallback) {
       connection.writeDebugState.noWriteReason = NoWriteReason::NO_FRAME;
     }
@@ -311,7 +354,6 @@ DataPathResult iobufChainBasedBuildScheduleEncrypt(
   }
   if (!packet->body) {
     // No more space remaining.
-    ioBufBatch.flush();
     if (connection.loopDetectorCallback) {
       connection.writeDebugState.noWriteReason = NoWriteReason::NO_BODY;
     }
@@ -320,42 +362,149 @@ DataPathResult iobufChainBasedBuildScheduleEncrypt(
   packet->header->coalesce();
   auto headerLen = packet->header->length();
   auto bodyLen = packet->body->computeChainDataLength();
-  auto unencrypted =
-      folly::IOBuf::create(headerLen + bodyLen + aead.getCipherOverhead());
+  auto encodedSize = headerLen + bodyLen + cipherOverhead;
+  auto unencrypted = folly::IOBuf::create(encodedSize);
   auto bodyCursor = folly::io::Cursor(packet->body.get());
   bodyCursor.pull(unencrypted->writableData() + headerLen, bodyLen);
   unencrypted->advance(headerLen);
   unencrypted->append(bodyLen);
-  auto packetBuf = aead.inplaceEncrypt(
-      std::move(unencrypted), packet->header.get(), packetNum);
-  DCHECK(packetBuf->headroom() == headerLen);
-  packetBuf->clear();
-  auto headerCursor = folly::io::Cursor(packet->header.get());
-  headerCursor.pull(packetBuf->writableData(), headerLen);
-  packetBuf->append(headerLen + bodyLen + aead.getCipherOverhead());
-
-  HeaderForm headerForm = packet->packet.header.getHeaderForm();
-  encryptPacketHeader(
-      headerForm,
-      packetBuf->writableData(),
-      headerLen,
-      packetBuf->data() + headerLen,
-      packetBuf->length() - headerLen,
-      headerCipher);
-  auto encodedSize = packetBuf->computeChainDataLength();
 #if !FOLLY_MOBILE
   if (encodedSize > connection.udpSendPacketLen) {
     LOG_EVERY_N(ERROR, 5000)
         << "Quic sending pkt larger than limit, encodedSize=" << encodedSize;
   }
 #endif
-  bool ret = ioBufBatch.write(std::move(packetBuf), encodedSize);
-  if (ret) {
-    // update stats and connection
-    QUIC_STATS(connection.statsCallback, onWrite, encodedSize);
-    QUIC_STATS(connection.statsCallback, onPacketSent);
+  pendingPackets.requests.push_back(AeadEncryptRequest{
+      std::move(unencrypted), packet->header.get(), packetNum});
+  pendingPackets.headerForms.push_back(packet->packet.header.getHeaderForm());
+  pendingPackets.headers.push_back(std::move(packet->header));
+  // Nothing has been written yet, a failed write is reported by
+  // encryptAndWritePendingPackets().
+  return DataPathResult::makeWriteResult(true, std::move(result), encodedSize);
+}
+
+/**
+ * Undoes updateConnection() for a packet that was built but never handed to
+ * the socket. Its data is queued to be sent again, like for a lost packet,
+ * rather than waiting for loss detection to find it missing.
+ */
+void removeUnwrittenPacket(
+    QuicConnectionStateBase& connection,
+    PacketNumberSpace pnSpace,
+    PacketNum packetNum,
+    uint32_t encodedSize) {
+  connection.lossState.totalBytesSent -= encodedSize;
+  auto packetIt = std::find_if(
+      connection.outstandings.packets.rbegin(),
+      connection.outstandings.packets.rend(),
+      [&](const auto& packet) {
+        return packet.packetNum == packetNum &&
+            packet.packetNumberSpace == pnSpace;
+      });
+  if (packetIt == connection.outstandings.packets.rend()) {
+    // Not retransmittable, so it was never outstanding.
+    return;
   }
-  return DataPathResult::makeWriteResult(ret, std::move(result), encodedSize);
+  auto& pkt = *packetIt;
+  if (pkt.associatedEvent) {
+    // A clone, the data stays with the packet it was cloned from.
+    DCHECK_GT(connection.outstandings.clonedPacketsCount, 0);
+    --connection.outstandings.clonedPacketsCount;
+  } else {
+    markPacketLoss(connection, pkt.packet, false /* processed */);
+    if (pkt.isHandshake) {
+      if (pnSpace == PacketNumberSpace::Initial) {
+        CHECK(connection.outstandings.initialPacketsCount);
+        --connection.outstandings.initialPacketsCount;
+      } else {
+        CHECK(connection.outstandings.handshakePacketsCount);
+        --connection.outstandings.handshakePacketsCount;
+      }
+    }
+  }
+  if (connection.congestionController) {
+    connection.congestionController->onRemoveBytesFromInflight(
+        pkt.encodedSize);
+  }
+  connection.outstandings.packets.erase(std::next(packetIt).base());
+}
+
+/**
+ * Encrypts the packets queued by iobufChainBasedBuildSchedule() and writes them
+ * to ioBufBatch in the order they were built. Returns false if a write failed,
+ * the packets after the failed one are dropped and taken back out of the
+ * outstanding packets, since updateConnection() registered them when they
+ * were built.
+ */
+bool encryptAndWritePendingPackets(
+    QuicConnectionStateBase& connection,
+    PacketNumberSpace pnSpace,
+    PendingPackets& pendingPackets,
+    IOBufQuicBatch& ioBufBatch,
+    const Aead& aead,
+    const PacketNumberCipher& headerCipher) {
+  auto numPackets = pendingPackets.size();
+  if (numPackets == 0) {
+    return true;
+  }
+  aead.inplaceEncryptBatch(pendingPackets.requests);
+
+  auto& samples = pendingPackets.samples;
+  auto& masks = pendingPackets.masks;
+  samples.resize(numPackets);
+  masks.resize(numPackets);
+  for (size_t i = 0; i < numPackets; i++) {
+    auto& packetBuf = pendingPackets.requests[i].buf;
+    const auto& header = pendingPackets.headers[i];
+    auto headerLen = header->length();
+    DCHECK(packetBuf->headroom() == headerLen);
+    CHECK(!packetBuf->isChained());
+    packetBuf->prepend(headerLen);
+    memcpy(packetBuf->writableData(), header->data(), headerLen);
+    samples[i] = getHeaderProtectionSample(
+        *header->data(),
+        packetBuf->data() + headerLen,
+        packetBuf->length() - headerLen);
+  }
+  headerCipher.masks(folly::range(samples), folly::range(masks));
+
+  bool ret = true;
+  size_t i = 0;
+  for (; i < numPackets && ret; i++) {
+    auto& packetBuf = pendingPackets.requests[i].buf;
+    auto headerLen = pendingPackets.headers[i]->length();
+    auto packetNumberLength = parsePacketNumberLength(*packetBuf->data());
+    folly::MutableByteRange initialByteRange(packetBuf->writableData(), 1);
+    folly::MutableByteRange packetNumByteRange(
+        packetBuf->writableData() + headerLen - packetNumberLength,
+        packetNumberLength);
+    if (pendingPackets.headerForms[i] == HeaderForm::Short) {
+      headerCipher.encryptShortHeaderWithMask(
+          masks[i], initialByteRange, packetNumByteRange);
+    } else {
+      headerCipher.encryptLongHeaderWithMask(
+          masks[i], initialByteRange, packetNumByteRange);
+    }
+    auto encodedSize = packetBuf->length();
+    ret = ioBufBatch.write(std::move(packetBuf), encodedSize);
+    if (ret) {
+      // update stats and connection
+      QUIC_STATS(connection.statsCallback, onWrite, encodedSize);
+      QUIC_STATS(connection.statsCallback, onPacketSent);
+    }
+  }
+  // The packet whose write failed is treated as lost in the network, like on
+  // the other data paths, the ones after it never reached the socket.
+  for (; i < numPackets; i++) {
+    const auto& request = pendingPackets.requests[i];
+    removeUnwrittenPacket(
+        connection,
+        pnSpace,
+        request.seqNum,
+        folly::to<uint32_t>(request.buf->length()));
+  }
+  pendingPackets.clear();
+  return ret;
 }
 
 } // namespace
@@ -383,7 +532,7 @@ void handleNewStreamDataWritten(
             .emplace(
                 std::piecewise_construct,
                 std::forward_as_tuple(originalOffset),
-                std::forward_as_tuple(std::make_unique<StreamBuffer>(
+                std::forward_as_tuple(conn.streamBufferPool.get(
                     std::move(bufWritten), originalOffset, frameFin)))
             .second);
 }
@@ -413,7 +562,7 @@ void handleRetransmissionWritten(
             .emplace(
                 std::piecewise_construct,
                 std::forward_as_tuple(frameOffset),
-                std::forward_as_tuple(std::make_unique<StreamBuffer>(
+                std::forward_as_tuple(conn.streamBufferPool.get(
                     std::move(bufWritten), frameOffset, frameFin)))
             .second);
 }
@@ -642,6 +791,12 @@ void updateConnection(
         // 2. Of course we do not want to retransmit the ACK frames.
         break;
       }
+      case QuicWriteFrame::Type::DatagramFrame_E:
+        // Datagrams are never retransmitted, but the packets carrying them
+        // are ack-eliciting and congestion controlled, so they are tracked
+        // like retransmittable packets.
+        retransmittable = true;
+        break;
       default:
         retransmittable = true;
     }
@@ -676,8 +831,7 @@ void updateConnection(
           conn.outstandings.packets.rbegin(),
           conn.outstandings.packets.rend(),
           [packetNum](const auto& packetWithTime) {
-            return packetWithTime.packet.header.getPacketSequenceNum() <
-                packetNum;
+            return packetWithTime.packetNum < packetNum;
           })
           .base();
   auto& pkt = *conn.outstandings.packets.emplace(
@@ -1136,13 +1290,7 @@ void encryptPacketHeader(
     const PacketNumberCipher& headerCipher) {
   // Header encryption.
   auto packetNumberLength = parsePacketNumberLength(*header);
-  Sample sample;
-  size_t sampleBytesToUse = kMaxPacketNumEncodingSize - packetNumberLength;
-  // If there were less than 4 bytes in the packet number, some of the payload
-  // bytes will also be skipped during sampling.
-  CHECK_GE(bodyLen, sampleBytesToUse + sample.size());
-  encryptedBody += sampleBytesToUse;
-  memcpy(sample.data(), encryptedBody, sample.size());
+  Sample sample = getHeaderProtectionSample(*header, encryptedBody, bodyLen);
 
   folly::MutableByteRange initialByteRange(header, 1);
   folly::MutableByteRange packetNumByteRange(
@@ -1212,7 +1360,34 @@ uint64_t writeConnectionDataToSocket(
         Clock::now() - writeLoopBeginTime < connection.lossState.srtt /
             connection.transportSettings.writeLimitRttFraction;
   };
-  while (scheduler.hasData() && ioBufBatch.getPktSent() < packetLimit &&
+  // The chained memory data path builds up to a batch worth of packets before
+  // encrypting them, the continuous memory one encrypts every packet in the
+  // shared buffer before the next one is built.
+  bool useChainedMemory =
+      connection.transportSettings.dataPathType == DataPathType::ChainedMemory;
+  size_t encryptionBatchSize = connection.transportSettings.batchingMode ==
+          quic::QuicBatchingMode::BATCHING_MODE_NONE
+      ? 1
+      : connection.transportSettings.maxBatchSize;
+  PendingPackets pendingPackets;
+  auto writePendingPackets = [&]() -> bool {
+    if (!encryptAndWritePendingPackets(
+            connection,
+            pnSpace,
+            pendingPackets,
+            ioBufBatch,
+            aead,
+            headerCipher)) {
+      if (connection.loopDetectorCallback) {
+        connection.writeDebugState.noWriteReason =
+            NoWriteReason::SOCKET_FAILURE;
+      }
+      return false;
+    }
+    return true;
+  };
+  while (scheduler.hasData() &&
+         ioBufBatch.getPktSent() + pendingPackets.size() < packetLimit &&
          timeLimitHelper()) {
     auto packetNum = getNextPacketNum(connection, pnSpace);
     auto header = builder(srcConnId, dstConnId, packetNum, version, token);
@@ -1225,24 +1400,32 @@ uint64_t writeConnectionDataToSocket(
       writableBytes -= cipherOverhead;
     }
 
-    // TODO: Select a different DataPathFunc based on TransportSettings
-    const auto& dataPlainFunc =
-        connection.transportSettings.dataPathType == DataPathType::ChainedMemory
-        ? iobufChainBasedBuildScheduleEncrypt
-        : continuousMemoryBuildScheduleEncrypt;
-    auto ret = dataPlainFunc(
-        connection,
-        std::move(header),
-        pnSpace,
-        packetNum,
-        cipherOverhead,
-        scheduler,
-        writableBytes,
-        ioBufBatch,
-        aead,
-        headerCipher);
+    auto ret = useChainedMemory
+        ? iobufChainBasedBuildSchedule(
+              connection,
+              std::move(header),
+              pnSpace,
+              packetNum,
+              cipherOverhead,
+              scheduler,
+              writableBytes,
+              pendingPackets)
+        : continuousMemoryBuildScheduleEncrypt(
+              connection,
+              std::move(header),
+              pnSpace,
+              packetNum,
+              cipherOverhead,
+              scheduler,
+              writableBytes,
+              ioBufBatch,
+              aead,
+              headerCipher);
 
     if (!ret.buildSuccess) {
+      if (writePendingPackets()) {
+        ioBufBatch.flush();
+      }
       return ioBufBatch.getPktSent();
     }
 
@@ -1268,8 +1451,15 @@ uint64_t writeConnectionDataToSocket(
       }
       return ioBufBatch.getPktSent();
     }
+    if (pendingPackets.size() >= encryptionBatchSize &&
+        !writePendingPackets()) {
+      return ioBufBatch.getPktSent();
+    }
   }
 
+  if (!writePendingPackets()) {
+    return ioBufBatch.getPktSent();
+  }
   ioBufBatch.flush();
   if (connection.transportSettings.dataPathType ==
       DataPathType::ContinuousMemory) {
@@ -1462,6 +1652,9 @@ WriteDataReason hasNonAckDataToWrite(const QuicConnectionStateBase& conn) {
   if (conn.pendingEvents.sendPing) {
     return WriteDataReason::PING;
   }
+  if (!conn.datagramState.writeBuffer.empty() && conn.oneRttWriteCipher) {
+    return WriteDataReason::DATAGRAM;
+  }
   return WriteDataReason::NO_WRITE;
 }
 
@@ -1489,8 +1682,8 @@ void implicitAckCryptoStream(
   implicitAck.ackDelay = 0ms;
   implicitAck.implicit = true;
   for (const auto& op : conn.outstandings.packets) {
-    if (op.packet.header.getPacketNumberSpace() == packetNumSpace) {
-      ackBlocks.insert(op.packet.header.getPacketSequenceNum());
+    if (op.packetNumberSpace == packetNumSpace) {
+      ackBlocks.insert(op.packetNum);
     }
   }
   if (ackBlocks.empty()) {
@@ -1559,6 +1752,14 @@ void handshakeConfirmed(QuicConnectionStateBase& conn) {
   conn.readCodec->setHandshakeReadCipher(nullptr);
   conn.readCodec->setHandshakeHeaderCipher(nullptr);
   implicitAckCryptoStream(conn, EncryptionLevel::Handshake);
+  // Without the ciphers nothing more is read at these levels, so drop what is
+  // buffered along with the memory the buffers kept.
+  for (auto encryptionLevel :
+       {EncryptionLevel::Initial, EncryptionLevel::Handshake}) {
+    auto cryptoStream = getCryptoStream(*conn.cryptoState, encryptionLevel);
+    cryptoStream->readBuffer.clear();
+    cryptoStream->compactBuffers();
+  }
 }
 
 } // namespace quic
@@ -130,6 +130,15 @@ class MockQuicSocket : public QuicSocket {
       return std::pair<Buf, bool>(Buf(res.value().first), res.value().second);
     }
   }
+  folly::Expected<std::pair<std::vector<Buf>, bool>, LocalErrorCode>
+  readChunks(StreamId id, size_t maxRead) override {
+    auto res = read(id, maxRead);
+    if (res.hasError()) {
+      return folly::makeUnexpected(res.error());
+    }
+    return std::make_pair(
+        unchainBuf(std::move(res.value().first)), res.value().second);
+  }
   using ReadResult =
       folly::Expected<std::pair<folly::IOBuf*, bool>, LocalErrorCode>;
   MOCK_METHOD2(readNaked, ReadResult(StreamId, size_t));
@@ -213,11 +222,32 @@ class MockQuicSocket : public QuicSocket {
       maybeResetStreamFromReadError,
       folly::Expected<folly::Unit, LocalErrorCode>(StreamId, QuicErrorCode));
   MOCK_METHOD2(sendPing, void(PingCallback*, std::chrono::milliseconds));
+  MOCK_METHOD1(
+      setDatagramCallback,
+      folly::Expected<folly::Unit, LocalErrorCode>(DatagramCallback*));
+  MOCK_CONST_METHOD0(getDatagramSizeLimit, uint16_t());
+  WriteResult writeDatagram(Buf buf) override {
+    SharedBuf sharedBuf(buf.release());
+    return writeDatagram(sharedBuf);
+  }
+  MOCK_METHOD1(writeDatagram, WriteResult(SharedBuf));
+  MOCK_METHOD1(
+      readDatagrams,
+      folly::Expected<std::vector<ReadDatagram>, LocalErrorCode>(size_t));
   MOCK_CONST_METHOD0(getState, const QuicConnectionStateBase*());
   MOCK_METHOD0(isDetachable, bool());
   MOCK_METHOD1(attachEventBase, void(folly::EventBase*));
   MOCK_METHOD0(detachEventBase, void());
   MOCK_METHOD1(setControlStream, folly::Optional<LocalErrorCode>(StreamId));
+  MOCK_METHOD3(
+      setStreamPriority,
+      folly::Expected<folly::Unit, LocalErrorCode>(
+          StreamId,
+          PriorityLevel,
+          bool));
+  MOCK_METHOD1(
+      getStreamPriority,
+      folly::Expected<Priority, LocalErrorCode>(StreamId));
 
   MOCK_METHOD2(
       setPeekCallback,
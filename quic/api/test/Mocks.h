@@ -296,6 +296,8 @@ class MockQuicTransport : public QuicServerTransport {
   GMOCK_METHOD1_(, noexcept, , setConnectionIdAlgo, void(ConnectionIdAlgo*));
 
   MOCK_METHOD1(setBufAccessor, void(BufAccessor*));
+
+  MOCK_METHOD1(setZeroCopySendTracker, void(ZeroCopySendTracker*));
 };
 
 class MockLoopDetectorCallback : public LoopDetectorCallback {
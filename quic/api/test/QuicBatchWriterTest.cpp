@@ -10,8 +10,10 @@
 
 #include <folly/io/async/test/MockAsyncUDPSocket.h>
 #include <gtest/gtest.h>
+#include <quic/common/SocketUtil.h>
 #include <quic/fizz/server/handshake/FizzServerQuicHandshakeContext.h>
 #include <quic/server/state/ServerStateMachine.h>
+#include <quic/state/test/Mocks.h>
 
 using namespace testing;
 
@@ -628,6 +630,120 @@ TEST_P(QuicBatchWriterTest, InplaceWriterBufResidueCheck) {
   EXPECT_EQ(0, rawBuf->headroom());
 }
 
+TEST_P(QuicBatchWriterTest, TxTimeWriterSchedulesBursts) {
+  bool useThreadLocal = GetParam();
+  folly::EventBase evb;
+  folly::AsyncUDPSocket sock(&evb);
+  sock.setReuseAddr(false);
+  sock.bind(folly::SocketAddress("127.0.0.1", 0));
+  folly::AsyncUDPSocket peer(&evb);
+  peer.bind(folly::SocketAddress("127.0.0.1", 0));
+  if (!applyTxTimeSocketOption(sock)) {
+    GTEST_SKIP() << "SO_TXTIME is not supported";
+  }
+
+  conn_.transportSettings.pacingEnabled = true;
+  conn_.transportSettings.pacingWithTxTime = true;
+  conn_.canBePaced = true;
+  auto mockPacer = std::make_unique<quic::test::MockPacer>();
+  EXPECT_CALL(*mockPacer, getPacingRate())
+      .WillRepeatedly(Return(
+          PacingRate::Builder().setInterval(1ms).setBurstSize(2).build()));
+  conn_.pacer = std::move(mockPacer);
+
+  auto batchWriter = quic::BatchWriterFactory::makeBatchWriter(
+      sock,
+      quic::QuicBatchingMode::BATCHING_MODE_GSO,
+      kBatchNum * 2,
+      useThreadLocal,
+      quic::kDefaultThreadLocalDelay,
+      DataPathType::ChainedMemory,
+      conn_);
+  ASSERT_NE(
+      nullptr, dynamic_cast<TxTimePacketBatchWriter*>(batchWriter.get()));
+
+  auto start = Clock::now();
+  std::string strTest(kStrLen, 'A');
+  for (size_t i = 0; i < 5; i++) {
+    EXPECT_FALSE(batchWriter->append(
+        folly::IOBuf::copyBuffer(strTest),
+        kStrLen,
+        peer.address(),
+        nullptr));
+  }
+  EXPECT_EQ(5 * kStrLen, batchWriter->size());
+  // Three bursts of up to two packets, one pacing interval apart.
+  EXPECT_GE(conn_.nextTxTimeDeparture, start + 3ms);
+  EXPECT_LT(conn_.nextTxTimeDeparture, Clock::now() + 3ms);
+  EXPECT_EQ(5 * kStrLen, batchWriter->write(sock, peer.address()));
+}
+
+TEST_P(QuicBatchWriterTest, UnmarkedWriterAfterEcnValidationFails) {
+  bool useThreadLocal = GetParam();
+  folly::EventBase evb;
+  folly::AsyncUDPSocket sock(&evb);
+  sock.setReuseAddr(false);
+  sock.bind(folly::SocketAddress("127.0.0.1", 0));
+  applyEcnSocketOptions(sock, AF_INET, ECNCodepoint::ECT0, false);
+  folly::AsyncUDPSocket peer(&evb);
+  peer.bind(folly::SocketAddress("127.0.0.1", 0));
+  applyEcnSocketOptions(peer, AF_INET, ECNCodepoint::NotECT, true);
+
+  conn_.transportSettings.ecnMarking = ECNCodepoint::ECT0;
+  auto makeWriter = [&]() {
+    return quic::BatchWriterFactory::makeBatchWriter(
+        sock,
+        quic::QuicBatchingMode::BATCHING_MODE_GSO,
+        kBatchNum,
+        useThreadLocal,
+        quic::kDefaultThreadLocalDelay,
+        DataPathType::ChainedMemory,
+        conn_);
+  };
+  EXPECT_EQ(
+      nullptr, dynamic_cast<UnmarkedPacketBatchWriter*>(makeWriter().get()));
+  conn_.ecnState.validationFailed = true;
+  auto batchWriter = makeWriter();
+  ASSERT_NE(
+      nullptr, dynamic_cast<UnmarkedPacketBatchWriter*>(batchWriter.get()));
+
+  std::string strTest(kStrLen, 'A');
+  for (size_t i = 0; i < kBatchNum - 1; i++) {
+    EXPECT_FALSE(batchWriter->append(
+        folly::IOBuf::copyBuffer(strTest),
+        kStrLen,
+        peer.address(),
+        nullptr));
+  }
+  EXPECT_TRUE(batchWriter->append(
+      folly::IOBuf::copyBuffer(strTest), kStrLen, peer.address(), nullptr));
+  EXPECT_EQ(kBatchNum * kStrLen, batchWriter->write(sock, peer.address()));
+
+  // The datagrams arrive without the marking of the socket.
+  for (size_t i = 0; i < kBatchNum; i++) {
+    char data[kStrLen];
+    struct iovec iov = {data, sizeof(data)};
+    char control[kRecvCmsgSpace] = {};
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    ASSERT_EQ(
+        kStrLen,
+        folly::netops::recvmsg(peer.getNetworkSocket(), &msg, MSG_DONTWAIT));
+    folly::Optional<ECNCodepoint> ecn;
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+         cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+      if (auto cmsgEcn = getEcnFromCmsg(*cmsg)) {
+        ecn = cmsgEcn;
+      }
+    }
+    EXPECT_EQ(ecn, ECNCodepoint::NotECT);
+  }
+}
+
 INSTANTIATE_TEST_CASE_P(
     QuicBatchWriterTest,
     QuicBatchWriterTest,
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <folly/Benchmark.h>
+#include <folly/init/Init.h>
+
+#include <quic/api/QuicPacketScheduler.h>
+#include <quic/common/test/TestUtils.h>
+#include <quic/fizz/server/handshake/FizzServerQuicHandshakeContext.h>
+#include <quic/server/state/ServerStateMachine.h>
+#include <quic/state/QuicStreamFunctions.h>
+
+using namespace quic;
+using namespace quic::test;
+
+namespace {
+
+std::unique_ptr<QuicServerConnectionState> makeConnWithWritableStreams(
+    size_t numStreams,
+    size_t numUrgencies) {
+  auto conn = std::make_unique<QuicServerConnectionState>(
+      FizzServerQuicHandshakeContext::Builder().build());
+  conn->streamManager->setMaxLocalBidirectionalStreams(numStreams);
+  conn->flowControlState.peerAdvertisedMaxOffset =
+      std::numeric_limits<uint32_t>::max();
+  conn->flowControlState.peerAdvertisedInitialMaxStreamOffsetBidiRemote =
+      std::numeric_limits<uint32_t>::max();
+  auto data = folly::IOBuf::create(kDefaultUDPSendPacketLen * 4);
+  data->append(kDefaultUDPSendPacketLen * 4);
+  for (size_t i = 0; i < numStreams; i++) {
+    auto stream = conn->streamManager->createNextBidirectionalStream().value();
+    conn->streamManager->setStreamPriority(
+        stream->id, static_cast<PriorityLevel>(i % numUrgencies), i % 2 == 0);
+    writeDataToQuicStream(*stream, data->clone(), false);
+  }
+  return conn;
+}
+
+void writeStreamsBench(uint32_t iters, size_t numStreams, size_t numUrgencies) {
+  std::unique_ptr<QuicServerConnectionState> conn;
+  BENCHMARK_SUSPEND {
+    conn = makeConnWithWritableStreams(numStreams, numUrgencies);
+  }
+  StreamFrameScheduler scheduler(*conn);
+  for (uint32_t i = 0; i < iters; i++) {
+    ShortHeader header(ProtectionType::KeyPhaseZero, getTestConnectionId(), i);
+    RegularQuicPacketBuilder builder(
+        conn->udpSendPacketLen, std::move(header), 0);
+    builder.encodePacketHeader();
+    scheduler.writeStreams(builder);
+    folly::doNotOptimizeAway(std::move(builder).buildPacket());
+  }
+}
+
+void priorityUpdateBench(uint32_t iters, size_t numStreams) {
+  std::unique_ptr<QuicServerConnectionState> conn;
+  BENCHMARK_SUSPEND {
+    conn = makeConnWithWritableStreams(numStreams, kDefaultPriorityLevels);
+  }
+  auto& writableStreams = conn->streamManager->writableStreams();
+  for (uint32_t i = 0; i < iters; i++) {
+    StreamId id = (i % numStreams) * 4 + 1;
+    writableStreams.insertOrUpdate(
+        id,
+        Priority(
+            static_cast<PriorityLevel>(i % kDefaultPriorityLevels),
+            i % 3 == 0));
+  }
+}
+
+} // namespace
+
+BENCHMARK_NAMED_PARAM(writeStreamsBench, 10_streams_1_level, 10, 1)
+BENCHMARK_NAMED_PARAM(writeStreamsBench, 1000_streams_1_level, 1000, 1)
+BENCHMARK_NAMED_PARAM(writeStreamsBench, 50000_streams_1_level, 50000, 1)
+BENCHMARK_NAMED_PARAM(writeStreamsBench, 10_streams_8_levels, 10, 8)
+BENCHMARK_NAMED_PARAM(writeStreamsBench, 1000_streams_8_levels, 1000, 8)
+BENCHMARK_NAMED_PARAM(writeStreamsBench, 50000_streams_8_levels, 50000, 8)
+BENCHMARK_DRAW_LINE();
+BENCHMARK_PARAM(priorityUpdateBench, 10)
+BENCHMARK_PARAM(priorityUpdateBench, 1000)
+BENCHMARK_PARAM(priorityUpdateBench, 50000)
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -1067,7 +1067,8 @@ TEST_F(QuicPacketSchedulerTest, StreamFrameSchedulerAllFit) {
       folly::IOBuf::copyBuffer("some data"),
       false);
   scheduler.writeStreams(builder);
-  EXPECT_EQ(conn.schedulingState.nextScheduledStream, 0);
+  EXPECT_EQ(
+      conn.streamManager->writableStreams().getNextScheduledStream(), 0);
 }
 
 TEST_F(QuicPacketSchedulerTest, StreamFrameSchedulerRoundRobin) {
@@ -1111,9 +1112,10 @@ TEST_F(QuicPacketSchedulerTest, StreamFrameSchedulerRoundRobin) {
       folly::IOBuf::copyBuffer("some data"),
       false);
   // Force the wraparound initially.
-  conn.schedulingState.nextScheduledStream = stream3 + 8;
+  conn.streamManager->writableStreams().setNextScheduledStream(stream3 + 8);
   scheduler.writeStreams(builder);
-  EXPECT_EQ(conn.schedulingState.nextScheduledStream, 4);
+  EXPECT_EQ(
+      conn.streamManager->writableStreams().getNextScheduledStream(), 4);
 
   // Should write frames for stream2, stream3, followed by stream1 again.
   NiceMock<MockQuicPacketBuilder> builder2;
@@ -1176,9 +1178,10 @@ TEST_F(QuicPacketSchedulerTest, StreamFrameSchedulerRoundRobinStreamPerPacket) {
       folly::IOBuf::copyBuffer("some data"),
       false);
   // Force the wraparound initially.
-  conn.schedulingState.nextScheduledStream = stream3 + 8;
+  conn.streamManager->writableStreams().setNextScheduledStream(stream3 + 8);
   scheduler.writeStreams(builder1);
-  EXPECT_EQ(conn.schedulingState.nextScheduledStream, 4);
+  EXPECT_EQ(
+      conn.streamManager->writableStreams().getNextScheduledStream(), 4);
 
   // Should write frames for stream2, stream3, followed by stream1 again.
   NiceMock<MockQuicPacketBuilder> builder2;
@@ -1255,9 +1258,10 @@ TEST_F(QuicPacketSchedulerTest, StreamFrameSchedulerRoundRobinControl) {
       folly::IOBuf::copyBuffer("some data"),
       false);
   // Force the wraparound initially.
-  conn.schedulingState.nextScheduledStream = stream4 + 8;
+  conn.streamManager->writableStreams().setNextScheduledStream(stream4 + 8);
   scheduler.writeStreams(builder);
-  EXPECT_EQ(conn.schedulingState.nextScheduledStream, stream3);
+  EXPECT_EQ(
+      conn.streamManager->writableStreams().getNextScheduledStream(), stream3);
   EXPECT_EQ(conn.schedulingState.nextScheduledControlStream, stream2);
 
   // Should write frames for stream2, stream4, followed by stream 3 then 1.
@@ -1282,7 +1286,8 @@ TEST_F(QuicPacketSchedulerTest, StreamFrameSchedulerRoundRobinControl) {
   ASSERT_TRUE(frames[3].asWriteStreamFrame());
   EXPECT_EQ(*frames[3].asWriteStreamFrame(), f4);
 
-  EXPECT_EQ(conn.schedulingState.nextScheduledStream, stream3);
+  EXPECT_EQ(
+      conn.streamManager->writableStreams().getNextScheduledStream(), stream3);
   EXPECT_EQ(conn.schedulingState.nextScheduledControlStream, stream2);
 }
 
@@ -1306,7 +1311,8 @@ TEST_F(QuicPacketSchedulerTest, StreamFrameSchedulerOneStream) {
   auto stream1 = conn.streamManager->createNextBidirectionalStream().value();
   writeDataToQuicStream(*stream1, folly::IOBuf::copyBuffer("some data"), false);
   scheduler.writeStreams(builder);
-  EXPECT_EQ(conn.schedulingState.nextScheduledStream, 0);
+  EXPECT_EQ(
+      conn.streamManager->writableStreams().getNextScheduledStream(), 0);
 }
 
 TEST_F(QuicPacketSchedulerTest, StreamFrameSchedulerRemoveOne) {
@@ -1344,13 +1350,267 @@ TEST_F(QuicPacketSchedulerTest, StreamFrameSchedulerRemoveOne) {
   // Manually remove a stream and set the next scheduled to that stream.
   builder.frames_.clear();
   conn.streamManager->removeWritable(*conn.streamManager->findStream(stream2));
-  conn.schedulingState.nextScheduledStream = stream2;
+  conn.streamManager->writableStreams().setNextScheduledStream(stream2);
   scheduler.writeStreams(builder);
   ASSERT_EQ(builder.frames_.size(), 1);
   ASSERT_TRUE(builder.frames_[0].asWriteStreamFrame());
   EXPECT_EQ(*builder.frames_[0].asWriteStreamFrame(), f1);
 }
 
+TEST_F(QuicPacketSchedulerTest, StreamFrameSchedulerUrgentStreamFirst) {
+  QuicClientConnectionState conn(
+      FizzClientQuicHandshakeContext::Builder().build());
+  conn.streamManager->setMaxLocalBidirectionalStreams(10);
+  conn.flowControlState.peerAdvertisedMaxOffset = 100000;
+  conn.flowControlState.peerAdvertisedInitialMaxStreamOffsetBidiRemote = 100000;
+  StreamFrameScheduler scheduler(conn);
+  auto bulkStream =
+      conn.streamManager->createNextBidirectionalStream().value()->id;
+  auto urgentStream =
+      conn.streamManager->createNextBidirectionalStream().value()->id;
+  conn.streamManager->setStreamPriority(urgentStream, 0, false);
+  auto largeBuf = folly::IOBuf::createChain(conn.udpSendPacketLen * 2, 4096);
+  auto curBuf = largeBuf.get();
+  do {
+    curBuf->append(curBuf->capacity());
+    curBuf = curBuf->next();
+  } while (curBuf != largeBuf.get());
+  writeDataToQuicStream(
+      *conn.streamManager->findStream(bulkStream), std::move(largeBuf), false);
+  writeDataToQuicStream(
+      *conn.streamManager->findStream(urgentStream),
+      folly::IOBuf::copyBuffer("some data"),
+      false);
+
+  // The bulk stream has the lower id, but the urgent stream goes first.
+  ShortHeader shortHeader(
+      ProtectionType::KeyPhaseZero,
+      getTestConnectionId(),
+      getNextPacketNum(conn, PacketNumberSpace::AppData));
+  RegularQuicPacketBuilder builder(
+      conn.udpSendPacketLen,
+      std::move(shortHeader),
+      conn.ackStates.appDataAckState.largestAckedByPeer.value_or(0));
+  builder.encodePacketHeader();
+  scheduler.writeStreams(builder);
+  auto packet = std::move(builder).buildPacket().packet;
+  ASSERT_EQ(packet.frames.size(), 2);
+  ASSERT_TRUE(packet.frames[0].asWriteStreamFrame());
+  EXPECT_EQ(packet.frames[0].asWriteStreamFrame()->streamId, urgentStream);
+  ASSERT_TRUE(packet.frames[1].asWriteStreamFrame());
+  EXPECT_EQ(packet.frames[1].asWriteStreamFrame()->streamId, bulkStream);
+}
+
+TEST_F(QuicPacketSchedulerTest, StreamFrameSchedulerUrgentStreamBlocksLower) {
+  QuicClientConnectionState conn(
+      FizzClientQuicHandshakeContext::Builder().build());
+  conn.streamManager->setMaxLocalBidirectionalStreams(10);
+  conn.flowControlState.peerAdvertisedMaxOffset = 100000;
+  conn.flowControlState.peerAdvertisedInitialMaxStreamOffsetBidiRemote = 100000;
+  StreamFrameScheduler scheduler(conn);
+  auto lowStream =
+      conn.streamManager->createNextBidirectionalStream().value()->id;
+  auto urgentStream =
+      conn.streamManager->createNextBidirectionalStream().value()->id;
+  conn.streamManager->setStreamPriority(lowStream, kDefaultMaxPriority, true);
+  conn.streamManager->setStreamPriority(urgentStream, 1, true);
+  auto largeBuf = folly::IOBuf::createChain(conn.udpSendPacketLen * 2, 4096);
+  auto curBuf = largeBuf.get();
+  do {
+    curBuf->append(curBuf->capacity());
+    curBuf = curBuf->next();
+  } while (curBuf != largeBuf.get());
+  writeDataToQuicStream(
+      *conn.streamManager->findStream(lowStream),
+      folly::IOBuf::copyBuffer("some data"),
+      false);
+  writeDataToQuicStream(
+      *conn.streamManager->findStream(urgentStream),
+      std::move(largeBuf),
+      false);
+
+  ShortHeader shortHeader(
+      ProtectionType::KeyPhaseZero,
+      getTestConnectionId(),
+      getNextPacketNum(conn, PacketNumberSpace::AppData));
+  RegularQuicPacketBuilder builder(
+      conn.udpSendPacketLen,
+      std::move(shortHeader),
+      conn.ackStates.appDataAckState.largestAckedByPeer.value_or(0));
+  builder.encodePacketHeader();
+  scheduler.writeStreams(builder);
+  auto packet = std::move(builder).buildPacket().packet;
+  ASSERT_EQ(packet.frames.size(), 1);
+  ASSERT_TRUE(packet.frames[0].asWriteStreamFrame());
+  EXPECT_EQ(packet.frames[0].asWriteStreamFrame()->streamId, urgentStream);
+}
+
+TEST_F(QuicPacketSchedulerTest, StreamFrameSchedulerIncrementalFairness) {
+  QuicClientConnectionState conn(
+      FizzClientQuicHandshakeContext::Builder().build());
+  conn.streamManager->setMaxLocalBidirectionalStreams(10);
+  conn.flowControlState.peerAdvertisedMaxOffset = 100000;
+  conn.flowControlState.peerAdvertisedInitialMaxStreamOffsetBidiRemote = 100000;
+  StreamFrameScheduler scheduler(conn);
+  std::vector<StreamId> streams;
+  for (int i = 0; i < 3; i++) {
+    auto stream = conn.streamManager->createNextBidirectionalStream().value();
+    conn.streamManager->setStreamPriority(stream->id, 2, true);
+    auto largeBuf = folly::IOBuf::createChain(conn.udpSendPacketLen * 2, 4096);
+    auto curBuf = largeBuf.get();
+    do {
+      curBuf->append(curBuf->capacity());
+      curBuf = curBuf->next();
+    } while (curBuf != largeBuf.get());
+    writeDataToQuicStream(*stream, std::move(largeBuf), false);
+    streams.push_back(stream->id);
+  }
+
+  // Every stream fills a packet on its own, so consecutive packets should
+  // rotate through all of them.
+  std::vector<StreamId> scheduled;
+  for (int i = 0; i < 6; i++) {
+    ShortHeader shortHeader(
+        ProtectionType::KeyPhaseZero,
+        getTestConnectionId(),
+        getNextPacketNum(conn, PacketNumberSpace::AppData));
+    RegularQuicPacketBuilder builder(
+        conn.udpSendPacketLen,
+        std::move(shortHeader),
+        conn.ackStates.appDataAckState.largestAckedByPeer.value_or(0));
+    builder.encodePacketHeader();
+    scheduler.writeStreams(builder);
+    auto packet = std::move(builder).buildPacket().packet;
+    ASSERT_EQ(packet.frames.size(), 1);
+    ASSERT_TRUE(packet.frames[0].asWriteStreamFrame());
+    scheduled.push_back(packet.frames[0].asWriteStreamFrame()->streamId);
+  }
+  std::vector<StreamId> expected = {
+      streams[0], streams[1], streams[2], streams[0], streams[1], streams[2]};
+  EXPECT_EQ(scheduled, expected);
+}
+
+TEST_F(QuicPacketSchedulerTest, StreamFrameSchedulerNonIncrementalSequential) {
+  QuicClientConnectionState conn(
+      FizzClientQuicHandshakeContext::Builder().build());
+  conn.streamManager->setMaxLocalBidirectionalStreams(10);
+  conn.flowControlState.peerAdvertisedMaxOffset = 100000;
+  conn.flowControlState.peerAdvertisedInitialMaxStreamOffsetBidiRemote = 100000;
+  StreamFrameScheduler scheduler(conn);
+  auto stream1 =
+      conn.streamManager->createNextBidirectionalStream().value()->id;
+  auto stream2 =
+      conn.streamManager->createNextBidirectionalStream().value()->id;
+  auto stream3 =
+      conn.streamManager->createNextBidirectionalStream().value()->id;
+  for (auto id : {stream1, stream2, stream3}) {
+    conn.streamManager->setStreamPriority(id, 2, false);
+  }
+  auto largeBuf = folly::IOBuf::createChain(conn.udpSendPacketLen * 2, 4096);
+  auto curBuf = largeBuf.get();
+  do {
+    curBuf->append(curBuf->capacity());
+    curBuf = curBuf->next();
+  } while (curBuf != largeBuf.get());
+  writeDataToQuicStream(
+      *conn.streamManager->findStream(stream1),
+      folly::IOBuf::copyBuffer("some data"),
+      false);
+  writeDataToQuicStream(
+      *conn.streamManager->findStream(stream2), std::move(largeBuf), false);
+  writeDataToQuicStream(
+      *conn.streamManager->findStream(stream3),
+      folly::IOBuf::copyBuffer("some data"),
+      false);
+
+  // The round robin position is not used for non-incremental streams.
+  conn.streamManager->writableStreams().setNextScheduledStream(
+      stream3, Priority(2, false));
+  for (int i = 0; i < 2; i++) {
+    ShortHeader shortHeader(
+        ProtectionType::KeyPhaseZero,
+        getTestConnectionId(),
+        getNextPacketNum(conn, PacketNumberSpace::AppData));
+    RegularQuicPacketBuilder builder(
+        conn.udpSendPacketLen,
+        std::move(shortHeader),
+        conn.ackStates.appDataAckState.largestAckedByPeer.value_or(0));
+    builder.encodePacketHeader();
+    scheduler.writeStreams(builder);
+    auto packet = std::move(builder).buildPacket().packet;
+    ASSERT_EQ(packet.frames.size(), 2);
+    ASSERT_TRUE(packet.frames[0].asWriteStreamFrame());
+    EXPECT_EQ(packet.frames[0].asWriteStreamFrame()->streamId, stream1);
+    ASSERT_TRUE(packet.frames[1].asWriteStreamFrame());
+    EXPECT_EQ(packet.frames[1].asWriteStreamFrame()->streamId, stream2);
+  }
+}
+
+TEST_F(QuicPacketSchedulerTest, StreamFrameSchedulerPriorityUpdate) {
+  QuicClientConnectionState conn(
+      FizzClientQuicHandshakeContext::Builder().build());
+  conn.streamManager->setMaxLocalBidirectionalStreams(10);
+  conn.flowControlState.peerAdvertisedMaxOffset = 100000;
+  conn.flowControlState.peerAdvertisedInitialMaxStreamOffsetBidiRemote = 100000;
+  StreamFrameScheduler scheduler(conn);
+  NiceMock<MockQuicPacketBuilder> builder;
+  auto stream1 =
+      conn.streamManager->createNextBidirectionalStream().value()->id;
+  auto stream2 =
+      conn.streamManager->createNextBidirectionalStream().value()->id;
+  writeDataToQuicStream(
+      *conn.streamManager->findStream(stream1),
+      folly::IOBuf::copyBuffer("some data"),
+      false);
+  writeDataToQuicStream(
+      *conn.streamManager->findStream(stream2),
+      folly::IOBuf::copyBuffer("some data"),
+      false);
+  // Move the already writable stream2 ahead of stream1.
+  EXPECT_TRUE(conn.streamManager->setStreamPriority(stream2, 0, true));
+  EXPECT_FALSE(conn.streamManager->setStreamPriority(stream2, 0, true));
+  EXPECT_EQ(conn.streamManager->writableStreams().size(), 2);
+  EXPECT_CALL(builder, remainingSpaceInPkt()).WillRepeatedly(Return(4096));
+  EXPECT_CALL(builder, appendFrame(_)).WillRepeatedly(Invoke([&](auto f) {
+    builder.frames_.push_back(f);
+  }));
+  scheduler.writeStreams(builder);
+  ASSERT_EQ(builder.frames_.size(), 2);
+  WriteStreamFrame f1(stream2, 0, 9, false);
+  WriteStreamFrame f2(stream1, 0, 9, false);
+  ASSERT_TRUE(builder.frames_[0].asWriteStreamFrame());
+  EXPECT_EQ(*builder.frames_[0].asWriteStreamFrame(), f1);
+  ASSERT_TRUE(builder.frames_[1].asWriteStreamFrame());
+  EXPECT_EQ(*builder.frames_[1].asWriteStreamFrame(), f2);
+}
+
+TEST_F(QuicPacketSchedulerTest, StreamFrameSchedulerManyStreamsPriority) {
+  QuicClientConnectionState conn(
+      FizzClientQuicHandshakeContext::Builder().build());
+  conn.streamManager->setMaxLocalBidirectionalStreams(20000);
+  conn.flowControlState.peerAdvertisedMaxOffset = 1000000;
+  conn.flowControlState.peerAdvertisedInitialMaxStreamOffsetBidiRemote = 100000;
+  StreamFrameScheduler scheduler(conn);
+  StreamId urgentStream = 0;
+  for (int i = 0; i < 10000; i++) {
+    auto stream = conn.streamManager->createNextBidirectionalStream().value();
+    writeDataToQuicStream(
+        *stream, folly::IOBuf::copyBuffer("some data"), false);
+    urgentStream = stream->id;
+  }
+  // The most recently opened stream jumps ahead of the other 9999.
+  conn.streamManager->setStreamPriority(urgentStream, 0, true);
+  NiceMock<MockQuicPacketBuilder> builder;
+  EXPECT_CALL(builder, remainingSpaceInPkt()).WillRepeatedly(Return(4096));
+  EXPECT_CALL(builder, appendFrame(_)).WillRepeatedly(Invoke([&](auto f) {
+    builder.frames_.push_back(f);
+  }));
+  scheduler.writeStreams(builder);
+  ASSERT_FALSE(builder.frames_.empty());
+  ASSERT_TRUE(builder.frames_[0].asWriteStreamFrame());
+  EXPECT_EQ(builder.frames_[0].asWriteStreamFrame()->streamId, urgentStream);
+}
+
 TEST_F(
     QuicPacketSchedulerTest,
     CloningSchedulerWithInplaceBuilderDoNotEncodeHeaderWithoutBuild) {
@@ -1434,6 +1694,86 @@ TEST_F(
   EXPECT_EQ(buf->length(), 0);
 }
 
+TEST_F(QuicPacketSchedulerTest, DatagramFramesBeforeStreamFrames) {
+  QuicClientConnectionState conn(
+      FizzClientQuicHandshakeContext::Builder().build());
+  conn.streamManager->setMaxLocalBidirectionalStreams(10);
+  conn.flowControlState.peerAdvertisedMaxOffset = 100000;
+  conn.flowControlState.peerAdvertisedInitialMaxStreamOffsetBidiRemote = 100000;
+  conn.datagramState.maxWriteFrameSize = kMaxDatagramFrameSize;
+  for (size_t i = 0; i < 3; i++) {
+    conn.datagramState.writeBuffer.emplace_back(
+        folly::IOBuf::copyBuffer("datagram"));
+  }
+  auto stream = conn.streamManager->createNextBidirectionalStream().value();
+  writeDataToQuicStream(*stream, folly::IOBuf::copyBuffer("some data"), false);
+
+  FrameScheduler scheduler =
+      std::move(FrameScheduler::Builder(
+                    conn,
+                    EncryptionLevel::AppData,
+                    PacketNumberSpace::AppData,
+                    "DatagramScheduler")
+                    .datagramFrames()
+                    .streamFrames())
+          .build();
+  EXPECT_TRUE(scheduler.hasData());
+  ShortHeader shortHeader(
+      ProtectionType::KeyPhaseZero,
+      getTestConnectionId(),
+      getNextPacketNum(conn, PacketNumberSpace::AppData));
+  RegularQuicPacketBuilder builder(
+      conn.udpSendPacketLen,
+      std::move(shortHeader),
+      conn.ackStates.appDataAckState.largestAckedByPeer.value_or(0));
+  auto result = scheduler.scheduleFramesForPacket(
+      std::move(builder), conn.udpSendPacketLen);
+  ASSERT_TRUE(result.packet.has_value());
+  auto& frames = result.packet->packet.frames;
+  ASSERT_EQ(4, frames.size());
+  for (size_t i = 0; i < 3; i++) {
+    auto datagramFrame = frames[i].asDatagramFrame();
+    ASSERT_NE(datagramFrame, nullptr);
+    EXPECT_EQ(8, datagramFrame->length);
+  }
+  auto streamFrame = frames[3].asWriteStreamFrame();
+  ASSERT_NE(streamFrame, nullptr);
+  EXPECT_EQ(stream->id, streamFrame->streamId);
+  EXPECT_TRUE(conn.datagramState.writeBuffer.empty());
+}
+
+TEST_F(QuicPacketSchedulerTest, DatagramFramesPartialFit) {
+  QuicClientConnectionState conn(
+      FizzClientQuicHandshakeContext::Builder().build());
+  conn.datagramState.maxWriteFrameSize = kMaxDatagramFrameSize;
+  for (size_t i = 0; i < 3; i++) {
+    auto data = folly::IOBuf::create(500);
+    data->append(500);
+    conn.datagramState.writeBuffer.emplace_back(std::move(data));
+  }
+  // Larger than a packet can ever carry, gets dropped.
+  auto tooBig = folly::IOBuf::create(conn.udpSendPacketLen);
+  tooBig->append(conn.udpSendPacketLen);
+  conn.datagramState.writeBuffer.emplace_front(std::move(tooBig));
+
+  DatagramFrameScheduler scheduler(conn);
+  ASSERT_TRUE(scheduler.hasPendingDatagramFrames());
+  ShortHeader shortHeader(
+      ProtectionType::KeyPhaseZero,
+      getTestConnectionId(),
+      getNextPacketNum(conn, PacketNumberSpace::AppData));
+  RegularQuicPacketBuilder builder(
+      conn.udpSendPacketLen,
+      std::move(shortHeader),
+      conn.ackStates.appDataAckState.largestAckedByPeer.value_or(0));
+  builder.encodePacketHeader();
+  EXPECT_TRUE(scheduler.writeDatagramFrames(builder));
+  auto packet = std::move(builder).buildPacket();
+  EXPECT_EQ(2, packet.packet.frames.size());
+  EXPECT_EQ(1, conn.datagramState.writeBuffer.size());
+  EXPECT_EQ(500, conn.datagramState.writeBuffer.front()->length());
+}
+
 INSTANTIATE_TEST_CASE_P(
     QuicPacketSchedulerTests,
     QuicPacketSchedulerTest,
@@ -772,6 +772,43 @@ TEST_F(QuicTransportImplTest, ReadData) {
   transport.reset();
 }
 
+TEST_F(QuicTransportImplTest, ReadChunks) {
+  auto stream1 = transport->createBidirectionalStream().value();
+  auto readData1 = folly::IOBuf::copyBuffer("first packet");
+  auto readData2 = folly::IOBuf::copyBuffer("second packet");
+  transport->addDataToStream(stream1, StreamBuffer(readData1->clone(), 0));
+  transport->addDataToStream(
+      stream1,
+      StreamBuffer(readData2->clone(), readData1->length(), true /* eof */));
+
+  // Read across the first packet into the second one.
+  auto result = transport->readChunks(stream1, readData1->length() + 6);
+  ASSERT_FALSE(result.hasError());
+  auto& chunks = result->first;
+  EXPECT_FALSE(result->second);
+  ASSERT_EQ(2, chunks.size());
+  // One unchained buffer per received packet.
+  IOBufEqualTo eq;
+  EXPECT_FALSE(chunks[0]->isChained());
+  EXPECT_TRUE(eq(*chunks[0], *readData1));
+  EXPECT_FALSE(chunks[1]->isChained());
+  EXPECT_EQ(6, chunks[1]->length());
+  // Releasing a chunk does not affect the others.
+  chunks.erase(chunks.begin());
+  EXPECT_EQ("second", chunks[0]->moveToFbString().toStdString());
+
+  result = transport->readChunks(stream1, 0);
+  ASSERT_FALSE(result.hasError());
+  EXPECT_TRUE(result->second);
+  ASSERT_EQ(1, result->first.size());
+  EXPECT_EQ(" packet", result->first[0]->moveToFbString().toStdString());
+
+  EXPECT_EQ(
+      LocalErrorCode::STREAM_NOT_EXISTS,
+      transport->readChunks(stream1 + 4, 0).error());
+  transport.reset();
+}
+
 // TODO The finest copypasta around. We need a better story for parameterizing
 // unidirectional vs. bidirectional.
 TEST_F(QuicTransportImplTest, UnidirectionalReadData) {
@@ -2395,6 +2432,34 @@ TEST_P(QuicTransportImplTestUniBidi, AppIdleTestOnlyControlStreams) {
   transport->closeStream(ctrlStream2);
 }
 
+TEST_F(QuicTransportImplTest, SetStreamPriority) {
+  auto stream = transport->createBidirectionalStream().value();
+  auto priority = transport->getStreamPriority(stream);
+  ASSERT_TRUE(priority.hasValue());
+  EXPECT_EQ(*priority, kDefaultPriority);
+
+  EXPECT_TRUE(transport->setStreamPriority(stream, 0, false).hasValue());
+  priority = transport->getStreamPriority(stream);
+  ASSERT_TRUE(priority.hasValue());
+  EXPECT_EQ(*priority, Priority(0, false));
+
+  EXPECT_EQ(
+      transport->setStreamPriority(stream, kDefaultMaxPriority + 1, true)
+          .error(),
+      LocalErrorCode::INVALID_OPERATION);
+  EXPECT_EQ(
+      transport->setStreamPriority(stream + 4, 0, true).error(),
+      LocalErrorCode::STREAM_NOT_EXISTS);
+  EXPECT_EQ(
+      transport->getStreamPriority(stream + 4).error(),
+      LocalErrorCode::STREAM_NOT_EXISTS);
+
+  transport->close(folly::none);
+  EXPECT_EQ(
+      transport->setStreamPriority(stream, 0, true).error(),
+      LocalErrorCode::CONNECTION_CLOSED);
+}
+
 TEST_F(QuicTransportImplTest, UnidirectionalInvalidReadFuncs) {
   auto stream = transport->createUnidirectionalStream().value();
   EXPECT_THROW(
@@ -26,6 +26,42 @@ using namespace testing;
 namespace quic {
 namespace test {
 
+namespace {
+
+/**
+ * No-op aead that records the size of every batch it encrypts.
+ */
+class BatchRecordingAead : public Aead {
+ public:
+  std::unique_ptr<folly::IOBuf> inplaceEncrypt(
+      std::unique_ptr<folly::IOBuf>&& plaintext,
+      const folly::IOBuf*,
+      uint64_t) const override {
+    return std::move(plaintext);
+  }
+
+  void inplaceEncryptBatch(
+      std::vector<AeadEncryptRequest>& requests) const override {
+    batchSizes.push_back(requests.size());
+    Aead::inplaceEncryptBatch(requests);
+  }
+
+  folly::Optional<std::unique_ptr<folly::IOBuf>> tryDecrypt(
+      std::unique_ptr<folly::IOBuf>&& ciphertext,
+      const folly::IOBuf*,
+      uint64_t) const override {
+    return std::move(ciphertext);
+  }
+
+  size_t getCipherOverhead() const override {
+    return 0;
+  }
+
+  mutable std::vector<size_t> batchSizes;
+};
+
+} // namespace
+
 uint64_t writeProbingDataToSocketForTest(
     folly::AsyncUDPSocket& sock,
     QuicConnectionStateBase& conn,
@@ -1409,7 +1445,7 @@ TEST_F(QuicTransportFunctionsTest, NothingWritten) {
 }
 
 const QuicWriteFrame& getFirstFrameInOutstandingPackets(
-    const std::deque<OutstandingPacket>& outstandingPackets,
+    const CircularDeque<OutstandingPacket>& outstandingPackets,
     QuicWriteFrame::Type frameType) {
   for (const auto& packet : outstandingPackets) {
     for (const auto& frame : packet.packet.frames) {
@@ -2251,14 +2287,20 @@ TEST_F(QuicTransportFunctionsTest, HandshakeConfirmedDropCipher) {
       false));
   handshakeStream->insertIntoLossBuffer(std::make_unique<StreamBuffer>(
       folly::IOBuf::copyBuffer("Traffic Protocol Weekly Sync"), 0, false));
+  initialStream->readBuffer.emplace_back(
+      folly::IOBuf::copyBuffer("Out of order initial data"), 100, false);
+  handshakeStream->readBuffer.emplace_back(
+      folly::IOBuf::copyBuffer("Out of order handshake data"), 100, false);
 
   handshakeConfirmed(*conn);
   EXPECT_TRUE(initialStream->writeBuffer.empty());
   EXPECT_TRUE(initialStream->retransmissionBuffer.empty());
   EXPECT_TRUE(initialStream->lossBuffer.empty());
+  EXPECT_TRUE(initialStream->readBuffer.empty());
   EXPECT_TRUE(handshakeStream->writeBuffer.empty());
   EXPECT_TRUE(handshakeStream->retransmissionBuffer.empty());
   EXPECT_TRUE(handshakeStream->lossBuffer.empty());
+  EXPECT_TRUE(handshakeStream->readBuffer.empty());
   EXPECT_EQ(nullptr, conn->initialWriteCipher);
   EXPECT_EQ(nullptr, conn->handshakeWriteCipher);
   EXPECT_EQ(nullptr, conn->readCodec->getInitialCipher());
@@ -2422,6 +2464,91 @@ TEST_F(QuicTransportFunctionsTest, WriteWithInplaceBuilderGSOMultiplePackets) {
   EXPECT_EQ(0, bufPtr->headroom());
 }
 
+TEST_F(QuicTransportFunctionsTest, WriteGSOEncryptsPacketsInBatches) {
+  auto conn = createConn();
+  conn->transportSettings.batchingMode = QuicBatchingMode::BATCHING_MODE_GSO;
+  conn->transportSettings.maxBatchSize = 2;
+  EventBase evb;
+  NiceMock<folly::test::MockAsyncUDPSocket> mockSock(&evb);
+  EXPECT_CALL(mockSock, getGSO()).WillRepeatedly(Return(true));
+  auto stream = conn->streamManager->createNextBidirectionalStream().value();
+  auto buf = buildRandomInputData(conn->udpSendPacketLen * 10);
+  writeDataToQuicStream(*stream, buf->clone(), true);
+  EXPECT_CALL(mockSock, writeGSO(_, _, _))
+      .WillRepeatedly(Invoke([](const folly::SocketAddress&,
+                                const std::unique_ptr<folly::IOBuf>& sockBuf,
+                                int) {
+        return sockBuf->computeChainDataLength();
+      }));
+  EXPECT_CALL(mockSock, write(_, _))
+      .WillRepeatedly(Invoke([](const folly::SocketAddress&,
+                                const std::unique_ptr<folly::IOBuf>& sockBuf) {
+        return sockBuf->computeChainDataLength();
+      }));
+  BatchRecordingAead recordingAead;
+  auto written = writeQuicDataToSocket(
+      mockSock,
+      *conn,
+      *conn->clientConnectionId,
+      *conn->serverConnectionId,
+      recordingAead,
+      *headerCipher,
+      getVersion(*conn),
+      5 /* packetLimit */);
+  EXPECT_EQ(5, written);
+  EXPECT_EQ(5, conn->outstandings.packets.size());
+  EXPECT_EQ(std::vector<size_t>({2, 2, 1}), recordingAead.batchSizes);
+}
+
+TEST_F(QuicTransportFunctionsTest, WriteGSOFailureDropsRestOfBatch) {
+  auto conn = createConn();
+  conn->transportSettings.batchingMode = QuicBatchingMode::BATCHING_MODE_GSO;
+  conn->transportSettings.maxBatchSize = 4;
+  auto mockCongestionController =
+      std::make_unique<NiceMock<MockCongestionController>>();
+  auto rawCongestionController = mockCongestionController.get();
+  conn->congestionController = std::move(mockCongestionController);
+  // The second packet of the batch is smaller, which makes the GSO writer
+  // flush it together with the first one.
+  size_t numSent = 0;
+  EXPECT_CALL(*rawCongestionController, onPacketSent(_))
+      .WillRepeatedly(InvokeWithoutArgs([&numSent]() { numSent++; }));
+  EXPECT_CALL(*rawCongestionController, getWritableBytes())
+      .WillRepeatedly(InvokeWithoutArgs([&numSent]() -> uint64_t {
+        return numSent == 1 ? 500 : 10000;
+      }));
+  EventBase evb;
+  NiceMock<folly::test::MockAsyncUDPSocket> mockSock(&evb);
+  EXPECT_CALL(mockSock, getGSO()).WillRepeatedly(Return(true));
+  auto stream = conn->streamManager->createNextBidirectionalStream().value();
+  auto buf = buildRandomInputData(conn->udpSendPacketLen * 10);
+  writeDataToQuicStream(*stream, buf->clone(), true);
+  EXPECT_CALL(mockSock, writeGSO(_, _, _))
+      .WillRepeatedly(SetErrnoAndReturn(EAGAIN, -1));
+  EXPECT_CALL(mockSock, write(_, _))
+      .WillRepeatedly(SetErrnoAndReturn(EAGAIN, -1));
+  // The two packets after the failed write never reached the socket.
+  EXPECT_CALL(*rawCongestionController, onRemoveBytesFromInflight(_))
+      .Times(2);
+  auto written = writeQuicDataToSocket(
+      mockSock,
+      *conn,
+      *conn->clientConnectionId,
+      *conn->serverConnectionId,
+      *aead,
+      *headerCipher,
+      getVersion(*conn),
+      conn->transportSettings.writeConnectionDataPacketsLimit);
+  EXPECT_EQ(2, written);
+  ASSERT_EQ(2, conn->outstandings.packets.size());
+  EXPECT_EQ(
+      conn->outstandings.packets[0].encodedSize +
+          conn->outstandings.packets[1].encodedSize,
+      conn->lossState.totalBytesSent);
+  EXPECT_EQ(2, stream->retransmissionBuffer.size());
+  EXPECT_FALSE(stream->lossBuffer.empty());
+}
+
 TEST_F(QuicTransportFunctionsTest, WriteProbingWithInplaceBuilder) {
   auto conn = createConn();
   conn->transportSettings.dataPathType = DataPathType::ContinuousMemory;
@@ -2880,7 +2880,7 @@ TEST_F(QuicTransportTest, WriteStreamFromMiddleOfMap) {
   conn.outstandings.packets.clear();
 
   // Start from stream2 instead of stream1
-  conn.schedulingState.nextScheduledStream = s2;
+  conn.streamManager->writableStreams().setNextScheduledStream(s2);
   writableBytes = kDefaultUDPSendPacketLen - 100;
 
   EXPECT_CALL(*socket_, write(_, _)).WillOnce(Invoke(bufLength));
@@ -2903,7 +2903,7 @@ TEST_F(QuicTransportTest, WriteStreamFromMiddleOfMap) {
   conn.outstandings.packets.clear();
 
   // Test wrap around
-  conn.schedulingState.nextScheduledStream = s2;
+  conn.streamManager->writableStreams().setNextScheduledStream(s2);
   writableBytes = kDefaultUDPSendPacketLen;
   EXPECT_CALL(*socket_, write(_, _)).WillOnce(Invoke(bufLength));
   writeQuicDataToSocket(
@@ -2945,8 +2945,7 @@ TEST_F(QuicTransportTest, NoStream) {
 }
 
 TEST_F(QuicTransportTest, CancelAckTimeout) {
-  transport_->getTimer()->scheduleTimeout(
-      transport_->getAckTimeout(), 1000000ms);
+  transport_->scheduleTimeout(transport_->getAckTimeout(), 1000000ms);
   EXPECT_TRUE(transport_->getAckTimeout()->isScheduled());
   transport_->getConnectionState().pendingEvents.scheduleAckTimeout = false;
   transport_->onNetworkData(
@@ -3034,6 +3033,31 @@ TEST_F(QuicTransportTest, IdleTimeoutPeerDisabled) {
       transport_->idleTimeout().getTimeRemaining().count(), 60000, 1000);
 }
 
+TEST_F(QuicTransportTest, IdleCompactionTimeout) {
+  auto& conn = transport_->getConnectionState();
+  conn.transportSettings.idleCompactionTimeout = 10ms;
+  for (int i = 0; i < 10; i++) {
+    conn.streamBufferPool.put(
+        std::make_unique<StreamBuffer>(nullptr, 0, false));
+  }
+  transport_->setIdleTimerNow();
+  // Scheduled on the connection timer, not directly on the wheel timer.
+  ASSERT_TRUE(transport_->idleCompactionTimeout().isScheduled());
+  EXPECT_EQ(conn.streamBufferPool.size(), 10);
+
+  evb_.runAfterDelay([&] { evb_.terminateLoopSoon(); }, 50);
+  evb_.loop();
+  EXPECT_FALSE(transport_->idleCompactionTimeout().isScheduled());
+  EXPECT_EQ(conn.streamBufferPool.size(), 0);
+}
+
+TEST_F(QuicTransportTest, IdleCompactionTimeoutDisabled) {
+  auto& conn = transport_->getConnectionState();
+  conn.transportSettings.idleCompactionTimeout = 0ms;
+  transport_->setIdleTimerNow();
+  EXPECT_FALSE(transport_->idleCompactionTimeout().isScheduled());
+}
+
 TEST_F(QuicTransportTest, PacedWriteNoDataToWrite) {
   ASSERT_EQ(
       WriteDataReason::NO_WRITE,
@@ -3280,5 +3304,51 @@ TEST_F(QuicTransportTest, GetStreamPacketsTxedMultiplePackets) {
   Mock::VerifyAndClearExpectations(&lastByteTxCb);
 }
 
+TEST_F(QuicTransportTest, WriteDatagram) {
+  auto& conn = transport_->getConnectionState();
+  conn.datagramState.maxWriteFrameSize = kMaxDatagramFrameSize;
+  auto sizeLimit = transport_->getDatagramSizeLimit();
+  EXPECT_EQ(conn.udpSendPacketLen - kMaxDatagramPacketOverhead, sizeLimit);
+
+  EXPECT_CALL(*socket_, write(_, _)).WillOnce(Invoke(bufLength));
+  EXPECT_TRUE(
+      transport_->writeDatagram(buildRandomInputData(sizeLimit)).hasValue());
+  loopForWrites();
+  EXPECT_TRUE(conn.datagramState.writeBuffer.empty());
+  ASSERT_FALSE(conn.outstandings.packets.empty());
+  bool foundDatagram = false;
+  for (const auto& frame : conn.outstandings.packets.back().packet.frames) {
+    auto datagramFrame = frame.asDatagramFrame();
+    if (datagramFrame) {
+      EXPECT_EQ(sizeLimit, datagramFrame->length);
+      foundDatagram = true;
+    }
+  }
+  EXPECT_TRUE(foundDatagram);
+}
+
+TEST_F(QuicTransportTest, WriteDatagramSizeLimit) {
+  auto& conn = transport_->getConnectionState();
+  // Not negotiated.
+  EXPECT_EQ(0, transport_->getDatagramSizeLimit());
+  EXPECT_EQ(
+      LocalErrorCode::DATAGRAM_UNSUPPORTED,
+      transport_->writeDatagram(buildRandomInputData(10)).error());
+
+  // The peer's limit includes the frame type and length.
+  conn.datagramState.maxWriteFrameSize = 100;
+  auto sizeLimit = transport_->getDatagramSizeLimit();
+  EXPECT_EQ(100 - kMaxDatagramFrameOverhead, sizeLimit);
+  EXPECT_EQ(
+      LocalErrorCode::INVALID_WRITE_DATA,
+      transport_->writeDatagram(buildRandomInputData(sizeLimit + 1)).error());
+  EXPECT_TRUE(
+      transport_->writeDatagram(buildRandomInputData(sizeLimit)).hasValue());
+
+  // No room left for any payload.
+  conn.datagramState.maxWriteFrameSize = kMaxDatagramFrameOverhead;
+  EXPECT_EQ(0, transport_->getDatagramSizeLimit());
+}
+
 } // namespace test
 } // namespace quic
@@ -116,12 +116,18 @@ class TestQuicTransport
     return idleTimeout_;
   }
 
+  auto& idleCompactionTimeout() {
+    return idleCompactionTimeout_;
+  }
+
   CloseState closeState() {
     return closeState_;
   }
 
-  folly::HHWheelTimer* getTimer() {
-    return &getEventBase()->timer();
+  void scheduleTimeout(
+      ConnectionTimer::Callback* callback,
+      std::chrono::milliseconds timeout) {
+    connTimer_.scheduleTimeout(getEventBase()->timer(), callback, timeout);
   }
 
   void drainImmediately() {
@@ -13,6 +13,7 @@
 #include <quic/QuicConstants.h>
 #include <quic/api/LoopDetectorCallback.h>
 #include <quic/api/QuicTransportFunctions.h>
+#include <quic/common/SocketUtil.h>
 #include <quic/client/handshake/ClientHandshakeFactory.h>
 #include <quic/client/handshake/ClientTransportParametersExtension.h>
 #include <quic/client/state/ClientStateMachine.h>
@@ -22,6 +23,7 @@
 #include <quic/logging/QLoggerConstants.h>
 #include <quic/loss/QuicLossFunctions.h>
 #include <quic/state/AckHandlers.h>
+#include <quic/state/DatagramHandlers.h>
 #include <quic/state/QuicPacingFunctions.h>
 #include <quic/state/SimpleFrameFunctions.h>
 #include <quic/state/stream/StreamReceiveHandlers.h>
@@ -111,7 +113,8 @@ void QuicClientTransport::processUDPData(
   for (uint16_t processedPackets = 0;
        !udpData.empty() && processedPackets < kMaxNumCoalescedPackets;
        processedPackets++) {
-    processPacketData(peer, networkData.receiveTimePoint, udpData);
+    processPacketData(
+        peer, networkData.receiveTimePoint, networkData.ecn, udpData);
   }
   VLOG_IF(4, !udpData.empty())
       << "Leaving " << udpData.chainLength()
@@ -122,6 +125,7 @@ void QuicClientTransport::processUDPData(
 void QuicClientTransport::processPacketData(
     const folly::SocketAddress& peer,
     TimePoint receiveTimePoint,
+    ECNCodepoint ecn,
     BufQueue& packetQueue) {
   auto packetSize = packetQueue.chainLength();
   if (packetSize == 0) {
@@ -164,7 +168,10 @@ void QuicClientTransport::processPacketData(
     }
 
     // Set the destination connection ID to be the value from the source
-    // connection id of the retry packet
+    // connection id of the retry packet. The server echoes both in its
+    // transport parameters.
+    clientConn_->originalDestinationConnectionId =
+        clientConn_->initialDestinationConnectionId;
     clientConn_->initialDestinationConnectionId =
         retryPacket->header.getSourceConnId();
 
@@ -178,8 +185,6 @@ void QuicClientTransport::processPacketData(
     clientConn_->retryToken = retryPacket->header.getToken();
 
     // TODO (amsharma): add a "RetryPacket" QLog event, and log it here.
-    // TODO (amsharma): verify the "original_connection_id" parameter
-    // upon receiving a subsequent initial from the server.
 
     startCryptoHandshake();
     return;
@@ -489,6 +494,25 @@ void QuicClientTransport::processPacketData(
             *conn_, simpleFrame, packetNum, false);
         break;
       }
+      case QuicFrame::Type::ReadNewTokenFrame_E: {
+        ReadNewTokenFrame& newTokenFrame = *quicFrame.asReadNewTokenFrame();
+        VLOG(10) << "Client received new token " << *this;
+        pktHasRetransmittableData = true;
+        if (tokenCache_ && hostname_ && newTokenFrame.token) {
+          tokenCache_->putToken(
+              *hostname_, newTokenFrame.token->moveToFbString().toStdString());
+        }
+        break;
+      }
+      case QuicFrame::Type::DatagramFrame_E: {
+        DatagramFrame& frame = *quicFrame.asDatagramFrame();
+        VLOG(10) << "Client received datagram len=" << frame.length << " "
+                 << *this;
+        // Datagrams are not retransmitted, but they are ack-eliciting.
+        pktHasRetransmittableData = true;
+        handleDatagram(*conn_, frame, receiveTimePoint);
+        break;
+      }
       default:
         break;
     }
@@ -637,6 +661,7 @@ void QuicClientTransport::processPacketData(
       outOfOrder,
       pktHasRetransmittableData,
       pktHasCryptoData);
+  updateEcnCountsOnRecvPacket(ackState, ecn);
   if (encryptionLevel == EncryptionLevel::Handshake &&
       conn_->version != QuicVersion::MVFST_D24 && conn_->initialWriteCipher) {
     conn_->initialWriteCipher.reset();
@@ -664,6 +689,15 @@ void QuicClientTransport::onReadData(
   }
   bool waitingForFirstPacket = !hasReceivedPackets(*conn_);
   processUDPData(peer, std::move(networkData));
+  if (conn_->ecnState.validationFailed && !ecnMarkingCleared_) {
+    // The path doesn't carry our ECN marks, stop setting them.
+    ecnMarkingCleared_ = true;
+    applyEcnSocketOptions(
+        *socket_,
+        socket_->address().getFamily(),
+        ECNCodepoint::NotECT,
+        conn_->transportSettings.readEcnOnIngress);
+  }
   if (connCallback_ && waitingForFirstPacket && hasReceivedPackets(*conn_)) {
     connCallback_->onFirstPeerPacketProcessed();
   }
@@ -746,10 +780,11 @@ void QuicClientTransport::writeData() {
     return;
   }
 
-  uint64_t packetLimit =
-      (isConnectionPaced(*conn_)
-           ? conn_->pacer->updateAndGetWriteBatchSize(Clock::now())
-           : conn_->transportSettings.writeConnectionDataPacketsLimit);
+  uint64_t packetLimit = isTxTimePaced(*conn_)
+      ? getTxTimeWriteBatchSize(*conn_, Clock::now())
+      : (isConnectionPaced(*conn_)
+             ? conn_->pacer->updateAndGetWriteBatchSize(Clock::now())
+             : conn_->transportSettings.writeConnectionDataPacketsLimit);
   if (conn_->initialWriteCipher) {
     auto& initialCryptoStream =
         *getCryptoStream(*conn_->cryptoState, EncryptionLevel::Initial);
@@ -772,7 +807,8 @@ void QuicClientTransport::writeData() {
           *conn_->initialHeaderCipher,
           version,
           packetLimit,
-          clientConn_->retryToken);
+          clientConn_->retryToken.empty() ? clientConn_->newToken
+                                          : clientConn_->retryToken);
     }
     if (!packetLimit && !conn_->pendingEvents.numProbePackets) {
       return;
@@ -862,6 +898,8 @@ void QuicClientTransport::startCryptoHandshake() {
 
   // Add partial reliability parameter to customTransportParameters_.
   setPartialReliabilityTransportParameter();
+  setDatagramTransportParameter();
+  setAckFrequencyTransportParameter();
 
   auto paramsExtension = std::make_shared<ClientTransportParametersExtension>(
       conn_->originalVersion.value(),
@@ -906,6 +944,9 @@ bool QuicClientTransport::isTLSResumed() const {
 
 void QuicClientTransport::errMessage(
     FOLLY_MAYBE_UNUSED const cmsghdr& cmsg) noexcept {
+  if (zeroCopySendTracker_ && zeroCopySendTracker_->onErrMessage(cmsg)) {
+    return;
+  }
 #ifdef FOLLY_HAVE_MSG_ERRQUEUE
   if ((cmsg.cmsg_level == SOL_IP && cmsg.cmsg_type == IP_RECVERR) ||
       (cmsg.cmsg_level == SOL_IPV6 && cmsg.cmsg_type == IPV6_RECVERR)) {
@@ -1034,7 +1075,10 @@ void QuicClientTransport::onDataAvailable(
 }
 
 bool QuicClientTransport::shouldOnlyNotify() {
-  return conn_->transportSettings.shouldRecvBatch;
+  // Only the recvmsg and recvmmsg paths ask for the control messages that
+  // carry the ECN codepoint, so reading ECN always goes through them.
+  return conn_->transportSettings.readEcnOnIngress ||
+      conn_->transportSettings.shouldRecvBatch;
 }
 
 void QuicClientTransport::recvMsg(
@@ -1068,14 +1112,17 @@ void QuicClientTransport::recvMsg(
     msg.msg_namelen = size_t(addrLen);
     msg.msg_iov = &vec;
     msg.msg_iovlen = 1;
+    ECNCodepoint ecn = ECNCodepoint::NotECT;
 #ifdef FOLLY_HAVE_MSG_ERRQUEUE
-    char control[CMSG_SPACE(sizeof(uint16_t))] = {};
+    char control[kRecvCmsgSpace] = {};
     bool useGRO = sock.getGRO() > 0;
+    bool useControl = useGRO || conn_->transportSettings.readEcnOnIngress;
 
-    if (useGRO) {
+    if (useControl) {
       msg.msg_control = control;
       msg.msg_controllen = sizeof(control);
-
+    }
+    if (useGRO) {
       // we need to consider MSG_TRUNC too
       flags |= MSG_TRUNC;
     }
@@ -1104,15 +1151,17 @@ void QuicClientTransport::recvMsg(
       break;
     }
 #ifdef FOLLY_HAVE_MSG_ERRQUEUE
-    if (useGRO) {
+    if (useControl) {
       for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
            cmsg = CMSG_NXTHDR(&msg, cmsg)) {
         if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
           gro = *((uint16_t*)CMSG_DATA(cmsg));
-          break;
+        } else if (auto cmsgEcn = getEcnFromCmsg(*cmsg)) {
+          ecn = *cmsgEcn;
         }
       }
-
+    }
+    if (useGRO) {
       // truncated
       if ((size_t)ret > readBufferSize) {
         ret = readBufferSize;
@@ -1149,18 +1198,18 @@ void QuicClientTransport::recvMsg(
 
           offset += gro;
           remaining -= gro;
-          networkData.packets.emplace_back(std::move(tmp));
+          networkData.addPacket(std::move(tmp), ecn);
         } else {
           // do not clone the last packet
           // start at offset, use all the remaining data
           readBuffer->trimStart(offset);
           DCHECK_EQ(readBuffer->length(), remaining);
           remaining = 0;
-          networkData.packets.emplace_back(std::move(readBuffer));
+          networkData.addPacket(std::move(readBuffer), ecn);
         }
       }
     } else {
-      networkData.packets.emplace_back(std::move(readBuffer));
+      networkData.addPacket(std::move(readBuffer), ecn);
     }
     if (conn_->qLogger) {
       conn_->qLogger->addDatagramReceived(bytesRead);
@@ -1185,8 +1234,9 @@ void QuicClientTransport::recvMmsg(
   int flags = 0;
 #ifdef FOLLY_HAVE_MSG_ERRQUEUE
   bool useGRO = sock.getGRO() > 0;
-  std::vector<std::array<char, CMSG_SPACE(sizeof(uint16_t))>> controlVec(
-      useGRO ? numPackets : 0);
+  bool useControl = useGRO || conn_->transportSettings.readEcnOnIngress;
+  std::vector<std::array<char, kRecvCmsgSpace>> controlVec(
+      useControl ? numPackets : 0);
 
   // we need to consider MSG_TRUNC too
   if (useGRO) {
@@ -1216,7 +1266,7 @@ void QuicClientTransport::recvMmsg(
     msg->msg_iov = &iovecs[i];
     msg->msg_iovlen = 1;
 #ifdef FOLLY_HAVE_MSG_ERRQUEUE
-    if (useGRO) {
+    if (useControl) {
       msg->msg_control = controlVec[i].data();
       msg->msg_controllen = controlVec[i].size();
     }
@@ -1256,17 +1306,20 @@ void QuicClientTransport::recvMmsg(
       continue;
     }
     int gro = -1;
+    ECNCodepoint ecn = ECNCodepoint::NotECT;
 #ifdef FOLLY_HAVE_MSG_ERRQUEUE
-    if (useGRO) {
+    if (useControl) {
       for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msgs[i].msg_hdr);
            cmsg != nullptr;
            cmsg = CMSG_NXTHDR(&msgs[i].msg_hdr, cmsg)) {
         if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
           gro = *((uint16_t*)CMSG_DATA(cmsg));
-          break;
+        } else if (auto cmsgEcn = getEcnFromCmsg(*cmsg)) {
+          ecn = *cmsgEcn;
         }
       }
-
+    }
+    if (useGRO) {
       // truncated
       if (bytesRead > readBufferSize) {
         bytesRead = readBufferSize;
@@ -1305,18 +1358,18 @@ void QuicClientTransport::recvMmsg(
 
           offset += gro;
           remaining -= gro;
-          networkData.packets.emplace_back(std::move(tmp));
+          networkData.addPacket(std::move(tmp), ecn);
         } else {
           // do not clone the last packet
           // start at offset, use all the remaining data
           readBuffers[i]->trimStart(offset);
           DCHECK_EQ(readBuffers[i]->length(), remaining);
           remaining = 0;
-          networkData.packets.emplace_back(std::move(readBuffers[i]));
+          networkData.addPacket(std::move(readBuffers[i]), ecn);
         }
       }
     } else {
-      networkData.packets.emplace_back(std::move(readBuffers[i]));
+      networkData.addPacket(std::move(readBuffers[i]), ecn);
     }
 
     QUIC_TRACE(udp_recvd, *conn_, bytesRead);
@@ -1333,7 +1386,11 @@ void QuicClientTransport::onNotifyDataAvailable(
   DCHECK(conn_) << "trying to receive packets without a connection";
   auto readBufferSize =
       conn_->transportSettings.maxRecvPacketSize * numGROBuffers_;
-  const int numPackets = conn_->transportSettings.maxRecvBatchSize;
+  // Without batching, read one packet per notification like onDataAvailable
+  // does.
+  const int numPackets = conn_->transportSettings.shouldRecvBatch
+      ? conn_->transportSettings.maxRecvBatchSize
+      : 1;
 
   NetworkData networkData;
   networkData.packets.reserve(numPackets);
@@ -1411,8 +1468,35 @@ void QuicClientTransport::start(ConnectionCallback* cb) {
         this,
         this,
         socketOptions_);
+    if (conn_->transportSettings.pacingWithTxTime &&
+        !applyTxTimeSocketOption(*socket_)) {
+      LOG(WARNING) << "SO_TXTIME not supported, pacing with the timer instead";
+      conn_->transportSettings.pacingWithTxTime = false;
+    }
+    if (conn_->transportSettings.zeroCopyGSOWrites) {
+      // The completions arrive through the error message callback, and a
+      // zerocopy batch can't be written to a second happy eyeballs socket.
+      if (conn_->transportSettings.enableSocketErrMsgCallback &&
+          !happyEyeballsEnabled_) {
+        zeroCopySendTracker_ = ZeroCopySendTracker::create(*socket_);
+      }
+      if (zeroCopySendTracker_) {
+        conn_->zeroCopySendTracker = zeroCopySendTracker_.get();
+      } else {
+        LOG(WARNING) << "Zerocopy writes not supported, copying GSO writes";
+        conn_->transportSettings.zeroCopyGSOWrites = false;
+      }
+    }
     // adjust the GRO buffers
     adjustGROBuffers();
+    if (tokenCache_ && hostname_) {
+      // A token is only good for one connection attempt.
+      auto token = tokenCache_->getToken(*hostname_);
+      if (token) {
+        tokenCache_->removeToken(*hostname_);
+        clientConn_->newToken = std::move(*token);
+      }
+    }
     startCryptoHandshake();
   } catch (const QuicTransportException& ex) {
     runOnEvbAsync([ex](auto self) {
@@ -1479,6 +1563,11 @@ void QuicClientTransport::setHostname(const std::string& hostname) {
   hostname_ = hostname;
 }
 
+void QuicClientTransport::setTokenCache(
+    std::shared_ptr<QuicTokenCache> tokenCache) {
+  tokenCache_ = std::move(tokenCache);
+}
+
 void QuicClientTransport::setSelfOwning() {
   selfOwning_ = shared_from_this();
 }
@@ -1524,6 +1613,29 @@ void QuicClientTransport::setPartialReliabilityTransportParameter() {
   }
 }
 
+void QuicClientTransport::setDatagramTransportParameter() {
+  if (conn_->datagramState.maxReadFrameSize == 0) {
+    return;
+  }
+  // max_datagram_frame_size is a registered parameter, so it does not go
+  // through setCustomTransportParameter which only accepts private ids.
+  customTransportParameters_.push_back(encodeIntegerParameter(
+      TransportParameterId::max_datagram_frame_size,
+      conn_->datagramState.maxReadFrameSize));
+}
+
+void QuicClientTransport::setAckFrequencyTransportParameter() {
+  if (!conn_->transportSettings.minAckDelay ||
+      conn_->originalVersion == QuicVersion::MVFST_D24) {
+    // MVFST_D24 encodes parameter ids in 16 bits, which min_ack_delay does
+    // not fit in.
+    return;
+  }
+  customTransportParameters_.push_back(encodeIntegerParameter(
+      TransportParameterId::min_ack_delay,
+      conn_->transportSettings.minAckDelay->count()));
+}
+
 void QuicClientTransport::setD6DBasePMTUTransportParameter() {
   if (!conn_->transportSettings.d6dConfig.enabled) {
     return;
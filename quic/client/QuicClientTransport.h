@@ -14,6 +14,7 @@
 #include <folly/io/async/AsyncUDPSocket.h>
 #include <folly/net/NetOps.h>
 #include <quic/api/QuicTransportBase.h>
+#include <quic/client/handshake/QuicTokenCache.h>
 #include <quic/client/state/ClientStateMachine.h>
 #include <quic/common/BufUtil.h>
 
@@ -63,6 +64,13 @@ class QuicClientTransport
    */
   void setHostname(const std::string& hostname);
 
+  /**
+   * Supply the cache for the tokens the server sends in NEW_TOKEN frames,
+   * keyed by hostname. A cached token is used, and removed, by the next
+   * connection to the same hostname. Must be set before start().
+   */
+  void setTokenCache(std::shared_ptr<QuicTokenCache> tokenCache);
+
   /**
    * Supplies a new peer address to use for the connection. This must be called
    * at least once before start().
@@ -190,6 +198,7 @@ class QuicClientTransport
   void processPacketData(
       const folly::SocketAddress& peer,
       TimePoint receiveTimePoint,
+      ECNCodepoint ecn,
       BufQueue& packetQueue);
 
   void startCryptoHandshake();
@@ -203,10 +212,13 @@ class QuicClientTransport
 
   Buf readBuffer_;
   folly::Optional<std::string> hostname_;
+  std::shared_ptr<QuicTokenCache> tokenCache_;
   HappyEyeballsConnAttemptDelayTimeout happyEyeballsConnAttemptDelayTimeout_;
 
  private:
   void setPartialReliabilityTransportParameter();
+  void setDatagramTransportParameter();
+  void setAckFrequencyTransportParameter();
   void setD6DBasePMTUTransportParameter();
   void setD6DRaiseTimeoutTransportParameter();
   void setD6DProbeTimeoutTransportParameter();
@@ -214,6 +226,8 @@ class QuicClientTransport
   void trackDatagramReceived(size_t len);
 
   bool replaySafeNotified_{false};
+  // Set once the socket stopped marking packets after ECN validation failed.
+  bool ecnMarkingCleared_{false};
   // Set it QuicClientTransport is in a self owning mode. This will be cleaned
   // up when the caller invokes a terminal call to the transport.
   std::shared_ptr<QuicClientTransport> selfOwning_;
@@ -227,5 +241,7 @@ class QuicClientTransport
   // supports GRO. otherwise kDefaultNumGROBuffers
   uint32_t numGROBuffers_{kDefaultNumGROBuffers};
   RecvmmsgStorage recvmmsgStorage_;
+  // Zerocopy writes on socket_ when zeroCopyGSOWrites is enabled.
+  std::unique_ptr<ZeroCopySendTracker> zeroCopySendTracker_;
 };
 } // namespace quic
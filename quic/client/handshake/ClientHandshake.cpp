@@ -100,6 +100,10 @@ void ClientHandshake::doHandshake(
 
 void ClientHandshake::handshakeConfirmed() {
   phase_ = Phase::Established;
+  // Nothing is read at the Initial or Handshake encryption levels any more.
+  // The fizz state is kept since it processes the session tickets.
+  initialReadBuf_.move();
+  handshakeReadBuf_.move();
 }
 
 ClientHandshake::Phase ClientHandshake::getPhase() const {
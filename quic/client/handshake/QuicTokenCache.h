@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#pragma once
+
+#include <folly/Optional.h>
+
+#include <string>
+#include <unordered_map>
+
+namespace quic {
+
+/**
+ * Stores the tokens servers send in NEW_TOKEN frames, by hostname. The client
+ * puts the token in the Initial of its next connection to the server, which
+ * proves it owns its address before the handshake completes.
+ */
+class QuicTokenCache {
+ public:
+  virtual ~QuicTokenCache() = default;
+
+  virtual folly::Optional<std::string> getToken(const std::string&) = 0;
+  virtual void putToken(const std::string&, std::string) = 0;
+  virtual void removeToken(const std::string&) = 0;
+};
+
+/**
+ * Basic token cache that stores tokens in a hash map. There is no bound on the
+ * size of this cache.
+ */
+class BasicQuicTokenCache : public QuicTokenCache {
+ public:
+  ~BasicQuicTokenCache() override = default;
+
+  folly::Optional<std::string> getToken(const std::string& hostname) override {
+    auto result = cache_.find(hostname);
+    if (result != cache_.end()) {
+      return result->second;
+    }
+    return folly::none;
+  }
+
+  void putToken(const std::string& hostname, std::string token) override {
+    cache_[hostname] = std::move(token);
+  }
+
+  void removeToken(const std::string& hostname) override {
+    cache_.erase(hostname);
+  }
+
+ private:
+  std::unordered_map<std::string, std::string> cache_;
+};
+
+} // namespace quic
@@ -30,6 +30,8 @@ std::unique_ptr<QuicClientConnectionState> undoAllClientStateForRetry(
   newConn->clientConnectionId = conn->clientConnectionId;
   newConn->initialDestinationConnectionId =
       conn->initialDestinationConnectionId;
+  newConn->originalDestinationConnectionId =
+      conn->originalDestinationConnectionId;
   // TODO: don't carry server connection id over to the new connection.
   newConn->serverConnectionId = conn->serverConnectionId;
   newConn->ackStates.initialAckState.nextPacketNum =
@@ -89,6 +91,10 @@ void processServerInitialParams(
   auto activeConnectionIdLimit = getIntegerParameter(
       TransportParameterId::active_connection_id_limit,
       serverParams.parameters);
+  auto maxDatagramFrameSize = getIntegerParameter(
+      TransportParameterId::max_datagram_frame_size, serverParams.parameters);
+  auto minAckDelay = getIntegerParameter(
+      TransportParameterId::min_ack_delay, serverParams.parameters);
   if (conn.version == QuicVersion::QUIC_DRAFT) {
     auto initialSourceConnId = getConnIdParameter(
         TransportParameterId::initial_source_connection_id,
@@ -96,15 +102,32 @@ void processServerInitialParams(
     auto originalDestinationConnId = getConnIdParameter(
         TransportParameterId::original_destination_connection_id,
         serverParams.parameters);
+    auto retrySourceConnId = getConnIdParameter(
+        TransportParameterId::retry_source_connection_id,
+        serverParams.parameters);
+    bool retried = conn.originalDestinationConnectionId.has_value();
+    const auto& expectedOriginalDestinationConnId = retried
+        ? conn.originalDestinationConnectionId
+        : conn.initialDestinationConnectionId;
     if (!initialSourceConnId || !originalDestinationConnId ||
         initialSourceConnId.value() !=
             conn.readCodec->getServerConnectionId() ||
         originalDestinationConnId.value() !=
-            conn.initialDestinationConnectionId) {
+            expectedOriginalDestinationConnId) {
       throw QuicTransportException(
           "Initial CID does not match.",
           TransportErrorCode::TRANSPORT_PARAMETER_ERROR);
     }
+    // The server must name the Retry it sent us, and only if it sent one.
+    if (retried
+            ? !retrySourceConnId ||
+                retrySourceConnId.value() !=
+                    conn.initialDestinationConnectionId
+            : retrySourceConnId.has_value()) {
+      throw QuicTransportException(
+          "Retry CID does not match.",
+          TransportErrorCode::TRANSPORT_PARAMETER_ERROR);
+    }
   }
 
   // TODO Validate active_connection_id_limit
@@ -164,6 +187,15 @@ void processServerInitialParams(
   conn.peerActiveConnectionIdLimit =
       activeConnectionIdLimit.value_or(kDefaultActiveConnectionIdLimit);
 
+  // A zero or absent max_datagram_frame_size means the server does not accept
+  // DATAGRAM frames.
+  conn.datagramState.maxWriteFrameSize = maxDatagramFrameSize.value_or(0);
+
+  if (minAckDelay) {
+    conn.ackFrequencyState.peerMinAckDelay =
+        std::chrono::microseconds(*minAckDelay);
+  }
+
   if (partialReliability && *partialReliability != 0 &&
       conn.transportSettings.partialReliabilityEnabled) {
     conn.partialReliabilityEnabled = true;
@@ -30,9 +30,18 @@ struct QuicClientConnectionState : public QuicConnectionStateBase {
   // The retry token sent by the server.
   std::string retryToken;
 
-  // Initial destination connection id.
+  // The token from a NEW_TOKEN frame of an earlier connection to the server,
+  // sent in our Initials unless the server asks for a retry.
+  std::string newToken;
+
+  // Initial destination connection id. After a Retry, this is the source
+  // connection id of the Retry.
   folly::Optional<ConnectionId> initialDestinationConnectionId;
 
+  // Destination connection id of our first Initial. Only set once the server
+  // sent a Retry.
+  folly::Optional<ConnectionId> originalDestinationConnectionId;
+
   std::shared_ptr<ClientHandshakeFactory> handshakeFactory;
   ClientHandshake* clientHandshakeLayer;
 
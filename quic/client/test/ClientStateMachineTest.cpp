@@ -87,4 +87,56 @@ TEST_F(ClientStateMachineTest, TestUpdateTransportParamsFromCachedEarlyParams) {
       client_->streamManager->createNextUnidirectionalStream().hasError());
 }
 
+TEST_F(ClientStateMachineTest, TestProcessServerInitialParamsAfterRetry) {
+  ConnectionId originalDstConnId(std::vector<uint8_t>{1, 2, 3, 4, 5, 6, 7, 8});
+  ConnectionId retrySrcConnId(std::vector<uint8_t>{8, 7, 6, 5, 4, 3, 2, 1});
+  ConnectionId serverConnId(std::vector<uint8_t>{1, 1, 1, 1, 1, 1, 1, 1});
+  client_->version = QuicVersion::QUIC_DRAFT;
+  client_->readCodec = std::make_unique<QuicReadCodec>(QuicNodeType::Client);
+  client_->readCodec->setServerConnectionId(serverConnId);
+  client_->originalDestinationConnectionId = originalDstConnId;
+  client_->initialDestinationConnectionId = retrySrcConnId;
+
+  auto makeParams = [&](const ConnectionId& odcid,
+                        folly::Optional<ConnectionId> rscid) {
+    ServerTransportParameters params;
+    params.parameters.push_back(encodeConnIdParameter(
+        TransportParameterId::initial_source_connection_id, serverConnId));
+    params.parameters.push_back(encodeConnIdParameter(
+        TransportParameterId::original_destination_connection_id, odcid));
+    if (rscid) {
+      params.parameters.push_back(encodeConnIdParameter(
+          TransportParameterId::retry_source_connection_id, *rscid));
+    }
+    return params;
+  };
+  // The server must send the connection id of our first Initial, not the one
+  // of the Retry.
+  EXPECT_THROW(
+      processServerInitialParams(
+          *client_, makeParams(retrySrcConnId, retrySrcConnId), 0),
+      QuicTransportException);
+  // And it must name the Retry.
+  EXPECT_THROW(
+      processServerInitialParams(
+          *client_, makeParams(originalDstConnId, folly::none), 0),
+      QuicTransportException);
+  EXPECT_THROW(
+      processServerInitialParams(
+          *client_, makeParams(originalDstConnId, originalDstConnId), 0),
+      QuicTransportException);
+  processServerInitialParams(
+      *client_, makeParams(originalDstConnId, retrySrcConnId), 0);
+
+  // Without a Retry, retry_source_connection_id must be absent.
+  client_->originalDestinationConnectionId = folly::none;
+  client_->initialDestinationConnectionId = originalDstConnId;
+  EXPECT_THROW(
+      processServerInitialParams(
+          *client_, makeParams(originalDstConnId, retrySrcConnId), 0),
+      QuicTransportException);
+  processServerInitialParams(
+      *client_, makeParams(originalDstConnId, folly::none), 0);
+}
+
 } // namespace quic::test
@@ -98,6 +98,28 @@ KnobFrame decodeKnobFrame(folly::io::Cursor& cursor) {
   return KnobFrame(knobSpace->first, knobId->first, std::move(knobBlob));
 }
 
+DatagramFrame decodeDatagramFrame(folly::io::Cursor& cursor, bool hasLen) {
+  size_t length = cursor.totalLength();
+  if (hasLen) {
+    auto decodedLength = decodeQuicInteger(cursor);
+    if (!decodedLength) {
+      throw QuicTransportException(
+          "Invalid datagram len",
+          TransportErrorCode::FRAME_ENCODING_ERROR,
+          FrameType::DATAGRAM_LEN);
+    }
+    length = decodedLength->first;
+  }
+  Buf data;
+  if (cursor.cloneAtMost(data, length) != length) {
+    throw QuicTransportException(
+        "Datagram data too short",
+        TransportErrorCode::FRAME_ENCODING_ERROR,
+        hasLen ? FrameType::DATAGRAM_LEN : FrameType::DATAGRAM);
+  }
+  return DatagramFrame(length, std::move(data), hasLen);
+}
+
 ReadAckFrame decodeAckFrame(
     folly::io::Cursor& cursor,
     const PacketHeader& header,
@@ -195,9 +217,7 @@ ReadAckFrame decodeAckFrameWithECN(
     folly::io::Cursor& cursor,
     const PacketHeader& header,
     const CodecParameters& params) {
-  // TODO this is incomplete
   auto readAckFrame = decodeAckFrame(cursor, header, params);
-  // TODO we simply ignore ECN blocks in ACK-ECN frames for now.
   auto ect_0 = decodeQuicInteger(cursor);
   if (!ect_0) {
     throw QuicTransportException(
@@ -219,6 +239,10 @@ ReadAckFrame decodeAckFrameWithECN(
         quic::TransportErrorCode::FRAME_ENCODING_ERROR,
         quic::FrameType::ACK_ECN);
   }
+  readAckFrame.ecnCounts = ECNCounts();
+  readAckFrame.ecnCounts->ect0 = ect_0->first;
+  readAckFrame.ecnCounts->ect1 = ect_1->first;
+  readAckFrame.ecnCounts->ce = ect_ce->first;
   return readAckFrame;
 }
 
@@ -676,6 +700,46 @@ HandshakeDoneFrame decodeHandshakeDoneFrame(folly::io::Cursor& /*cursor*/) {
   return HandshakeDoneFrame();
 }
 
+AckFrequencyFrame decodeAckFrequencyFrame(folly::io::Cursor& cursor) {
+  auto sequenceNumber = decodeQuicInteger(cursor);
+  if (!sequenceNumber) {
+    throw QuicTransportException(
+        "Bad sequence number",
+        quic::TransportErrorCode::FRAME_ENCODING_ERROR,
+        quic::FrameType::ACK_FREQUENCY);
+  }
+  auto packetTolerance = decodeQuicInteger(cursor);
+  if (!packetTolerance) {
+    throw QuicTransportException(
+        "Bad packet tolerance",
+        quic::TransportErrorCode::FRAME_ENCODING_ERROR,
+        quic::FrameType::ACK_FREQUENCY);
+  }
+  auto updateMaxAckDelay = decodeQuicInteger(cursor);
+  if (!updateMaxAckDelay) {
+    throw QuicTransportException(
+        "Bad update max ack delay",
+        quic::TransportErrorCode::FRAME_ENCODING_ERROR,
+        quic::FrameType::ACK_FREQUENCY);
+  }
+  auto reorderThreshold = decodeQuicInteger(cursor);
+  if (!reorderThreshold) {
+    throw QuicTransportException(
+        "Bad reorder threshold",
+        quic::TransportErrorCode::FRAME_ENCODING_ERROR,
+        quic::FrameType::ACK_FREQUENCY);
+  }
+  return AckFrequencyFrame(
+      sequenceNumber->first,
+      packetTolerance->first,
+      updateMaxAckDelay->first,
+      reorderThreshold->first);
+}
+
+ImmediateAckFrame decodeImmediateAckFrame(folly::io::Cursor& /*cursor*/) {
+  return ImmediateAckFrame();
+}
+
 folly::Expected<RetryToken, TransportErrorCode> parsePlaintextRetryToken(
     folly::io::Cursor& cursor) {
   // Read in the length of the odcid.
@@ -713,7 +777,41 @@ folly::Expected<RetryToken, TransportErrorCode> parsePlaintextRetryToken(
     return folly::makeUnexpected(TransportErrorCode::INVALID_TOKEN);
   }
 
-  return RetryToken(connId, *ipAddress, clientPort);
+  // Read in the timestamp.
+  if (!cursor.canAdvance(sizeof(uint64_t))) {
+    return folly::makeUnexpected(TransportErrorCode::INVALID_TOKEN);
+  }
+  auto timestampInMs = cursor.readBE<uint64_t>();
+
+  return RetryToken(connId, *ipAddress, clientPort, timestampInMs);
+}
+
+folly::Expected<NewToken, TransportErrorCode> parsePlaintextNewToken(
+    folly::io::Cursor& cursor) {
+  // Read in the length of the client ip address.
+  if (!cursor.canAdvance(sizeof(uint8_t))) {
+    return folly::makeUnexpected(TransportErrorCode::INVALID_TOKEN);
+  }
+  uint16_t ipAddrLen = cursor.readBE<uint8_t>();
+
+  if (!cursor.canAdvance(ipAddrLen)) {
+    return folly::makeUnexpected(TransportErrorCode::INVALID_TOKEN);
+  }
+
+  // Read in the ip address.
+  std::string ipAddressStr = cursor.readFixedString(ipAddrLen);
+  auto ipAddress = folly::IPAddress::tryFromString(ipAddressStr);
+  if (!ipAddress.hasValue()) {
+    return folly::makeUnexpected(TransportErrorCode::INVALID_TOKEN);
+  }
+
+  // Read in the timestamp.
+  if (!cursor.canAdvance(sizeof(uint64_t))) {
+    return folly::makeUnexpected(TransportErrorCode::INVALID_TOKEN);
+  }
+  auto timestampInMs = cursor.readBE<uint64_t>();
+
+  return NewToken(*ipAddress, timestampInMs);
 }
 
 QuicFrame parseFrame(
@@ -803,6 +901,14 @@ QuicFrame parseFrame(
         return QuicFrame(decodeHandshakeDoneFrame(cursor));
       case FrameType::KNOB:
         return QuicFrame(decodeKnobFrame(cursor));
+      case FrameType::DATAGRAM:
+        return QuicFrame(decodeDatagramFrame(cursor, false));
+      case FrameType::DATAGRAM_LEN:
+        return QuicFrame(decodeDatagramFrame(cursor, true));
+      case FrameType::IMMEDIATE_ACK:
+        return QuicFrame(decodeImmediateAckFrame(cursor));
+      case FrameType::ACK_FREQUENCY:
+        return QuicFrame(decodeAckFrequencyFrame(cursor));
     }
   } catch (const std::exception&) {
     error = true;
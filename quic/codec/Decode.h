@@ -96,6 +96,12 @@ PingFrame decodePingFrame(folly::io::Cursor& cursor);
 
 KnobFrame decodeKnobFrame(folly::io::Cursor& cursor);
 
+/**
+ * Decodes a DATAGRAM frame. When hasLen is false the datagram extends to the
+ * end of the packet.
+ */
+DatagramFrame decodeDatagramFrame(folly::io::Cursor& cursor, bool hasLen);
+
 DataBlockedFrame decodeDataBlockedFrame(folly::io::Cursor& cursor);
 
 StreamDataBlockedFrame decodeStreamDataBlockedFrame(folly::io::Cursor& cursor);
@@ -135,9 +141,16 @@ ReadNewTokenFrame decodeNewTokenFrame(folly::io::Cursor& cursor);
 
 HandshakeDoneFrame decodeHandshakeDoneFrame(folly::io::Cursor& cursor);
 
+AckFrequencyFrame decodeAckFrequencyFrame(folly::io::Cursor& cursor);
+
+ImmediateAckFrame decodeImmediateAckFrame(folly::io::Cursor& cursor);
+
 folly::Expected<RetryToken, TransportErrorCode> parsePlaintextRetryToken(
     folly::io::Cursor& cursor);
 
+folly::Expected<NewToken, TransportErrorCode> parsePlaintextNewToken(
+    folly::io::Cursor& cursor);
+
 /**
  * Parse the Invariant fields in Long Header.
  *
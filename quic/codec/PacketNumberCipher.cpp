@@ -13,14 +13,14 @@
 
 namespace quic {
 
-void PacketNumberCipher::decipherHeader(
-    folly::ByteRange sample,
+namespace {
+
+void applyDecryptionMask(
+    const HeaderProtectionMask& headerMask,
     folly::MutableByteRange initialByte,
     folly::MutableByteRange packetNumberBytes,
-    uint8_t initialByteMask,
-    uint8_t /* packetNumLengthMask */) const {
+    uint8_t initialByteMask) {
   CHECK_EQ(packetNumberBytes.size(), kMaxPacketNumEncodingSize);
-  HeaderProtectionMask headerMask = mask(sample);
   // Mask size should be > packet number length + 1.
   DCHECK_GE(headerMask.size(), 5);
   initialByte.data()[0] ^= headerMask.data()[0] & initialByteMask;
@@ -30,13 +30,11 @@ void PacketNumberCipher::decipherHeader(
   }
 }
 
-void PacketNumberCipher::cipherHeader(
-    folly::ByteRange sample,
+void applyEncryptionMask(
+    const HeaderProtectionMask& headerMask,
     folly::MutableByteRange initialByte,
     folly::MutableByteRange packetNumberBytes,
-    uint8_t initialByteMask,
-    uint8_t /* packetNumLengthMask */) const {
-  HeaderProtectionMask headerMask = mask(sample);
+    uint8_t initialByteMask) {
   // Mask size should be > packet number length + 1.
   DCHECK_GE(headerMask.size(), kMaxPacketNumEncodingSize + 1);
   size_t packetNumLength = parsePacketNumberLength(*initialByte.data());
@@ -46,6 +44,37 @@ void PacketNumberCipher::cipherHeader(
   }
 }
 
+} // namespace
+
+void PacketNumberCipher::decipherHeader(
+    folly::ByteRange sample,
+    folly::MutableByteRange initialByte,
+    folly::MutableByteRange packetNumberBytes,
+    uint8_t initialByteMask,
+    uint8_t /* packetNumLengthMask */) const {
+  applyDecryptionMask(
+      mask(sample), initialByte, packetNumberBytes, initialByteMask);
+}
+
+void PacketNumberCipher::masks(
+    folly::Range<const Sample*> samples,
+    folly::Range<HeaderProtectionMask*> headerMasks) const {
+  CHECK_EQ(samples.size(), headerMasks.size());
+  for (size_t i = 0; i < samples.size(); ++i) {
+    headerMasks[i] = mask(folly::range(samples[i]));
+  }
+}
+
+void PacketNumberCipher::cipherHeader(
+    folly::ByteRange sample,
+    folly::MutableByteRange initialByte,
+    folly::MutableByteRange packetNumberBytes,
+    uint8_t initialByteMask,
+    uint8_t /* packetNumLengthMask */) const {
+  applyEncryptionMask(
+      mask(sample), initialByte, packetNumberBytes, initialByteMask);
+}
+
 void PacketNumberCipher::decryptLongHeader(
     folly::ByteRange sample,
     folly::MutableByteRange initialByte,
@@ -94,4 +123,36 @@ void PacketNumberCipher::encryptShortHeader(
       ShortHeader::kPacketNumLenMask);
 }
 
+void PacketNumberCipher::decryptLongHeaderWithMask(
+    const HeaderProtectionMask& mask,
+    folly::MutableByteRange initialByte,
+    folly::MutableByteRange packetNumberBytes) const {
+  applyDecryptionMask(
+      mask, initialByte, packetNumberBytes, LongHeader::kTypeBitsMask);
+}
+
+void PacketNumberCipher::decryptShortHeaderWithMask(
+    const HeaderProtectionMask& mask,
+    folly::MutableByteRange initialByte,
+    folly::MutableByteRange packetNumberBytes) const {
+  applyDecryptionMask(
+      mask, initialByte, packetNumberBytes, ShortHeader::kTypeBitsMask);
+}
+
+void PacketNumberCipher::encryptLongHeaderWithMask(
+    const HeaderProtectionMask& mask,
+    folly::MutableByteRange initialByte,
+    folly::MutableByteRange packetNumberBytes) const {
+  applyEncryptionMask(
+      mask, initialByte, packetNumberBytes, LongHeader::kTypeBitsMask);
+}
+
+void PacketNumberCipher::encryptShortHeaderWithMask(
+    const HeaderProtectionMask& mask,
+    folly::MutableByteRange initialByte,
+    folly::MutableByteRange packetNumberBytes) const {
+  applyEncryptionMask(
+      mask, initialByte, packetNumberBytes, ShortHeader::kTypeBitsMask);
+}
+
 } // namespace quic
@@ -24,6 +24,15 @@ class PacketNumberCipher {
 
   virtual HeaderProtectionMask mask(folly::ByteRange sample) const = 0;
 
+  /**
+   * Computes the mask of every sample, headerMasks must have the same size as
+   * samples. The default calls mask() once per sample, implementations should
+   * override it when they can process several samples in one pass.
+   */
+  virtual void masks(
+      folly::Range<const Sample*> samples,
+      folly::Range<HeaderProtectionMask*> headerMasks) const;
+
   /**
    * Decrypts a long header from a sample.
    * sample should be 16 bytes long.
@@ -66,6 +75,38 @@ class PacketNumberCipher {
       folly::MutableByteRange initialByte,
       folly::MutableByteRange packetNumberBytes) const;
 
+  /**
+   * Decrypts a long header with a mask previously computed by masks().
+   */
+  void decryptLongHeaderWithMask(
+      const HeaderProtectionMask& mask,
+      folly::MutableByteRange initialByte,
+      folly::MutableByteRange packetNumberBytes) const;
+
+  /**
+   * Decrypts a short header with a mask previously computed by masks().
+   */
+  void decryptShortHeaderWithMask(
+      const HeaderProtectionMask& mask,
+      folly::MutableByteRange initialByte,
+      folly::MutableByteRange packetNumberBytes) const;
+
+  /**
+   * Encrypts a long header with a mask previously computed by masks().
+   */
+  void encryptLongHeaderWithMask(
+      const HeaderProtectionMask& mask,
+      folly::MutableByteRange initialByte,
+      folly::MutableByteRange packetNumberBytes) const;
+
+  /**
+   * Encrypts a short header with a mask previously computed by masks().
+   */
+  void encryptShortHeaderWithMask(
+      const HeaderProtectionMask& mask,
+      folly::MutableByteRange initialByte,
+      folly::MutableByteRange packetNumberBytes) const;
+
   /**
    * Returns the length of key needed for the pn cipher.
    */
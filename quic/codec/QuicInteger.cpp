@@ -11,6 +11,25 @@
 
 namespace quic {
 
+namespace {
+
+/**
+ * Decodes the integer at data, which must have at least sizeof(uint64_t)
+ * readable bytes. A single load and shift handles all four lengths, so there
+ * is no branch on the length.
+ */
+inline std::pair<uint64_t, size_t> decodeQuicIntegerFromEightBytes(
+    const uint8_t* data) {
+  uint64_t raw;
+  memcpy(&raw, data, sizeof(raw));
+  raw = folly::Endian::big(raw);
+  size_t numBytes = size_t(1) << (raw >> 62);
+  uint64_t value = (raw & kEightByteLimit) >> (64 - 8 * numBytes);
+  return std::make_pair(value, numBytes);
+}
+
+} // namespace
+
 folly::Expected<size_t, TransportErrorCode> getQuicIntegerSize(uint64_t value) {
   if (value <= kOneByteLimit) {
     return 1;
@@ -46,6 +65,18 @@ uint8_t decodeQuicIntegerLength(uint8_t firstByte) {
 folly::Optional<std::pair<uint64_t, size_t>> decodeQuicInteger(
     folly::io::Cursor& cursor,
     uint64_t atMost) {
+  // Fast path for the common case of the integer not being at the very end of
+  // a contiguous buffer.
+  if (cursor.length() >= sizeof(uint64_t)) {
+    auto decoded = decodeQuicIntegerFromEightBytes(cursor.data());
+    if (decoded.second > atMost) {
+      VLOG(10) << "Could not decode integer numBytes=" << decoded.second
+               << " atMost=" << atMost;
+      return folly::none;
+    }
+    cursor.skip(decoded.second);
+    return decoded;
+  }
   size_t numBytes = 0;
   size_t advanceLen = 0;
   uint64_t result = 0;
@@ -93,6 +124,32 @@ folly::Optional<std::pair<uint64_t, size_t>> decodeQuicInteger(
       numBytes + 1);
 }
 
+folly::Optional<std::pair<uint64_t, size_t>> decodeQuicInteger(
+    folly::ByteRange& range,
+    uint64_t atMost) {
+  if (range.size() >= sizeof(uint64_t)) {
+    auto decoded = decodeQuicIntegerFromEightBytes(range.data());
+    if (decoded.second > atMost) {
+      return folly::none;
+    }
+    range.advance(decoded.second);
+    return decoded;
+  }
+  if (range.empty() || atMost < 1) {
+    return folly::none;
+  }
+  size_t numBytes = decodeQuicIntegerLength(range.front());
+  if (numBytes > atMost || numBytes > range.size()) {
+    return folly::none;
+  }
+  uint64_t value = range.front() & kOneByteLimit;
+  for (size_t i = 1; i < numBytes; i++) {
+    value = (value << 8) | range[i];
+  }
+  range.advance(numBytes);
+  return std::make_pair(value, numBytes);
+}
+
 QuicInteger::QuicInteger(uint64_t value) : value_(value) {}
 
 size_t QuicInteger::getSize() const {
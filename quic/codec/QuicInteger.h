@@ -103,6 +103,14 @@ folly::Optional<std::pair<uint64_t, size_t>> decodeQuicInteger(
     folly::io::Cursor& cursor,
     uint64_t atMost = sizeof(uint64_t));
 
+/**
+ * Same as the Cursor version, for a contiguous buffer. Reads an integer from
+ * the front of range and only advances range past it in case of success.
+ */
+folly::Optional<std::pair<uint64_t, size_t>> decodeQuicInteger(
+    folly::ByteRange& range,
+    uint64_t atMost = sizeof(uint64_t));
+
 /**
  * Returns the length of a quic integer given the first byte
  */
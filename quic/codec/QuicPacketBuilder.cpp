@@ -286,6 +286,51 @@ Buf StatelessResetPacketBuilder::buildPacket() && {
   return std::move(data_);
 }
 
+RetryPacketBuilder::RetryPacketBuilder(
+    const ConnectionId& sourceConnectionId,
+    const ConnectionId& destinationConnectionId,
+    const ConnectionId& originalDestinationConnectionId,
+    QuicVersion version,
+    const std::string& retryToken,
+    const Aead& retryCipher)
+    : data_(folly::IOBuf::create(kAppenderGrowthSize)) {
+  BufAppender appender(data_.get(), kAppenderGrowthSize);
+  // The low four bits are unused in Retry packets.
+  uint8_t initialByte = kHeaderFormMask | LongHeader::kFixedBitMask |
+      (static_cast<uint8_t>(LongHeader::Types::Retry)
+       << LongHeader::kTypeShift) |
+      (0x0f & folly::Random::secureRand32());
+  appender.writeBE<uint8_t>(initialByte);
+  appender.writeBE<QuicVersionType>(static_cast<QuicVersionType>(version));
+  appender.writeBE<uint8_t>(destinationConnectionId.size());
+  appender.push(destinationConnectionId.data(), destinationConnectionId.size());
+  appender.writeBE<uint8_t>(sourceConnectionId.size());
+  appender.push(sourceConnectionId.data(), sourceConnectionId.size());
+  appender.push((const uint8_t*)retryToken.data(), retryToken.size());
+
+  // The tag authenticates the pseudo-retry packet, which is the packet
+  // prefixed with the original destination connection id.
+  folly::IOBuf pseudoRetryPacket;
+  BufAppender pseudoAppender(&pseudoRetryPacket, kAppenderGrowthSize);
+  pseudoAppender.writeBE<uint8_t>(originalDestinationConnectionId.size());
+  pseudoAppender.push(
+      originalDestinationConnectionId.data(),
+      originalDestinationConnectionId.size());
+  data_->coalesce();
+  pseudoAppender.push(data_->data(), data_->length());
+  pseudoRetryPacket.coalesce();
+  auto integrityTag = retryCipher.inplaceEncrypt(
+      folly::IOBuf::create(retryCipher.getCipherOverhead()),
+      &pseudoRetryPacket,
+      0);
+  DCHECK_EQ(integrityTag->computeChainDataLength(), kRetryIntegrityTagLen);
+  data_->prependChain(std::move(integrityTag));
+}
+
+Buf RetryPacketBuilder::buildPacket() && {
+  return std::move(data_);
+}
+
 RegularSizeEnforcedPacketBuilder::RegularSizeEnforcedPacketBuilder(
     Packet packet,
     uint64_t enforcedSize,
@@ -14,6 +14,7 @@
 #include <quic/codec/Types.h>
 #include <quic/common/BufAccessor.h>
 #include <quic/common/BufUtil.h>
+#include <quic/handshake/Aead.h>
 #include <quic/handshake/HandshakeLayer.h>
 
 namespace quic {
@@ -377,6 +378,27 @@ class StatelessResetPacketBuilder {
   std::unique_ptr<folly::IOBuf> data_;
 };
 
+/**
+ * Builds a Retry packet carrying retryToken. The integrity tag is computed with
+ * retryCipher over the packet, prefixed with the destination connection id of
+ * the client's Initial.
+ */
+class RetryPacketBuilder {
+ public:
+  RetryPacketBuilder(
+      const ConnectionId& sourceConnectionId,
+      const ConnectionId& destinationConnectionId,
+      const ConnectionId& originalDestinationConnectionId,
+      QuicVersion version,
+      const std::string& retryToken,
+      const Aead& retryCipher);
+
+  Buf buildPacket() &&;
+
+ private:
+  std::unique_ptr<folly::IOBuf> data_;
+};
+
 /**
  * A PacketBuilder that wraps in another PacketBuilder that may have a different
  * writableBytes limit. The minimum between the limit will be used to limit the
@@ -70,6 +70,7 @@ folly::Optional<PacketEvent> PacketRebuilder::rebuildFromPacket(
           ackBlocks.insert(block.start, block.end);
         }
         AckFrameMetaData meta(ackBlocks, ackFrame.ackDelay, ackDelayExponent);
+        meta.ecnCounts = ackFrame.ecnCounts;
         auto ackWriteResult = writeAckFrame(meta, builder_);
         writeSuccess = ackWriteResult.has_value();
         break;
@@ -178,6 +179,12 @@ folly::Optional<PacketEvent> PacketRebuilder::rebuildFromPacket(
         writeSuccess = ret;
         break;
       }
+      case QuicWriteFrame::Type::DatagramFrame_E: {
+        // Datagrams are unreliable and the payload is not kept around, so
+        // they are never cloned.
+        writeSuccess = true;
+        break;
+      }
       default: {
         bool ret = writeFrame(QuicWriteFrame(frame), builder_) != 0;
         notPureAck |= ret;
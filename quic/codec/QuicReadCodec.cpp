@@ -238,7 +238,8 @@ CodecResult QuicReadCodec::tryParseShortHeaderPacket(
     Buf data,
     const AckStates& ackStates,
     size_t dstConnIdSize,
-    folly::io::Cursor& cursor) {
+    folly::io::Cursor& cursor,
+    const HeaderProtectionMask* headerMask) {
   // TODO: allow other connid lengths from the state.
   size_t packetNumberOffset = 1 + dstConnIdSize;
   PacketNum expectedNextPacketNum =
@@ -259,8 +260,13 @@ CodecResult QuicReadCodec::tryParseShortHeaderPacket(
   folly::ByteRange sampleByteRange(
       data->writableData() + sampleOffset, sample.size());
 
-  oneRttHeaderCipher_->decryptShortHeader(
-      sampleByteRange, initialByteRange, packetNumberByteRange);
+  if (headerMask) {
+    oneRttHeaderCipher_->decryptShortHeaderWithMask(
+        *headerMask, initialByteRange, packetNumberByteRange);
+  } else {
+    oneRttHeaderCipher_->decryptShortHeader(
+        sampleByteRange, initialByteRange, packetNumberByteRange);
+  }
   std::pair<PacketNum, size_t> packetNum = parsePacketNumber(
       initialByteRange.data()[0], packetNumberByteRange, expectedNextPacketNum);
   auto shortHeader =
@@ -309,6 +315,70 @@ CodecResult QuicReadCodec::parsePacket(
     BufQueue& queue,
     const AckStates& ackStates,
     size_t dstConnIdSize) {
+  return parsePacketWithMask(
+      queue, ackStates, dstConnIdSize, takeHeaderMask(queue, dstConnIdSize));
+}
+
+void QuicReadCodec::computeHeaderMasks(folly::Range<const Buf*> packets) {
+  clearHeaderMasks();
+  // Short header packets carry our own connection id.
+  const auto& connId = nodeType_ == QuicNodeType::Client ? clientConnectionId_
+                                                         : serverConnectionId_;
+  if (!oneRttReadCipher_ || !oneRttHeaderCipher_ || !connId) {
+    return;
+  }
+  size_t sampleOffset = 1 + connId->size() + kMaxPacketNumEncodingSize;
+  std::vector<Sample> samples;
+  for (const auto& packet : packets) {
+    if (!packet || packet->isChained() ||
+        packet->length() < sampleOffset + sizeof(Sample) ||
+        getHeaderForm(packet->data()[0]) != HeaderForm::Short) {
+      continue;
+    }
+    samples.emplace_back();
+    memcpy(
+        samples.back().data(), packet->data() + sampleOffset, sizeof(Sample));
+    headerMasks_.push_back({packet->data(), HeaderProtectionMask()});
+  }
+  if (samples.empty()) {
+    return;
+  }
+  std::vector<HeaderProtectionMask> masks(samples.size());
+  oneRttHeaderCipher_->masks(folly::range(samples), folly::range(masks));
+  for (size_t i = 0; i < masks.size(); ++i) {
+    headerMasks_[i].mask = masks[i];
+  }
+  headerMasksDstConnIdSize_ = connId->size();
+}
+
+void QuicReadCodec::clearHeaderMasks() {
+  headerMasks_.clear();
+  nextHeaderMask_ = 0;
+}
+
+const HeaderProtectionMask* QuicReadCodec::takeHeaderMask(
+    const BufQueue& queue,
+    size_t dstConnIdSize) {
+  if (queue.empty() || dstConnIdSize != headerMasksDstConnIdSize_) {
+    return nullptr;
+  }
+  // Packets of the batch may have been dropped before getting here, so look
+  // past them rather than only at the next mask.
+  const uint8_t* packet = queue.front()->data();
+  for (size_t i = nextHeaderMask_; i < headerMasks_.size(); ++i) {
+    if (headerMasks_[i].packet == packet) {
+      nextHeaderMask_ = i + 1;
+      return &headerMasks_[i].mask;
+    }
+  }
+  return nullptr;
+}
+
+CodecResult QuicReadCodec::parsePacketWithMask(
+    BufQueue& queue,
+    const AckStates& ackStates,
+    size_t dstConnIdSize,
+    const HeaderProtectionMask* headerMask) {
   if (queue.empty()) {
     return CodecResult(Nothing());
   }
@@ -354,7 +424,7 @@ CodecResult QuicReadCodec::parsePacket(
   }
 
   auto maybeShortHeaderPacket = tryParseShortHeaderPacket(
-      std::move(data), ackStates, dstConnIdSize, cursor);
+      std::move(data), ackStates, dstConnIdSize, cursor, headerMask);
   if (token && maybeShortHeaderPacket.nothing()) {
     return StatelessReset(*token);
   }
@@ -103,11 +103,27 @@ class QuicReadCodec {
       const AckStates& ackStates,
       size_t dstConnIdSize = kDefaultConnectionIdSize);
 
+  /**
+   * Computes the header protection masks of the short header packets of a
+   * receive batch, such as the segments of a GRO read, with one call to
+   * PacketNumberCipher::masks(). parsePacket then uses the mask of each of
+   * these packets instead of computing it, until clearHeaderMasks() or the
+   * next call. The packets have to stay alive in the meantime.
+   */
+  void computeHeaderMasks(folly::Range<const Buf*> packets);
+
+  void clearHeaderMasks();
+
+  /**
+   * headerMask, when set, is the already computed header protection mask of
+   * the packet.
+   */
   CodecResult tryParseShortHeaderPacket(
       Buf data,
       const AckStates& ackStates,
       size_t dstConnIdSize,
-      folly::io::Cursor& cursor);
+      folly::io::Cursor& cursor,
+      const HeaderProtectionMask* headerMask = nullptr);
 
   /**
    * Tries to parse the packet and returns whether or not
@@ -167,6 +183,16 @@ class QuicReadCodec {
       BufQueue& queue,
       const AckStates& ackStates);
 
+  CodecResult parsePacketWithMask(
+      BufQueue& queue,
+      const AckStates& ackStates,
+      size_t dstConnIdSize,
+      const HeaderProtectionMask* headerMask);
+
+  const HeaderProtectionMask* takeHeaderMask(
+      const BufQueue& queue,
+      size_t dstConnIdSize);
+
   std::string connIdToHex();
 
   QuicNodeType nodeType_;
@@ -189,6 +215,16 @@ class QuicReadCodec {
 
   folly::Optional<StatelessResetToken> statelessResetToken_;
   folly::Optional<TimePoint> handshakeDoneTime_;
+
+  // Masks from computeHeaderMasks(), with the start of the packet each one
+  // belongs to, in the order of the batch.
+  struct ComputedHeaderMask {
+    const uint8_t* packet;
+    HeaderProtectionMask mask;
+  };
+  std::vector<ComputedHeaderMask> headerMasks_;
+  size_t nextHeaderMask_{0};
+  size_t headerMasksDstConnIdSize_{0};
 };
 
 } // namespace quic
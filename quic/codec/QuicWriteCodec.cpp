@@ -280,10 +280,20 @@ folly::Optional<AckFrameWriteResult> writeAckFrame(
 
   // Required fields are Type, LargestAcked, AckDelay, AckBlockCount,
   // firstAckBlockLength
-  QuicInteger encodedintFrameType(static_cast<uint8_t>(FrameType::ACK));
+  QuicInteger encodedintFrameType(static_cast<uint8_t>(
+      ackFrameMetaData.ecnCounts ? FrameType::ACK_ECN : FrameType::ACK));
   auto headerSize = encodedintFrameType.getSize() +
       largestAckedPacketInt.getSize() + ackDelayInt.getSize() +
       minAdditionalAckBlockCount.getSize() + firstAckBlockLengthInt.getSize();
+  // The ECN counts go after the ack blocks, reserve their space up front so
+  // the blocks don't use it up.
+  auto ecnCounts = ackFrameMetaData.ecnCounts.value_or(ECNCounts());
+  QuicInteger ect0Int(ecnCounts.ect0);
+  QuicInteger ect1Int(ecnCounts.ect1);
+  QuicInteger ceInt(ecnCounts.ce);
+  if (ackFrameMetaData.ecnCounts) {
+    headerSize += ect0Int.getSize() + ect1Int.getSize() + ceInt.getSize();
+  }
   if (spaceLeft < headerSize) {
     return folly::none;
   }
@@ -313,7 +323,13 @@ folly::Optional<AckFrameWriteResult> writeAckFrame(
     builder.write(currentBlockLenInt);
     currentSeqNum = it->start;
   }
+  if (ackFrameMetaData.ecnCounts) {
+    builder.write(ect0Int);
+    builder.write(ect1Int);
+    builder.write(ceInt);
+  }
   ackFrame.ackDelay = ackFrameMetaData.ackDelay;
+  ackFrame.ecnCounts = ackFrameMetaData.ecnCounts;
   builder.appendFrame(std::move(ackFrame));
   return AckFrameWriteResult(
       beginningSpace - builder.remainingSpaceInPkt(),
@@ -510,6 +526,58 @@ size_t writeSimpleFrame(
       // no space left in packet
       return size_t(0);
     }
+    case QuicSimpleFrame::Type::AckFrequencyFrame_E: {
+      const AckFrequencyFrame& ackFrequencyFrame = *frame.asAckFrequencyFrame();
+      QuicInteger intFrameType(static_cast<uint64_t>(FrameType::ACK_FREQUENCY));
+      QuicInteger sequenceNumber(ackFrequencyFrame.sequenceNumber);
+      QuicInteger packetTolerance(ackFrequencyFrame.packetTolerance);
+      QuicInteger updateMaxAckDelay(ackFrequencyFrame.updateMaxAckDelay);
+      QuicInteger reorderThreshold(ackFrequencyFrame.reorderThreshold);
+      size_t ackFrequencyFrameLen = intFrameType.getSize() +
+          sequenceNumber.getSize() + packetTolerance.getSize() +
+          updateMaxAckDelay.getSize() + reorderThreshold.getSize();
+      if (packetSpaceCheck(spaceLeft, ackFrequencyFrameLen)) {
+        builder.write(intFrameType);
+        builder.write(sequenceNumber);
+        builder.write(packetTolerance);
+        builder.write(updateMaxAckDelay);
+        builder.write(reorderThreshold);
+        builder.appendFrame(QuicSimpleFrame(ackFrequencyFrame));
+        return ackFrequencyFrameLen;
+      }
+      // no space left in packet
+      return size_t(0);
+    }
+    case QuicSimpleFrame::Type::ImmediateAckFrame_E: {
+      const ImmediateAckFrame& immediateAckFrame = *frame.asImmediateAckFrame();
+      QuicInteger intFrameType(static_cast<uint64_t>(FrameType::IMMEDIATE_ACK));
+      if (packetSpaceCheck(spaceLeft, intFrameType.getSize())) {
+        builder.write(intFrameType);
+        builder.appendFrame(QuicSimpleFrame(immediateAckFrame));
+        return intFrameType.getSize();
+      }
+      // no space left in packet
+      return size_t(0);
+    }
+    case QuicSimpleFrame::Type::NewTokenFrame_E: {
+      const NewTokenFrame& newTokenFrame = *frame.asNewTokenFrame();
+      CHECK(builder.getPacketHeader().asShort());
+      QuicInteger intFrameType(static_cast<uint8_t>(FrameType::NEW_TOKEN));
+      QuicInteger tokenLength(newTokenFrame.token.size());
+      auto newTokenFrameSize = intFrameType.getSize() + tokenLength.getSize() +
+          newTokenFrame.token.size();
+      if (packetSpaceCheck(spaceLeft, newTokenFrameSize)) {
+        builder.write(intFrameType);
+        builder.write(tokenLength);
+        builder.push(
+            (const uint8_t*)newTokenFrame.token.data(),
+            newTokenFrame.token.size());
+        builder.appendFrame(QuicSimpleFrame(newTokenFrame));
+        return newTokenFrameSize;
+      }
+      // no space left in packet
+      return size_t(0);
+    }
   }
   folly::assume_unreachable();
 }
@@ -691,8 +759,27 @@ size_t writeFrame(QuicWriteFrame&& frame, PacketBuilderInterface& builder) {
     case QuicWriteFrame::Type::QuicSimpleFrame_E: {
       return writeSimpleFrame(std::move(*frame.asQuicSimpleFrame()), builder);
     }
+    case QuicWriteFrame::Type::DatagramFrame_E: {
+      DatagramFrame& datagramFrame = *frame.asDatagramFrame();
+      // Always write the length so that other frames can follow.
+      QuicInteger intFrameType(static_cast<uint8_t>(FrameType::DATAGRAM_LEN));
+      QuicInteger length(datagramFrame.length);
+      auto datagramFrameSize =
+          intFrameType.getSize() + length.getSize() + datagramFrame.length;
+      if (packetSpaceCheck(spaceLeft, datagramFrameSize)) {
+        builder.write(intFrameType);
+        builder.write(length);
+        builder.insert(std::move(datagramFrame.data));
+        // The payload now belongs to the packet, the outstanding copy of the
+        // frame only needs the length.
+        builder.appendFrame(DatagramFrame(datagramFrame.length, nullptr));
+        return datagramFrameSize;
+      }
+      // no space left in packet
+      return size_t(0);
+    }
     default: {
-      // TODO add support for: RETIRE_CONNECTION_ID and NEW_TOKEN frames
+      // TODO add support for: RETIRE_CONNECTION_ID frames
       auto errorStr = folly::to<std::string>(
           "Unknown / unsupported frame type received at ", __func__);
       VLOG(2) << errorStr;
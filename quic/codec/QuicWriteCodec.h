@@ -22,6 +22,8 @@ struct AckFrameMetaData {
   std::chrono::microseconds ackDelay;
   // The ack delay exponent to use.
   uint8_t ackDelayExponent;
+  // ECN counts to echo, the frame is written as ACK_ECN when set.
+  folly::Optional<ECNCounts> ecnCounts;
 
   AckFrameMetaData(
       const AckBlocks& acksIn,
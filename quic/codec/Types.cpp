@@ -307,9 +307,17 @@ StreamTypeField StreamTypeField::Builder::build() {
   return StreamTypeField(field_);
 }
 
-Buf RetryToken::getPlaintextToken() {
+size_t DatagramFrame::encodedSize() const {
+  size_t size = sizeof(uint8_t) + length;
+  if (hasLength) {
+    size += getQuicIntegerSizeThrows(length);
+  }
+  return size;
+}
+
+Buf RetryToken::getPlaintextToken() const {
   // The plaintext token consists of the following:
-  // len(odcid) || odcid || port || ipaddr_len || ipaddr
+  // len(odcid) || odcid || port || ipaddr_len || ipaddr || timestamp
   auto buf = std::make_unique<folly::IOBuf>();
   folly::io::Appender appender(buf.get(), 20);
 
@@ -331,6 +339,29 @@ Buf RetryToken::getPlaintextToken() {
   // Write the ipaddr
   appender.push((const uint8_t*)clientIpStr.data(), clientIpStr.size());
 
+  // Write the timestamp
+  appender.writeBE<uint64_t>(timestampInMs);
+
+  return buf;
+}
+
+Buf NewToken::getPlaintextToken() const {
+  // The plaintext token consists of the following:
+  // ipaddr_len || ipaddr || timestamp
+  auto buf = std::make_unique<folly::IOBuf>();
+  folly::io::Appender appender(buf.get(), 20);
+
+  std::string clientIpStr = clientIp.str();
+
+  // Write the ipaddr len
+  appender.writeBE<uint8_t>(clientIpStr.size());
+
+  // Write the ipaddr
+  appender.push((const uint8_t*)clientIpStr.data(), clientIpStr.size());
+
+  // Write the timestamp
+  appender.writeBE<uint64_t>(timestampInMs);
+
   return buf;
 }
 
@@ -425,6 +456,13 @@ std::string toString(FrameType frame) {
       return "EXPIRED_STREAM_DATA";
     case FrameType::HANDSHAKE_DONE:
       return "HANDSHAKE_DONE";
+    case FrameType::DATAGRAM:
+    case FrameType::DATAGRAM_LEN:
+      return "DATAGRAM";
+    case FrameType::IMMEDIATE_ACK:
+      return "IMMEDIATE_ACK";
+    case FrameType::ACK_FREQUENCY:
+      return "ACK_FREQUENCY";
     case FrameType::KNOB:
       return "KNOB";
   }
@@ -121,6 +121,20 @@ struct AckBlock {
       : startPacket(start), endPacket(end) {}
 };
 
+/**
+ * ECN counts carried by an ACK_ECN frame: the number of packets received in
+ * the packet number space with each of the ECN codepoints.
+ */
+struct ECNCounts {
+  uint64_t ect0{0};
+  uint64_t ect1{0};
+  uint64_t ce{0};
+
+  bool operator==(const ECNCounts& rhs) const {
+    return ect0 == rhs.ect0 && ect1 == rhs.ect1 && ce == rhs.ce;
+  }
+};
+
 /**
  0                   1                   2                   3
  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
@@ -150,6 +164,8 @@ struct ReadAckFrame {
   // These are ordered in descending order by start packet.
   using Vec = SmallVec<AckBlock, kNumInitialAckBlocksPerFrame, uint16_t>;
   Vec ackBlocks;
+  // Only set for ACK_ECN frames.
+  folly::Optional<ECNCounts> ecnCounts;
 
   bool operator==(const ReadAckFrame& /*rhs*/) const {
     // Can't compare ackBlocks, function is just here to appease compiler.
@@ -165,6 +181,8 @@ struct WriteAckFrame {
   AckBlockVec ackBlocks;
   // Delay in sending ack from time that packet was received.
   std::chrono::microseconds ackDelay{0us};
+  // Written as an ACK_ECN frame when set.
+  folly::Optional<ECNCounts> ecnCounts;
 
   bool operator==(const WriteAckFrame& /*rhs*/) const {
     // Can't compare ackBlocks, function is just here to appease compiler.
@@ -598,6 +616,109 @@ struct HandshakeDoneFrame {
   }
 };
 
+/**
+ * The NEW_TOKEN frame the server writes. The client reads it as a
+ * ReadNewTokenFrame.
+ */
+struct NewTokenFrame {
+  std::string token;
+
+  explicit NewTokenFrame(std::string tokenIn) : token(std::move(tokenIn)) {}
+
+  bool operator==(const NewTokenFrame& rhs) const {
+    return token == rhs.token;
+  }
+};
+
+/**
+ * Asks the peer to send an ACK every packetTolerance ack-eliciting packets, or
+ * after updateMaxAckDelay microseconds, whichever comes first. A
+ * reorderThreshold of 0 tells the peer not to ack out of order packets
+ * immediately.
+ */
+struct AckFrequencyFrame {
+  uint64_t sequenceNumber;
+  uint64_t packetTolerance;
+  uint64_t updateMaxAckDelay;
+  uint64_t reorderThreshold;
+
+  AckFrequencyFrame(
+      uint64_t sequenceNumberIn,
+      uint64_t packetToleranceIn,
+      uint64_t updateMaxAckDelayIn,
+      uint64_t reorderThresholdIn)
+      : sequenceNumber(sequenceNumberIn),
+        packetTolerance(packetToleranceIn),
+        updateMaxAckDelay(updateMaxAckDelayIn),
+        reorderThreshold(reorderThresholdIn) {}
+
+  bool operator==(const AckFrequencyFrame& rhs) const {
+    return sequenceNumber == rhs.sequenceNumber &&
+        packetTolerance == rhs.packetTolerance &&
+        updateMaxAckDelay == rhs.updateMaxAckDelay &&
+        reorderThreshold == rhs.reorderThreshold;
+  }
+};
+
+struct ImmediateAckFrame {
+  bool operator==(const ImmediateAckFrame& /*rhs*/) const {
+    return true;
+  }
+};
+
+/**
+ * Unreliable DATAGRAM frame (RFC 9221). It is ack-eliciting but never
+ * retransmitted. On the write side the payload is handed over to the packet
+ * builder when the frame is written, so the copy recorded in the outstanding
+ * packet only keeps the length.
+ */
+struct DatagramFrame {
+  size_t length;
+  Buf data;
+  // Whether the frame carries an explicit length (DATAGRAM_LEN). Only the
+  // read side has frames without one.
+  bool hasLength;
+
+  DatagramFrame(size_t lengthIn, Buf dataIn, bool hasLengthIn = true)
+      : length(lengthIn), data(std::move(dataIn)), hasLength(hasLengthIn) {}
+
+  // Stuff stored in a variant type needs to be copyable.
+  DatagramFrame(const DatagramFrame& other)
+      : length(other.length),
+        data(other.data ? other.data->clone() : nullptr),
+        hasLength(other.hasLength) {}
+
+  DatagramFrame(DatagramFrame&& other) noexcept
+      : length(other.length),
+        data(std::move(other.data)),
+        hasLength(other.hasLength) {}
+
+  DatagramFrame& operator=(const DatagramFrame& other) {
+    length = other.length;
+    data = other.data ? other.data->clone() : nullptr;
+    hasLength = other.hasLength;
+    return *this;
+  }
+
+  DatagramFrame& operator=(DatagramFrame&& other) noexcept {
+    length = other.length;
+    data = std::move(other.data);
+    hasLength = other.hasLength;
+    return *this;
+  }
+
+  /**
+   * Size of the whole frame on the wire, which is what max_datagram_frame_size
+   * limits.
+   */
+  size_t encodedSize() const;
+
+  bool operator==(const DatagramFrame& other) const {
+    folly::IOBufEqualTo eq;
+    return length == other.length && eq(data, other.data);
+  }
+};
+
 // Frame to represent ones we skip
 struct NoopFrame {
   bool operator==(const NoopFrame&) const {
@@ -616,19 +737,36 @@ struct RetryToken {
   RetryToken(
       ConnectionId originalDstConnIdIn,
       folly::IPAddress clientIpIn,
-      uint16_t clientPortIn)
+      uint16_t clientPortIn,
+      uint64_t timestampInMsIn = 0)
       : originalDstConnId(originalDstConnIdIn),
         clientIp(clientIpIn),
-        clientPort(clientPortIn) {}
+        clientPort(clientPortIn),
+        timestampInMs(timestampInMsIn) {}
 
   // We serialize the members to obtain a plaintext token.
   // This token is encrypted before it's placed in the outgoing
   // Retry packet.
-  Buf getPlaintextToken();
+  Buf getPlaintextToken() const;
 
   ConnectionId originalDstConnId;
   folly::IPAddress clientIp;
   uint16_t clientPort;
+  // When the token was issued, in milliseconds since the epoch.
+  uint64_t timestampInMs;
+};
+
+struct NewToken {
+  explicit NewToken(folly::IPAddress clientIpIn, uint64_t timestampInMsIn = 0)
+      : clientIp(clientIpIn), timestampInMs(timestampInMsIn) {}
+
+  // We serialize the members to obtain a plaintext token.
+  // This token is encrypted before it's placed in a NEW_TOKEN frame.
+  Buf getPlaintextToken() const;
+
+  folly::IPAddress clientIp;
+  // When the token was issued, in milliseconds since the epoch.
+  uint64_t timestampInMs;
 };
 
 #define QUIC_SIMPLE_FRAME(F, ...)         \
@@ -641,7 +779,10 @@ struct RetryToken {
   F(MaxStreamsFrame, __VA_ARGS__)         \
   F(RetireConnectionIdFrame, __VA_ARGS__) \
   F(HandshakeDoneFrame, __VA_ARGS__)      \
-  F(KnobFrame, __VA_ARGS__)
+  F(KnobFrame, __VA_ARGS__)               \
+  F(AckFrequencyFrame, __VA_ARGS__)       \
+  F(ImmediateAckFrame, __VA_ARGS__)       \
+  F(NewTokenFrame, __VA_ARGS__)
 
 DECLARE_VARIANT_TYPE(QuicSimpleFrame, QUIC_SIMPLE_FRAME)
 
@@ -660,7 +801,8 @@ DECLARE_VARIANT_TYPE(QuicSimpleFrame, QUIC_SIMPLE_FRAME)
   F(ReadNewTokenFrame, __VA_ARGS__)      \
   F(QuicSimpleFrame, __VA_ARGS__)        \
   F(PingFrame, __VA_ARGS__)              \
-  F(NoopFrame, __VA_ARGS__)
+  F(NoopFrame, __VA_ARGS__)              \
+  F(DatagramFrame, __VA_ARGS__)
 
 DECLARE_VARIANT_TYPE(QuicFrame, QUIC_FRAME)
 
@@ -678,7 +820,8 @@ DECLARE_VARIANT_TYPE(QuicFrame, QUIC_FRAME)
   F(WriteCryptoFrame, __VA_ARGS__)       \
   F(QuicSimpleFrame, __VA_ARGS__)        \
   F(PingFrame, __VA_ARGS__)              \
-  F(NoopFrame, __VA_ARGS__)
+  F(NoopFrame, __VA_ARGS__)              \
+  F(DatagramFrame, __VA_ARGS__)
 
 // Types of frames which are written.
 DECLARE_VARIANT_TYPE(QuicWriteFrame, QUIC_WRITE_FRAME)
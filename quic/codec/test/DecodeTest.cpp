@@ -518,6 +518,44 @@ TEST_F(DecodeTest, AckFrameBlockLengthZero) {
   EXPECT_EQ(readAckFrame.ackBlocks[3].startPacket, 944);
 }
 
+TEST_F(DecodeTest, AckFrameWithECNCounts) {
+  auto result = createAckFrame(
+      QuicInteger(1000), QuicInteger(100), QuicInteger(0), QuicInteger(10));
+  BufAppender wcursor(result.get(), 10);
+  auto appenderOp = [&](auto val) { wcursor.writeBE(val); };
+  QuicInteger(20).encode(appenderOp);
+  QuicInteger(0).encode(appenderOp);
+  QuicInteger(300).encode(appenderOp);
+  folly::io::Cursor cursor(result.get());
+
+  auto readAckFrame = decodeAckFrameWithECN(
+      cursor,
+      makeHeader(),
+      CodecParameters(kDefaultAckDelayExponent, QuicVersion::MVFST));
+  EXPECT_EQ(readAckFrame.largestAcked, 1000);
+  ASSERT_TRUE(readAckFrame.ecnCounts.has_value());
+  EXPECT_EQ(readAckFrame.ecnCounts->ect0, 20);
+  EXPECT_EQ(readAckFrame.ecnCounts->ect1, 0);
+  EXPECT_EQ(readAckFrame.ecnCounts->ce, 300);
+  EXPECT_TRUE(cursor.isAtEnd());
+}
+
+TEST_F(DecodeTest, AckFrameWithECNCountsMissing) {
+  auto result = createAckFrame(
+      QuicInteger(1000), QuicInteger(100), QuicInteger(0), QuicInteger(10));
+  BufAppender wcursor(result.get(), 10);
+  auto appenderOp = [&](auto val) { wcursor.writeBE(val); };
+  QuicInteger(20).encode(appenderOp);
+  folly::io::Cursor cursor(result.get());
+
+  EXPECT_THROW(
+      decodeAckFrameWithECN(
+          cursor,
+          makeHeader(),
+          CodecParameters(kDefaultAckDelayExponent, QuicVersion::MVFST)),
+      QuicTransportException);
+}
+
 TEST_F(DecodeTest, StreamDecodeSuccess) {
   QuicInteger streamId(10);
   QuicInteger offset(10);
@@ -737,11 +775,79 @@ TEST_F(DecodeTest, DecodeExpiredStreamDataFrame) {
   EXPECT_EQ(result.minimumStreamOffset, 100);
 }
 
+TEST_F(DecodeTest, DecodeDatagramFrame) {
+  // Without a length the datagram extends to the end of the packet.
+  auto payload = folly::IOBuf::copyBuffer("datagram");
+  folly::io::Cursor cursor(payload.get());
+  auto frame = decodeDatagramFrame(cursor, false);
+  EXPECT_EQ(frame.length, payload->length());
+  EXPECT_TRUE(folly::IOBufEqualTo()(frame.data, payload));
+  EXPECT_TRUE(cursor.isAtEnd());
+
+  auto datagramFrame = folly::IOBuf::create(0);
+  BufAppender wcursor(datagramFrame.get(), 10);
+  auto appenderOp = [&](auto val) { wcursor.writeBE(val); };
+  QuicInteger length(4);
+  length.encode(appenderOp);
+  wcursor.insert(payload->clone());
+  folly::io::Cursor lenCursor(datagramFrame.get());
+  auto lenFrame = decodeDatagramFrame(lenCursor, true);
+  EXPECT_EQ(lenFrame.length, 4);
+  EXPECT_EQ(lenFrame.data->moveToFbString().toStdString(), "data");
+  // Whatever follows is left for the next frame.
+  EXPECT_EQ(lenCursor.totalLength(), payload->length() - 4);
+}
+
+TEST_F(DecodeTest, DecodeDatagramFrameIncorrectDataLength) {
+  auto datagramFrame = folly::IOBuf::create(0);
+  BufAppender wcursor(datagramFrame.get(), 10);
+  auto appenderOp = [&](auto val) { wcursor.writeBE(val); };
+  QuicInteger length(100);
+  length.encode(appenderOp);
+  wcursor.insert(folly::IOBuf::copyBuffer("datagram"));
+  folly::io::Cursor cursor(datagramFrame.get());
+  EXPECT_THROW(decodeDatagramFrame(cursor, true), QuicTransportException);
+}
+
+TEST_F(DecodeTest, DecodeAckFrequencyFrame) {
+  auto ackFrequencyFrame = folly::IOBuf::create(0);
+  BufAppender wcursor(ackFrequencyFrame.get(), 10);
+  auto appenderOp = [&](auto val) { wcursor.writeBE(val); };
+  QuicInteger sequenceNumber(3);
+  QuicInteger packetTolerance(50);
+  QuicInteger updateMaxAckDelay(20000);
+  QuicInteger reorderThreshold(0);
+  sequenceNumber.encode(appenderOp);
+  packetTolerance.encode(appenderOp);
+  updateMaxAckDelay.encode(appenderOp);
+  reorderThreshold.encode(appenderOp);
+  folly::io::Cursor cursor(ackFrequencyFrame.get());
+  auto frame = decodeAckFrequencyFrame(cursor);
+  EXPECT_EQ(frame.sequenceNumber, 3);
+  EXPECT_EQ(frame.packetTolerance, 50);
+  EXPECT_EQ(frame.updateMaxAckDelay, 20000);
+  EXPECT_EQ(frame.reorderThreshold, 0);
+  EXPECT_TRUE(cursor.isAtEnd());
+}
+
+TEST_F(DecodeTest, DecodeAckFrequencyFrameTruncated) {
+  auto ackFrequencyFrame = folly::IOBuf::create(0);
+  BufAppender wcursor(ackFrequencyFrame.get(), 10);
+  auto appenderOp = [&](auto val) { wcursor.writeBE(val); };
+  QuicInteger sequenceNumber(3);
+  QuicInteger packetTolerance(50);
+  sequenceNumber.encode(appenderOp);
+  packetTolerance.encode(appenderOp);
+  folly::io::Cursor cursor(ackFrequencyFrame.get());
+  EXPECT_THROW(decodeAckFrequencyFrame(cursor), QuicTransportException);
+}
+
 TEST_F(DecodeTest, ParsePlaintextRetryToken) {
   ConnectionId odcid = getTestConnectionId();
   folly::IPAddress clientIp("109.115.3.49");
   uint16_t clientPort = 42069;
-  RetryToken retryToken(odcid, clientIp, clientPort);
+  uint64_t timestampInMs = 1234567890123;
+  RetryToken retryToken(odcid, clientIp, clientPort, timestampInMs);
   Buf plaintextRetryToken = retryToken.getPlaintextToken();
 
   folly::io::Cursor cursor(plaintextRetryToken.get());
@@ -751,6 +857,48 @@ TEST_F(DecodeTest, ParsePlaintextRetryToken) {
   EXPECT_EQ(parseResult->originalDstConnId, odcid);
   EXPECT_EQ(parseResult->clientIp, clientIp);
   EXPECT_EQ(parseResult->clientPort, clientPort);
+  EXPECT_EQ(parseResult->timestampInMs, timestampInMs);
+}
+
+TEST_F(DecodeTest, ParsePlaintextRetryTokenTruncated) {
+  RetryToken retryToken(
+      getTestConnectionId(), folly::IPAddress("109.115.3.49"), 42069, 1);
+  Buf plaintextRetryToken = retryToken.getPlaintextToken();
+  plaintextRetryToken->coalesce();
+  plaintextRetryToken->trimEnd(1);
+
+  folly::io::Cursor cursor(plaintextRetryToken.get());
+  auto parseResult = parsePlaintextRetryToken(cursor);
+
+  EXPECT_TRUE(parseResult.hasError());
+  EXPECT_EQ(parseResult.error(), TransportErrorCode::INVALID_TOKEN);
+}
+
+TEST_F(DecodeTest, ParsePlaintextNewToken) {
+  folly::IPAddress clientIp("2001:db8::1");
+  uint64_t timestampInMs = 1234567890123;
+  NewToken newToken(clientIp, timestampInMs);
+  Buf plaintextNewToken = newToken.getPlaintextToken();
+
+  folly::io::Cursor cursor(plaintextNewToken.get());
+  auto parseResult = parsePlaintextNewToken(cursor);
+
+  EXPECT_TRUE(parseResult.hasValue());
+  EXPECT_EQ(parseResult->clientIp, clientIp);
+  EXPECT_EQ(parseResult->timestampInMs, timestampInMs);
+}
+
+TEST_F(DecodeTest, ParsePlaintextNewTokenTruncated) {
+  NewToken newToken(folly::IPAddress("109.115.3.49"), 1);
+  Buf plaintextNewToken = newToken.getPlaintextToken();
+  plaintextNewToken->coalesce();
+  plaintextNewToken->trimEnd(1);
+
+  folly::io::Cursor cursor(plaintextNewToken.get());
+  auto parseResult = parsePlaintextNewToken(cursor);
+
+  EXPECT_TRUE(parseResult.hasError());
+  EXPECT_EQ(parseResult.error(), TransportErrorCode::INVALID_TOKEN);
 }
 
 TEST_F(DecodeTest, ParsePlaintextRetryTokenMalformed) {
@@ -0,0 +1,339 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <folly/Benchmark.h>
+#include <folly/init/Init.h>
+#include <folly/io/Cursor.h>
+
+#include <quic/codec/Decode.h>
+#include <quic/codec/QuicInteger.h>
+#include <quic/codec/QuicPacketBuilder.h>
+#include <quic/codec/QuicReadCodec.h>
+#include <quic/codec/QuicWriteCodec.h>
+#include <quic/common/BufAccessor.h>
+#include <quic/common/test/TestUtils.h>
+
+using namespace quic;
+using namespace quic::test;
+
+namespace {
+
+constexpr size_t kNumIntegers = 1000;
+constexpr StreamId kStreamId = 4;
+
+/**
+ * The packet contents the builder and parser benchmarks run over. The mix is
+ * what a bulk transfer looks like: full sized data packets from the sender and
+ * ack-only packets from the receiver, sometimes both in one packet.
+ */
+enum class PacketMix { StreamOnly, AckOnly, AckAndStream };
+
+/**
+ * Varint values sized like the ones on the wire: mostly frame types, stream
+ * ids and lengths that fit in one or two bytes, some offsets that need four
+ * bytes and a few eight byte ones.
+ */
+std::vector<uint64_t> makeIntegers() {
+  std::vector<uint64_t> values;
+  values.reserve(kNumIntegers);
+  for (size_t i = 0; i < kNumIntegers; i++) {
+    auto bucket = i % 100;
+    if (bucket < 60) {
+      values.push_back(i % kOneByteLimit);
+    } else if (bucket < 85) {
+      values.push_back(
+          kOneByteLimit + i * 7 % (kTwoByteLimit - kOneByteLimit));
+    } else if (bucket < 97) {
+      values.push_back(kTwoByteLimit + i * 1009);
+    } else {
+      values.push_back(kFourByteLimit + i * 100003);
+    }
+  }
+  return values;
+}
+
+AckBlocks makeAckBlocks(size_t numBlocks) {
+  // Every third packet is missing, like a receiver seeing sporadic loss.
+  AckBlocks ackBlocks;
+  PacketNum start = 1000;
+  for (size_t i = 0; i < numBlocks; i++) {
+    ackBlocks.insert(start, start + 1);
+    start += 3;
+  }
+  return ackBlocks;
+}
+
+ShortHeader makeHeader(PacketNum packetNum) {
+  return ShortHeader(
+      ProtectionType::KeyPhaseZero, getTestConnectionId(), packetNum);
+}
+
+void writePacketFrames(
+    PacketBuilderInterface& builder,
+    PacketMix mix,
+    const AckBlocks& ackBlocks,
+    const Buf& data,
+    uint64_t offset) {
+  builder.encodePacketHeader();
+  if (mix != PacketMix::StreamOnly) {
+    AckFrameMetaData meta(
+        ackBlocks, std::chrono::microseconds(100), kDefaultAckDelayExponent);
+    writeAckFrame(meta, builder);
+  }
+  if (mix != PacketMix::AckOnly) {
+    auto dataLen = writeStreamFrameHeader(
+        builder,
+        kStreamId,
+        offset,
+        data->computeChainDataLength(),
+        data->computeChainDataLength(),
+        false,
+        folly::none);
+    CHECK(dataLen);
+    writeStreamFrameData(builder, data->clone(), *dataLen);
+  }
+}
+
+Buf buildPacketBuf(PacketMix mix, const AckBlocks& ackBlocks) {
+  auto data = buildRandomInputData(kDefaultUDPSendPacketLen);
+  RegularQuicPacketBuilder builder(kDefaultUDPSendPacketLen, makeHeader(1), 0);
+  writePacketFrames(builder, mix, ackBlocks, data, 0);
+  return packetToBuf(std::move(builder).buildPacket());
+}
+
+Buf encodeIntegers() {
+  auto values = makeIntegers();
+  auto buf = folly::IOBuf::create(kNumIntegers * sizeof(uint64_t));
+  BufAppender appender(buf.get(), kNumIntegers * sizeof(uint64_t));
+  auto appendOp = [&](auto val) { appender.writeBE(val); };
+  for (auto value : values) {
+    encodeQuicInteger(value, appendOp);
+  }
+  return buf;
+}
+
+void encodeQuicIntegerBench(uint32_t iters) {
+  std::vector<uint64_t> values;
+  BENCHMARK_SUSPEND {
+    values = makeIntegers();
+  }
+  std::array<uint8_t, sizeof(uint64_t)> out;
+  auto appendOp = [&](auto val) {
+    auto bigEndian = folly::Endian::big(val);
+    memcpy(out.data(), &bigEndian, sizeof(bigEndian));
+  };
+  for (uint32_t i = 0; i < iters; i++) {
+    folly::doNotOptimizeAway(
+        encodeQuicInteger(values[i % kNumIntegers], appendOp));
+  }
+  folly::doNotOptimizeAway(out);
+}
+
+void decodeQuicIntegerBench(uint32_t iters) {
+  Buf buf;
+  BENCHMARK_SUSPEND {
+    buf = encodeIntegers();
+  }
+  folly::io::Cursor cursor(buf.get());
+  for (uint32_t i = 0; i < iters; i++) {
+    if (cursor.isAtEnd()) {
+      cursor.reset(buf.get());
+    }
+    folly::doNotOptimizeAway(decodeQuicInteger(cursor));
+  }
+}
+
+/**
+ * The integers split over one IOBuf per byte, which always takes the
+ * bounds-checked path that contiguous buffers used to take too.
+ */
+void decodeQuicIntegerChainedBench(uint32_t iters) {
+  Buf buf;
+  BENCHMARK_SUSPEND {
+    auto contiguous = encodeIntegers();
+    buf = folly::IOBuf::create(0);
+    for (size_t i = 0; i < contiguous->length(); i++) {
+      buf->prependChain(folly::IOBuf::copyBuffer(contiguous->data() + i, 1));
+    }
+  }
+  folly::io::Cursor cursor(buf.get());
+  for (uint32_t i = 0; i < iters; i++) {
+    if (cursor.isAtEnd()) {
+      cursor.reset(buf.get());
+    }
+    folly::doNotOptimizeAway(decodeQuicInteger(cursor));
+  }
+}
+
+void decodeQuicIntegerRangeBench(uint32_t iters) {
+  Buf buf;
+  BENCHMARK_SUSPEND {
+    buf = encodeIntegers();
+  }
+  folly::ByteRange range;
+  for (uint32_t i = 0; i < iters; i++) {
+    if (range.empty()) {
+      range = folly::ByteRange(buf->data(), buf->length());
+    }
+    folly::doNotOptimizeAway(decodeQuicInteger(range));
+  }
+}
+
+void decodeAckFrameBench(uint32_t iters, size_t numBlocks) {
+  Buf frameBuf;
+  BENCHMARK_SUSPEND {
+    auto ackBlocks = makeAckBlocks(numBlocks);
+    RegularQuicPacketBuilder builder(
+        kDefaultUDPSendPacketLen, makeHeader(1), 0);
+    builder.encodePacketHeader();
+    AckFrameMetaData meta(
+        ackBlocks, std::chrono::microseconds(100), kDefaultAckDelayExponent);
+    CHECK(writeAckFrame(meta, builder));
+    frameBuf = std::move(builder).buildPacket().body;
+    // Skip the frame type, decodeAckFrame starts after it.
+    frameBuf->coalesce();
+    frameBuf->trimStart(1);
+  }
+  auto header = makeHeader(1);
+  CodecParameters params(kDefaultAckDelayExponent, QuicVersion::MVFST);
+  for (uint32_t i = 0; i < iters; i++) {
+    folly::io::Cursor cursor(frameBuf.get());
+    folly::doNotOptimizeAway(decodeAckFrame(cursor, header, params));
+  }
+}
+
+void parsePacketBench(uint32_t iters, PacketMix mix) {
+  std::unique_ptr<QuicReadCodec> codec;
+  Buf packetBuf;
+  BENCHMARK_SUSPEND {
+    codec = std::make_unique<QuicReadCodec>(QuicNodeType::Server);
+    codec->setCodecParameters(
+        CodecParameters(kDefaultAckDelayExponent, QuicVersion::MVFST));
+    codec->setOneRttReadCipher(createNoOpAead());
+    codec->setOneRttHeaderCipher(createNoOpHeaderCipher());
+    packetBuf = buildPacketBuf(mix, makeAckBlocks(4));
+  }
+  AckStates ackStates;
+  for (uint32_t i = 0; i < iters; i++) {
+    BufQueue queue;
+    BENCHMARK_SUSPEND {
+      queue.append(packetBuf->clone());
+    }
+    auto result = codec->parsePacket(queue, ackStates);
+    CHECK(result.regularPacket());
+    folly::doNotOptimizeAway(result);
+  }
+}
+
+void regularBuilderBench(uint32_t iters, PacketMix mix) {
+  Buf data;
+  AckBlocks ackBlocks;
+  BENCHMARK_SUSPEND {
+    data = buildRandomInputData(kDefaultUDPSendPacketLen);
+    ackBlocks = makeAckBlocks(4);
+  }
+  for (uint32_t i = 0; i < iters; i++) {
+    RegularQuicPacketBuilder builder(
+        kDefaultUDPSendPacketLen, makeHeader(i), i);
+    writePacketFrames(builder, mix, ackBlocks, data, i * 1000);
+    folly::doNotOptimizeAway(std::move(builder).buildPacket());
+  }
+}
+
+void inplaceBuilderBench(uint32_t iters, PacketMix mix) {
+  Buf data;
+  AckBlocks ackBlocks;
+  std::unique_ptr<SimpleBufAccessor> bufAccessor;
+  BENCHMARK_SUSPEND {
+    data = buildRandomInputData(kDefaultUDPSendPacketLen);
+    ackBlocks = makeAckBlocks(4);
+    bufAccessor = std::make_unique<SimpleBufAccessor>(
+        kDefaultUDPSendPacketLen * 16);
+  }
+  for (uint32_t i = 0; i < iters; i++) {
+    {
+      InplaceQuicPacketBuilder builder(
+          *bufAccessor, kDefaultUDPSendPacketLen, makeHeader(i), i);
+      writePacketFrames(builder, mix, ackBlocks, data, i * 1000);
+      folly::doNotOptimizeAway(std::move(builder).buildPacket());
+    }
+    // Reuse the buffer like the write path does once a batch is flushed.
+    auto buf = bufAccessor->obtain();
+    buf->clear();
+    bufAccessor->release(std::move(buf));
+  }
+}
+
+void writeStreamFrameHeaderBench(uint32_t iters) {
+  // Enough room for a full packet worth of small frames.
+  constexpr uint32_t kFramesPerBuilder = 100;
+  std::unique_ptr<RegularQuicPacketBuilder> builder;
+  for (uint32_t i = 0; i < iters; i++) {
+    if (i % kFramesPerBuilder == 0) {
+      BENCHMARK_SUSPEND {
+        builder = std::make_unique<RegularQuicPacketBuilder>(
+            kDefaultMaxUDPPayload, makeHeader(i), 0);
+        builder->encodePacketHeader();
+      }
+    }
+    folly::doNotOptimizeAway(writeStreamFrameHeader(
+        *builder,
+        kStreamId + (i % kFramesPerBuilder) * 4,
+        static_cast<uint64_t>(i) * kDefaultUDPSendPacketLen,
+        kDefaultUDPSendPacketLen,
+        kDefaultUDPSendPacketLen,
+        false,
+        folly::none));
+  }
+}
+
+} // namespace
+
+BENCHMARK(encodeQuicIntegerMix, n) {
+  encodeQuicIntegerBench(n);
+}
+BENCHMARK(decodeQuicIntegerChainedMix, n) {
+  decodeQuicIntegerChainedBench(n);
+}
+BENCHMARK_RELATIVE(decodeQuicIntegerMix, n) {
+  decodeQuicIntegerBench(n);
+}
+BENCHMARK_RELATIVE(decodeQuicIntegerRangeMix, n) {
+  decodeQuicIntegerRangeBench(n);
+}
+BENCHMARK_DRAW_LINE();
+BENCHMARK_PARAM(decodeAckFrameBench, 1)
+BENCHMARK_PARAM(decodeAckFrameBench, 8)
+BENCHMARK_PARAM(decodeAckFrameBench, 64)
+BENCHMARK_DRAW_LINE();
+BENCHMARK_NAMED_PARAM(parsePacketBench, stream_only, PacketMix::StreamOnly)
+BENCHMARK_NAMED_PARAM(parsePacketBench, ack_only, PacketMix::AckOnly)
+BENCHMARK_NAMED_PARAM(parsePacketBench, ack_and_stream, PacketMix::AckAndStream)
+BENCHMARK_DRAW_LINE();
+BENCHMARK_NAMED_PARAM(regularBuilderBench, stream_only, PacketMix::StreamOnly)
+BENCHMARK_NAMED_PARAM(regularBuilderBench, ack_only, PacketMix::AckOnly)
+BENCHMARK_NAMED_PARAM(
+    regularBuilderBench,
+    ack_and_stream,
+    PacketMix::AckAndStream)
+BENCHMARK_NAMED_PARAM(inplaceBuilderBench, stream_only, PacketMix::StreamOnly)
+BENCHMARK_NAMED_PARAM(inplaceBuilderBench, ack_only, PacketMix::AckOnly)
+BENCHMARK_NAMED_PARAM(
+    inplaceBuilderBench,
+    ack_and_stream,
+    PacketMix::AckAndStream)
+BENCHMARK_DRAW_LINE();
+BENCHMARK(writeStreamFrameHeaders, n) {
+  writeStreamFrameHeaderBench(n);
+}
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -15,6 +15,8 @@
 #include <quic/QuicException.h>
 #include <quic/codec/QuicInteger.h>
 
+#include <random>
+
 using namespace testing;
 using namespace folly;
 
@@ -72,6 +74,68 @@ TEST_P(QuicIntegerDecodeTest, DecodeAtMost) {
   }
 }
 
+TEST_P(QuicIntegerDecodeTest, DecodeWithTrailingBytes) {
+  if (GetParam().error) {
+    // Trailing bytes would complete the truncated integer.
+    return;
+  }
+  // Enough bytes after the integer for the contiguous fast path.
+  std::string encodedBytes =
+      folly::unhexlify(GetParam().hexEncoded) + std::string(8, '\xff');
+  auto wrappedEncoded = IOBuf::copyBuffer(encodedBytes);
+
+  for (int atMost = 0; atMost <= GetParam().encodedLength; atMost++) {
+    folly::io::Cursor cursor(wrappedEncoded.get());
+    auto originalLength = cursor.length();
+    folly::ByteRange range(wrappedEncoded->data(), wrappedEncoded->length());
+    auto decodedValue = decodeQuicInteger(cursor, atMost);
+    auto rangeDecodedValue = decodeQuicInteger(range, atMost);
+    if (atMost != GetParam().encodedLength) {
+      EXPECT_FALSE(decodedValue.has_value());
+      EXPECT_FALSE(rangeDecodedValue.has_value());
+      EXPECT_EQ(cursor.length(), originalLength);
+      EXPECT_EQ(range.size(), originalLength);
+    } else {
+      EXPECT_EQ(decodedValue->first, GetParam().decoded);
+      EXPECT_EQ(decodedValue->second, GetParam().encodedLength);
+      EXPECT_EQ(decodedValue, rangeDecodedValue);
+      EXPECT_EQ(cursor.length(), originalLength - GetParam().encodedLength);
+      EXPECT_EQ(range.size(), cursor.length());
+    }
+  }
+}
+
+TEST(QuicIntegerDecodeFuzzTest, ContiguousMatchesChained) {
+  std::mt19937 rng(1234);
+  std::uniform_int_distribution<uint16_t> byteDist(0, 0xff);
+  std::uniform_int_distribution<size_t> lengthDist(0, 16);
+  std::uniform_int_distribution<uint64_t> atMostDist(0, 9);
+  for (int i = 0; i < 100000; i++) {
+    std::vector<uint8_t> bytes(lengthDist(rng));
+    for (auto& byte : bytes) {
+      byte = static_cast<uint8_t>(byteDist(rng));
+    }
+    auto atMost = atMostDist(rng);
+
+    // One byte per IOBuf never has enough contiguous bytes for the fast path.
+    auto chained = IOBuf::create(0);
+    for (auto byte : bytes) {
+      chained->prependChain(IOBuf::copyBuffer(&byte, 1));
+    }
+    folly::io::Cursor chainedCursor(chained.get());
+    auto expected = decodeQuicInteger(chainedCursor, atMost);
+
+    auto contiguous = IOBuf::copyBuffer(bytes.data(), bytes.size());
+    folly::io::Cursor cursor(contiguous.get());
+    EXPECT_EQ(expected, decodeQuicInteger(cursor, atMost));
+    EXPECT_EQ(chainedCursor.totalLength(), cursor.totalLength());
+
+    folly::ByteRange range(bytes.data(), bytes.size());
+    EXPECT_EQ(expected, decodeQuicInteger(range, atMost));
+    EXPECT_EQ(chainedCursor.totalLength(), range.size());
+  }
+}
+
 TEST_P(QuicIntegerEncodeTest, Encode) {
   auto queue = folly::IOBuf::create(0);
   BufAppender appender(queue.get(), 10);
@@ -239,6 +239,57 @@ TEST_F(QuicReadCodecTest, StreamWithShortHeaderOnlyHeader) {
   EXPECT_FALSE(parseSuccess(std::move(packet)));
 }
 
+TEST_F(QuicReadCodecTest, ParsePacketUsesComputedHeaderMasks) {
+  auto connId = getTestConnectionId();
+  PacketNum firstPacketNum = 12321;
+  StreamId streamId = 2;
+
+  std::vector<Buf> packets;
+  auto data = folly::IOBuf::copyBuffer("hello");
+  for (PacketNum packetNum = firstPacketNum; packetNum < firstPacketNum + 3;
+       packetNum++) {
+    auto streamPacket = createStreamPacket(
+        connId,
+        connId,
+        packetNum,
+        streamId,
+        *data,
+        0 /* cipherOverhead */,
+        0 /* largestAcked */);
+    packets.push_back(packetToBuf(streamPacket));
+    packets.back()->coalesce();
+  }
+  // Too small to have a sample, it must not get a mask.
+  ShortHeader header(ProtectionType::KeyPhaseZero, connId, firstPacketNum + 3);
+  RegularQuicPacketBuilder builder(
+      kDefaultUDPSendPacketLen, std::move(header), 0 /* largestAcked */);
+  builder.encodePacketHeader();
+  packets.push_back(packetToBuf(std::move(builder).buildPacket()));
+  packets.back()->coalesce();
+
+  auto codec = makeEncryptedCodec(connId, createNoOpAead());
+  codec->setServerConnectionId(connId);
+  auto headerCipher = std::make_unique<MockPacketNumberCipher>();
+  EXPECT_CALL(*headerCipher, mask(_))
+      .Times(3)
+      .WillRepeatedly(Return(HeaderProtectionMask{}));
+  codec->setOneRttHeaderCipher(std::move(headerCipher));
+  codec->computeHeaderMasks(folly::range(packets));
+
+  AckStates ackStates;
+  // The first packet was dropped before getting parsed.
+  for (size_t i = 1; i < 3; i++) {
+    BufQueue queue(std::move(packets[i]));
+    auto result = codec->parsePacket(queue, ackStates);
+    auto regularPacket = result.regularPacket();
+    ASSERT_NE(regularPacket, nullptr);
+    EXPECT_EQ(
+        firstPacketNum + i, regularPacket->header.getPacketSequenceNum());
+  }
+  BufQueue queue(std::move(packets[3]));
+  EXPECT_NE(codec->parsePacket(queue, ackStates).nothing(), nullptr);
+}
+
 TEST_F(QuicReadCodecTest, PacketDecryptFail) {
   auto connId = getTestConnectionId();
   PacketNum packetNum = 12321;
@@ -822,6 +822,38 @@ TEST_F(QuicWriteCodecTest, WriteSimpleAckFrame) {
   EXPECT_EQ(decodedAckFrame.ackBlocks[1].endPacket, 400);
 }
 
+TEST_F(QuicWriteCodecTest, WriteAckFrameWithECNCounts) {
+  MockQuicPacketBuilder pktBuilder;
+  setupCommonExpects(pktBuilder);
+  auto ackDelay = 111us;
+  AckBlocks ackBlocks = {{501, 1000}, {101, 400}};
+  AckFrameMetaData meta(ackBlocks, ackDelay, kDefaultAckDelayExponent);
+  meta.ecnCounts = ECNCounts();
+  meta.ecnCounts->ect0 = 1000;
+  meta.ecnCounts->ce = 3;
+
+  // 11 bytes for the same frame as in WriteSimpleAckFrame, then 2 bytes for
+  // ECT(0) and 1 byte each for ECT(1) and CE.
+  auto result = *writeAckFrame(meta, pktBuilder);
+
+  EXPECT_EQ(15, result.bytesWritten);
+  auto builtOut = std::move(pktBuilder).buildTestPacket();
+  auto regularPacket = builtOut.first;
+  WriteAckFrame& ackFrame = *regularPacket.frames.back().asWriteAckFrame();
+  ASSERT_TRUE(ackFrame.ecnCounts.has_value());
+  EXPECT_EQ(*meta.ecnCounts, *ackFrame.ecnCounts);
+
+  auto wireBuf = std::move(builtOut.second);
+  BufQueue queue;
+  queue.append(wireBuf->clone());
+  QuicFrame decodedFrame = parseQuicFrame(queue);
+  auto& decodedAckFrame = *decodedFrame.asReadAckFrame();
+  EXPECT_EQ(decodedAckFrame.largestAcked, 1000);
+  EXPECT_EQ(decodedAckFrame.ackBlocks.size(), 2);
+  ASSERT_TRUE(decodedAckFrame.ecnCounts.has_value());
+  EXPECT_EQ(*meta.ecnCounts, *decodedAckFrame.ecnCounts);
+}
+
 TEST_F(QuicWriteCodecTest, WriteAckFrameWillSaveAckDelay) {
   MockQuicPacketBuilder pktBuilder;
   setupCommonExpects(pktBuilder);
@@ -1664,6 +1696,33 @@ TEST_F(QuicWriteCodecTest, WritePathChallenge) {
   EXPECT_EQ(queue.chainLength(), 0);
 }
 
+TEST_F(QuicWriteCodecTest, WriteNewToken) {
+  MockQuicPacketBuilder pktBuilder;
+  setupCommonExpects(pktBuilder);
+
+  std::string token = "address validation token";
+  NewTokenFrame newToken(token);
+  auto bytesWritten = writeSimpleFrame(newToken, pktBuilder);
+  // 1 byte for type, 1 byte for the token length
+  EXPECT_EQ(bytesWritten, 2 + token.size());
+
+  auto builtOut = std::move(pktBuilder).buildTestPacket();
+
+  auto regularPacket = builtOut.first;
+  NewTokenFrame result =
+      *regularPacket.frames[0].asQuicSimpleFrame()->asNewTokenFrame();
+  EXPECT_EQ(result.token, token);
+
+  auto wireBuf = std::move(builtOut.second);
+  BufQueue queue;
+  queue.append(wireBuf->clone());
+  QuicFrame decodedFrame = parseQuicFrame(queue);
+  auto wireNewTokenFrame = decodedFrame.asReadNewTokenFrame();
+  ASSERT_NE(wireNewTokenFrame, nullptr);
+  EXPECT_EQ(wireNewTokenFrame->token->moveToFbString().toStdString(), token);
+  EXPECT_EQ(queue.chainLength(), 0);
+}
+
 TEST_F(QuicWriteCodecTest, WritePathResponse) {
   MockQuicPacketBuilder pktBuilder;
   setupCommonExpects(pktBuilder);
@@ -1689,5 +1748,84 @@ TEST_F(QuicWriteCodecTest, WritePathResponse) {
   EXPECT_EQ(wirePathResponseFrame.pathData, pathData);
   EXPECT_EQ(queue.chainLength(), 0);
 }
+
+TEST_F(QuicWriteCodecTest, WriteDatagramFrame) {
+  MockQuicPacketBuilder pktBuilder;
+  setupCommonExpects(pktBuilder);
+
+  auto payload = folly::IOBuf::copyBuffer("datagram");
+  size_t len = payload->computeChainDataLength();
+  auto bytesWritten =
+      writeFrame(DatagramFrame(len, std::move(payload)), pktBuilder);
+  // frame type + length + payload
+  EXPECT_EQ(bytesWritten, 1 + 1 + len);
+
+  auto builtOut = std::move(pktBuilder).buildTestPacket();
+  // The outstanding copy of the frame does not hold on to the payload.
+  auto regularPacket = builtOut.first;
+  const DatagramFrame& result = *regularPacket.frames[0].asDatagramFrame();
+  EXPECT_EQ(result.length, len);
+  EXPECT_EQ(result.data, nullptr);
+
+  auto wireBuf = std::move(builtOut.second);
+  BufQueue queue;
+  queue.append(wireBuf->clone());
+  QuicFrame decodedFrame = parseQuicFrame(queue);
+  DatagramFrame& wireDatagramFrame = *decodedFrame.asDatagramFrame();
+  EXPECT_EQ(wireDatagramFrame.length, len);
+  EXPECT_EQ(
+      wireDatagramFrame.data->moveToFbString().toStdString(), "datagram");
+  EXPECT_EQ(queue.chainLength(), 0);
+}
+
+TEST_F(QuicWriteCodecTest, WriteAckFrequencyFrame) {
+  MockQuicPacketBuilder pktBuilder;
+  setupCommonExpects(pktBuilder);
+
+  AckFrequencyFrame ackFrequency(1, 10, 25000, 1);
+  auto bytesWritten = writeSimpleFrame(ackFrequency, pktBuilder);
+  // 2 bytes frame type, 4 bytes max ack delay and 1 byte for the rest.
+  EXPECT_EQ(bytesWritten, 9);
+
+  auto builtOut = std::move(pktBuilder).buildTestPacket();
+  auto regularPacket = builtOut.first;
+  EXPECT_EQ(
+      *regularPacket.frames[0].asQuicSimpleFrame()->asAckFrequencyFrame(),
+      ackFrequency);
+
+  auto wireBuf = std::move(builtOut.second);
+  BufQueue queue;
+  queue.append(wireBuf->clone());
+  QuicFrame decodedFrame = parseQuicFrame(queue);
+  QuicSimpleFrame& simpleFrame = *decodedFrame.asQuicSimpleFrame();
+  EXPECT_EQ(*simpleFrame.asAckFrequencyFrame(), ackFrequency);
+  EXPECT_EQ(queue.chainLength(), 0);
+}
+
+TEST_F(QuicWriteCodecTest, WriteImmediateAckFrame) {
+  MockQuicPacketBuilder pktBuilder;
+  setupCommonExpects(pktBuilder);
+
+  auto bytesWritten = writeSimpleFrame(ImmediateAckFrame(), pktBuilder);
+  EXPECT_EQ(bytesWritten, 2);
+
+  auto builtOut = std::move(pktBuilder).buildTestPacket();
+  auto wireBuf = std::move(builtOut.second);
+  BufQueue queue;
+  queue.append(wireBuf->clone());
+  QuicFrame decodedFrame = parseQuicFrame(queue);
+  QuicSimpleFrame& simpleFrame = *decodedFrame.asQuicSimpleFrame();
+  EXPECT_NE(simpleFrame.asImmediateAckFrame(), nullptr);
+  EXPECT_EQ(queue.chainLength(), 0);
+}
+
+TEST_F(QuicWriteCodecTest, NoSpaceForDatagramFrame) {
+  MockQuicPacketBuilder pktBuilder;
+  pktBuilder.remaining_ = 9;
+  setupCommonExpects(pktBuilder);
+  auto payload = folly::IOBuf::copyBuffer("datagram");
+  size_t len = payload->computeChainDataLength();
+  EXPECT_EQ(0, writeFrame(DatagramFrame(len, std::move(payload)), pktBuilder));
+}
 } // namespace test
 } // namespace quic
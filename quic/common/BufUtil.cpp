@@ -4,6 +4,22 @@
 
 namespace quic {
 
+std::vector<Buf> unchainBuf(Buf chain) {
+  std::vector<Buf> bufs;
+  if (!chain) {
+    return bufs;
+  }
+  bufs.reserve(chain->countChainElements());
+  while (chain) {
+    auto next = chain->pop();
+    if (chain->length() != 0) {
+      bufs.emplace_back(std::move(chain));
+    }
+    chain = std::move(next);
+  }
+  return bufs;
+}
+
 Buf BufQueue::splitAtMost(size_t len) {
   Buf result;
   folly::IOBuf* current = chain_.get();
@@ -2,6 +2,7 @@
 
 #pragma once
 #include <folly/io/IOBuf.h>
+#include <vector>
 
 namespace quic {
 using Buf = std::unique_ptr<folly::IOBuf>;
@@ -64,6 +65,13 @@ class BufQueue {
   size_t chainLength_{0};
 };
 
+/**
+ * Break up a chain into its individual buffers, dropping the empty ones. The
+ * returned buffers still share memory with the original chain, nothing is
+ * copied.
+ */
+std::vector<Buf> unchainBuf(Buf chain);
+
 class BufAppender {
  public:
   BufAppender(folly::IOBuf* data, size_t appendLen);
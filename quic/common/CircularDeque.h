@@ -0,0 +1,555 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#pragma once
+
+#include <glog/logging.h>
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace quic {
+
+/**
+ * A double ended queue backed by a single contiguous ring buffer.
+ *
+ * std::deque allocates one block per element once the element is larger than
+ * its block size, which is the case for OutstandingPacket, so walking the
+ * outstanding packets is a pointer chase with a cache miss per packet.
+ * CircularDeque keeps the elements in one allocation and grows it
+ * geometrically. Appending and removing at either end is amortized O(1),
+ * erasing a range moves whichever side of the range is shorter, and inserting
+ * in the middle is O(n).
+ *
+ * Unlike std::deque, any insertion or erasure invalidates all iterators and
+ * references.
+ */
+template <typename T>
+class CircularDeque {
+ public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = T&;
+  using const_reference = const T&;
+  using pointer = T*;
+  using const_pointer = const T*;
+
+  template <typename Owner, typename Value>
+  class CircularDequeIterator {
+   public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = std::remove_const_t<Value>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = Value*;
+    using reference = Value&;
+
+    CircularDequeIterator() = default;
+
+    CircularDequeIterator(Owner* owner, size_type index)
+        : owner_(owner), index_(index) {}
+
+    // Allow conversion from iterator to const_iterator.
+    template <
+        typename OtherOwner,
+        typename OtherValue,
+        typename = std::enable_if_t<
+            std::is_convertible<OtherOwner*, Owner*>::value>>
+    /* implicit */ CircularDequeIterator(
+        const CircularDequeIterator<OtherOwner, OtherValue>& other)
+        : owner_(other.owner_), index_(other.index_) {}
+
+    reference operator*() const {
+      return (*owner_)[index_];
+    }
+
+    pointer operator->() const {
+      return &(*owner_)[index_];
+    }
+
+    reference operator[](difference_type n) const {
+      return (*owner_)[index_ + n];
+    }
+
+    CircularDequeIterator& operator++() {
+      ++index_;
+      return *this;
+    }
+
+    CircularDequeIterator operator++(int) {
+      auto ret = *this;
+      ++index_;
+      return ret;
+    }
+
+    CircularDequeIterator& operator--() {
+      --index_;
+      return *this;
+    }
+
+    CircularDequeIterator operator--(int) {
+      auto ret = *this;
+      --index_;
+      return ret;
+    }
+
+    CircularDequeIterator& operator+=(difference_type n) {
+      index_ += n;
+      return *this;
+    }
+
+    CircularDequeIterator& operator-=(difference_type n) {
+      index_ -= n;
+      return *this;
+    }
+
+    CircularDequeIterator operator+(difference_type n) const {
+      return CircularDequeIterator(owner_, index_ + n);
+    }
+
+    friend CircularDequeIterator operator+(
+        difference_type n,
+        const CircularDequeIterator& it) {
+      return it + n;
+    }
+
+    CircularDequeIterator operator-(difference_type n) const {
+      return CircularDequeIterator(owner_, index_ - n);
+    }
+
+    // Comparisons are friends so that an iterator and a const_iterator can be
+    // mixed, as with the standard containers.
+    friend difference_type operator-(
+        const CircularDequeIterator& lhs,
+        const CircularDequeIterator& rhs) {
+      return static_cast<difference_type>(lhs.index_) -
+          static_cast<difference_type>(rhs.index_);
+    }
+
+    friend bool operator==(
+        const CircularDequeIterator& lhs,
+        const CircularDequeIterator& rhs) {
+      return lhs.index_ == rhs.index_;
+    }
+
+    friend bool operator!=(
+        const CircularDequeIterator& lhs,
+        const CircularDequeIterator& rhs) {
+      return lhs.index_ != rhs.index_;
+    }
+
+    friend bool operator<(
+        const CircularDequeIterator& lhs,
+        const CircularDequeIterator& rhs) {
+      return lhs.index_ < rhs.index_;
+    }
+
+    friend bool operator>(
+        const CircularDequeIterator& lhs,
+        const CircularDequeIterator& rhs) {
+      return lhs.index_ > rhs.index_;
+    }
+
+    friend bool operator<=(
+        const CircularDequeIterator& lhs,
+        const CircularDequeIterator& rhs) {
+      return lhs.index_ <= rhs.index_;
+    }
+
+    friend bool operator>=(
+        const CircularDequeIterator& lhs,
+        const CircularDequeIterator& rhs) {
+      return lhs.index_ >= rhs.index_;
+    }
+
+   private:
+    template <typename, typename>
+    friend class CircularDequeIterator;
+    friend class CircularDeque;
+
+    Owner* owner_{nullptr};
+    // Logical position, i.e. the distance from begin().
+    size_type index_{0};
+  };
+
+  using iterator = CircularDequeIterator<CircularDeque, T>;
+  using const_iterator = CircularDequeIterator<const CircularDeque, const T>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  CircularDeque() = default;
+
+  explicit CircularDeque(size_type capacity) {
+    reserve(capacity);
+  }
+
+  CircularDeque(std::initializer_list<T> init) {
+    reserve(init.size());
+    for (const auto& val : init) {
+      emplace_back(val);
+    }
+  }
+
+  CircularDeque(const CircularDeque& other) {
+    reserve(other.size());
+    for (const auto& val : other) {
+      emplace_back(val);
+    }
+  }
+
+  CircularDeque(CircularDeque&& other) noexcept {
+    swap(other);
+  }
+
+  CircularDeque& operator=(const CircularDeque& other) {
+    if (this != &other) {
+      CircularDeque copy(other);
+      swap(copy);
+    }
+    return *this;
+  }
+
+  CircularDeque& operator=(CircularDeque&& other) noexcept {
+    if (this != &other) {
+      clear();
+      deallocate();
+      swap(other);
+    }
+    return *this;
+  }
+
+  ~CircularDeque() {
+    clear();
+    deallocate();
+  }
+
+  void swap(CircularDeque& other) noexcept {
+    std::swap(storage_, other.storage_);
+    std::swap(capacity_, other.capacity_);
+    std::swap(begin_, other.begin_);
+    std::swap(size_, other.size_);
+  }
+
+  bool empty() const noexcept {
+    return size_ == 0;
+  }
+
+  size_type size() const noexcept {
+    return size_;
+  }
+
+  size_type capacity() const noexcept {
+    return capacity_;
+  }
+
+  size_type max_size() const noexcept {
+    return std::allocator_traits<std::allocator<T>>::max_size(
+        std::allocator<T>());
+  }
+
+  void reserve(size_type capacity) {
+    if (capacity > capacity_) {
+      reallocate(capacity);
+    }
+  }
+
+  void shrink_to_fit() {
+    if (size_ < capacity_) {
+      reallocate(size_);
+    }
+  }
+
+  reference operator[](size_type index) {
+    DCHECK_LT(index, size_);
+    return storage_[physicalIndex(index)];
+  }
+
+  const_reference operator[](size_type index) const {
+    DCHECK_LT(index, size_);
+    return storage_[physicalIndex(index)];
+  }
+
+  reference front() {
+    return (*this)[0];
+  }
+
+  const_reference front() const {
+    return (*this)[0];
+  }
+
+  reference back() {
+    return (*this)[size_ - 1];
+  }
+
+  const_reference back() const {
+    return (*this)[size_ - 1];
+  }
+
+  iterator begin() noexcept {
+    return iterator(this, 0);
+  }
+
+  const_iterator begin() const noexcept {
+    return const_iterator(this, 0);
+  }
+
+  const_iterator cbegin() const noexcept {
+    return begin();
+  }
+
+  iterator end() noexcept {
+    return iterator(this, size_);
+  }
+
+  const_iterator end() const noexcept {
+    return const_iterator(this, size_);
+  }
+
+  const_iterator cend() const noexcept {
+    return end();
+  }
+
+  reverse_iterator rbegin() noexcept {
+    return reverse_iterator(end());
+  }
+
+  const_reverse_iterator rbegin() const noexcept {
+    return const_reverse_iterator(end());
+  }
+
+  const_reverse_iterator crbegin() const noexcept {
+    return rbegin();
+  }
+
+  reverse_iterator rend() noexcept {
+    return reverse_iterator(begin());
+  }
+
+  const_reverse_iterator rend() const noexcept {
+    return const_reverse_iterator(begin());
+  }
+
+  const_reverse_iterator crend() const noexcept {
+    return rend();
+  }
+
+  template <typename... Args>
+  reference emplace_back(Args&&... args) {
+    if (size_ == capacity_) {
+      // Construct the new element before moving the existing ones, args may
+      // refer to one of them.
+      auto newCapacity = growCapacity();
+      T* newStorage = allocate(newCapacity);
+      try {
+        ::new (newStorage + size_) T(std::forward<Args>(args)...);
+      } catch (...) {
+        std::allocator<T>().deallocate(newStorage, newCapacity);
+        throw;
+      }
+      moveTo(newStorage, newCapacity);
+    } else {
+      ::new (storage_ + physicalIndex(size_)) T(std::forward<Args>(args)...);
+    }
+    ++size_;
+    return back();
+  }
+
+  template <typename... Args>
+  reference emplace_front(Args&&... args) {
+    if (size_ == capacity_) {
+      auto newCapacity = growCapacity();
+      T* newStorage = allocate(newCapacity);
+      // Leave the first slot of the new buffer for the new element.
+      try {
+        ::new (newStorage) T(std::forward<Args>(args)...);
+      } catch (...) {
+        std::allocator<T>().deallocate(newStorage, newCapacity);
+        throw;
+      }
+      moveTo(newStorage, newCapacity, 1);
+      begin_ = 0;
+    } else {
+      auto newBegin = begin_ == 0 ? capacity_ - 1 : begin_ - 1;
+      ::new (storage_ + newBegin) T(std::forward<Args>(args)...);
+      begin_ = newBegin;
+    }
+    ++size_;
+    return front();
+  }
+
+  void push_back(const T& val) {
+    emplace_back(val);
+  }
+
+  void push_back(T&& val) {
+    emplace_back(std::move(val));
+  }
+
+  void push_front(const T& val) {
+    emplace_front(val);
+  }
+
+  void push_front(T&& val) {
+    emplace_front(std::move(val));
+  }
+
+  void pop_back() {
+    DCHECK(!empty());
+    storage_[physicalIndex(size_ - 1)].~T();
+    --size_;
+  }
+
+  void pop_front() {
+    DCHECK(!empty());
+    storage_[begin_].~T();
+    begin_ = physicalIndex(1);
+    --size_;
+  }
+
+  /**
+   * Construct an element in front of pos. Appending is the common case and
+   * is amortized O(1), anything else shifts the elements after pos.
+   */
+  template <typename... Args>
+  iterator emplace(const_iterator pos, Args&&... args) {
+    auto index = pos.index_;
+    DCHECK_LE(index, size_);
+    if (index == size_) {
+      emplace_back(std::forward<Args>(args)...);
+    } else if (index == 0) {
+      emplace_front(std::forward<Args>(args)...);
+    } else {
+      emplace_back(std::forward<Args>(args)...);
+      std::rotate(begin() + index, end() - 1, end());
+    }
+    return begin() + index;
+  }
+
+  iterator insert(const_iterator pos, const T& val) {
+    return emplace(pos, val);
+  }
+
+  iterator insert(const_iterator pos, T&& val) {
+    return emplace(pos, std::move(val));
+  }
+
+  iterator erase(const_iterator pos) {
+    return erase(pos, pos + 1);
+  }
+
+  /**
+   * Erase [first, last). Returns the iterator following the last removed
+   * element.
+   */
+  iterator erase(const_iterator first, const_iterator last) {
+    auto firstIndex = first.index_;
+    auto lastIndex = last.index_;
+    DCHECK_LE(firstIndex, lastIndex);
+    DCHECK_LE(lastIndex, size_);
+    auto count = lastIndex - firstIndex;
+    if (count == 0) {
+      return begin() + firstIndex;
+    }
+    if (firstIndex < size_ - lastIndex) {
+      // Fewer elements in front of the range, shift them towards the back.
+      std::move_backward(begin(), begin() + firstIndex, begin() + lastIndex);
+      for (size_type i = 0; i < count; ++i) {
+        pop_front();
+      }
+    } else {
+      std::move(begin() + lastIndex, end(), begin() + firstIndex);
+      for (size_type i = 0; i < count; ++i) {
+        pop_back();
+      }
+    }
+    return begin() + firstIndex;
+  }
+
+  void clear() noexcept {
+    for (size_type i = 0; i < size_; ++i) {
+      storage_[physicalIndex(i)].~T();
+    }
+    begin_ = 0;
+    size_ = 0;
+  }
+
+  void resize(size_type count) {
+    while (size_ > count) {
+      pop_back();
+    }
+    reserve(count);
+    while (size_ < count) {
+      emplace_back();
+    }
+  }
+
+ private:
+  size_type physicalIndex(size_type index) const {
+    auto physical = begin_ + index;
+    return physical >= capacity_ ? physical - capacity_ : physical;
+  }
+
+  size_type growCapacity() const {
+    return std::max<size_type>(capacity_ * 2, kMinCapacity);
+  }
+
+  static T* allocate(size_type capacity) {
+    return std::allocator<T>().allocate(capacity);
+  }
+
+  void deallocate() {
+    if (storage_) {
+      std::allocator<T>().deallocate(storage_, capacity_);
+      storage_ = nullptr;
+      capacity_ = 0;
+      begin_ = 0;
+    }
+  }
+
+  /**
+   * Move all the elements into newStorage starting at offset, release the old
+   * buffer and adopt the new one. The elements are stored unwrapped in the
+   * new buffer.
+   */
+  void moveTo(T* newStorage, size_type newCapacity, size_type offset = 0) {
+    for (size_type i = 0; i < size_; ++i) {
+      auto& elem = storage_[physicalIndex(i)];
+      ::new (newStorage + offset + i) T(std::move_if_noexcept(elem));
+      elem.~T();
+    }
+    if (storage_) {
+      std::allocator<T>().deallocate(storage_, capacity_);
+    }
+    storage_ = newStorage;
+    capacity_ = newCapacity;
+    begin_ = offset;
+  }
+
+  void reallocate(size_type newCapacity) {
+    DCHECK_GE(newCapacity, size_);
+    if (newCapacity == 0) {
+      deallocate();
+      return;
+    }
+    moveTo(allocate(newCapacity), newCapacity);
+  }
+
+  static constexpr size_type kMinCapacity = 8;
+
+  T* storage_{nullptr};
+  size_type capacity_{0};
+  // Physical index of the first element.
+  size_type begin_{0};
+  size_type size_{0};
+};
+
+} // namespace quic
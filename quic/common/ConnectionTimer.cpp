@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/common/ConnectionTimer.h>
+
+#include <folly/chrono/Conv.h>
+#include <glog/logging.h>
+
+#include <algorithm>
+
+namespace quic {
+
+ConnectionTimer::Callback::~Callback() {
+  cancelTimeout();
+}
+
+void ConnectionTimer::Callback::cancelTimeout() {
+  if (timer_) {
+    timer_->cancelTimeout(this);
+  }
+}
+
+std::chrono::milliseconds ConnectionTimer::Callback::getTimeRemaining() const {
+  if (!timer_) {
+    return std::chrono::milliseconds(0);
+  }
+  auto now = Clock::now();
+  if (deadline_ <= now) {
+    return std::chrono::milliseconds(0);
+  }
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+      deadline_ - now);
+}
+
+ConnectionTimer::ConnectionTimer() : wheelCallback_(*this) {}
+
+ConnectionTimer::~ConnectionTimer() {
+  for (auto callback : callbacks_) {
+    callback->timer_ = nullptr;
+  }
+  callbacks_.clear();
+}
+
+void ConnectionTimer::scheduleTimeout(
+    folly::HHWheelTimer& wheelTimer,
+    Callback* callback,
+    std::chrono::milliseconds timeout) {
+  if (callback->timer_ && callback->timer_ != this) {
+    callback->cancelTimeout();
+  }
+  if (wheelTimer_ != &wheelTimer) {
+    wheelCallback_.cancelTimeout();
+    wheelTimer_ = &wheelTimer;
+  }
+  callback->deadline_ = Clock::now() + timeout;
+  if (!callback->timer_) {
+    callback->timer_ = this;
+    callbacks_.push_back(callback);
+  }
+  maybeScheduleWheelTimeout();
+}
+
+void ConnectionTimer::cancelTimeout(Callback* callback) {
+  DCHECK_EQ(callback->timer_, this);
+  auto it = std::find(callbacks_.begin(), callbacks_.end(), callback);
+  DCHECK(it != callbacks_.end());
+  callbacks_.erase(it);
+  callback->timer_ = nullptr;
+  // A later deadline is left on the wheel timer, it is re-armed when it fires.
+  // Only stop it once nothing is scheduled so an idle connection does not wake
+  // up for nothing.
+  if (callbacks_.empty()) {
+    wheelCallback_.cancelTimeout();
+  }
+}
+
+size_t ConnectionTimer::numScheduled() const {
+  return callbacks_.size();
+}
+
+uint64_t ConnectionTimer::wheelTimerScheduleCount() const {
+  return wheelTimerScheduleCount_;
+}
+
+void ConnectionTimer::scheduleWheelTimeout(Clock::time_point deadline) {
+  auto now = Clock::now();
+  auto timeout = deadline > now
+      ? folly::chrono::ceil<std::chrono::milliseconds>(deadline - now)
+      : std::chrono::milliseconds(0);
+  wheelTimer_->scheduleTimeout(&wheelCallback_, timeout);
+  wheelDeadline_ = deadline;
+  wheelTimerScheduleCount_++;
+}
+
+void ConnectionTimer::maybeScheduleWheelTimeout() {
+  if (callbacks_.empty()) {
+    return;
+  }
+  auto earliest = std::min_element(
+      callbacks_.begin(), callbacks_.end(), [](auto lhs, auto rhs) {
+        return lhs->deadline_ < rhs->deadline_;
+      });
+  if (!wheelCallback_.isScheduled() ||
+      (*earliest)->deadline_ < wheelDeadline_) {
+    scheduleWheelTimeout((*earliest)->deadline_);
+  }
+}
+
+void ConnectionTimer::wheelTimeoutExpired() noexcept {
+  // The wheel timer can fire up to a tick before the deadline it was armed
+  // for. Timeouts that are not due yet are left for the wheel timer to be
+  // re-armed for, rather than run early.
+  auto dueBy = Clock::now();
+  // Collect the due callbacks first, the ones scheduled while running them
+  // wait for the next time the wheel timer fires.
+  SmallVec<Callback*, 8> dueCallbacks;
+  for (auto callback : callbacks_) {
+    if (callback->deadline_ <= dueBy) {
+      dueCallbacks.push_back(callback);
+    }
+  }
+  std::sort(
+      dueCallbacks.begin(), dueCallbacks.end(), [](auto lhs, auto rhs) {
+        return lhs->deadline_ < rhs->deadline_;
+      });
+  folly::DestructorCheck::Safety safety(*this);
+  for (auto callback : dueCallbacks) {
+    // An earlier callback may have cancelled or moved this one.
+    if (callback->timer_ != this || callback->deadline_ > dueBy) {
+      continue;
+    }
+    cancelTimeout(callback);
+    callback->timeoutExpired();
+    if (safety.destroyed()) {
+      return;
+    }
+  }
+  maybeScheduleWheelTimeout();
+}
+
+void ConnectionTimer::wheelCallbackCanceled() noexcept {
+  folly::DestructorCheck::Safety safety(*this);
+  while (!callbacks_.empty()) {
+    auto callback = callbacks_.back();
+    callbacks_.pop_back();
+    callback->timer_ = nullptr;
+    callback->callbackCanceled();
+    if (safety.destroyed()) {
+      return;
+    }
+  }
+}
+
+} // namespace quic
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#pragma once
+
+#include <folly/io/async/DestructorCheck.h>
+#include <folly/io/async/HHWheelTimer.h>
+#include <quic/common/SmallVec.h>
+
+#include <chrono>
+
+namespace quic {
+
+/**
+ * Multiplexes the timeouts of one connection onto a single HHWheelTimer
+ * callback. Only the earliest deadline is registered with the wheel timer:
+ * cancelling a timeout or pushing it to a later deadline, which the ack, loss
+ * and idle timeouts do on almost every packet, does not touch the wheel. When
+ * the wheel timer fires, the timeouts that are due run and the wheel timer is
+ * re-armed for the next earliest deadline.
+ *
+ * Timeouts never run before their deadline. Since the wheel timer has tick
+ * granularity, they may run up to a tick late.
+ */
+class ConnectionTimer : public folly::DestructorCheck {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * A timeout of the connection, mirroring the HHWheelTimer::Callback
+   * interface.
+   */
+  class Callback {
+   public:
+    virtual ~Callback();
+
+    virtual void timeoutExpired() noexcept = 0;
+
+    /**
+     * Called instead of timeoutExpired() when the wheel timer is destroyed
+     * while the timeout is scheduled.
+     */
+    virtual void callbackCanceled() noexcept {
+      timeoutExpired();
+    }
+
+    bool isScheduled() const {
+      return timer_ != nullptr;
+    }
+
+    void cancelTimeout();
+
+    std::chrono::milliseconds getTimeRemaining() const;
+
+   private:
+    friend class ConnectionTimer;
+
+    ConnectionTimer* timer_{nullptr};
+    Clock::time_point deadline_;
+  };
+
+  ConnectionTimer();
+
+  ~ConnectionTimer() override;
+
+  ConnectionTimer(const ConnectionTimer&) = delete;
+  ConnectionTimer& operator=(const ConnectionTimer&) = delete;
+
+  /**
+   * Schedules callback to run after timeout. A callback that is already
+   * scheduled is moved to the new deadline.
+   */
+  void scheduleTimeout(
+      folly::HHWheelTimer& wheelTimer,
+      Callback* callback,
+      std::chrono::milliseconds timeout);
+
+  void cancelTimeout(Callback* callback);
+
+  size_t numScheduled() const;
+
+  /**
+   * Number of times the connection was (re)scheduled with the wheel timer.
+   */
+  uint64_t wheelTimerScheduleCount() const;
+
+ private:
+  class WheelCallback : public folly::HHWheelTimer::Callback {
+   public:
+    explicit WheelCallback(ConnectionTimer& timer) : timer_(timer) {}
+
+    void timeoutExpired() noexcept override {
+      timer_.wheelTimeoutExpired();
+    }
+
+    void callbackCanceled() noexcept override {
+      timer_.wheelCallbackCanceled();
+    }
+
+   private:
+    ConnectionTimer& timer_;
+  };
+
+  void wheelTimeoutExpired() noexcept;
+
+  void wheelCallbackCanceled() noexcept;
+
+  void scheduleWheelTimeout(Clock::time_point deadline);
+
+  // Arms the wheel timer for the earliest scheduled callback if it would fire
+  // too late for it, or not at all.
+  void maybeScheduleWheelTimeout();
+
+  folly::HHWheelTimer* wheelTimer_{nullptr};
+  WheelCallback wheelCallback_;
+  // The deadline the wheel timer is armed for.
+  Clock::time_point wheelDeadline_;
+  SmallVec<Callback*, 8> callbacks_;
+  uint64_t wheelTimerScheduleCount_{0};
+};
+
+} // namespace quic
@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#pragma once
+
+#include <iterator>
+
+namespace quic {
+
+/**
+ * Releases the memory a container holds beyond what its elements need. Neither
+ * the F14 containers nor std::vector give memory back when elements are
+ * erased, so a container that was large once stays large for the lifetime of
+ * the connection. An empty container is replaced by a default constructed one,
+ * which does not allocate; a non-empty one is rebuilt at its current size.
+ *
+ * Elements are moved, so this invalidates pointers and references to them.
+ */
+template <typename Container>
+void shrinkToFit(Container& container) {
+  if (container.empty()) {
+    Container().swap(container);
+    return;
+  }
+  Container compacted(
+      std::make_move_iterator(container.begin()),
+      std::make_move_iterator(container.end()));
+  container.swap(compacted);
+}
+
+} // namespace quic
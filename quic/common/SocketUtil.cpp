@@ -8,6 +8,13 @@
 
 #include "quic/common/SocketUtil.h"
 
+#include <glog/logging.h>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/net_tstamp.h>
+#endif
+
 using folly::AsyncUDPSocket;
 
 namespace quic {
@@ -37,4 +44,99 @@ void applySocketOptions(
   sock.applyOptions(validOptions, pos);
 }
 
+namespace {
+
+void setIntSocketOption(
+    folly::NetworkSocket fd,
+    int level,
+    int optname,
+    int value) noexcept {
+  if (folly::netops::setsockopt(fd, level, optname, &value, sizeof(value))) {
+    VLOG(2) << "setsockopt level=" << level << " optname=" << optname
+            << " failed errno=" << errno;
+  }
+}
+
+} // namespace
+
+void setErrMessageCallbackWithoutRecvErr(
+    AsyncUDPSocket& sock,
+    AsyncUDPSocket::ErrMessageCallback* callback) noexcept {
+  sock.setErrMessageCallback(callback);
+#if defined(IP_RECVERR) && defined(IPV6_RECVERR)
+  // A dual stack IPv6 socket sends IPv4 datagrams too, which look at the IPv4
+  // option.
+  auto fd = sock.getNetworkSocket();
+  setIntSocketOption(fd, IPPROTO_IP, IP_RECVERR, 0);
+  if (sock.address().getFamily() == AF_INET6) {
+    setIntSocketOption(fd, IPPROTO_IPV6, IPV6_RECVERR, 0);
+  }
+#endif
+}
+
+void applyEcnSocketOptions(
+    AsyncUDPSocket& sock,
+    sa_family_t family,
+    ECNCodepoint marking,
+    bool readEcn) noexcept {
+  auto fd = sock.getNetworkSocket();
+  int tos = static_cast<int>(marking);
+  // A dual stack IPv6 socket sends and receives IPv4 datagrams too, which use
+  // the IPv4 options.
+  setIntSocketOption(fd, IPPROTO_IP, IP_TOS, tos);
+  if (family == AF_INET6) {
+    setIntSocketOption(fd, IPPROTO_IPV6, IPV6_TCLASS, tos);
+  }
+#if defined(IP_RECVTOS) && defined(IPV6_RECVTCLASS)
+  if (readEcn) {
+    setIntSocketOption(fd, IPPROTO_IP, IP_RECVTOS, 1);
+    if (family == AF_INET6) {
+      setIntSocketOption(fd, IPPROTO_IPV6, IPV6_RECVTCLASS, 1);
+    }
+  }
+#else
+  (void)readEcn;
+#endif
+}
+
+bool applyTxTimeSocketOption(AsyncUDPSocket& sock) noexcept {
+#ifdef SO_TXTIME
+  struct sock_txtime txTime;
+  memset(&txTime, 0, sizeof(txTime));
+  // Departure times are taken from quic::Clock, which is CLOCK_MONOTONIC.
+  txTime.clockid = CLOCK_MONOTONIC;
+  if (folly::netops::setsockopt(
+          sock.getNetworkSocket(),
+          SOL_SOCKET,
+          SO_TXTIME,
+          &txTime,
+          sizeof(txTime))) {
+    LOG(WARNING) << "setsockopt SO_TXTIME failed errno=" << errno;
+    return false;
+  }
+  // Without fq on the egress interface the departure times are ignored and
+  // the bursts go out back to back. Nothing here can check the qdisc.
+  LOG_FIRST_N(INFO, 1) << "SO_TXTIME pacing enabled, it requires the fq "
+                       << "qdisc on the egress interface, which is not checked";
+  return true;
+#else
+  (void)sock;
+  return false;
+#endif
+}
+
+folly::Optional<ECNCodepoint> getEcnFromCmsg(const struct cmsghdr& cmsg) {
+  // IP_TOS carries a single byte, IPV6_TCLASS an int.
+  if (cmsg.cmsg_level == IPPROTO_IP && cmsg.cmsg_type == IP_TOS) {
+    auto tos = *reinterpret_cast<const uint8_t*>(CMSG_DATA(&cmsg));
+    return static_cast<ECNCodepoint>(tos & kECNMask);
+  }
+  if (cmsg.cmsg_level == IPPROTO_IPV6 && cmsg.cmsg_type == IPV6_TCLASS) {
+    int tclass;
+    memcpy(&tclass, CMSG_DATA(&cmsg), sizeof(tclass));
+    return static_cast<ECNCodepoint>(tclass & kECNMask);
+  }
+  return folly::none;
+}
+
 } // namespace quic
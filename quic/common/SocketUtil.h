@@ -8,12 +8,24 @@
 
 #pragma once
 
+#include <folly/Optional.h>
 #include <folly/io/SocketOptionMap.h>
 #include <folly/io/async/AsyncUDPSocket.h>
 #include <folly/net/NetOps.h>
+#include <quic/QuicConstants.h>
 
 namespace quic {
 
+// Control buffer size for a UDP_GRO cmsg along with an IP_TOS or IPV6_TCLASS
+// one.
+constexpr size_t kRecvCmsgSpace =
+    CMSG_SPACE(sizeof(uint16_t)) + CMSG_SPACE(sizeof(int));
+
+// Control buffer size for the cmsgs a batch writer attaches to a message: an
+// SCM_TXTIME, a UDP_SEGMENT and an IP_TOS or IPV6_TCLASS one.
+constexpr size_t kSendCmsgSpace = CMSG_SPACE(sizeof(uint64_t)) +
+    CMSG_SPACE(sizeof(uint16_t)) + CMSG_SPACE(sizeof(int));
+
 bool isNetworkUnreachable(int err);
 
 void applySocketOptions(
@@ -22,4 +34,42 @@ void applySocketOptions(
     sa_family_t family,
     folly::SocketOptionKey::ApplyPos pos) noexcept;
 
+/**
+ * Sets the callback the socket's error queue is drained to, and turns back off
+ * the IP_RECVERR / IPV6_RECVERR folly enables along with it. Zerocopy
+ * completions are queued either way, but with those options an ICMP error from
+ * any peer of an unconnected socket fails the next send on it, whatever its
+ * destination.
+ */
+void setErrMessageCallbackWithoutRecvErr(
+    folly::AsyncUDPSocket& sock,
+    folly::AsyncUDPSocket::ErrMessageCallback* callback) noexcept;
+
+/**
+ * Marks all datagrams sent on the socket with the given ECN codepoint, and if
+ * readEcn is set asks the kernel to hand the TOS / traffic class of received
+ * datagrams to recvmsg as a control message. Failures are only logged, the
+ * socket keeps working without ECN.
+ */
+void applyEcnSocketOptions(
+    folly::AsyncUDPSocket& sock,
+    sa_family_t family,
+    ECNCodepoint marking,
+    bool readEcn) noexcept;
+
+/**
+ * Lets datagrams sent on the socket carry an SCM_TXTIME departure time on
+ * CLOCK_MONOTONIC, which the fq qdisc holds them until. Returns false if the
+ * platform or the kernel doesn't support SO_TXTIME, in which case the caller
+ * has to pace in userspace. A true return doesn't mean fq is installed, the
+ * qdisc isn't checked, so the first success is logged as a reminder.
+ */
+bool applyTxTimeSocketOption(folly::AsyncUDPSocket& sock) noexcept;
+
+/**
+ * Returns the ECN codepoint of an IP_TOS or IPV6_TCLASS control message, or
+ * folly::none for any other control message.
+ */
+folly::Optional<ECNCodepoint> getEcnFromCmsg(const struct cmsghdr& cmsg);
+
 } // namespace quic
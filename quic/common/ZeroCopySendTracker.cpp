@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/common/ZeroCopySendTracker.h>
+
+#include <folly/net/NetOps.h>
+#include <glog/logging.h>
+#include <quic/QuicConstants.h>
+
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/errqueue.h>
+#endif
+
+#if defined(__linux__) && !defined(UDP_SEGMENT)
+#define UDP_SEGMENT 103
+#endif
+
+#if defined(FOLLY_HAVE_MSG_ERRQUEUE) && defined(SO_ZEROCOPY) && \
+    defined(MSG_ZEROCOPY) && defined(SO_EE_ORIGIN_ZEROCOPY)
+#define QUIC_HAVE_ZEROCOPY_SEND 1
+#else
+#define QUIC_HAVE_ZEROCOPY_SEND 0
+#endif
+
+namespace quic {
+
+std::unique_ptr<ZeroCopySendTracker> ZeroCopySendTracker::create(
+    folly::AsyncUDPSocket& sock) {
+#if QUIC_HAVE_ZEROCOPY_SEND
+  int enable = 1;
+  if (folly::netops::setsockopt(
+          sock.getNetworkSocket(),
+          SOL_SOCKET,
+          SO_ZEROCOPY,
+          &enable,
+          sizeof(enable))) {
+    LOG(WARNING) << "setsockopt SO_ZEROCOPY failed errno=" << errno;
+    return nullptr;
+  }
+  return std::unique_ptr<ZeroCopySendTracker>(
+      new ZeroCopySendTracker(sock.getNetworkSocket()));
+#else
+  (void)sock;
+  return nullptr;
+#endif
+}
+
+bool ZeroCopySendTracker::canWrite(const folly::AsyncUDPSocket& sock) const {
+  return sock.getNetworkSocket() == fd_;
+}
+
+ssize_t ZeroCopySendTracker::write(
+    folly::AsyncUDPSocket& sock,
+    const folly::SocketAddress& address,
+    std::unique_ptr<folly::IOBuf> buf,
+    int gsoSize) {
+  DCHECK(canWrite(sock));
+#if QUIC_HAVE_ZEROCOPY_SEND
+  auto len = buf->computeChainDataLength();
+  if (len < kMinZeroCopyWriteSize ||
+      pinned_.size() >= kMaxZeroCopyPinnedWrites) {
+    return copyWrite(sock, address, std::move(buf), gsoSize);
+  }
+
+  struct sockaddr_storage addrStorage;
+  socklen_t addrLen = address.getAddress(&addrStorage);
+  auto iovs = buf->getIov();
+
+  union {
+    struct cmsghdr hdr;
+    char buf[CMSG_SPACE(sizeof(uint16_t))];
+  } control;
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_name = &addrStorage;
+  msg.msg_namelen = addrLen;
+  msg.msg_iov = iovs.data();
+  msg.msg_iovlen = iovs.size();
+  if (gsoSize > 0) {
+    memset(control.buf, 0, sizeof(control.buf));
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    uint16_t segmentSize = gsoSize;
+    cmsg->cmsg_level = SOL_UDP;
+    cmsg->cmsg_type = UDP_SEGMENT;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(segmentSize));
+    memcpy(CMSG_DATA(cmsg), &segmentSize, sizeof(segmentSize));
+  }
+
+  auto ret =
+      folly::netops::sendmsg(sock.getNetworkSocket(), &msg, MSG_ZEROCOPY);
+  if (ret < 0) {
+    if (errno == ENOBUFS) {
+      // Out of optmem or locked memory for pinning pages, copy this one.
+      return copyWrite(sock, address, std::move(buf), gsoSize);
+    }
+    return ret;
+  }
+  // Only sends that succeed take a number.
+  pinned_.emplace(nextSendId_++, std::move(buf));
+  stats_.zeroCopyWrites++;
+  stats_.zeroCopyBytes += ret;
+  return ret;
+#else
+  return copyWrite(sock, address, std::move(buf), gsoSize);
+#endif
+}
+
+ssize_t ZeroCopySendTracker::copyWrite(
+    folly::AsyncUDPSocket& sock,
+    const folly::SocketAddress& address,
+    std::unique_ptr<folly::IOBuf> buf,
+    int gsoSize) {
+  auto ret = (gsoSize > 0) ? sock.writeGSO(address, buf, gsoSize)
+                           : sock.write(address, buf);
+  if (ret >= 0) {
+    stats_.copiedWrites++;
+    stats_.copiedBytes += ret;
+  }
+  recycle(std::move(buf));
+  return ret;
+}
+
+bool ZeroCopySendTracker::onErrMessage(
+    FOLLY_MAYBE_UNUSED const cmsghdr& cmsg) {
+#if QUIC_HAVE_ZEROCOPY_SEND
+  if (!(cmsg.cmsg_level == SOL_IP && cmsg.cmsg_type == IP_RECVERR) &&
+      !(cmsg.cmsg_level == SOL_IPV6 && cmsg.cmsg_type == IPV6_RECVERR)) {
+    return false;
+  }
+  const auto* serr =
+      reinterpret_cast<const struct sock_extended_err*>(CMSG_DATA(&cmsg));
+  if (serr->ee_errno != 0 || serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+    return false;
+  }
+  // ee_info and ee_data are the first and the last send of the range, which
+  // can wrap around.
+  uint32_t numSends = serr->ee_data - serr->ee_info + 1;
+  if (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+    stats_.kernelCopiedWrites += numSends;
+  }
+  for (uint32_t i = 0; i < numSends; i++) {
+    auto it = pinned_.find(serr->ee_info + i);
+    if (it == pinned_.end()) {
+      continue;
+    }
+    recycle(std::move(it->second));
+    pinned_.erase(it);
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+std::unique_ptr<folly::IOBuf> ZeroCopySendTracker::getBuffer(
+    size_t capacity) {
+  while (!freeBuffers_.empty()) {
+    auto buf = std::move(freeBuffers_.back());
+    freeBuffers_.pop_back();
+    if (buf->capacity() == capacity) {
+      buf->clear();
+      return buf;
+    }
+  }
+  return folly::IOBuf::create(capacity);
+}
+
+void ZeroCopySendTracker::recycle(std::unique_ptr<folly::IOBuf> buf) {
+  // Only buffers big enough for a zerocopy write are worth keeping.
+  if (buf && !buf->isChained() && !buf->isShared() &&
+      buf->capacity() >= kMinZeroCopyWriteSize &&
+      freeBuffers_.size() < kMaxZeroCopyFreeBuffers) {
+    freeBuffers_.push_back(std::move(buf));
+  }
+}
+
+} // namespace quic
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#pragma once
+
+#include <folly/container/F14Map.h>
+#include <folly/io/IOBuf.h>
+#include <folly/io/async/AsyncUDPSocket.h>
+
+#include <vector>
+
+namespace quic {
+
+/**
+ * Sends large GSO writes with MSG_ZEROCOPY on one socket. The kernel reads the
+ * data straight from our buffers, so each buffer is held until the completion
+ * for its send shows up on the socket's error queue, which has to be fed to
+ * onErrMessage. The kernel numbers the zerocopy sends on a socket from 0 and
+ * one completion covers a range of those numbers, so there must be a single
+ * tracker per socket, shared by every connection writing to it.
+ *
+ * Released buffers that aren't chained are kept for getBuffer, so the
+ * continuous memory data path doesn't allocate a buffer per write.
+ */
+class ZeroCopySendTracker {
+ public:
+  struct Stats {
+    // Writes and bytes handed to the kernel with MSG_ZEROCOPY.
+    uint64_t zeroCopyWrites{0};
+    uint64_t zeroCopyBytes{0};
+    // Zerocopy writes the kernel ended up copying anyway, e.g. because the
+    // device can't do scatter-gather or the route is loopback.
+    uint64_t kernelCopiedWrites{0};
+    // Writes sent with a regular copying write, because they were too small,
+    // too many writes were pinned, or the kernel refused MSG_ZEROCOPY.
+    uint64_t copiedWrites{0};
+    uint64_t copiedBytes{0};
+  };
+
+  /**
+   * Enables SO_ZEROCOPY on sock and returns a tracker for it, or nullptr if
+   * the platform or the kernel doesn't support it.
+   */
+  static std::unique_ptr<ZeroCopySendTracker> create(
+      folly::AsyncUDPSocket& sock);
+
+  /**
+   * Whether writes on sock can go through this tracker.
+   */
+  bool canWrite(const folly::AsyncUDPSocket& sock) const;
+
+  /**
+   * Writes buf to address, GSO segmented when gsoSize is positive. Writes of
+   * at least kMinZeroCopyWriteSize bytes are sent with MSG_ZEROCOPY and buf is
+   * held until they complete. Has the same return value and errno as
+   * AsyncUDPSocket::writeGSO.
+   */
+  ssize_t write(
+      folly::AsyncUDPSocket& sock,
+      const folly::SocketAddress& address,
+      std::unique_ptr<folly::IOBuf> buf,
+      int gsoSize);
+
+  /**
+   * Handles a message from the socket's error queue. Returns true if it was a
+   * zerocopy completion, which releases the buffers of the sends it covers.
+   */
+  bool onErrMessage(const struct cmsghdr& cmsg);
+
+  /**
+   * Returns an empty buffer with the given capacity and no headroom, recycled
+   * from a completed write if possible.
+   */
+  std::unique_ptr<folly::IOBuf> getBuffer(size_t capacity);
+
+  size_t numPinnedWrites() const {
+    return pinned_.size();
+  }
+
+  const Stats& getStats() const {
+    return stats_;
+  }
+
+ private:
+  explicit ZeroCopySendTracker(folly::NetworkSocket fd) : fd_(fd) {}
+
+  ssize_t copyWrite(
+      folly::AsyncUDPSocket& sock,
+      const folly::SocketAddress& address,
+      std::unique_ptr<folly::IOBuf> buf,
+      int gsoSize);
+
+  void recycle(std::unique_ptr<folly::IOBuf> buf);
+
+  folly::NetworkSocket fd_;
+  // The number the kernel gives the next zerocopy send on the socket.
+  uint32_t nextSendId_{0};
+  folly::F14FastMap<uint32_t, std::unique_ptr<folly::IOBuf>> pinned_;
+  std::vector<std::unique_ptr<folly::IOBuf>> freeBuffers_;
+  Stats stats_;
+};
+
+} // namespace quic
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/common/test/AllocationTracker.h>
+
+#include <malloc.h>
+#include <cstdlib>
+#include <new>
+
+namespace {
+thread_local int64_t threadLiveHeapBytes = 0;
+thread_local bool countAllocations = false;
+thread_local size_t numAllocations = 0;
+} // namespace
+
+void* operator new(size_t size) {
+  if (countAllocations) {
+    numAllocations++;
+  }
+  void* ptr = std::malloc(size == 0 ? 1 : size);
+  if (!ptr) {
+    throw std::bad_alloc();
+  }
+  threadLiveHeapBytes += malloc_usable_size(ptr);
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+  if (ptr) {
+    threadLiveHeapBytes -= malloc_usable_size(ptr);
+  }
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+  operator delete(ptr);
+}
+
+namespace quic {
+namespace test {
+
+int64_t liveHeapBytes() {
+  return threadLiveHeapBytes;
+}
+
+AllocationCounter::AllocationCounter() {
+  numAllocations = 0;
+  countAllocations = true;
+}
+
+AllocationCounter::~AllocationCounter() {
+  countAllocations = false;
+}
+
+size_t AllocationCounter::count() const {
+  return numAllocations;
+}
+
+} // namespace test
+} // namespace quic
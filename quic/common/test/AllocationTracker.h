@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace quic {
+namespace test {
+
+/**
+ * Linking mvfst_allocation_tracker replaces the global operator new and
+ * delete of the test binary to track the heap usage of the calling thread.
+ * Only link it into tests that measure allocations.
+ */
+
+/**
+ * Heap bytes allocated through operator new by this thread and not yet freed,
+ * as reported by malloc_usable_size.
+ */
+int64_t liveHeapBytes();
+
+/**
+ * Counts the operator new calls this thread makes while the counter is alive,
+ * to check a code path does not allocate.
+ */
+class AllocationCounter {
+ public:
+  AllocationCounter();
+  ~AllocationCounter();
+
+  AllocationCounter(const AllocationCounter&) = delete;
+  AllocationCounter& operator=(const AllocationCounter&) = delete;
+
+  size_t count() const;
+};
+
+} // namespace test
+} // namespace quic
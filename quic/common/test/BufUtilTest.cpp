@@ -504,3 +504,28 @@ TEST(BufWriterTest, TwoWriters) {
   EXPECT_EQ(15, outputBuffer->length());
   EXPECT_EQ("Destroyer Saint", reader.readFixedString(outputBuffer->length()));
 }
+
+TEST(BufUtil, UnchainBuf) {
+  EXPECT_TRUE(unchainBuf(nullptr).empty());
+
+  auto chain = IOBuf::copyBuffer("hello");
+  chain->prependChain(IOBuf::create(0));
+  chain->prependChain(IOBuf::copyBuffer(" "));
+  chain->prependChain(IOBuf::copyBuffer("world"));
+  std::vector<const uint8_t*> dataPtrs;
+  for (auto& buf : *chain) {
+    if (!buf.empty()) {
+      dataPtrs.push_back(buf.data());
+    }
+  }
+
+  auto bufs = unchainBuf(std::move(chain));
+  ASSERT_EQ(3, bufs.size());
+  std::string joined;
+  for (size_t i = 0; i < bufs.size(); i++) {
+    EXPECT_FALSE(bufs[i]->isChained());
+    EXPECT_EQ(dataPtrs[i], bufs[i]->data());
+    joined += bufs[i]->moveToFbString().toStdString();
+  }
+  EXPECT_EQ("hello world", joined);
+}
@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/common/CircularDeque.h>
+
+#include <gtest/gtest.h>
+#include <deque>
+#include <memory>
+#include <string>
+
+using namespace testing;
+
+namespace quic {
+namespace test {
+
+namespace {
+
+template <typename T>
+void expectSameElements(
+    const CircularDeque<T>& actual,
+    const std::deque<T>& expected) {
+  ASSERT_EQ(actual.size(), expected.size());
+  size_t index = 0;
+  for (const auto& val : actual) {
+    EXPECT_EQ(val, expected[index]) << "index=" << index;
+    EXPECT_EQ(actual[index], expected[index]) << "index=" << index;
+    index++;
+  }
+}
+
+} // namespace
+
+TEST(CircularDequeTest, PushPopBothEnds) {
+  CircularDeque<int> cd;
+  EXPECT_TRUE(cd.empty());
+  for (int i = 0; i < 20; i++) {
+    cd.push_back(i);
+  }
+  for (int i = 1; i <= 20; i++) {
+    cd.push_front(-i);
+  }
+  EXPECT_EQ(40, cd.size());
+  EXPECT_EQ(-20, cd.front());
+  EXPECT_EQ(19, cd.back());
+  cd.pop_front();
+  cd.pop_back();
+  EXPECT_EQ(-19, cd.front());
+  EXPECT_EQ(18, cd.back());
+  EXPECT_EQ(38, cd.size());
+  cd.clear();
+  EXPECT_TRUE(cd.empty());
+}
+
+TEST(CircularDequeTest, WrapAround) {
+  CircularDeque<int> cd;
+  std::deque<int> expected;
+  // Keep the size constant while pushing at the back and popping at the front
+  // so the elements wrap around the end of the buffer several times.
+  for (int i = 0; i < 6; i++) {
+    cd.push_back(i);
+    expected.push_back(i);
+  }
+  for (int i = 6; i < 100; i++) {
+    cd.pop_front();
+    expected.pop_front();
+    cd.push_back(i);
+    expected.push_back(i);
+    expectSameElements(cd, expected);
+  }
+  // Growing while wrapped keeps the order.
+  for (int i = 100; i < 120; i++) {
+    cd.push_back(i);
+    expected.push_back(i);
+  }
+  expectSameElements(cd, expected);
+}
+
+TEST(CircularDequeTest, EmplaceInTheMiddle) {
+  CircularDeque<int> cd{1, 2, 4, 5};
+  auto it = cd.emplace(cd.begin() + 2, 3);
+  EXPECT_EQ(3, *it);
+  EXPECT_EQ(cd.begin() + 2, it);
+  it = cd.emplace(cd.begin(), 0);
+  EXPECT_EQ(cd.begin(), it);
+  it = cd.emplace(cd.end(), 6);
+  EXPECT_EQ(cd.end() - 1, it);
+  expectSameElements(cd, std::deque<int>{0, 1, 2, 3, 4, 5, 6});
+}
+
+TEST(CircularDequeTest, EraseRanges) {
+  CircularDeque<int> cd;
+  std::deque<int> expected;
+  for (int i = 0; i < 50; i++) {
+    cd.push_back(i);
+    expected.push_back(i);
+  }
+  // Close to the front.
+  auto it = cd.erase(cd.begin() + 2, cd.begin() + 5);
+  auto expectedIt = expected.erase(expected.begin() + 2, expected.begin() + 5);
+  EXPECT_EQ(*expectedIt, *it);
+  expectSameElements(cd, expected);
+  // Close to the back.
+  it = cd.erase(cd.end() - 6, cd.end() - 2);
+  expectedIt = expected.erase(expected.end() - 6, expected.end() - 2);
+  EXPECT_EQ(*expectedIt, *it);
+  expectSameElements(cd, expected);
+  // Single element.
+  it = cd.erase(cd.begin() + 10);
+  expectedIt = expected.erase(expected.begin() + 10);
+  EXPECT_EQ(*expectedIt, *it);
+  expectSameElements(cd, expected);
+  // Everything.
+  it = cd.erase(cd.begin(), cd.end());
+  EXPECT_EQ(cd.end(), it);
+  EXPECT_TRUE(cd.empty());
+}
+
+TEST(CircularDequeTest, ReverseIteratorErase) {
+  // The erase pattern used by ack processing: erase a range described by two
+  // reverse iterators and keep iterating from the returned position.
+  CircularDeque<int> cd;
+  for (int i = 0; i < 10; i++) {
+    cd.push_back(i);
+  }
+  auto rEnd = cd.rbegin() + 2;
+  auto rIt = rEnd + 3;
+  auto nextElem = cd.erase(rIt.base(), rEnd.base());
+  auto rNext = std::reverse_iterator<decltype(nextElem)>(nextElem);
+  EXPECT_EQ(4, *rNext);
+  expectSameElements(cd, std::deque<int>{0, 1, 2, 3, 4, 8, 9});
+
+  auto lb = std::lower_bound(
+      cd.rbegin(), cd.rend(), 3, [](int lhs, int rhs) { return lhs > rhs; });
+  EXPECT_EQ(3, *lb);
+}
+
+TEST(CircularDequeTest, MoveOnlyElements) {
+  CircularDeque<std::unique_ptr<int>> cd;
+  for (int i = 0; i < 20; i++) {
+    if (i % 2) {
+      cd.emplace_back(std::make_unique<int>(i));
+    } else {
+      cd.emplace_front(std::make_unique<int>(i));
+    }
+  }
+  cd.erase(cd.begin() + 3, cd.begin() + 7);
+  cd.emplace(cd.begin() + 5, std::make_unique<int>(100));
+  EXPECT_EQ(17, cd.size());
+  EXPECT_EQ(100, *cd[5]);
+  CircularDeque<std::unique_ptr<int>> moved(std::move(cd));
+  EXPECT_TRUE(cd.empty());
+  EXPECT_EQ(17, moved.size());
+  EXPECT_EQ(18, *moved.front());
+  EXPECT_EQ(19, *moved.back());
+}
+
+TEST(CircularDequeTest, EmplaceBackFromOwnElement) {
+  CircularDeque<std::string> cd;
+  for (size_t i = 0; i < 8; i++) {
+    cd.emplace_back(std::string(32, 'a' + i));
+  }
+  EXPECT_EQ(cd.capacity(), cd.size());
+  // Triggers a reallocation while the argument refers to an element.
+  cd.push_back(cd.front());
+  EXPECT_EQ(cd.front(), cd.back());
+}
+
+TEST(CircularDequeTest, ConstIterators) {
+  CircularDeque<int> cd{1, 2, 3};
+  const auto& constRef = cd;
+  CircularDeque<int>::const_iterator cit = cd.begin();
+  EXPECT_TRUE(cit == constRef.begin());
+  EXPECT_TRUE(cd.begin() == cit);
+  EXPECT_EQ(3, cd.end() - cit);
+  int sum = 0;
+  for (auto it = constRef.crbegin(); it != constRef.crend(); ++it) {
+    sum += *it;
+  }
+  EXPECT_EQ(6, sum);
+}
+
+} // namespace test
+} // namespace quic
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <folly/Benchmark.h>
+#include <folly/init/Init.h>
+#include <folly/io/async/EventBase.h>
+
+#include <quic/common/ConnectionTimer.h>
+
+using namespace quic;
+using namespace std::chrono_literals;
+
+namespace {
+
+/**
+ * The timeouts every packet touches: the ack timeout is scheduled when the
+ * packet is received and cancelled once the ack is written, the loss and idle
+ * timeouts move to a later deadline.
+ */
+template <class Timeout>
+struct ConnectionTimeouts {
+  Timeout ack;
+  Timeout loss;
+  Timeout idle;
+};
+
+class WheelTimeout : public folly::HHWheelTimer::Callback {
+ public:
+  void timeoutExpired() noexcept override {}
+};
+
+class ConsolidatedTimeout : public ConnectionTimer::Callback {
+ public:
+  void timeoutExpired() noexcept override {}
+};
+
+void wheelTimerPerPacketBench(uint32_t iters, size_t numConnections) {
+  folly::EventBase evb;
+  std::vector<ConnectionTimeouts<WheelTimeout>> connections(numConnections);
+  auto& wheelTimer = evb.timer();
+  BENCHMARK_SUSPEND {
+    for (auto& conn : connections) {
+      wheelTimer.scheduleTimeout(&conn.loss, 200ms);
+      wheelTimer.scheduleTimeout(&conn.idle, 60s);
+    }
+  }
+  for (uint32_t i = 0; i < iters; i++) {
+    auto& conn = connections[i % numConnections];
+    wheelTimer.scheduleTimeout(&conn.ack, 25ms);
+    conn.ack.cancelTimeout();
+    wheelTimer.scheduleTimeout(&conn.loss, 200ms);
+    wheelTimer.scheduleTimeout(&conn.idle, 60s);
+  }
+  folly::doNotOptimizeAway(wheelTimer.count());
+}
+
+void connectionTimerPerPacketBench(uint32_t iters, size_t numConnections) {
+  folly::EventBase evb;
+  std::vector<ConnectionTimer> timers(numConnections);
+  std::vector<ConnectionTimeouts<ConsolidatedTimeout>> connections(
+      numConnections);
+  auto& wheelTimer = evb.timer();
+  BENCHMARK_SUSPEND {
+    for (size_t i = 0; i < numConnections; i++) {
+      timers[i].scheduleTimeout(wheelTimer, &connections[i].loss, 200ms);
+      timers[i].scheduleTimeout(wheelTimer, &connections[i].idle, 60s);
+    }
+  }
+  for (uint32_t i = 0; i < iters; i++) {
+    auto& timer = timers[i % numConnections];
+    auto& conn = connections[i % numConnections];
+    timer.scheduleTimeout(wheelTimer, &conn.ack, 25ms);
+    conn.ack.cancelTimeout();
+    timer.scheduleTimeout(wheelTimer, &conn.loss, 200ms);
+    timer.scheduleTimeout(wheelTimer, &conn.idle, 60s);
+  }
+  folly::doNotOptimizeAway(wheelTimer.count());
+}
+
+} // namespace
+
+BENCHMARK_PARAM(wheelTimerPerPacketBench, 1000)
+BENCHMARK_RELATIVE_PARAM(connectionTimerPerPacketBench, 1000)
+BENCHMARK_PARAM(wheelTimerPerPacketBench, 100000)
+BENCHMARK_RELATIVE_PARAM(connectionTimerPerPacketBench, 100000)
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/common/ConnectionTimer.h>
+
+#include <folly/io/async/EventBase.h>
+#include <gtest/gtest.h>
+
+#include <functional>
+
+using namespace std;
+using namespace folly;
+using namespace testing;
+
+namespace quic {
+namespace test {
+
+class RecordingTimeout : public ConnectionTimer::Callback {
+ public:
+  RecordingTimeout(std::vector<int>& fired, int id) : fired_(fired), id_(id) {}
+
+  void timeoutExpired() noexcept override {
+    fired_.push_back(id_);
+    if (onExpired) {
+      onExpired();
+    }
+  }
+
+  void callbackCanceled() noexcept override {
+    canceled = true;
+  }
+
+  std::function<void()> onExpired;
+  bool canceled{false};
+
+ private:
+  std::vector<int>& fired_;
+  int id_;
+};
+
+TEST(ConnectionTimerTest, FiresInDeadlineOrder) {
+  EventBase evb;
+  ConnectionTimer timer;
+  std::vector<int> fired;
+  RecordingTimeout first(fired, 1);
+  RecordingTimeout second(fired, 2);
+  timer.scheduleTimeout(evb.timer(), &second, 60ms);
+  timer.scheduleTimeout(evb.timer(), &first, 20ms);
+  EXPECT_EQ(timer.numScheduled(), 2);
+  EXPECT_TRUE(first.isScheduled());
+  EXPECT_TRUE(second.isScheduled());
+  evb.loop();
+  EXPECT_EQ(fired, std::vector<int>({1, 2}));
+  EXPECT_FALSE(first.isScheduled());
+  EXPECT_FALSE(second.isScheduled());
+  EXPECT_EQ(timer.numScheduled(), 0);
+}
+
+TEST(ConnectionTimerTest, LaterDeadlinesDoNotTouchWheel) {
+  EventBase evb;
+  ConnectionTimer timer;
+  std::vector<int> fired;
+  RecordingTimeout ack(fired, 1);
+  RecordingTimeout loss(fired, 2);
+  RecordingTimeout idle(fired, 3);
+  timer.scheduleTimeout(evb.timer(), &idle, 60s);
+  EXPECT_EQ(timer.wheelTimerScheduleCount(), 1);
+  timer.scheduleTimeout(evb.timer(), &loss, 1s);
+  EXPECT_EQ(timer.wheelTimerScheduleCount(), 2);
+  timer.scheduleTimeout(evb.timer(), &ack, 25ms);
+  EXPECT_EQ(timer.wheelTimerScheduleCount(), 3);
+  // What happens on every packet: the ack timeout is cancelled, the loss and
+  // idle timeouts move to later deadlines.
+  for (int i = 0; i < 100; i++) {
+    ack.cancelTimeout();
+    timer.scheduleTimeout(evb.timer(), &ack, 25ms);
+    timer.scheduleTimeout(evb.timer(), &loss, 1s);
+    timer.scheduleTimeout(evb.timer(), &idle, 60s);
+  }
+  EXPECT_EQ(timer.wheelTimerScheduleCount(), 3);
+  EXPECT_EQ(timer.numScheduled(), 3);
+  EXPECT_NEAR(idle.getTimeRemaining().count(), 60000, 1000);
+}
+
+TEST(ConnectionTimerTest, EarlierDeadlineReschedulesWheel) {
+  EventBase evb;
+  ConnectionTimer timer;
+  std::vector<int> fired;
+  RecordingTimeout idle(fired, 1);
+  RecordingTimeout ack(fired, 2);
+  timer.scheduleTimeout(evb.timer(), &idle, 60s);
+  timer.scheduleTimeout(evb.timer(), &ack, 10ms);
+  EXPECT_EQ(timer.wheelTimerScheduleCount(), 2);
+  while (fired.empty()) {
+    evb.loopOnce();
+  }
+  EXPECT_EQ(fired, std::vector<int>({2}));
+  EXPECT_TRUE(idle.isScheduled());
+}
+
+TEST(ConnectionTimerTest, MovedDeadlineRearmsWheel) {
+  EventBase evb;
+  ConnectionTimer timer;
+  std::vector<int> fired;
+  RecordingTimeout loss(fired, 1);
+  timer.scheduleTimeout(evb.timer(), &loss, 10ms);
+  timer.scheduleTimeout(evb.timer(), &loss, 50ms);
+  auto start = std::chrono::steady_clock::now();
+  evb.loop();
+  EXPECT_EQ(fired, std::vector<int>({1}));
+  EXPECT_GE(std::chrono::steady_clock::now() - start, 50ms);
+  // Once for the original deadline, at least once more when it fired early.
+  EXPECT_GE(timer.wheelTimerScheduleCount(), 2);
+}
+
+TEST(ConnectionTimerTest, NeverFiresEarly) {
+  EventBase evb;
+  ConnectionTimer timer;
+  std::vector<int> fired;
+  RecordingTimeout ack(fired, 1);
+  RecordingTimeout loss(fired, 2);
+  std::vector<std::chrono::steady_clock::time_point> firedAt;
+  ack.onExpired = [&] { firedAt.push_back(std::chrono::steady_clock::now()); };
+  loss.onExpired = ack.onExpired;
+  // Deadlines that are not a multiple of the tick interval, a tick apart.
+  auto start = std::chrono::steady_clock::now();
+  timer.scheduleTimeout(evb.timer(), &ack, 15ms);
+  timer.scheduleTimeout(
+      evb.timer(), &loss, 15ms + evb.timer().getTickInterval());
+  evb.loop();
+  ASSERT_EQ(fired, std::vector<int>({1, 2}));
+  EXPECT_GE(firedAt[0] - start, 15ms);
+  EXPECT_GE(firedAt[1] - start, 15ms + evb.timer().getTickInterval());
+}
+
+TEST(ConnectionTimerTest, CancelLastTimeoutStopsWheel) {
+  EventBase evb;
+  ConnectionTimer timer;
+  std::vector<int> fired;
+  RecordingTimeout idle(fired, 1);
+  timer.scheduleTimeout(evb.timer(), &idle, 10ms);
+  idle.cancelTimeout();
+  EXPECT_FALSE(idle.isScheduled());
+  EXPECT_EQ(idle.getTimeRemaining().count(), 0);
+  EXPECT_EQ(evb.timer().count(), 0);
+  evb.loop();
+  EXPECT_TRUE(fired.empty());
+}
+
+TEST(ConnectionTimerTest, RescheduleFromTimeout) {
+  EventBase evb;
+  ConnectionTimer timer;
+  std::vector<int> fired;
+  RecordingTimeout ping(fired, 1);
+  ping.onExpired = [&] {
+    if (fired.size() < 3) {
+      timer.scheduleTimeout(evb.timer(), &ping, 0ms);
+    }
+  };
+  timer.scheduleTimeout(evb.timer(), &ping, 0ms);
+  evb.loop();
+  EXPECT_EQ(fired, std::vector<int>({1, 1, 1}));
+}
+
+TEST(ConnectionTimerTest, DestroyedFromTimeout) {
+  EventBase evb;
+  auto timer = std::make_unique<ConnectionTimer>();
+  std::vector<int> fired;
+  RecordingTimeout first(fired, 1);
+  RecordingTimeout second(fired, 2);
+  first.onExpired = [&] { timer.reset(); };
+  timer->scheduleTimeout(evb.timer(), &first, 0ms);
+  timer->scheduleTimeout(evb.timer(), &second, 1ms);
+  evb.loop();
+  EXPECT_EQ(fired, std::vector<int>({1}));
+  EXPECT_FALSE(second.isScheduled());
+}
+
+TEST(ConnectionTimerTest, WheelTimerDestroyed) {
+  ConnectionTimer timer;
+  std::vector<int> fired;
+  RecordingTimeout idle(fired, 1);
+  {
+    EventBase evb;
+    timer.scheduleTimeout(evb.timer(), &idle, 60s);
+  }
+  EXPECT_TRUE(idle.canceled);
+  EXPECT_FALSE(idle.isScheduled());
+  EXPECT_TRUE(fired.empty());
+}
+
+} // namespace test
+} // namespace quic
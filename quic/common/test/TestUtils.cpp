@@ -352,9 +352,15 @@ RegularQuicPacketBuilder::Packet createInitialCryptoPacket(
     const Aead& aead,
     PacketNum largestAcked,
     uint64_t offset,
-    const BuilderProvider& builderProvider) {
+    const BuilderProvider& builderProvider,
+    const std::string& token) {
   LongHeader header(
-      LongHeader::Types::Initial, srcConnId, dstConnId, packetNum, version);
+      LongHeader::Types::Initial,
+      srcConnId,
+      dstConnId,
+      packetNum,
+      version,
+      token);
   LongHeader copyHeader(header);
   PacketBuilderInterface* builder = nullptr;
   if (builderProvider) {
@@ -95,7 +95,8 @@ RegularQuicPacketBuilder::Packet createInitialCryptoPacket(
     const Aead& aead,
     PacketNum largestAcked,
     uint64_t offset = 0,
-    const BuilderProvider& builderProvider = nullptr);
+    const BuilderProvider& builderProvider = nullptr,
+    const std::string& token = std::string());
 
 RegularQuicPacketBuilder::Packet createCryptoPacket(
     ConnectionId srcConnId,
@@ -194,7 +195,7 @@ OutstandingPacket* findOutstandingPacket(
     QuicConnectionStateBase& conn,
     Match match) {
   auto helper =
-      [&](std::deque<OutstandingPacket>& packets) -> OutstandingPacket* {
+      [&](CircularDeque<OutstandingPacket>& packets) -> OutstandingPacket* {
     for (auto& packet : packets) {
       if (match(packet)) {
         return &packet;
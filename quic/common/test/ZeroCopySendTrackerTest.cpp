@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/common/ZeroCopySendTracker.h>
+
+#include <folly/io/async/EventBase.h>
+#include <folly/portability/GTest.h>
+#include <quic/QuicConstants.h>
+#include <quic/common/SocketUtil.h>
+
+#ifdef __linux__
+#include <linux/errqueue.h>
+#endif
+
+namespace quic {
+namespace test {
+
+class ZeroCopySendTrackerTest : public testing::Test {
+ public:
+  void SetUp() override {
+    sock = std::make_unique<folly::AsyncUDPSocket>(&evb);
+    sock->setReuseAddr(false);
+    sock->bind(folly::SocketAddress("127.0.0.1", 0));
+    peer = std::make_unique<folly::AsyncUDPSocket>(&evb);
+    peer->setReuseAddr(false);
+    peer->bind(folly::SocketAddress("127.0.0.1", 0));
+    tracker = ZeroCopySendTracker::create(*sock);
+  }
+
+  folly::EventBase evb;
+  std::unique_ptr<folly::AsyncUDPSocket> sock;
+  std::unique_ptr<folly::AsyncUDPSocket> peer;
+  std::unique_ptr<ZeroCopySendTracker> tracker;
+};
+
+TEST_F(ZeroCopySendTrackerTest, CanWriteOnlyItsSocket) {
+  if (!tracker) {
+    GTEST_SKIP() << "SO_ZEROCOPY not supported";
+  }
+  EXPECT_TRUE(tracker->canWrite(*sock));
+  EXPECT_FALSE(tracker->canWrite(*peer));
+}
+
+TEST_F(ZeroCopySendTrackerTest, SmallWritesAreCopied) {
+  if (!tracker) {
+    GTEST_SKIP() << "SO_ZEROCOPY not supported";
+  }
+  auto buf = folly::IOBuf::create(1000);
+  buf->append(1000);
+  EXPECT_EQ(1000, tracker->write(*sock, peer->address(), std::move(buf), 0));
+  EXPECT_EQ(0, tracker->numPinnedWrites());
+  EXPECT_EQ(1, tracker->getStats().copiedWrites);
+  EXPECT_EQ(1000, tracker->getStats().copiedBytes);
+  EXPECT_EQ(0, tracker->getStats().zeroCopyWrites);
+}
+
+TEST_F(ZeroCopySendTrackerTest, CompletionReleasesBuffers) {
+  if (!tracker) {
+    GTEST_SKIP() << "SO_ZEROCOPY not supported";
+  }
+#if defined(__linux__) && defined(SO_EE_ORIGIN_ZEROCOPY)
+  constexpr size_t kSegmentSize = 1000;
+  constexpr size_t kCapacity = kMinZeroCopyWriteSize * 2;
+  const uint8_t* firstData = nullptr;
+  for (int i = 0; i < 2; i++) {
+    auto buf = tracker->getBuffer(kCapacity);
+    if (i == 0) {
+      firstData = buf->data();
+    }
+    buf->append(kSegmentSize * 20);
+    auto ret =
+        tracker->write(*sock, peer->address(), std::move(buf), kSegmentSize);
+    if (ret < 0) {
+      GTEST_SKIP() << "UDP GSO not supported";
+    }
+  }
+  EXPECT_EQ(2, tracker->numPinnedWrites());
+  EXPECT_EQ(2, tracker->getStats().zeroCopyWrites);
+
+  union {
+    struct cmsghdr hdr;
+    char buf[CMSG_SPACE(sizeof(struct sock_extended_err))];
+  } control;
+  memset(control.buf, 0, sizeof(control.buf));
+  control.hdr.cmsg_level = SOL_IP;
+  control.hdr.cmsg_type = IP_RECVERR;
+  control.hdr.cmsg_len = CMSG_LEN(sizeof(struct sock_extended_err));
+  struct sock_extended_err serr;
+  memset(&serr, 0, sizeof(serr));
+  serr.ee_origin = SO_EE_ORIGIN_ZEROCOPY;
+  serr.ee_code = SO_EE_CODE_ZEROCOPY_COPIED;
+  serr.ee_info = 0;
+  serr.ee_data = 1;
+  memcpy(CMSG_DATA(&control.hdr), &serr, sizeof(serr));
+
+  EXPECT_TRUE(tracker->onErrMessage(control.hdr));
+  EXPECT_EQ(0, tracker->numPinnedWrites());
+  EXPECT_EQ(2, tracker->getStats().kernelCopiedWrites);
+
+  // The released buffers are handed out again.
+  auto reused = tracker->getBuffer(kCapacity);
+  auto reusedAgain = tracker->getBuffer(kCapacity);
+  EXPECT_TRUE(
+      reused->data() == firstData || reusedAgain->data() == firstData);
+  EXPECT_EQ(0, reused->length());
+
+  // Other errors are left to the socket's owner.
+  serr.ee_origin = SO_EE_ORIGIN_LOCAL;
+  serr.ee_errno = EMSGSIZE;
+  memcpy(CMSG_DATA(&control.hdr), &serr, sizeof(serr));
+  EXPECT_FALSE(tracker->onErrMessage(control.hdr));
+#endif
+}
+
+TEST_F(ZeroCopySendTrackerTest, ErrMessageCallbackWithoutRecvErr) {
+#ifdef IP_RECVERR
+  class ErrMessageCallback : public folly::AsyncUDPSocket::ErrMessageCallback {
+    void errMessage(const cmsghdr&) noexcept override {}
+    void errMessageError(const folly::AsyncSocketException&) noexcept override {
+    }
+  } callback;
+  setErrMessageCallbackWithoutRecvErr(*sock, &callback);
+  int recvErr = 1;
+  socklen_t len = sizeof(recvErr);
+  ASSERT_EQ(
+      0,
+      folly::netops::getsockopt(
+          sock->getNetworkSocket(), IPPROTO_IP, IP_RECVERR, &recvErr, &len));
+  EXPECT_EQ(0, recvErr);
+  sock->setErrMessageCallback(nullptr);
+#else
+  GTEST_SKIP() << "IP_RECVERR not supported";
+#endif
+}
+
+TEST_F(ZeroCopySendTrackerTest, GetBufferIsEmpty) {
+  if (!tracker) {
+    GTEST_SKIP() << "SO_ZEROCOPY not supported";
+  }
+  auto buf = tracker->getBuffer(kMinZeroCopyWriteSize);
+  EXPECT_GE(buf->capacity(), kMinZeroCopyWriteSize);
+  EXPECT_EQ(0, buf->headroom());
+  EXPECT_EQ(0, buf->length());
+}
+
+} // namespace test
+} // namespace quic
@@ -15,6 +15,7 @@
 #include <quic/congestion_control/CongestionControlFunctions.h>
 #include <quic/logging/QLoggerConstants.h>
 #include <quic/logging/QuicLogger.h>
+#include <quic/state/QuicStateFunctions.h>
 
 using namespace std::chrono_literals;
 
@@ -24,6 +25,8 @@ quic::Bandwidth kHighPacingRateForSendQuantum{24, 1us};
 // See BBRInflight(gain) function in
 // https://tools.ietf.org/html/draft-cardwell-iccrg-bbr-congestion-control-00#section-4.2.3.2
 uint64_t kQuantaFactor = 3;
+// Never ask the peer to ack less often than every this many packets.
+uint64_t kMinAckFrequencyPacketTolerance = 2;
 } // namespace
 
 namespace quic {
@@ -168,10 +171,38 @@ void BbrCongestionController::onPacketAckOrLoss(
   }
   if (ackEvent && ackEvent->largestAckedPacket.has_value()) {
     CHECK(!ackEvent->ackedPackets.empty());
+    if (ackEvent->ecnCeMarkedPackets > 0) {
+      onCongestionExperienced(*ackEvent);
+    }
     onPacketAcked(*ackEvent, prevInflightBytes, lossEvent.has_value());
   }
 }
 
+void BbrCongestionController::onCongestionExperienced(const AckEvent& ack) {
+  // BBR doesn't back off on its bandwidth model for CE marks, but it limits
+  // the inflight bytes to what is being delivered for a round trip, the same
+  // way as for a loss.
+  if (inRecovery()) {
+    return;
+  }
+  endOfRecovery_ = Clock::now();
+  endOfRoundTrip_ = Clock::now();
+  recoveryState_ = BbrCongestionController::RecoveryState::CONSERVATIVE;
+  recoveryWindow_ = boundedCwnd(
+      conn_.lossState.inflightBytes + ack.ackedBytes,
+      conn_.udpSendPacketLen,
+      conn_.transportSettings.maxCwndInMss,
+      kMinCwndInMssForBbr);
+  if (conn_.qLogger) {
+    conn_.qLogger->addCongestionMetricUpdate(
+        conn_.lossState.inflightBytes,
+        getCongestionWindow(),
+        kCongestionEcnCe,
+        bbrStateToString(state_),
+        bbrRecoveryStateToString(recoveryState_));
+  }
+}
+
 void BbrCongestionController::onPacketAcked(
     const AckEvent& ack,
     uint64_t prevInflightBytes,
@@ -262,6 +293,9 @@ void BbrCongestionController::onPacketAcked(
 
   updateCwnd(ack.ackedBytes, excessiveBytes);
   updatePacing();
+  if (newRoundTrip && state_ == BbrState::ProbeBw) {
+    updatePeerAckFrequency();
+  }
 }
 
 // TODO: We used to check if there is available bandwidth and rtt samples in
@@ -401,6 +435,30 @@ void BbrCongestionController::handleAckInProbeRtt(
   // handleAckInProbeRtt
 }
 
+void BbrCongestionController::updatePeerAckFrequency() noexcept {
+  auto acksPerRtt = conn_.transportSettings.bbrConfig.ackFrequencyAcksPerRtt;
+  if (acksPerRtt == 0 || !conn_.ackFrequencyState.peerMinAckDelay ||
+      minRtt() == 0us) {
+    return;
+  }
+  uint64_t packetTolerance = std::max<uint64_t>(
+      kMinAckFrequencyPacketTolerance,
+      calculateTargetCwnd(1.0f) / conn_.udpSendPacketLen / acksPerRtt);
+  const auto& lastRequested = conn_.ackFrequencyState.lastRequested;
+  if (lastRequested) {
+    // Only update the peer when the tolerance moved by more than a quarter,
+    // rather than sending a frame every round trip.
+    auto diff = packetTolerance > lastRequested->packetTolerance
+        ? packetTolerance - lastRequested->packetTolerance
+        : lastRequested->packetTolerance - packetTolerance;
+    if (diff * 4 <= lastRequested->packetTolerance) {
+      return;
+    }
+  }
+  requestPeerAckFrequencyChange(
+      conn_, packetTolerance, minRtt() / acksPerRtt, 1 /* reorderThreshold */);
+}
+
 void BbrCongestionController::transitToStartup() noexcept {
   state_ = BbrState::Startup;
   pacingGain_ = kStartupGain;
@@ -138,8 +138,15 @@ class BbrCongestionController : public CongestionController {
   void
   onPacketAcked(const AckEvent& ack, uint64_t prevInflightBytes, bool hasLoss);
   void onPacketLoss(const LossEvent&, uint64_t ackedBytes);
+  void onCongestionExperienced(const AckEvent& ack);
   void updatePacing() noexcept;
 
+  /**
+   * Ask the peer to ack bbrConfig.ackFrequencyAcksPerRtt times per min RTT
+   * with ACK_FREQUENCY, if the peer supports it.
+   */
+  void updatePeerAckFrequency() noexcept;
+
   /**
    * Update the ack aggregation states
    *
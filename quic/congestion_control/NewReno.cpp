@@ -99,6 +99,9 @@ void NewReno::onPacketAckOrLoss(
     // on the pacer when there is loss.
   }
   if (ackEvent && ackEvent->largestAckedPacket.has_value()) {
+    if (ackEvent->ecnCeMarkedPackets > 0) {
+      onCongestionExperienced(*ackEvent);
+    }
     onAckEvent(*ackEvent);
   }
   // TODO: Pacing isn't supported with NewReno
@@ -109,16 +112,7 @@ void NewReno::onPacketLoss(const LossEvent& loss) {
       loss.largestLostPacketNum.has_value() &&
       loss.largestLostSentTime.has_value());
   subtractAndCheckUnderflow(conn_.lossState.inflightBytes, loss.lostBytes);
-  if (!endOfRecovery_ || *endOfRecovery_ < *loss.largestLostSentTime) {
-    endOfRecovery_ = Clock::now();
-    cwndBytes_ = (cwndBytes_ >> kRenoLossReductionFactorShift);
-    cwndBytes_ = boundedCwnd(
-        cwndBytes_,
-        conn_.udpSendPacketLen,
-        conn_.transportSettings.maxCwndInMss,
-        conn_.transportSettings.minCwndInMss);
-    // This causes us to exit slow start.
-    ssthresh_ = cwndBytes_;
+  if (maybeEnterRecovery(*loss.largestLostSentTime)) {
     VLOG(10) << __func__ << " exit slow start, ssthresh=" << ssthresh_
              << " packetNum=" << *loss.largestLostPacketNum
              << " writable=" << getWritableBytes() << " cwnd=" << cwndBytes_
@@ -149,6 +143,39 @@ void NewReno::onPacketLoss(const LossEvent& loss) {
   }
 }
 
+void NewReno::onCongestionExperienced(const AckEvent& ack) {
+  // CE marks are handled like a loss of the largest acked packet.
+  if (maybeEnterRecovery(ack.largestAckedPacketSentTime)) {
+    VLOG(10) << __func__ << " exit slow start, ssthresh=" << ssthresh_
+             << " ceMarked=" << ack.ecnCeMarkedPackets
+             << " writable=" << getWritableBytes() << " cwnd=" << cwndBytes_
+             << " inflight=" << conn_.lossState.inflightBytes << " " << conn_;
+    if (conn_.qLogger) {
+      conn_.qLogger->addCongestionMetricUpdate(
+          conn_.lossState.inflightBytes,
+          getCongestionWindow(),
+          kCongestionEcnCe);
+    }
+  }
+}
+
+bool NewReno::maybeEnterRecovery(TimePoint congestionSentTime) {
+  if (endOfRecovery_ && *endOfRecovery_ >= congestionSentTime) {
+    // Already reacted to this round of congestion.
+    return false;
+  }
+  endOfRecovery_ = Clock::now();
+  cwndBytes_ = (cwndBytes_ >> kRenoLossReductionFactorShift);
+  cwndBytes_ = boundedCwnd(
+      cwndBytes_,
+      conn_.udpSendPacketLen,
+      conn_.transportSettings.maxCwndInMss,
+      conn_.transportSettings.minCwndInMss);
+  // This causes us to exit slow start.
+  ssthresh_ = cwndBytes_;
+  return true;
+}
+
 uint64_t NewReno::getWritableBytes() const noexcept {
   if (conn_.lossState.inflightBytes > cwndBytes_) {
     return 0;
@@ -40,6 +40,11 @@ class NewReno : public CongestionController {
   void onPacketLoss(const LossEvent&);
   void onAckEvent(const AckEvent&);
   void onPacketAcked(const CongestionController::AckEvent::AckPacket&);
+  void onCongestionExperienced(const AckEvent&);
+  // Reduces the cwnd, unless the congestion signal about a packet sent at
+  // congestionSentTime falls into the current recovery period. Returns whether
+  // the cwnd was reduced.
+  bool maybeEnterRecovery(TimePoint congestionSentTime);
 
  private:
   QuicConnectionStateBase& conn_;
@@ -137,6 +137,13 @@ uint64_t DefaultPacer::getCachedWriteBatchSize() const {
   return cachedBatchSize_;
 }
 
+PacingRate DefaultPacer::getPacingRate() const {
+  return PacingRate::Builder()
+      .setInterval(writeInterval_)
+      .setBurstSize(batchSize_)
+      .build();
+}
+
 void DefaultPacer::setPacingRateCalculator(
     PacingRateCalculator pacingRateCalculator) {
   pacingRateCalculator_ = std::move(pacingRateCalculator);
@@ -48,6 +48,8 @@ class DefaultPacer : public Pacer {
 
   uint64_t getCachedWriteBatchSize() const override;
 
+  PacingRate getPacingRate() const override;
+
   void onPacketSent() override;
   void onPacketsLoss() override;
 
@@ -362,10 +362,41 @@ void Cubic::onPacketAckOrLoss(
   }
   if (ackEvent && ackEvent->largestAckedPacket.has_value()) {
     CHECK(!ackEvent->ackedPackets.empty());
+    if (ackEvent->ecnCeMarkedPackets > 0) {
+      onCongestionExperienced(*ackEvent);
+    }
     onPacketAcked(*ackEvent);
   }
 }
 
+void Cubic::onCongestionExperienced(const AckEvent& ack) {
+  // CE marks get the same reduction as a loss of the largest acked packet, at
+  // most once per recovery period. Nothing was lost, so unlike onPacketLoss
+  // there are no bytes to take out of flight.
+  if (recoveryState_.endOfRecovery.has_value() &&
+      *recoveryState_.endOfRecovery >= ack.largestAckedPacketSentTime) {
+    return;
+  }
+  quiescenceStart_ = folly::none;
+  recoveryState_.endOfRecovery = Clock::now();
+  cubicReduction(ack.ackTime);
+  if (state_ == CubicStates::Hystart || state_ == CubicStates::Steady) {
+    state_ = CubicStates::FastRecovery;
+  }
+  ssthresh_ = cwndBytes_;
+  if (conn_.pacer) {
+    conn_.pacer->refreshPacingRate(
+        cwndBytes_ * pacingGain(), conn_.lossState.srtt);
+  }
+  if (conn_.qLogger) {
+    conn_.qLogger->addCongestionMetricUpdate(
+        conn_.lossState.inflightBytes,
+        getCongestionWindow(),
+        kCongestionEcnCe,
+        cubicStateToString(state_).str());
+  }
+}
+
 void Cubic::onPacketAcked(const AckEvent& ack) {
   auto currentCwnd = cwndBytes_;
   DCHECK_LE(ack.ackedBytes, conn_.lossState.inflightBytes);
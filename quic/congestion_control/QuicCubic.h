@@ -115,6 +115,7 @@ class Cubic : public CongestionController {
   void onPacketAckedInRecovery(const AckEvent& ack);
 
   void onPacketLoss(const LossEvent& loss);
+  void onCongestionExperienced(const AckEvent& ack);
   void onPacketLossInRecovery(const LossEvent& loss);
   void onPersistentCongestion();
 
@@ -92,6 +92,13 @@ uint64_t TokenlessPacer::getCachedWriteBatchSize() const {
   return batchSize_;
 }
 
+PacingRate TokenlessPacer::getPacingRate() const {
+  return PacingRate::Builder()
+      .setInterval(writeInterval_)
+      .setBurstSize(batchSize_)
+      .build();
+}
+
 void TokenlessPacer::setPacingRateCalculator(
     PacingRateCalculator pacingRateCalculator) {
   pacingRateCalculator_ = std::move(pacingRateCalculator);
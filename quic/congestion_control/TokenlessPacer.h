@@ -41,6 +41,8 @@ class TokenlessPacer : public Pacer {
 
   uint64_t getCachedWriteBatchSize() const override;
 
+  PacingRate getPacingRate() const override;
+
   void onPacketSent() override;
   void onPacketsLoss() override;
 
@@ -230,5 +230,33 @@ TEST_F(NewRenoTest, RemoveBytesWithoutLossOrAck) {
   reno.onRemoveBytesFromInflight(2);
   EXPECT_EQ(reno.getWritableBytes(), originalWritableBytes - ackedSize + 2);
 }
+
+TEST_F(NewRenoTest, EcnCongestionExperienced) {
+  QuicServerConnectionState conn(
+      FizzServerQuicHandshakeContext::Builder().build());
+  NewReno reno(conn);
+  EXPECT_TRUE(reno.inSlowStart());
+
+  auto sentTime = Clock::now();
+  reno.onPacketSent(createPacket(1, 1000, sentTime));
+  reno.onPacketSent(createPacket(2, 1000, sentTime));
+  auto originalCwnd = reno.getCongestionWindow();
+
+  auto ack = createAckEvent(1, 1000, sentTime);
+  ack.largestAckedPacketSentTime = sentTime;
+  ack.ecnCeMarkedPackets = 1;
+  reno.onPacketAckOrLoss(ack, folly::none);
+  EXPECT_EQ(originalCwnd / 2, reno.getCongestionWindow());
+  EXPECT_FALSE(reno.inSlowStart());
+  EXPECT_EQ(1000, reno.getBytesInFlight());
+
+  // More marks on packets sent before the reduction don't reduce it again.
+  auto ack2 = createAckEvent(2, 1000, sentTime);
+  ack2.largestAckedPacketSentTime = sentTime;
+  ack2.ecnCeMarkedPackets = 1;
+  reno.onPacketAckOrLoss(ack2, folly::none);
+  EXPECT_EQ(originalCwnd / 2, reno.getCongestionWindow());
+  EXPECT_EQ(0, reno.getBytesInFlight());
+}
 } // namespace test
 } // namespace quic
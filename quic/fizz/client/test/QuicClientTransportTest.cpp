@@ -179,6 +179,10 @@ class TestingQuicClientTransport : public QuicClientTransport {
     onNotifyDataAvailable(sock);
   }
 
+  bool invokeShouldOnlyNotify() {
+    return shouldOnlyNotify();
+  }
+
  private:
   std::shared_ptr<DestructionCallback> destructionCallback_;
 };
@@ -2817,6 +2821,48 @@ TEST_F(QuicClientTransportAfterStartTest, ReadStream) {
   client->close(folly::none);
 }
 
+TEST_F(QuicClientTransportAfterStartTest, ReadEcnWithoutRecvBatch) {
+#ifndef FOLLY_HAVE_MSG_ERRQUEUE
+  GTEST_SKIP() << "control messages are not read on this platform";
+#endif
+  auto& conn = client->getNonConstConn();
+  conn.transportSettings.shouldRecvBatch = false;
+  conn.transportSettings.readEcnOnIngress = true;
+  // onDataAvailable has no control messages, ECN must be read with recvmsg.
+  EXPECT_TRUE(client->invokeShouldOnlyNotify());
+
+  StreamId streamId = client->createBidirectionalStream().value();
+  auto packet = packetToBuf(createStreamPacket(
+      *serverChosenConnId /* src */,
+      *originalConnId /* dest */,
+      appDataPacketNum++,
+      streamId,
+      *IOBuf::copyBuffer("hello"),
+      0 /* cipherOverhead */,
+      0 /* largestAcked */));
+  packet->coalesce();
+  // Still one packet per notification without batching.
+  EXPECT_CALL(*sock, recvmsg(_, _))
+      .WillOnce(Invoke([&](struct msghdr* msg, int) -> ssize_t {
+        memcpy(msg->msg_iov[0].iov_base, packet->data(), packet->length());
+        if (msg->msg_name) {
+          msg->msg_namelen = serverAddr.getAddress(
+              static_cast<sockaddr_storage*>(msg->msg_name));
+        }
+        auto cmsg = CMSG_FIRSTHDR(msg);
+        CHECK(cmsg);
+        cmsg->cmsg_level = IPPROTO_IP;
+        cmsg->cmsg_type = IP_TOS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(uint8_t));
+        *CMSG_DATA(cmsg) = static_cast<uint8_t>(ECNCodepoint::ECT0);
+        msg->msg_controllen = CMSG_SPACE(sizeof(uint8_t));
+        return packet->length();
+      }));
+  client->invokeOnNotifyDataAvailable(*sock);
+  EXPECT_EQ(conn.ackStates.appDataAckState.ecnCounts.ect0, 1);
+  client->close(folly::none);
+}
+
 TEST_F(QuicClientTransportAfterStartTest, CleanupReadLoopCounting) {
   auto streamId = client->createBidirectionalStream().value();
   auto& conn = client->getNonConstConn();
@@ -3130,6 +3176,30 @@ TEST_F(QuicClientTransportAfterStartTest, RecvNewConnectionIdValid) {
   EXPECT_EQ(conn.peerConnectionIds[1].token, newConnId.token);
 }
 
+TEST_F(QuicClientTransportAfterStartTest, RecvNewTokenCachesToken) {
+  auto tokenCache = std::make_shared<BasicQuicTokenCache>();
+  client->setTokenCache(tokenCache);
+  auto& conn = client->getNonConstConn();
+
+  ShortHeader header(ProtectionType::KeyPhaseZero, *conn.clientConnectionId, 1);
+  RegularQuicPacketBuilder builder(
+      conn.udpSendPacketLen, std::move(header), 0 /* largestAcked */);
+  builder.encodePacketHeader();
+  ASSERT_TRUE(builder.canBuildPacket());
+
+  NewTokenFrame newToken("address validation token");
+  writeSimpleFrame(QuicSimpleFrame(newToken), builder);
+
+  auto packet = std::move(builder).buildPacket();
+  auto data = packetToBuf(packet);
+
+  EXPECT_FALSE(tokenCache->getToken(hostname_).has_value());
+  deliverData(data->coalesce(), false);
+  auto cachedToken = tokenCache->getToken(hostname_);
+  ASSERT_TRUE(cachedToken.has_value());
+  EXPECT_EQ(*cachedToken, newToken.token);
+}
+
 TEST_F(
     QuicClientTransportAfterStartTest,
     RecvNewConnectionIdTooManyReceivedIds) {
@@ -4486,6 +4556,54 @@ TEST_F(QuicClientTransportVersionAndRetryTest, RetryPacket) {
   client->close(folly::none);
 }
 
+TEST_F(QuicClientTransportVersionAndRetryTest, RetryPacketFromBuilder) {
+  ConnectionId clientConnId(std::vector<uint8_t>{});
+  ConnectionId initialDstConnId(
+      {0x83, 0x94, 0xc8, 0xf0, 0x3e, 0x51, 0x57, 0x08});
+  client->getNonConstConn().readCodec->setClientConnectionId(clientConnId);
+  client->getNonConstConn().initialDestinationConnectionId = initialDstConnId;
+
+  StreamId streamId = *client->createBidirectionalStream();
+  client->writeChain(
+      streamId, IOBuf::copyBuffer("ice cream"), true, false, nullptr);
+  loopForWrites();
+
+  std::unique_ptr<IOBuf> bytesWrittenToNetwork = nullptr;
+  EXPECT_CALL(*sock, write(_, _))
+      .WillRepeatedly(Invoke(
+          [&](const SocketAddress&, const std::unique_ptr<folly::IOBuf>& buf) {
+            bytesWrittenToNetwork = buf->clone();
+            return buf->computeChainDataLength();
+          }));
+
+  // The server's Retry, built the way QuicServerWorker builds it.
+  ConnectionId serverChosenConnId(
+      {0xf0, 0x67, 0xa5, 0x50, 0x2a, 0x42, 0x62, 0xb5});
+  auto retryCipher = FizzCryptoFactory().makeRetryAead();
+  auto retryPacket = RetryPacketBuilder(
+                         serverChosenConnId,
+                         clientConnId,
+                         initialDstConnId,
+                         QuicVersion::MVFST,
+                         "token",
+                         *retryCipher)
+                         .buildPacket();
+  deliverData(retryPacket->coalesce());
+
+  ASSERT_TRUE(bytesWrittenToNetwork);
+  AckStates ackStates;
+  auto packetQueue = bufToQueue(bytesWrittenToNetwork->clone());
+  auto codecResult =
+      makeEncryptedCodec(true)->parsePacket(packetQueue, ackStates);
+  auto& header = *codecResult.regularPacket()->header.asLong();
+  EXPECT_EQ(header.getHeaderType(), LongHeader::Types::Initial);
+  EXPECT_EQ(header.getToken(), std::string("token"));
+  EXPECT_EQ(header.getDestinationConnId(), serverChosenConnId);
+
+  eventbase_->loopOnce();
+  client->close(folly::none);
+}
+
 TEST_F(
     QuicClientTransportVersionAndRetryTest,
     VersionNegotiationPacketNotSupported) {
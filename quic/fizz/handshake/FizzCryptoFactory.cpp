@@ -14,6 +14,13 @@
 
 namespace quic {
 
+namespace {
+constexpr folly::StringPiece kRetryPacketKey =
+    "\x4d\x32\xec\xdb\x2a\x21\x33\xc8\x41\xe4\x04\x3d\xf2\x7d\x44\x30";
+constexpr folly::StringPiece kRetryPacketNonce =
+    "\x4d\x16\x11\xd0\x55\x13\xa5\x52\xc5\x87\xd5\x75";
+} // namespace
+
 Buf FizzCryptoFactory::makeInitialTrafficSecret(
     folly::StringPiece label,
     const ConnectionId& clientDestinationConnId,
@@ -73,6 +80,15 @@ std::unique_ptr<Aead> FizzCryptoFactory::makeInitialAead(
   return FizzAead::wrap(std::move(aead));
 }
 
+std::unique_ptr<Aead> FizzCryptoFactory::makeRetryAead() const {
+  auto aead = fizzFactory_->makeAead(fizz::CipherSuite::TLS_AES_128_GCM_SHA256);
+  fizz::TrafficKey trafficKey;
+  trafficKey.key = folly::IOBuf::copyBuffer(kRetryPacketKey);
+  trafficKey.iv = folly::IOBuf::copyBuffer(kRetryPacketNonce);
+  aead->setKey(std::move(trafficKey));
+  return FizzAead::wrap(std::move(aead));
+}
+
 std::unique_ptr<PacketNumberCipher> FizzCryptoFactory::makePacketNumberCipher(
     folly::ByteRange baseSecret) const {
   auto pnCipher =
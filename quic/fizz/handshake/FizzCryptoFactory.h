@@ -30,6 +30,8 @@ class FizzCryptoFactory : public CryptoFactory {
   std::unique_ptr<PacketNumberCipher> makePacketNumberCipher(
       folly::ByteRange baseSecret) const override;
 
+  std::unique_ptr<Aead> makeRetryAead() const override;
+
   virtual std::unique_ptr<PacketNumberCipher> makePacketNumberCipher(
       fizz::CipherSuite cipher) const;
 
@@ -43,6 +43,31 @@ static HeaderProtectionMask maskImpl(
   return outMask;
 }
 
+// The mask is a single AES-ECB block per sample. ECB has no chaining, so the
+// samples can be laid out back to back and encrypted in a single call, which
+// lets OpenSSL keep several blocks in flight in its AES-NI pipeline.
+static void masksImpl(
+    const folly::ssl::EvpCipherCtxUniquePtr& context,
+    folly::Range<const Sample*> samples,
+    folly::Range<HeaderProtectionMask*> headerMasks) {
+  static_assert(sizeof(Sample) == sizeof(HeaderProtectionMask), "");
+  CHECK_EQ(samples.size(), headerMasks.size());
+  if (samples.empty()) {
+    return;
+  }
+  int inLen = samples.size() * sizeof(Sample);
+  int outLen = 0;
+  if (EVP_EncryptUpdate(
+          context.get(),
+          headerMasks.front().data(),
+          &outLen,
+          samples.front().data(),
+          inLen) != 1 ||
+      outLen != inLen) {
+    throw std::runtime_error("Encryption error");
+  }
+}
+
 void Aes128PacketNumberCipher::setKey(folly::ByteRange key) {
   return setKeyImpl(encryptCtx_, EVP_aes_128_ecb(), key);
 }
@@ -61,6 +86,18 @@ HeaderProtectionMask Aes256PacketNumberCipher::mask(
   return maskImpl(encryptCtx_, sample);
 }
 
+void Aes128PacketNumberCipher::masks(
+    folly::Range<const Sample*> samples,
+    folly::Range<HeaderProtectionMask*> headerMasks) const {
+  masksImpl(encryptCtx_, samples, headerMasks);
+}
+
+void Aes256PacketNumberCipher::masks(
+    folly::Range<const Sample*> samples,
+    folly::Range<HeaderProtectionMask*> headerMasks) const {
+  masksImpl(encryptCtx_, samples, headerMasks);
+}
+
 constexpr size_t kAES128KeyLength = 16;
 
 size_t Aes128PacketNumberCipher::keyLength() const {
@@ -22,6 +22,10 @@ class Aes128PacketNumberCipher : public PacketNumberCipher {
 
   HeaderProtectionMask mask(folly::ByteRange sample) const override;
 
+  void masks(
+      folly::Range<const Sample*> samples,
+      folly::Range<HeaderProtectionMask*> headerMasks) const override;
+
   size_t keyLength() const override;
 
  private:
@@ -36,6 +40,10 @@ class Aes256PacketNumberCipher : public PacketNumberCipher {
 
   HeaderProtectionMask mask(folly::ByteRange sample) const override;
 
+  void masks(
+      folly::Range<const Sample*> samples,
+      folly::Range<HeaderProtectionMask*> headerMasks) const override;
+
   size_t keyLength() const override;
 
  private:
@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <folly/Benchmark.h>
+#include <folly/init/Init.h>
+
+#include <fizz/record/Types.h>
+#include <quic/codec/QuicReadCodec.h>
+#include <quic/common/test/TestUtils.h>
+#include <quic/fizz/handshake/FizzCryptoFactory.h>
+
+using namespace quic;
+using namespace quic::test;
+
+namespace {
+
+constexpr size_t kSampleOffset =
+    1 + kDefaultConnectionIdSize + kMaxPacketNumEncodingSize;
+
+std::unique_ptr<PacketNumberCipher> makeHeaderCipher() {
+  FizzCryptoFactory cryptoFactory;
+  auto cipher = cryptoFactory.makePacketNumberCipher(
+      fizz::CipherSuite::TLS_AES_128_GCM_SHA256);
+  std::vector<uint8_t> key(cipher->keyLength(), 0x2a);
+  cipher->setKey(folly::range(key));
+  return cipher;
+}
+
+/**
+ * Full sized short header packets with their header protected by cipher, like
+ * the segments of one GRO read.
+ */
+std::vector<Buf> makeProtectedPackets(
+    const PacketNumberCipher& cipher,
+    size_t numPackets) {
+  std::vector<Buf> packets;
+  auto connId = getTestConnectionId();
+  auto data = buildRandomInputData(kDefaultUDPSendPacketLen);
+  for (size_t i = 0; i < numPackets; i++) {
+    auto packetBuf = packetToBuf(createStreamPacket(
+        connId,
+        connId,
+        1000 + i,
+        4 /* streamId */,
+        *data,
+        0 /* cipherOverhead */,
+        1000 /* largestAcked */));
+    packetBuf->coalesce();
+    Sample sample;
+    memcpy(sample.data(), packetBuf->data() + kSampleOffset, sample.size());
+    cipher.encryptShortHeader(
+        folly::range(sample),
+        folly::MutableByteRange(packetBuf->writableData(), 1),
+        folly::MutableByteRange(
+            packetBuf->writableData() + 1 + kDefaultConnectionIdSize,
+            kMaxPacketNumEncodingSize));
+    packets.push_back(std::move(packetBuf));
+  }
+  return packets;
+}
+
+std::vector<Buf> clonePackets(const std::vector<Buf>& packets) {
+  std::vector<Buf> clones;
+  for (const auto& packet : packets) {
+    // Unmasking writes into the buffer, so it cannot be shared.
+    clones.push_back(packet->cloneCoalesced());
+  }
+  return clones;
+}
+
+void unmaskPerPacketBench(uint32_t iters, size_t batchSize) {
+  std::unique_ptr<PacketNumberCipher> cipher;
+  std::vector<Buf> packets;
+  BENCHMARK_SUSPEND {
+    cipher = makeHeaderCipher();
+    packets = makeProtectedPackets(*cipher, batchSize);
+  }
+  for (uint32_t i = 0; i < iters; i++) {
+    for (auto& packet : packets) {
+      cipher->decryptShortHeader(
+          folly::ByteRange(packet->data() + kSampleOffset, sizeof(Sample)),
+          folly::MutableByteRange(packet->writableData(), 1),
+          folly::MutableByteRange(
+              packet->writableData() + 1 + kDefaultConnectionIdSize,
+              kMaxPacketNumEncodingSize));
+    }
+    folly::doNotOptimizeAway(packets);
+  }
+}
+
+void unmaskBatchedBench(uint32_t iters, size_t batchSize) {
+  std::unique_ptr<PacketNumberCipher> cipher;
+  std::vector<Buf> packets;
+  std::vector<Sample> samples(batchSize);
+  std::vector<HeaderProtectionMask> headerMasks(batchSize);
+  BENCHMARK_SUSPEND {
+    cipher = makeHeaderCipher();
+    packets = makeProtectedPackets(*cipher, batchSize);
+  }
+  for (uint32_t i = 0; i < iters; i++) {
+    for (size_t j = 0; j < batchSize; j++) {
+      memcpy(
+          samples[j].data(),
+          packets[j]->data() + kSampleOffset,
+          sizeof(Sample));
+    }
+    cipher->masks(folly::range(samples), folly::range(headerMasks));
+    for (size_t j = 0; j < batchSize; j++) {
+      cipher->decryptShortHeaderWithMask(
+          headerMasks[j],
+          folly::MutableByteRange(packets[j]->writableData(), 1),
+          folly::MutableByteRange(
+              packets[j]->writableData() + 1 + kDefaultConnectionIdSize,
+              kMaxPacketNumEncodingSize));
+    }
+    folly::doNotOptimizeAway(packets);
+  }
+}
+
+std::unique_ptr<QuicReadCodec> makeCodec() {
+  auto codec = std::make_unique<QuicReadCodec>(QuicNodeType::Server);
+  codec->setCodecParameters(
+      CodecParameters(kDefaultAckDelayExponent, QuicVersion::MVFST));
+  codec->setOneRttReadCipher(createNoOpAead());
+  codec->setOneRttHeaderCipher(makeHeaderCipher());
+  codec->setServerConnectionId(getTestConnectionId());
+  return codec;
+}
+
+void parsePerPacketBench(uint32_t iters, size_t batchSize) {
+  std::unique_ptr<QuicReadCodec> codec;
+  std::vector<Buf> packets;
+  BENCHMARK_SUSPEND {
+    codec = makeCodec();
+    packets = makeProtectedPackets(*makeHeaderCipher(), batchSize);
+  }
+  AckStates ackStates;
+  ackStates.appDataAckState.largestReceivedPacketNum = 999;
+  for (uint32_t i = 0; i < iters; i++) {
+    std::vector<BufQueue> queues;
+    BENCHMARK_SUSPEND {
+      for (auto& packet : clonePackets(packets)) {
+        queues.emplace_back(std::move(packet));
+      }
+    }
+    for (auto& queue : queues) {
+      auto result = codec->parsePacket(queue, ackStates);
+      CHECK(result.regularPacket());
+      folly::doNotOptimizeAway(result);
+    }
+  }
+}
+
+void parseBatchedBench(uint32_t iters, size_t batchSize) {
+  std::unique_ptr<QuicReadCodec> codec;
+  std::vector<Buf> packets;
+  BENCHMARK_SUSPEND {
+    codec = makeCodec();
+    packets = makeProtectedPackets(*makeHeaderCipher(), batchSize);
+  }
+  AckStates ackStates;
+  ackStates.appDataAckState.largestReceivedPacketNum = 999;
+  for (uint32_t i = 0; i < iters; i++) {
+    std::vector<Buf> clones;
+    BENCHMARK_SUSPEND {
+      clones = clonePackets(packets);
+    }
+    // What QuicTransportBase::onNetworkData does for a receive batch.
+    codec->computeHeaderMasks(folly::range(clones));
+    for (auto& packet : clones) {
+      BufQueue queue(std::move(packet));
+      auto result = codec->parsePacket(queue, ackStates);
+      CHECK(result.regularPacket());
+      folly::doNotOptimizeAway(result);
+    }
+    codec->clearHeaderMasks();
+  }
+}
+
+} // namespace
+
+BENCHMARK_PARAM(unmaskPerPacketBench, 16)
+BENCHMARK_RELATIVE_PARAM(unmaskBatchedBench, 16)
+BENCHMARK_PARAM(unmaskPerPacketBench, 64)
+BENCHMARK_RELATIVE_PARAM(unmaskBatchedBench, 64)
+BENCHMARK_DRAW_LINE();
+BENCHMARK_PARAM(parsePerPacketBench, 16)
+BENCHMARK_RELATIVE_PARAM(parseBatchedBench, 16)
+BENCHMARK_PARAM(parsePerPacketBench, 64)
+BENCHMARK_RELATIVE_PARAM(parseBatchedBench, 64)
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
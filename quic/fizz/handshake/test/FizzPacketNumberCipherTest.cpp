@@ -89,6 +89,37 @@ TEST_P(LongPacketNumberCipherTest, TestEncryptDecrypt) {
       GetParam().decryptedPacketNumberBytes);
 }
 
+TEST_P(LongPacketNumberCipherTest, TestEncryptWithBatchMasks) {
+  FizzCryptoFactory cryptoFactory;
+  auto cipher = cryptoFactory.makePacketNumberCipher(GetParam().cipher);
+  auto key = folly::unhexlify(GetParam().key);
+  cipher->setKey(folly::range(key));
+  CipherBytes cipherBytes(
+      GetParam().sample,
+      GetParam().decryptedInitialByte,
+      GetParam().decryptedPacketNumberBytes);
+  // Surround the test vector with other samples, every mask has to match the
+  // one computed on its own.
+  std::vector<Sample> samples(5);
+  for (size_t i = 0; i < samples.size(); ++i) {
+    samples[i].fill(static_cast<uint8_t>(i));
+  }
+  samples[2] = cipherBytes.sample;
+  std::vector<HeaderProtectionMask> masks(samples.size());
+  cipher->masks(folly::range(samples), folly::range(masks));
+  for (size_t i = 0; i < samples.size(); ++i) {
+    EXPECT_EQ(masks[i], cipher->mask(folly::range(samples[i])));
+  }
+
+  cipher->encryptLongHeaderWithMask(
+      masks[2],
+      folly::range(cipherBytes.initial),
+      folly::range(cipherBytes.packetNumber));
+  EXPECT_EQ(folly::hexlify(cipherBytes.initial), GetParam().initialByte);
+  EXPECT_EQ(
+      folly::hexlify(cipherBytes.packetNumber), GetParam().packetNumberBytes);
+}
+
 INSTANTIATE_TEST_CASE_P(
     LongPacketNumberCipherTests,
     LongPacketNumberCipherTest,
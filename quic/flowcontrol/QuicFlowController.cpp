@@ -26,8 +26,9 @@ folly::Optional<uint64_t> calculateNewWindowUpdate(
     const TimePoint& updateTime) {
   DCHECK_LE(curReadOffset, curAdvertisedOffset);
   auto nextAdvertisedOffset = curReadOffset + windowSize;
-  if (nextAdvertisedOffset == curAdvertisedOffset) {
-    // No change in flow control
+  if (nextAdvertisedOffset <= curAdvertisedOffset) {
+    // No change in flow control, or a smaller window which the advertised
+    // offset cannot shrink to.
     return folly::none;
   }
   bool enoughTimeElapsed = lastSendTime && updateTime > *lastSendTime &&
@@ -45,6 +46,97 @@ folly::Optional<uint64_t> calculateNewWindowUpdate(
   return folly::none;
 }
 
+/**
+ * An update being due less than flowControlRttFrequency RTTs after the previous
+ * one means the peer used up the window faster than the RTT based updates
+ * refresh it, so the window is what limits the transfer.
+ */
+bool shouldAutotuneWindow(
+    const std::chrono::microseconds& srtt,
+    const TransportSettings& transportSettings,
+    const folly::Optional<TimePoint>& lastSendTime,
+    const TimePoint& updateTime) {
+  if (!transportSettings.autotuneFlowControlWindows || !lastSendTime ||
+      srtt == std::chrono::microseconds::zero()) {
+    return false;
+  }
+  return updateTime - *lastSendTime <
+      transportSettings.flowControlRttFrequency * srtt;
+}
+
+void maybeAutotuneConnWindow(QuicConnectionStateBase& conn) {
+  auto& flowControlState = conn.flowControlState;
+  auto newWindowSize = std::min(
+      flowControlState.windowSize * 2,
+      conn.transportSettings.maxAutotuneConnectionWindowSize);
+  if (newWindowSize <= flowControlState.windowSize) {
+    return;
+  }
+  auto growth = newWindowSize - flowControlState.windowSize;
+  // Keep charging the budget the connection started with, so that it is the
+  // one released on close even if the settings change.
+  auto budget = flowControlState.windowBudget
+      ? flowControlState.windowBudget
+      : conn.transportSettings.flowControlWindowBudget;
+  if (budget) {
+    if (!budget->tryCharge(growth)) {
+      QUIC_STATS(conn.statsCallback, onFlowControlWindowBudgetExhausted);
+      return;
+    }
+    flowControlState.windowBudget = std::move(budget);
+    flowControlState.windowBudgetCharged += growth;
+  }
+  VLOG(4) << "Autotuned conn window from " << flowControlState.windowSize
+          << " to " << newWindowSize;
+  flowControlState.windowSize = newWindowSize;
+  QUIC_STATS(conn.statsCallback, onConnFlowControlWindowIncreased);
+}
+
+void maybeAutotuneStreamWindow(QuicStreamState& stream) {
+  auto& flowControlState = stream.flowControlState;
+  auto newWindowSize = std::min(
+      flowControlState.windowSize * 2,
+      stream.conn.transportSettings.maxAutotuneStreamWindowSize);
+  if (newWindowSize <= flowControlState.windowSize) {
+    return;
+  }
+  VLOG(4) << "Autotuned window of stream=" << stream.id << " from "
+          << flowControlState.windowSize << " to " << newWindowSize;
+  flowControlState.windowSize = newWindowSize;
+  QUIC_STATS(stream.conn.statsCallback, onStreamFlowControlWindowIncreased);
+}
+
+/**
+ * Receive window the connection has granted its peer and the application
+ * hasn't read yet. It is reserved in the buffer memory pool before the peer
+ * sends into it.
+ */
+uint64_t getReservedReceiveWindow(const QuicConnectionStateBase& conn) {
+  const auto& flowControlState = conn.flowControlState;
+  // The read offsets count one past the FIN.
+  return flowControlState.advertisedMaxOffset >
+          flowControlState.sumCurReadOffset
+      ? flowControlState.advertisedMaxOffset - flowControlState.sumCurReadOffset
+      : 0;
+}
+
+/**
+ * Limits the connection window to what the connection already reserved in
+ * its buffer memory pool plus what is left in the pool, so that the windows
+ * of the connections sharing the pool never add up to more than it holds.
+ * Stream windows aren't limited, the connection window bounds them all.
+ */
+uint64_t limitWindowByBufferMemory(
+    const QuicConnectionStateBase& conn,
+    uint64_t windowSize) {
+  if (!conn.bufferMemoryPool) {
+    return windowSize;
+  }
+  return std::min(
+      windowSize,
+      getReservedReceiveWindow(conn) + conn.bufferMemoryPool->available());
+}
+
 template <typename T>
 inline void incrementWithOverFlowCheck(T& num, T diff) {
   if (num > std::numeric_limits<T>::max() - diff) {
@@ -61,6 +153,27 @@ inline uint64_t calculateMaximumData(const QuicStreamState& stream) {
 }
 } // namespace
 
+void updateBufferMemoryCharge(QuicConnectionStateBase& conn) {
+  if (!conn.bufferMemoryPool) {
+    return;
+  }
+  uint64_t charge = conn.flowControlState.sumCurStreamBufferLen +
+      getReservedReceiveWindow(conn);
+  if (charge == conn.bufferMemoryCharged) {
+    return;
+  }
+  if (charge > conn.bufferMemoryCharged) {
+    conn.bufferMemoryPool->charge(charge - conn.bufferMemoryCharged);
+  } else {
+    conn.bufferMemoryPool->release(conn.bufferMemoryCharged - charge);
+  }
+  conn.bufferMemoryCharged = charge;
+  QUIC_STATS(
+      conn.statsCallback,
+      onBufferMemoryPoolUsage,
+      conn.bufferMemoryPool->used());
+}
+
 bool maybeSendConnWindowUpdate(
     QuicConnectionStateBase& conn,
     TimePoint updateTime) {
@@ -70,15 +183,28 @@ bool maybeSendConnWindowUpdate(
     return false;
   }
   auto& flowControlState = conn.flowControlState;
+  auto windowSize =
+      limitWindowByBufferMemory(conn, flowControlState.windowSize);
+  if (windowSize < flowControlState.windowSize && conn.bufferMemoryCallback) {
+    // Nothing else re-advertises the window once the pool frees up.
+    conn.bufferMemoryPool->notifyOnRelease(conn.bufferMemoryCallback);
+  }
   auto newAdvertisedOffset = calculateNewWindowUpdate(
       flowControlState.sumCurReadOffset,
       flowControlState.advertisedMaxOffset,
-      flowControlState.windowSize,
+      windowSize,
       conn.lossState.srtt,
       conn.transportSettings,
       flowControlState.timeOfLastFlowControlUpdate,
       updateTime);
   if (newAdvertisedOffset) {
+    if (shouldAutotuneWindow(
+            conn.lossState.srtt,
+            conn.transportSettings,
+            flowControlState.timeOfLastFlowControlUpdate,
+            updateTime)) {
+      maybeAutotuneConnWindow(conn);
+    }
     conn.pendingEvents.connWindowUpdate = true;
     QUIC_STATS(conn.statsCallback, onConnFlowControlUpdate);
     if (conn.qLogger) {
@@ -110,6 +236,13 @@ bool maybeSendStreamWindowUpdate(
       flowControlState.timeOfLastFlowControlUpdate,
       updateTime);
   if (newAdvertisedOffset) {
+    if (shouldAutotuneWindow(
+            stream.conn.lossState.srtt,
+            stream.conn.transportSettings,
+            flowControlState.timeOfLastFlowControlUpdate,
+            updateTime)) {
+      maybeAutotuneStreamWindow(stream);
+    }
     VLOG(10) << "Queued flow control update for stream=" << stream.id
              << " offset=" << *newAdvertisedOffset;
     stream.conn.streamManager->queueWindowUpdate(stream.id);
@@ -153,6 +286,7 @@ void updateFlowControlOnRead(
   auto diff = stream.currentReadOffset - lastReadOffset;
   incrementWithOverFlowCheck(
       stream.conn.flowControlState.sumCurReadOffset, diff);
+  updateBufferMemoryCharge(stream.conn);
   if (maybeSendConnWindowUpdate(stream.conn, readTime)) {
     VLOG(4) << "Read trigger conn window update "
             << " readOffset=" << stream.conn.flowControlState.sumCurReadOffset
@@ -174,6 +308,7 @@ void updateFlowControlOnWriteToSocket(
       stream.conn.flowControlState.sumCurWriteOffset, length);
   DCHECK_GE(stream.conn.flowControlState.sumCurStreamBufferLen, length);
   stream.conn.flowControlState.sumCurStreamBufferLen -= length;
+  updateBufferMemoryCharge(stream.conn);
   if (stream.conn.flowControlState.sumCurWriteOffset ==
       stream.conn.flowControlState.peerAdvertisedMaxOffset) {
     if (stream.conn.qLogger) {
@@ -195,6 +330,7 @@ void updateFlowControlOnWriteToStream(
     uint64_t length) {
   incrementWithOverFlowCheck(
       stream.conn.flowControlState.sumCurStreamBufferLen, length);
+  updateBufferMemoryCharge(stream.conn);
 }
 
 void maybeWriteBlockAfterAPIWrite(QuicStreamState& stream) {
@@ -368,6 +504,7 @@ void onConnWindowUpdateSent(
   conn.flowControlState.advertisedMaxOffset = maximumDataSent;
   conn.flowControlState.timeOfLastFlowControlUpdate = sentTime;
   conn.pendingEvents.connWindowUpdate = false;
+  updateBufferMemoryCharge(conn);
   VLOG(4) << "sent window for conn";
 }
 
@@ -417,7 +554,8 @@ void updateFlowControlStateWithSettings(
 
 MaxDataFrame generateMaxDataFrame(const QuicConnectionStateBase& conn) {
   return MaxDataFrame(std::max(
-      conn.flowControlState.sumCurReadOffset + conn.flowControlState.windowSize,
+      conn.flowControlState.sumCurReadOffset +
+          limitWindowByBufferMemory(conn, conn.flowControlState.windowSize),
       conn.flowControlState.advertisedMaxOffset));
 }
 
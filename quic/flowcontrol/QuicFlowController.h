@@ -38,6 +38,13 @@ void updateFlowControlOnWriteToSocket(QuicStreamState& stream, uint64_t length);
 
 void updateFlowControlOnWriteToStream(QuicStreamState& stream, uint64_t length);
 
+/**
+ * Charges the buffer memory pool of the connection, if it has one, with the
+ * receive window it granted the peer and the application hasn't read yet, and
+ * with the data written by the application but not sent yet.
+ */
+void updateBufferMemoryCharge(QuicConnectionStateBase& conn);
+
 void maybeWriteBlockAfterAPIWrite(QuicStreamState& stream);
 
 void maybeWriteDataBlockedAfterSocketWrite(QuicConnectionStateBase& conn);
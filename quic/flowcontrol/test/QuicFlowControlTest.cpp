@@ -20,6 +20,11 @@ using namespace testing;
 namespace quic {
 namespace test {
 
+class MockBufferMemoryCallback : public BufferMemoryPool::Callback {
+ public:
+  GMOCK_METHOD0_(, noexcept, , onBufferMemoryReleased, void());
+};
+
 class QuicFlowControlTest : public Test {
  public:
   void SetUp() override {
@@ -88,6 +93,174 @@ TEST_F(QuicFlowControlTest, DontSendConnFlowControlTwice) {
       conn_, *conn_.flowControlState.timeOfLastFlowControlUpdate + 300us);
 }
 
+TEST_F(QuicFlowControlTest, AutotuneConnWindow) {
+  conn_.transportSettings.autotuneFlowControlWindows = true;
+  conn_.transportSettings.maxAutotuneConnectionWindowSize = 800;
+  conn_.flowControlState.windowSize = 500;
+  conn_.flowControlState.advertisedMaxOffset = 400;
+  conn_.flowControlState.sumCurReadOffset = 300;
+  conn_.lossState.srtt = 100us;
+  conn_.flowControlState.timeOfLastFlowControlUpdate = Clock::now();
+
+  // The window is used up less than 2 rtts after the last update.
+  EXPECT_CALL(*transportInfoCb_, onConnFlowControlWindowIncreased()).Times(1);
+  EXPECT_TRUE(maybeSendConnWindowUpdate(
+      conn_, *conn_.flowControlState.timeOfLastFlowControlUpdate + 100us));
+  EXPECT_EQ(800, conn_.flowControlState.windowSize);
+  EXPECT_EQ(800 + 300, generateMaxDataFrame(conn_).maximumData);
+
+  // Already at the cap.
+  onConnWindowUpdateSent(conn_, 1100, Clock::now());
+  conn_.flowControlState.sumCurReadOffset = 800;
+  EXPECT_CALL(*transportInfoCb_, onConnFlowControlWindowIncreased()).Times(0);
+  EXPECT_TRUE(maybeSendConnWindowUpdate(
+      conn_, *conn_.flowControlState.timeOfLastFlowControlUpdate + 100us));
+  EXPECT_EQ(800, conn_.flowControlState.windowSize);
+}
+
+TEST_F(QuicFlowControlTest, AutotuneConnWindowNotWhenUpdatesAreRare) {
+  conn_.transportSettings.autotuneFlowControlWindows = true;
+  conn_.flowControlState.windowSize = 500;
+  conn_.flowControlState.advertisedMaxOffset = 400;
+  conn_.flowControlState.sumCurReadOffset = 300;
+  conn_.lossState.srtt = 100us;
+  conn_.flowControlState.timeOfLastFlowControlUpdate = Clock::now();
+
+  EXPECT_CALL(*transportInfoCb_, onConnFlowControlWindowIncreased()).Times(0);
+  EXPECT_TRUE(maybeSendConnWindowUpdate(
+      conn_, *conn_.flowControlState.timeOfLastFlowControlUpdate + 300us));
+  EXPECT_EQ(500, conn_.flowControlState.windowSize);
+}
+
+TEST_F(QuicFlowControlTest, AutotuneConnWindowBudget) {
+  auto budget = std::make_shared<FlowControlWindowBudget>(700);
+  auto conn = std::make_unique<QuicConnectionStateBase>(QuicNodeType::Server);
+  conn->statsCallback = transportInfoCb_.get();
+  conn->transportSettings.autotuneFlowControlWindows = true;
+  conn->transportSettings.flowControlWindowBudget = budget;
+  conn->flowControlState.windowSize = 500;
+  conn->flowControlState.advertisedMaxOffset = 400;
+  conn->flowControlState.sumCurReadOffset = 300;
+  conn->lossState.srtt = 100us;
+  conn->flowControlState.timeOfLastFlowControlUpdate = Clock::now();
+
+  EXPECT_CALL(*transportInfoCb_, onConnFlowControlWindowIncreased()).Times(1);
+  maybeSendConnWindowUpdate(
+      *conn, *conn->flowControlState.timeOfLastFlowControlUpdate + 100us);
+  EXPECT_EQ(1000, conn->flowControlState.windowSize);
+  EXPECT_EQ(500, budget->used());
+
+  // Doubling again needs 1000 more bytes than the budget has left.
+  onConnWindowUpdateSent(*conn, 1300, Clock::now());
+  conn->flowControlState.sumCurReadOffset = 1000;
+  EXPECT_CALL(*transportInfoCb_, onFlowControlWindowBudgetExhausted())
+      .Times(1);
+  EXPECT_TRUE(maybeSendConnWindowUpdate(
+      *conn, *conn->flowControlState.timeOfLastFlowControlUpdate + 100us));
+  EXPECT_EQ(1000, conn->flowControlState.windowSize);
+  EXPECT_EQ(500, budget->used());
+
+  conn.reset();
+  EXPECT_EQ(0, budget->used());
+}
+
+TEST_F(QuicFlowControlTest, BufferMemoryPoolCharge) {
+  auto pool = std::make_shared<BufferMemoryPool>(1000);
+  auto conn = std::make_unique<QuicConnectionStateBase>(QuicNodeType::Client);
+  conn->streamManager = std::make_unique<QuicStreamManager>(
+      *conn, conn->nodeType, conn->transportSettings);
+  conn->statsCallback = transportInfoCb_.get();
+  conn->bufferMemoryPool = pool;
+  conn->flowControlState.windowSize = 5000;
+  conn->flowControlState.advertisedMaxOffset = 400;
+  {
+    QuicStreamState stream(3, *conn);
+    stream.flowControlState.windowSize = 5000;
+    stream.flowControlState.advertisedMaxOffset = 400;
+
+    // The window granted to the peer is reserved up front.
+    EXPECT_CALL(*transportInfoCb_, onBufferMemoryPoolUsage(400));
+    updateBufferMemoryCharge(*conn);
+    EXPECT_CALL(*transportInfoCb_, onBufferMemoryPoolUsage(700));
+    updateFlowControlOnWriteToStream(stream, 300);
+    EXPECT_CALL(*transportInfoCb_, onBufferMemoryPoolUsage(_)).Times(0);
+    updateFlowControlOnStreamData(stream, 0, 200);
+    EXPECT_EQ(700, pool->used());
+    EXPECT_EQ(700, conn->bufferMemoryCharged);
+    Mock::VerifyAndClearExpectations(transportInfoCb_.get());
+
+    // The connection window can only grow by what is left in the pool, the
+    // stream windows are bounded by it.
+    EXPECT_EQ(700, generateMaxDataFrame(*conn).maximumData);
+    EXPECT_EQ(5000, generateMaxStreamDataFrame(stream).maximumData);
+    EXPECT_CALL(*transportInfoCb_, onBufferMemoryPoolUsage(1000));
+    onConnWindowUpdateSent(*conn, 700, Clock::now());
+
+    EXPECT_CALL(*transportInfoCb_, onBufferMemoryPoolUsage(700));
+    updateFlowControlOnWriteToSocket(stream, 300);
+    stream.currentReadOffset = 100;
+    EXPECT_CALL(*transportInfoCb_, onBufferMemoryPoolUsage(600));
+    updateFlowControlOnRead(stream, 0, Clock::now());
+    EXPECT_EQ(600, pool->used());
+  }
+  conn.reset();
+  EXPECT_EQ(0, pool->used());
+}
+
+TEST_F(QuicFlowControlTest, BufferMemoryPoolSharedWithoutOvercommit) {
+  auto pool = std::make_shared<BufferMemoryPool>(1000);
+  QuicConnectionStateBase otherConn(QuicNodeType::Server);
+  for (auto conn : {&conn_, &otherConn}) {
+    conn->bufferMemoryPool = pool;
+    conn->flowControlState.windowSize = 800;
+    conn->flowControlState.advertisedMaxOffset = 0;
+  }
+
+  EXPECT_EQ(800, generateMaxDataFrame(conn_).maximumData);
+  onConnWindowUpdateSent(conn_, 800, Clock::now());
+  EXPECT_EQ(800, pool->used());
+  // Only what conn_ hasn't reserved is left for the other connection.
+  EXPECT_EQ(200, generateMaxDataFrame(otherConn).maximumData);
+  onConnWindowUpdateSent(otherConn, 200, Clock::now());
+  EXPECT_EQ(1000, pool->used());
+
+  // Reading frees the reservation up again.
+  otherConn.flowControlState.sumCurReadOffset = 200;
+  updateBufferMemoryCharge(otherConn);
+  EXPECT_EQ(800, pool->used());
+  EXPECT_EQ(800, generateMaxDataFrame(conn_).maximumData);
+  EXPECT_EQ(400, generateMaxDataFrame(otherConn).maximumData);
+}
+
+TEST_F(QuicFlowControlTest, BufferMemoryPoolFullStopsWindowUpdates) {
+  auto pool = std::make_shared<BufferMemoryPool>(1000);
+  pool->charge(1000);
+  MockBufferMemoryCallback callback;
+  conn_.bufferMemoryPool = pool;
+  conn_.bufferMemoryCallback = &callback;
+  conn_.flowControlState.windowSize = 500;
+  conn_.flowControlState.advertisedMaxOffset = 400;
+  conn_.flowControlState.sumCurReadOffset = 400;
+
+  EXPECT_CALL(*transportInfoCb_, onConnFlowControlUpdate()).Times(0);
+  EXPECT_FALSE(maybeSendConnWindowUpdate(conn_, Clock::now()));
+  EXPECT_EQ(400, generateMaxDataFrame(conn_).maximumData);
+  Mock::VerifyAndClearExpectations(transportInfoCb_.get());
+
+  // The connection is told once the pool frees up, to advertise the window.
+  EXPECT_CALL(callback, onBufferMemoryReleased()).Times(1);
+  pool->release(1000);
+  Mock::VerifyAndClearExpectations(&callback);
+  EXPECT_CALL(*transportInfoCb_, onConnFlowControlUpdate()).Times(1);
+  EXPECT_TRUE(maybeSendConnWindowUpdate(conn_, Clock::now()));
+  EXPECT_EQ(900, generateMaxDataFrame(conn_).maximumData);
+
+  // Not held back any more, so it isn't told again.
+  EXPECT_CALL(callback, onBufferMemoryReleased()).Times(0);
+  pool->charge(10);
+  pool->release(10);
+}
+
 TEST_F(QuicFlowControlTest, NoStreamFlowControlUpdateOnTimeFlowUnchanged) {
   conn_.flowControlState.windowSize = 500;
   conn_.flowControlState.advertisedMaxOffset = 600;
@@ -213,6 +386,24 @@ TEST_F(QuicFlowControlTest, MaybeSendStreamWindowUpdateTimeElapsed) {
   EXPECT_TRUE(conn_.streamManager->pendingWindowUpdate(stream.id));
 }
 
+TEST_F(QuicFlowControlTest, AutotuneStreamWindow) {
+  conn_.transportSettings.autotuneFlowControlWindows = true;
+  StreamId id = 3;
+  QuicStreamState stream(id, conn_);
+  stream.currentReadOffset = 300;
+  stream.flowControlState.windowSize = 500;
+  stream.flowControlState.advertisedMaxOffset = 400;
+  conn_.lossState.srtt = 100us;
+  stream.flowControlState.timeOfLastFlowControlUpdate = Clock::now();
+
+  EXPECT_CALL(*transportInfoCb_, onStreamFlowControlWindowIncreased())
+      .Times(1);
+  EXPECT_TRUE(maybeSendStreamWindowUpdate(
+      stream, *stream.flowControlState.timeOfLastFlowControlUpdate + 100us));
+  EXPECT_EQ(1000, stream.flowControlState.windowSize);
+  EXPECT_EQ(1300, generateMaxStreamDataFrame(stream).maximumData);
+}
+
 TEST_F(QuicFlowControlTest, DontSendStreamWindowUpdateTwice) {
   StreamId id = 3;
   QuicStreamState stream(id, conn_);
@@ -11,6 +11,8 @@
 #include <folly/Optional.h>
 #include <folly/io/IOBuf.h>
 
+#include <vector>
+
 namespace quic {
 
 struct TrafficKey {
@@ -18,6 +20,16 @@ struct TrafficKey {
   std::unique_ptr<folly::IOBuf> iv;
 };
 
+/**
+ * A plaintext to be encrypted as part of a batch, see
+ * Aead::inplaceEncryptBatch().
+ */
+struct AeadEncryptRequest {
+  std::unique_ptr<folly::IOBuf> buf;
+  const folly::IOBuf* associatedData;
+  uint64_t seqNum;
+};
+
 /**
  * Interface for aead algorithms (RFC 5116).
  */
@@ -33,6 +45,20 @@ class Aead {
       const folly::IOBuf* associatedData,
       uint64_t seqNum) const = 0;
 
+  /**
+   * Encrypts every plaintext of the batch inplace and replaces it with its
+   * ciphertext, as inplaceEncrypt() would. Implementations that can interleave
+   * the work for several packets should override this, the default encrypts
+   * them one at a time. Will throw on error.
+   */
+  virtual void inplaceEncryptBatch(
+      std::vector<AeadEncryptRequest>& requests) const {
+    for (auto& request : requests) {
+      request.buf = inplaceEncrypt(
+          std::move(request.buf), request.associatedData, request.seqNum);
+    }
+  }
+
   /**
    * Decrypt ciphertext. Will throw if the ciphertext does not decrypt
    * successfully.
@@ -65,6 +65,11 @@ class CryptoFactory {
   virtual std::unique_ptr<PacketNumberCipher> makePacketNumberCipher(
       folly::ByteRange baseSecret) const = 0;
 
+  /**
+   * Makes the cipher computing the integrity tag of Retry packets.
+   */
+  virtual std::unique_ptr<Aead> makeRetryAead() const = 0;
+
   virtual ~CryptoFactory() = default;
 };
 
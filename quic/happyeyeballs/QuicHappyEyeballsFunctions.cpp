@@ -151,6 +151,14 @@ void happyEyeballsSetUpSocket(
   }
   applySocketOptions(
       socket, options, sockFamily, folly::SocketOptionKey::ApplyPos::POST_BIND);
+  if (transportSettings.ecnMarking != ECNCodepoint::NotECT ||
+      transportSettings.readEcnOnIngress) {
+    applyEcnSocketOptions(
+        socket,
+        sockFamily,
+        transportSettings.ecnMarking,
+        transportSettings.readEcnOnIngress);
+  }
 
 #ifdef SO_NOSIGPIPE
   folly::SocketOptionKey nopipeKey = {SOL_SOCKET, SO_NOSIGPIPE};
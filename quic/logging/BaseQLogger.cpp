@@ -71,6 +71,23 @@ void addQuicSimpleFrameToEvent(
           frame.knobSpace, frame.id, frame.blob->length()));
       break;
     }
+    case quic::QuicSimpleFrame::Type::AckFrequencyFrame_E: {
+      const quic::AckFrequencyFrame& frame = *simpleFrame.asAckFrequencyFrame();
+      event->frames.push_back(std::make_unique<quic::AckFrequencyFrameLog>(
+          frame.sequenceNumber,
+          frame.packetTolerance,
+          frame.updateMaxAckDelay,
+          frame.reorderThreshold));
+      break;
+    }
+    case quic::QuicSimpleFrame::Type::ImmediateAckFrame_E: {
+      event->frames.push_back(std::make_unique<quic::ImmediateAckFrameLog>());
+      break;
+    }
+    case quic::QuicSimpleFrame::Type::NewTokenFrame_E: {
+      event->frames.push_back(std::make_unique<quic::ReadNewTokenFrameLog>());
+      break;
+    }
   }
 }
 } // namespace
@@ -180,6 +197,12 @@ std::unique_ptr<QLogPacketEvent> BaseQLogger::createPacketEvent(
       case QuicFrame::Type::NoopFrame_E: {
         break;
       }
+      case QuicFrame::Type::DatagramFrame_E: {
+        const DatagramFrame& frame = *quicFrame.asDatagramFrame();
+        event->frames.push_back(
+            std::make_unique<quic::DatagramFrameLog>(frame.length));
+        break;
+      }
     }
   }
   if (numPaddingFrames > 0) {
@@ -279,6 +302,12 @@ std::unique_ptr<QLogPacketEvent> BaseQLogger::createPacketEvent(
         addQuicSimpleFrameToEvent(event.get(), simpleFrame);
         break;
       }
+      case QuicWriteFrame::Type::DatagramFrame_E: {
+        const DatagramFrame& frame = *quicFrame.asDatagramFrame();
+        event->frames.push_back(
+            std::make_unique<quic::DatagramFrameLog>(frame.length));
+        break;
+      }
       default:
         break;
     }
@@ -0,0 +1,563 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/logging/BinaryQLogReader.h>
+
+#include <folly/container/F14Map.h>
+#include <folly/container/F14Set.h>
+#include <folly/io/Cursor.h>
+#include <folly/lang/Bits.h>
+#include <quic/common/IntervalSet.h>
+#include <quic/logging/BinaryQLogger.h>
+
+namespace {
+
+uint64_t readVarint(folly::io::Cursor& cursor) {
+  uint64_t value = 0;
+  for (unsigned shift = 0; shift < 64; shift += 7) {
+    auto byte = cursor.read<uint8_t>();
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if (!(byte & 0x80)) {
+      return value;
+    }
+  }
+  throw std::runtime_error("Varint too long");
+}
+
+std::string readString(folly::io::Cursor& cursor) {
+  auto len = readVarint(cursor);
+  return cursor.readFixedString(len);
+}
+
+bool readBool(folly::io::Cursor& cursor) {
+  return cursor.read<uint8_t>() != 0;
+}
+
+std::chrono::microseconds readMicros(folly::io::Cursor& cursor) {
+  return std::chrono::microseconds(static_cast<int64_t>(readVarint(cursor)));
+}
+
+quic::ConnectionId readConnectionId(folly::io::Cursor& cursor) {
+  auto len = readVarint(cursor);
+  return quic::ConnectionId(cursor, len);
+}
+
+quic::QuicErrorCode readErrorCode(folly::io::Cursor& cursor) {
+  auto type = static_cast<quic::QuicErrorCode::Type>(cursor.read<uint8_t>());
+  auto value = readVarint(cursor);
+  switch (type) {
+    case quic::QuicErrorCode::Type::ApplicationErrorCode_E:
+      return quic::QuicErrorCode(
+          static_cast<quic::ApplicationErrorCode>(value));
+    case quic::QuicErrorCode::Type::LocalErrorCode_E:
+      return quic::QuicErrorCode(static_cast<quic::LocalErrorCode>(value));
+    case quic::QuicErrorCode::Type::TransportErrorCode_E:
+      return quic::QuicErrorCode(static_cast<quic::TransportErrorCode>(value));
+  }
+  throw std::runtime_error("Unknown error code type");
+}
+
+void readFrames(
+    folly::io::Cursor& cursor,
+    quic::QLogPacketEvent& event,
+    bool isPacketRecvd) {
+  using namespace quic;
+  while (true) {
+    auto type = static_cast<BinaryQLogFrameType>(cursor.read<uint8_t>());
+    switch (type) {
+      case BinaryQLogFrameType::End:
+        return;
+      case BinaryQLogFrameType::Padding:
+        event.frames.push_back(
+            std::make_unique<PaddingFrameLog>(readVarint(cursor)));
+        break;
+      case BinaryQLogFrameType::RstStream: {
+        auto streamId = readVarint(cursor);
+        auto errorCode = readVarint(cursor);
+        auto offset = readVarint(cursor);
+        event.frames.push_back(std::make_unique<RstStreamFrameLog>(
+            streamId, errorCode, offset));
+        break;
+      }
+      case BinaryQLogFrameType::ConnectionClose: {
+        auto errorCode = readErrorCode(cursor);
+        auto reasonPhrase = readString(cursor);
+        auto closingFrameType = static_cast<FrameType>(readVarint(cursor));
+        event.frames.push_back(std::make_unique<ConnectionCloseFrameLog>(
+            std::move(errorCode), std::move(reasonPhrase), closingFrameType));
+        break;
+      }
+      case BinaryQLogFrameType::MaxData:
+        event.frames.push_back(
+            std::make_unique<MaxDataFrameLog>(readVarint(cursor)));
+        break;
+      case BinaryQLogFrameType::MaxStreamData: {
+        auto streamId = readVarint(cursor);
+        auto maximumData = readVarint(cursor);
+        event.frames.push_back(
+            std::make_unique<MaxStreamDataFrameLog>(streamId, maximumData));
+        break;
+      }
+      case BinaryQLogFrameType::MaxStreams: {
+        auto maxStreams = readVarint(cursor);
+        auto isForBidirectional = readBool(cursor);
+        event.frames.push_back(std::make_unique<MaxStreamsFrameLog>(
+            maxStreams, isForBidirectional));
+        break;
+      }
+      case BinaryQLogFrameType::StreamsBlocked: {
+        auto streamLimit = readVarint(cursor);
+        auto isForBidirectional = readBool(cursor);
+        event.frames.push_back(std::make_unique<StreamsBlockedFrameLog>(
+            streamLimit, isForBidirectional));
+        break;
+      }
+      case BinaryQLogFrameType::Ping:
+        event.frames.push_back(std::make_unique<PingFrameLog>());
+        break;
+      case BinaryQLogFrameType::DataBlocked:
+        event.frames.push_back(
+            std::make_unique<DataBlockedFrameLog>(readVarint(cursor)));
+        break;
+      case BinaryQLogFrameType::Knob: {
+        auto knobSpace = readVarint(cursor);
+        auto knobId = readVarint(cursor);
+        auto knobBlobLen = readVarint(cursor);
+        event.frames.push_back(
+            std::make_unique<KnobFrameLog>(knobSpace, knobId, knobBlobLen));
+        break;
+      }
+      case BinaryQLogFrameType::Datagram:
+        event.frames.push_back(
+            std::make_unique<DatagramFrameLog>(readVarint(cursor)));
+        break;
+      case BinaryQLogFrameType::StreamDataBlocked: {
+        auto streamId = readVarint(cursor);
+        auto dataLimit = readVarint(cursor);
+        event.frames.push_back(
+            std::make_unique<StreamDataBlockedFrameLog>(streamId, dataLimit));
+        break;
+      }
+      case BinaryQLogFrameType::Ack: {
+        auto ackDelay = readMicros(cursor);
+        auto numBlocks = readVarint(cursor);
+        // Received and sent packets log their acks from different frame types.
+        if (isPacketRecvd) {
+          ReadAckFrame::Vec ackBlocks;
+          for (uint64_t i = 0; i < numBlocks; i++) {
+            auto start = readVarint(cursor);
+            auto end = readVarint(cursor);
+            ackBlocks.emplace_back(start, end);
+          }
+          event.frames.push_back(
+              std::make_unique<ReadAckFrameLog>(ackBlocks, ackDelay));
+        } else {
+          WriteAckFrame::AckBlockVec ackBlocks;
+          for (uint64_t i = 0; i < numBlocks; i++) {
+            auto start = readVarint(cursor);
+            auto end = readVarint(cursor);
+            ackBlocks.emplace_back(start, end);
+          }
+          event.frames.push_back(
+              std::make_unique<WriteAckFrameLog>(ackBlocks, ackDelay));
+        }
+        break;
+      }
+      case BinaryQLogFrameType::Stream: {
+        auto streamId = readVarint(cursor);
+        auto offset = readVarint(cursor);
+        auto len = readVarint(cursor);
+        auto fin = readBool(cursor);
+        event.frames.push_back(
+            std::make_unique<StreamFrameLog>(streamId, offset, len, fin));
+        break;
+      }
+      case BinaryQLogFrameType::Crypto: {
+        auto offset = readVarint(cursor);
+        auto len = readVarint(cursor);
+        event.frames.push_back(std::make_unique<CryptoFrameLog>(offset, len));
+        break;
+      }
+      case BinaryQLogFrameType::StopSending: {
+        auto streamId = readVarint(cursor);
+        auto errorCode = readVarint(cursor);
+        event.frames.push_back(
+            std::make_unique<StopSendingFrameLog>(streamId, errorCode));
+        break;
+      }
+      case BinaryQLogFrameType::MinStreamData: {
+        auto streamId = readVarint(cursor);
+        auto maximumData = readVarint(cursor);
+        auto minimumStreamOffset = readVarint(cursor);
+        event.frames.push_back(std::make_unique<MinStreamDataFrameLog>(
+            streamId, maximumData, minimumStreamOffset));
+        break;
+      }
+      case BinaryQLogFrameType::ExpiredStreamData: {
+        auto streamId = readVarint(cursor);
+        auto minimumStreamOffset = readVarint(cursor);
+        event.frames.push_back(std::make_unique<ExpiredStreamDataFrameLog>(
+            streamId, minimumStreamOffset));
+        break;
+      }
+      case BinaryQLogFrameType::PathChallenge:
+        event.frames.push_back(
+            std::make_unique<PathChallengeFrameLog>(readVarint(cursor)));
+        break;
+      case BinaryQLogFrameType::PathResponse:
+        event.frames.push_back(
+            std::make_unique<PathResponseFrameLog>(readVarint(cursor)));
+        break;
+      case BinaryQLogFrameType::NewConnectionId: {
+        auto sequence = readVarint(cursor);
+        StatelessResetToken token;
+        cursor.pull(token.data(), token.size());
+        event.frames.push_back(
+            std::make_unique<NewConnectionIdFrameLog>(sequence, token));
+        break;
+      }
+      case BinaryQLogFrameType::RetireConnectionId:
+        event.frames.push_back(
+            std::make_unique<RetireConnectionIdFrameLog>(readVarint(cursor)));
+        break;
+      case BinaryQLogFrameType::NewToken:
+        event.frames.push_back(std::make_unique<ReadNewTokenFrameLog>());
+        break;
+      case BinaryQLogFrameType::HandshakeDone:
+        event.frames.push_back(std::make_unique<HandshakeDoneFrameLog>());
+        break;
+      case BinaryQLogFrameType::AckFrequency: {
+        auto sequenceNumber = readVarint(cursor);
+        auto packetTolerance = readVarint(cursor);
+        auto updateMaxAckDelay = readVarint(cursor);
+        auto reorderThreshold = readVarint(cursor);
+        event.frames.push_back(std::make_unique<AckFrequencyFrameLog>(
+            sequenceNumber,
+            packetTolerance,
+            updateMaxAckDelay,
+            reorderThreshold));
+        break;
+      }
+      case BinaryQLogFrameType::ImmediateAck:
+        event.frames.push_back(std::make_unique<ImmediateAckFrameLog>());
+        break;
+      default:
+        throw std::runtime_error(folly::to<std::string>(
+            "Unknown frame type ", static_cast<int>(type)));
+    }
+  }
+}
+
+class BinaryQLogDecoder {
+ public:
+  void decodeRecord(folly::io::Cursor& cursor);
+
+  // Traces whose TraceStart record was lost are left out, since their
+  // events were decoded with the wrong vantage point.
+  std::vector<std::unique_ptr<quic::FileQLogger>> takeTraces(
+      size_t* numSkippedTraces) {
+    std::vector<std::unique_ptr<quic::FileQLogger>> traces;
+    traces.reserve(traceIds_.size());
+    size_t numSkipped = 0;
+    for (auto traceId : traceIds_) {
+      if (!startedTraceIds_.count(traceId)) {
+        numSkipped++;
+        continue;
+      }
+      traces.push_back(std::move(traces_[traceId]));
+    }
+    if (numSkippedTraces) {
+      *numSkippedTraces = numSkipped;
+    }
+    return traces;
+  }
+
+ private:
+  quic::FileQLogger& getTrace(uint64_t traceId) {
+    auto& trace = traces_[traceId];
+    if (!trace) {
+      // The TraceStart record sets the vantage point and protocol type.
+      trace = std::make_unique<quic::FileQLogger>(quic::VantagePoint::Server);
+      traceIds_.push_back(traceId);
+    }
+    return *trace;
+  }
+
+  std::unique_ptr<quic::QLogEvent> decodeEvent(
+      quic::BinaryQLogRecordType type,
+      const quic::FileQLogger& trace,
+      std::chrono::microseconds refTime,
+      folly::io::Cursor& cursor);
+
+  folly::F14FastMap<uint64_t, std::unique_ptr<quic::FileQLogger>> traces_;
+  std::vector<uint64_t> traceIds_;
+  folly::F14FastSet<uint64_t> startedTraceIds_;
+};
+
+void BinaryQLogDecoder::decodeRecord(folly::io::Cursor& cursor) {
+  using quic::BinaryQLogRecordType;
+  auto type = static_cast<BinaryQLogRecordType>(cursor.read<uint8_t>());
+  auto traceId = readVarint(cursor);
+  auto& trace = getTrace(traceId);
+  switch (type) {
+    case BinaryQLogRecordType::TraceStart:
+      startedTraceIds_.insert(traceId);
+      trace.vantagePoint = static_cast<quic::VantagePoint>(readBool(cursor));
+      trace.protocolType = readString(cursor);
+      return;
+    case BinaryQLogRecordType::Dcid:
+      trace.dcid = readConnectionId(cursor);
+      return;
+    case BinaryQLogRecordType::Scid:
+      trace.scid = readConnectionId(cursor);
+      return;
+    default:
+      break;
+  }
+  auto refTime = readMicros(cursor);
+  trace.logs.push_back(decodeEvent(type, trace, refTime, cursor));
+}
+
+std::unique_ptr<quic::QLogEvent> BinaryQLogDecoder::decodeEvent(
+    quic::BinaryQLogRecordType type,
+    const quic::FileQLogger& trace,
+    std::chrono::microseconds refTime,
+    folly::io::Cursor& cursor) {
+  using namespace quic;
+  switch (type) {
+    case BinaryQLogRecordType::PacketReceived:
+    case BinaryQLogRecordType::PacketSent: {
+      bool isPacketRecvd = type == BinaryQLogRecordType::PacketReceived;
+      auto event = std::make_unique<QLogPacketEvent>();
+      event->refTime = refTime;
+      event->eventType = isPacketRecvd ? QLogEventType::PacketReceived
+                                       : QLogEventType::PacketSent;
+      auto packetType = cursor.read<uint8_t>();
+      event->packetSize = readVarint(cursor);
+      if (packetType > static_cast<uint8_t>(LongHeader::Types::Retry)) {
+        event->packetType = kShortHeaderPacketType.str();
+      } else {
+        auto longHeaderType = static_cast<LongHeader::Types>(packetType);
+        event->packetType = toQlogString(longHeaderType).str();
+        if (longHeaderType == LongHeader::Types::Retry) {
+          // A Retry packet does not include a packet number or frames.
+          return event;
+        }
+      }
+      event->packetNum = readVarint(cursor);
+      readFrames(cursor, *event, isPacketRecvd);
+      return event;
+    }
+    case BinaryQLogRecordType::VersionNegotiation: {
+      auto event = std::make_unique<QLogVersionNegotiationEvent>();
+      event->refTime = refTime;
+      event->eventType = readBool(cursor) ? QLogEventType::PacketReceived
+                                          : QLogEventType::PacketSent;
+      event->packetSize = readVarint(cursor);
+      event->packetType = kVersionNegotiationPacketType;
+      std::vector<QuicVersion> versions(readVarint(cursor));
+      for (auto& version : versions) {
+        version = static_cast<QuicVersion>(readVarint(cursor));
+      }
+      event->versionLog = std::make_unique<VersionNegotiationLog>(versions);
+      return event;
+    }
+    case BinaryQLogRecordType::Retry: {
+      auto event = std::make_unique<QLogRetryEvent>();
+      event->refTime = refTime;
+      event->eventType = readBool(cursor) ? QLogEventType::PacketReceived
+                                          : QLogEventType::PacketSent;
+      event->packetSize = readVarint(cursor);
+      event->tokenSize = readVarint(cursor);
+      event->packetType = toQlogString(LongHeader::Types::Retry).str();
+      return event;
+    }
+    case BinaryQLogRecordType::ConnectionClose: {
+      auto error = readString(cursor);
+      auto reason = readString(cursor);
+      auto drainConnection = readBool(cursor);
+      auto sendCloseImmediately = readBool(cursor);
+      return std::make_unique<QLogConnectionCloseEvent>(
+          std::move(error),
+          std::move(reason),
+          drainConnection,
+          sendCloseImmediately,
+          refTime);
+    }
+    case BinaryQLogRecordType::TransportSummary: {
+      uint64_t values[10];
+      for (auto& value : values) {
+        value = readVarint(cursor);
+      }
+      return std::make_unique<QLogTransportSummaryEvent>(
+          values[0],
+          values[1],
+          values[2],
+          values[3],
+          values[4],
+          values[5],
+          values[6],
+          values[7],
+          values[8],
+          values[9],
+          refTime);
+    }
+    case BinaryQLogRecordType::CongestionMetricUpdate: {
+      auto bytesInFlight = readVarint(cursor);
+      auto currentCwnd = readVarint(cursor);
+      auto congestionEvent = readString(cursor);
+      auto state = readString(cursor);
+      auto recoveryState = readString(cursor);
+      return std::make_unique<QLogCongestionMetricUpdateEvent>(
+          bytesInFlight,
+          currentCwnd,
+          std::move(congestionEvent),
+          std::move(state),
+          std::move(recoveryState),
+          refTime);
+    }
+    case BinaryQLogRecordType::BandwidthEstUpdate: {
+      auto bytes = readVarint(cursor);
+      auto interval = readMicros(cursor);
+      return std::make_unique<QLogBandwidthEstUpdateEvent>(
+          bytes, interval, refTime);
+    }
+    case BinaryQLogRecordType::AppLimitedUpdate:
+      return std::make_unique<QLogAppLimitedUpdateEvent>(
+          readBool(cursor), refTime);
+    case BinaryQLogRecordType::PacingMetricUpdate: {
+      auto pacingBurstSize = readVarint(cursor);
+      auto pacingInterval = readMicros(cursor);
+      return std::make_unique<QLogPacingMetricUpdateEvent>(
+          pacingBurstSize, pacingInterval, refTime);
+    }
+    case BinaryQLogRecordType::PacingObservation: {
+      auto actual = readString(cursor);
+      auto expect = readString(cursor);
+      auto conclusion = readString(cursor);
+      return std::make_unique<QLogPacingObservationEvent>(
+          std::move(actual), std::move(expect), std::move(conclusion), refTime);
+    }
+    case BinaryQLogRecordType::AppIdleUpdate: {
+      auto idleEvent = readString(cursor);
+      auto idle = readBool(cursor);
+      return std::make_unique<QLogAppIdleUpdateEvent>(
+          std::move(idleEvent), idle, refTime);
+    }
+    case BinaryQLogRecordType::PacketDrop: {
+      auto packetSize = readVarint(cursor);
+      auto dropReason = readString(cursor);
+      return std::make_unique<QLogPacketDropEvent>(
+          packetSize, std::move(dropReason), refTime);
+    }
+    case BinaryQLogRecordType::DatagramReceived:
+      return std::make_unique<QLogDatagramReceivedEvent>(
+          readVarint(cursor), refTime);
+    case BinaryQLogRecordType::LossAlarm: {
+      auto largestSent = readVarint(cursor);
+      auto alarmCount = readVarint(cursor);
+      auto outstandingPackets = readVarint(cursor);
+      auto alarmType = readString(cursor);
+      return std::make_unique<QLogLossAlarmEvent>(
+          largestSent,
+          alarmCount,
+          outstandingPackets,
+          std::move(alarmType),
+          refTime);
+    }
+    case BinaryQLogRecordType::PacketsLost: {
+      auto largestLostPacketNum = readVarint(cursor);
+      auto lostBytes = readVarint(cursor);
+      auto lostPackets = readVarint(cursor);
+      return std::make_unique<QLogPacketsLostEvent>(
+          largestLostPacketNum, lostBytes, lostPackets, refTime);
+    }
+    case BinaryQLogRecordType::TransportStateUpdate:
+      return std::make_unique<QLogTransportStateUpdateEvent>(
+          readString(cursor), refTime);
+    case BinaryQLogRecordType::PacketBuffered: {
+      auto packetNum = readVarint(cursor);
+      auto protectionType = static_cast<ProtectionType>(cursor.read<uint8_t>());
+      auto packetSize = readVarint(cursor);
+      return std::make_unique<QLogPacketBufferedEvent>(
+          packetNum, protectionType, packetSize, refTime);
+    }
+    case BinaryQLogRecordType::MetricUpdate: {
+      auto latestRtt = readMicros(cursor);
+      auto mrtt = readMicros(cursor);
+      auto srtt = readMicros(cursor);
+      auto ackDelay = readMicros(cursor);
+      return std::make_unique<QLogMetricUpdateEvent>(
+          latestRtt, mrtt, srtt, ackDelay, refTime);
+    }
+    case BinaryQLogRecordType::StreamStateUpdate: {
+      auto id = readVarint(cursor);
+      auto update = readString(cursor);
+      folly::Optional<std::chrono::milliseconds> timeSinceStreamCreation;
+      if (readBool(cursor)) {
+        timeSinceStreamCreation = std::chrono::milliseconds(
+            static_cast<int64_t>(readVarint(cursor)));
+      }
+      return std::make_unique<QLogStreamStateUpdateEvent>(
+          id,
+          std::move(update),
+          std::move(timeSinceStreamCreation),
+          trace.vantagePoint,
+          refTime);
+    }
+    case BinaryQLogRecordType::ConnectionMigration:
+      return std::make_unique<QLogConnectionMigrationEvent>(
+          readBool(cursor), trace.vantagePoint, refTime);
+    case BinaryQLogRecordType::PathValidation:
+      return std::make_unique<QLogPathValidationEvent>(
+          readBool(cursor), trace.vantagePoint, refTime);
+    default:
+      throw std::runtime_error(folly::to<std::string>(
+          "Unknown record type ", static_cast<int>(type)));
+  }
+}
+
+} // namespace
+
+namespace quic {
+
+std::vector<std::unique_ptr<FileQLogger>> readBinaryQLog(
+    folly::ByteRange data,
+    size_t* numSkippedTraces) {
+  BinaryQLogDecoder decoder;
+  size_t pos = 0;
+  while (pos + kBinaryQLogChunkHeaderSize <= data.size()) {
+    auto magic = folly::Endian::little(
+        folly::loadUnaligned<uint32_t>(data.data() + pos));
+    if (magic != kBinaryQLogChunkMagic) {
+      pos++;
+      continue;
+    }
+    auto len = folly::Endian::little(
+        folly::loadUnaligned<uint32_t>(data.data() + pos + sizeof(magic)));
+    pos += kBinaryQLogChunkHeaderSize;
+    if (len > data.size() - pos) {
+      LOG(WARNING) << "Truncated binary qlog chunk at offset " << pos;
+      break;
+    }
+    auto chunk = folly::IOBuf::wrapBufferAsValue(data.data() + pos, len);
+    folly::io::Cursor cursor(&chunk);
+    try {
+      while (!cursor.isAtEnd()) {
+        decoder.decodeRecord(cursor);
+      }
+    } catch (const std::exception& ex) {
+      LOG(ERROR) << "Malformed binary qlog chunk at offset " << pos << ": "
+                 << ex.what();
+    }
+    pos += len;
+  }
+  return decoder.takeTraces(numSkippedTraces);
+}
+
+} // namespace quic
@@ -0,0 +1,29 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <quic/logging/FileQLogger.h>
+
+namespace quic {
+
+/**
+ * Decodes a file written through a BinaryQLogSink into one FileQLogger per
+ * traced connection, in the order the connections first show up. The
+ * FileQLoggers hold the events in their logs, so each trace can be written as
+ * qlog JSON with outputLogsToFile. Anything that isn't a complete chunk, e.g.
+ * a note the file writer left in place of chunks it dropped, is skipped. So
+ * are traces whose TraceStart record was in a dropped chunk; their number is
+ * stored in numSkippedTraces if it isn't null.
+ */
+std::vector<std::unique_ptr<FileQLogger>> readBinaryQLog(
+    folly::ByteRange data,
+    size_t* numSkippedTraces = nullptr);
+
+} // namespace quic
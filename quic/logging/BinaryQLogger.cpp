@@ -0,0 +1,714 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/logging/BinaryQLogger.h>
+
+#include <folly/lang/Bits.h>
+
+namespace {
+
+void appendVarint(std::string& out, uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<char>(value));
+}
+
+void appendString(std::string& out, folly::StringPiece str) {
+  appendVarint(out, str.size());
+  out.append(str.data(), str.size());
+}
+
+void appendType(std::string& out, quic::BinaryQLogFrameType type) {
+  out.push_back(static_cast<char>(type));
+}
+
+void appendPacketType(std::string& out, const quic::PacketHeader& header) {
+  // The long header types fit in 2 bits, anything larger is a short header.
+  const quic::LongHeader* longHeader = header.asLong();
+  out.push_back(
+      longHeader ? static_cast<char>(longHeader->getHeaderType()) : 0x7f);
+}
+
+void appendQuicSimpleFrame(
+    std::string& out,
+    const quic::QuicSimpleFrame& simpleFrame) {
+  using quic::BinaryQLogFrameType;
+  switch (simpleFrame.type()) {
+    case quic::QuicSimpleFrame::Type::StopSendingFrame_E: {
+      const quic::StopSendingFrame& frame = *simpleFrame.asStopSendingFrame();
+      appendType(out, BinaryQLogFrameType::StopSending);
+      appendVarint(out, frame.streamId);
+      appendVarint(out, frame.errorCode);
+      break;
+    }
+    case quic::QuicSimpleFrame::Type::MinStreamDataFrame_E: {
+      const quic::MinStreamDataFrame& frame =
+          *simpleFrame.asMinStreamDataFrame();
+      appendType(out, BinaryQLogFrameType::MinStreamData);
+      appendVarint(out, frame.streamId);
+      appendVarint(out, frame.maximumData);
+      appendVarint(out, frame.minimumStreamOffset);
+      break;
+    }
+    case quic::QuicSimpleFrame::Type::ExpiredStreamDataFrame_E: {
+      const quic::ExpiredStreamDataFrame& frame =
+          *simpleFrame.asExpiredStreamDataFrame();
+      appendType(out, BinaryQLogFrameType::ExpiredStreamData);
+      appendVarint(out, frame.streamId);
+      appendVarint(out, frame.minimumStreamOffset);
+      break;
+    }
+    case quic::QuicSimpleFrame::Type::PathChallengeFrame_E: {
+      appendType(out, BinaryQLogFrameType::PathChallenge);
+      appendVarint(out, simpleFrame.asPathChallengeFrame()->pathData);
+      break;
+    }
+    case quic::QuicSimpleFrame::Type::PathResponseFrame_E: {
+      appendType(out, BinaryQLogFrameType::PathResponse);
+      appendVarint(out, simpleFrame.asPathResponseFrame()->pathData);
+      break;
+    }
+    case quic::QuicSimpleFrame::Type::NewConnectionIdFrame_E: {
+      const quic::NewConnectionIdFrame& frame =
+          *simpleFrame.asNewConnectionIdFrame();
+      appendType(out, BinaryQLogFrameType::NewConnectionId);
+      appendVarint(out, frame.sequenceNumber);
+      out.append(
+          reinterpret_cast<const char*>(frame.token.data()),
+          frame.token.size());
+      break;
+    }
+    case quic::QuicSimpleFrame::Type::MaxStreamsFrame_E: {
+      const quic::MaxStreamsFrame& frame = *simpleFrame.asMaxStreamsFrame();
+      appendType(out, BinaryQLogFrameType::MaxStreams);
+      appendVarint(out, frame.maxStreams);
+      out.push_back(frame.isForBidirectional);
+      break;
+    }
+    case quic::QuicSimpleFrame::Type::RetireConnectionIdFrame_E: {
+      appendType(out, BinaryQLogFrameType::RetireConnectionId);
+      appendVarint(
+          out, simpleFrame.asRetireConnectionIdFrame()->sequenceNumber);
+      break;
+    }
+    case quic::QuicSimpleFrame::Type::HandshakeDoneFrame_E: {
+      appendType(out, BinaryQLogFrameType::HandshakeDone);
+      break;
+    }
+    case quic::QuicSimpleFrame::Type::KnobFrame_E: {
+      const quic::KnobFrame& frame = *simpleFrame.asKnobFrame();
+      appendType(out, BinaryQLogFrameType::Knob);
+      appendVarint(out, frame.knobSpace);
+      appendVarint(out, frame.id);
+      appendVarint(out, frame.blob->length());
+      break;
+    }
+    case quic::QuicSimpleFrame::Type::AckFrequencyFrame_E: {
+      const quic::AckFrequencyFrame& frame = *simpleFrame.asAckFrequencyFrame();
+      appendType(out, BinaryQLogFrameType::AckFrequency);
+      appendVarint(out, frame.sequenceNumber);
+      appendVarint(out, frame.packetTolerance);
+      appendVarint(out, frame.updateMaxAckDelay);
+      appendVarint(out, frame.reorderThreshold);
+      break;
+    }
+    case quic::QuicSimpleFrame::Type::ImmediateAckFrame_E: {
+      appendType(out, BinaryQLogFrameType::ImmediateAck);
+      break;
+    }
+    case quic::QuicSimpleFrame::Type::NewTokenFrame_E: {
+      appendType(out, BinaryQLogFrameType::NewToken);
+      break;
+    }
+  }
+}
+
+void appendConnectionClose(
+    std::string& out,
+    const quic::ConnectionCloseFrame& frame) {
+  appendType(out, quic::BinaryQLogFrameType::ConnectionClose);
+  out.push_back(static_cast<char>(frame.errorCode.type()));
+  switch (frame.errorCode.type()) {
+    case quic::QuicErrorCode::Type::ApplicationErrorCode_E:
+      appendVarint(out, *frame.errorCode.asApplicationErrorCode());
+      break;
+    case quic::QuicErrorCode::Type::LocalErrorCode_E:
+      appendVarint(
+          out, static_cast<uint64_t>(*frame.errorCode.asLocalErrorCode()));
+      break;
+    case quic::QuicErrorCode::Type::TransportErrorCode_E:
+      appendVarint(
+          out, static_cast<uint64_t>(*frame.errorCode.asTransportErrorCode()));
+      break;
+  }
+  appendString(out, frame.reasonPhrase);
+  appendVarint(out, static_cast<uint64_t>(frame.closingFrameType));
+}
+
+} // namespace
+
+namespace quic {
+
+BinaryQLogSink::Chunk::Chunk(
+    folly::AsyncFileWriter& writerIn,
+    size_t chunkSizeIn)
+    : writer(writerIn), chunkSize(chunkSizeIn) {
+  reset();
+}
+
+BinaryQLogSink::Chunk::~Chunk() {
+  flush();
+}
+
+void BinaryQLogSink::Chunk::reset() {
+  data.clear();
+  // Records are never split across chunks, leave room for the one that fills
+  // it up.
+  data.reserve(chunkSize + chunkSize / 8);
+  data.append(kBinaryQLogChunkHeaderSize, '\0');
+  firstEventTime = std::chrono::steady_clock::time_point();
+}
+
+void BinaryQLogSink::Chunk::flush() {
+  if (data.size() <= kBinaryQLogChunkHeaderSize) {
+    return;
+  }
+  uint32_t header[2] = {
+      folly::Endian::little(kBinaryQLogChunkMagic),
+      folly::Endian::little(
+          static_cast<uint32_t>(data.size() - kBinaryQLogChunkHeaderSize))};
+  memcpy(&data[0], header, sizeof(header));
+  writer.writeMessage(std::move(data));
+  reset();
+}
+
+BinaryQLogSink::BinaryQLogSink(
+    const std::string& path,
+    size_t chunkSize,
+    std::chrono::milliseconds flushInterval)
+    : writer_(path),
+      chunkSize_(chunkSize),
+      flushInterval_(flushInterval),
+      chunks_([this] { return new Chunk(writer_, chunkSize_); }) {
+  writer_.setMaxBufferSize(kBinaryQLogMaxPendingBytes);
+}
+
+void BinaryQLogSink::flushAll() {
+  for (auto& chunk : chunks_.accessAllThreads()) {
+    chunk.flush();
+  }
+  writer_.flush();
+}
+
+BinaryQLogger::BinaryQLogger(
+    VantagePoint vantagePointIn,
+    std::shared_ptr<BinaryQLogSink> sink,
+    std::string protocolTypeIn)
+    : QLogger(vantagePointIn, std::move(protocolTypeIn)),
+      sink_(std::move(sink)),
+      traceId_(sink_->newTraceId()) {}
+
+std::string& BinaryQLogger::startRecord(BinaryQLogRecordType type) {
+  auto& out = sink_->getChunk();
+  if (!traceStarted_) {
+    // Written with the first record rather than on construction, since the
+    // logger may be created on another thread than the one the connection
+    // runs on, and records are only ordered within a thread.
+    traceStarted_ = true;
+    out.push_back(static_cast<char>(BinaryQLogRecordType::TraceStart));
+    appendVarint(out, traceId_);
+    out.push_back(static_cast<char>(vantagePoint));
+    appendString(out, protocolType);
+  }
+  out.push_back(static_cast<char>(type));
+  appendVarint(out, traceId_);
+  return out;
+}
+
+std::string& BinaryQLogger::startEvent(BinaryQLogRecordType type) {
+  auto now = std::chrono::steady_clock::now();
+  sink_->onEventStart(now);
+  auto& out = startRecord(type);
+  appendVarint(
+      out,
+      std::chrono::duration_cast<std::chrono::microseconds>(now - refTimePoint)
+          .count());
+  return out;
+}
+
+void BinaryQLogger::setDcid(folly::Optional<ConnectionId> connID) {
+  if (connID.hasValue()) {
+    dcid = connID.value();
+    auto& out = startRecord(BinaryQLogRecordType::Dcid);
+    appendVarint(out, dcid->size());
+    out.append(reinterpret_cast<const char*>(dcid->data()), dcid->size());
+    endRecord();
+  }
+}
+
+void BinaryQLogger::setScid(folly::Optional<ConnectionId> connID) {
+  if (connID.hasValue()) {
+    scid = connID.value();
+    auto& out = startRecord(BinaryQLogRecordType::Scid);
+    appendVarint(out, scid->size());
+    out.append(reinterpret_cast<const char*>(scid->data()), scid->size());
+    endRecord();
+  }
+}
+
+void BinaryQLogger::addPacket(
+    const RegularQuicPacket& regularPacket,
+    uint64_t packetSize) {
+  auto& out = startEvent(BinaryQLogRecordType::PacketReceived);
+  appendPacketType(out, regularPacket.header);
+  appendVarint(out, packetSize);
+  const LongHeader* longHeader = regularPacket.header.asLong();
+  if (longHeader && longHeader->getHeaderType() == LongHeader::Types::Retry) {
+    // A Retry packet does not include a packet number or frames.
+    endRecord();
+    return;
+  }
+  appendVarint(out, regularPacket.header.getPacketSequenceNum());
+
+  uint64_t numPaddingFrames = 0;
+  for (const auto& quicFrame : regularPacket.frames) {
+    switch (quicFrame.type()) {
+      case QuicFrame::Type::PaddingFrame_E: {
+        ++numPaddingFrames;
+        break;
+      }
+      case QuicFrame::Type::RstStreamFrame_E: {
+        const auto& frame = *quicFrame.asRstStreamFrame();
+        appendType(out, BinaryQLogFrameType::RstStream);
+        appendVarint(out, frame.streamId);
+        appendVarint(out, frame.errorCode);
+        appendVarint(out, frame.offset);
+        break;
+      }
+      case QuicFrame::Type::ConnectionCloseFrame_E: {
+        appendConnectionClose(out, *quicFrame.asConnectionCloseFrame());
+        break;
+      }
+      case QuicFrame::Type::MaxDataFrame_E: {
+        appendType(out, BinaryQLogFrameType::MaxData);
+        appendVarint(out, quicFrame.asMaxDataFrame()->maximumData);
+        break;
+      }
+      case QuicFrame::Type::MaxStreamDataFrame_E: {
+        const auto& frame = *quicFrame.asMaxStreamDataFrame();
+        appendType(out, BinaryQLogFrameType::MaxStreamData);
+        appendVarint(out, frame.streamId);
+        appendVarint(out, frame.maximumData);
+        break;
+      }
+      case QuicFrame::Type::DataBlockedFrame_E: {
+        appendType(out, BinaryQLogFrameType::DataBlocked);
+        appendVarint(out, quicFrame.asDataBlockedFrame()->dataLimit);
+        break;
+      }
+      case QuicFrame::Type::StreamDataBlockedFrame_E: {
+        const auto& frame = *quicFrame.asStreamDataBlockedFrame();
+        appendType(out, BinaryQLogFrameType::StreamDataBlocked);
+        appendVarint(out, frame.streamId);
+        appendVarint(out, frame.dataLimit);
+        break;
+      }
+      case QuicFrame::Type::StreamsBlockedFrame_E: {
+        const auto& frame = *quicFrame.asStreamsBlockedFrame();
+        appendType(out, BinaryQLogFrameType::StreamsBlocked);
+        appendVarint(out, frame.streamLimit);
+        out.push_back(frame.isForBidirectional);
+        break;
+      }
+      case QuicFrame::Type::ReadAckFrame_E: {
+        const auto& frame = *quicFrame.asReadAckFrame();
+        appendType(out, BinaryQLogFrameType::Ack);
+        appendVarint(out, frame.ackDelay.count());
+        appendVarint(out, frame.ackBlocks.size());
+        for (const auto& block : frame.ackBlocks) {
+          appendVarint(out, block.startPacket);
+          appendVarint(out, block.endPacket);
+        }
+        break;
+      }
+      case QuicFrame::Type::ReadStreamFrame_E: {
+        const auto& frame = *quicFrame.asReadStreamFrame();
+        appendType(out, BinaryQLogFrameType::Stream);
+        appendVarint(out, frame.streamId);
+        appendVarint(out, frame.offset);
+        appendVarint(out, frame.data->length());
+        out.push_back(frame.fin);
+        break;
+      }
+      case QuicFrame::Type::ReadCryptoFrame_E: {
+        const auto& frame = *quicFrame.asReadCryptoFrame();
+        appendType(out, BinaryQLogFrameType::Crypto);
+        appendVarint(out, frame.offset);
+        appendVarint(out, frame.data->length());
+        break;
+      }
+      case QuicFrame::Type::ReadNewTokenFrame_E: {
+        appendType(out, BinaryQLogFrameType::NewToken);
+        break;
+      }
+      case QuicFrame::Type::PingFrame_E:
+        appendType(out, BinaryQLogFrameType::Ping);
+        break;
+      case QuicFrame::Type::QuicSimpleFrame_E: {
+        appendQuicSimpleFrame(out, *quicFrame.asQuicSimpleFrame());
+        break;
+      }
+      case QuicFrame::Type::NoopFrame_E: {
+        break;
+      }
+      case QuicFrame::Type::DatagramFrame_E: {
+        appendType(out, BinaryQLogFrameType::Datagram);
+        appendVarint(out, quicFrame.asDatagramFrame()->length);
+        break;
+      }
+    }
+  }
+  if (numPaddingFrames > 0) {
+    appendType(out, BinaryQLogFrameType::Padding);
+    appendVarint(out, numPaddingFrames);
+  }
+  appendType(out, BinaryQLogFrameType::End);
+  endRecord();
+}
+
+void BinaryQLogger::addPacket(
+    const RegularQuicWritePacket& writePacket,
+    uint64_t packetSize) {
+  auto& out = startEvent(BinaryQLogRecordType::PacketSent);
+  appendPacketType(out, writePacket.header);
+  appendVarint(out, packetSize);
+  appendVarint(out, writePacket.header.getPacketSequenceNum());
+
+  uint64_t numPaddingFrames = 0;
+  for (const auto& quicFrame : writePacket.frames) {
+    switch (quicFrame.type()) {
+      case QuicWriteFrame::Type::PaddingFrame_E:
+        ++numPaddingFrames;
+        break;
+      case QuicWriteFrame::Type::RstStreamFrame_E: {
+        const RstStreamFrame& frame = *quicFrame.asRstStreamFrame();
+        appendType(out, BinaryQLogFrameType::RstStream);
+        appendVarint(out, frame.streamId);
+        appendVarint(out, frame.errorCode);
+        appendVarint(out, frame.offset);
+        break;
+      }
+      case QuicWriteFrame::Type::ConnectionCloseFrame_E: {
+        appendConnectionClose(out, *quicFrame.asConnectionCloseFrame());
+        break;
+      }
+      case QuicWriteFrame::Type::MaxDataFrame_E: {
+        appendType(out, BinaryQLogFrameType::MaxData);
+        appendVarint(out, quicFrame.asMaxDataFrame()->maximumData);
+        break;
+      }
+      case QuicWriteFrame::Type::MaxStreamDataFrame_E: {
+        const MaxStreamDataFrame& frame = *quicFrame.asMaxStreamDataFrame();
+        appendType(out, BinaryQLogFrameType::MaxStreamData);
+        appendVarint(out, frame.streamId);
+        appendVarint(out, frame.maximumData);
+        break;
+      }
+      case QuicWriteFrame::Type::StreamsBlockedFrame_E: {
+        const StreamsBlockedFrame& frame = *quicFrame.asStreamsBlockedFrame();
+        appendType(out, BinaryQLogFrameType::StreamsBlocked);
+        appendVarint(out, frame.streamLimit);
+        out.push_back(frame.isForBidirectional);
+        break;
+      }
+      case QuicWriteFrame::Type::DataBlockedFrame_E: {
+        appendType(out, BinaryQLogFrameType::DataBlocked);
+        appendVarint(out, quicFrame.asDataBlockedFrame()->dataLimit);
+        break;
+      }
+      case QuicWriteFrame::Type::StreamDataBlockedFrame_E: {
+        const StreamDataBlockedFrame& frame =
+            *quicFrame.asStreamDataBlockedFrame();
+        appendType(out, BinaryQLogFrameType::StreamDataBlocked);
+        appendVarint(out, frame.streamId);
+        appendVarint(out, frame.dataLimit);
+        break;
+      }
+      case QuicWriteFrame::Type::WriteAckFrame_E: {
+        const WriteAckFrame& frame = *quicFrame.asWriteAckFrame();
+        appendType(out, BinaryQLogFrameType::Ack);
+        appendVarint(out, frame.ackDelay.count());
+        appendVarint(out, frame.ackBlocks.size());
+        for (const auto& block : frame.ackBlocks) {
+          appendVarint(out, block.start);
+          appendVarint(out, block.end);
+        }
+        break;
+      }
+      case QuicWriteFrame::Type::WriteStreamFrame_E: {
+        const WriteStreamFrame& frame = *quicFrame.asWriteStreamFrame();
+        appendType(out, BinaryQLogFrameType::Stream);
+        appendVarint(out, frame.streamId);
+        appendVarint(out, frame.offset);
+        appendVarint(out, frame.len);
+        out.push_back(frame.fin);
+        break;
+      }
+      case QuicWriteFrame::Type::WriteCryptoFrame_E: {
+        const WriteCryptoFrame& frame = *quicFrame.asWriteCryptoFrame();
+        appendType(out, BinaryQLogFrameType::Crypto);
+        appendVarint(out, frame.offset);
+        appendVarint(out, frame.len);
+        break;
+      }
+      case QuicWriteFrame::Type::QuicSimpleFrame_E: {
+        appendQuicSimpleFrame(out, *quicFrame.asQuicSimpleFrame());
+        break;
+      }
+      case QuicWriteFrame::Type::DatagramFrame_E: {
+        appendType(out, BinaryQLogFrameType::Datagram);
+        appendVarint(out, quicFrame.asDatagramFrame()->length);
+        break;
+      }
+      default:
+        break;
+    }
+  }
+  if (numPaddingFrames > 0) {
+    appendType(out, BinaryQLogFrameType::Padding);
+    appendVarint(out, numPaddingFrames);
+  }
+  appendType(out, BinaryQLogFrameType::End);
+  endRecord();
+}
+
+void BinaryQLogger::addPacket(
+    const VersionNegotiationPacket& versionPacket,
+    uint64_t packetSize,
+    bool isPacketRecvd) {
+  auto& out = startEvent(BinaryQLogRecordType::VersionNegotiation);
+  out.push_back(isPacketRecvd);
+  appendVarint(out, packetSize);
+  appendVarint(out, versionPacket.versions.size());
+  for (auto version : versionPacket.versions) {
+    appendVarint(out, static_cast<uint64_t>(version));
+  }
+  endRecord();
+}
+
+void BinaryQLogger::addPacket(
+    const RetryPacket& retryPacket,
+    uint64_t packetSize,
+    bool isPacketRecvd) {
+  auto& out = startEvent(BinaryQLogRecordType::Retry);
+  out.push_back(isPacketRecvd);
+  appendVarint(out, packetSize);
+  appendVarint(out, retryPacket.header.getToken().size());
+  endRecord();
+}
+
+void BinaryQLogger::addConnectionClose(
+    std::string error,
+    std::string reason,
+    bool drainConnection,
+    bool sendCloseImmediately) {
+  auto& out = startEvent(BinaryQLogRecordType::ConnectionClose);
+  appendString(out, error);
+  appendString(out, reason);
+  out.push_back(drainConnection);
+  out.push_back(sendCloseImmediately);
+  endRecord();
+}
+
+void BinaryQLogger::addTransportSummary(
+    uint64_t totalBytesSent,
+    uint64_t totalBytesRecvd,
+    uint64_t sumCurWriteOffset,
+    uint64_t sumMaxObservedOffset,
+    uint64_t sumCurStreamBufferLen,
+    uint64_t totalBytesRetransmitted,
+    uint64_t totalStreamBytesCloned,
+    uint64_t totalBytesCloned,
+    uint64_t totalCryptoDataWritten,
+    uint64_t totalCryptoDataRecvd) {
+  auto& out = startEvent(BinaryQLogRecordType::TransportSummary);
+  appendVarint(out, totalBytesSent);
+  appendVarint(out, totalBytesRecvd);
+  appendVarint(out, sumCurWriteOffset);
+  appendVarint(out, sumMaxObservedOffset);
+  appendVarint(out, sumCurStreamBufferLen);
+  appendVarint(out, totalBytesRetransmitted);
+  appendVarint(out, totalStreamBytesCloned);
+  appendVarint(out, totalBytesCloned);
+  appendVarint(out, totalCryptoDataWritten);
+  appendVarint(out, totalCryptoDataRecvd);
+  endRecord();
+  // The summary is the last record of a closed connection, don't leave the
+  // connection's records waiting for the chunk to fill up.
+  sink_->flush();
+}
+
+void BinaryQLogger::addCongestionMetricUpdate(
+    uint64_t bytesInFlight,
+    uint64_t currentCwnd,
+    std::string congestionEvent,
+    std::string state,
+    std::string recoveryState) {
+  auto& out = startEvent(BinaryQLogRecordType::CongestionMetricUpdate);
+  appendVarint(out, bytesInFlight);
+  appendVarint(out, currentCwnd);
+  appendString(out, congestionEvent);
+  appendString(out, state);
+  appendString(out, recoveryState);
+  endRecord();
+}
+
+void BinaryQLogger::addBandwidthEstUpdate(
+    uint64_t bytes,
+    std::chrono::microseconds interval) {
+  auto& out = startEvent(BinaryQLogRecordType::BandwidthEstUpdate);
+  appendVarint(out, bytes);
+  appendVarint(out, interval.count());
+  endRecord();
+}
+
+void BinaryQLogger::addAppLimitedUpdate() {
+  auto& out = startEvent(BinaryQLogRecordType::AppLimitedUpdate);
+  out.push_back(true);
+  endRecord();
+}
+
+void BinaryQLogger::addAppUnlimitedUpdate() {
+  auto& out = startEvent(BinaryQLogRecordType::AppLimitedUpdate);
+  out.push_back(false);
+  endRecord();
+}
+
+void BinaryQLogger::addPacingMetricUpdate(
+    uint64_t pacingBurstSizeIn,
+    std::chrono::microseconds pacingIntervalIn) {
+  auto& out = startEvent(BinaryQLogRecordType::PacingMetricUpdate);
+  appendVarint(out, pacingBurstSizeIn);
+  appendVarint(out, pacingIntervalIn.count());
+  endRecord();
+}
+
+void BinaryQLogger::addPacingObservation(
+    std::string actual,
+    std::string expect,
+    std::string conclusion) {
+  auto& out = startEvent(BinaryQLogRecordType::PacingObservation);
+  appendString(out, actual);
+  appendString(out, expect);
+  appendString(out, conclusion);
+  endRecord();
+}
+
+void BinaryQLogger::addAppIdleUpdate(std::string idleEvent, bool idle) {
+  auto& out = startEvent(BinaryQLogRecordType::AppIdleUpdate);
+  appendString(out, idleEvent);
+  out.push_back(idle);
+  endRecord();
+}
+
+void BinaryQLogger::addPacketDrop(size_t packetSize, std::string dropReason) {
+  auto& out = startEvent(BinaryQLogRecordType::PacketDrop);
+  appendVarint(out, packetSize);
+  appendString(out, dropReason);
+  endRecord();
+}
+
+void BinaryQLogger::addDatagramReceived(uint64_t dataLen) {
+  auto& out = startEvent(BinaryQLogRecordType::DatagramReceived);
+  appendVarint(out, dataLen);
+  endRecord();
+}
+
+void BinaryQLogger::addLossAlarm(
+    PacketNum largestSent,
+    uint64_t alarmCount,
+    uint64_t outstandingPackets,
+    std::string type) {
+  auto& out = startEvent(BinaryQLogRecordType::LossAlarm);
+  appendVarint(out, largestSent);
+  appendVarint(out, alarmCount);
+  appendVarint(out, outstandingPackets);
+  appendString(out, type);
+  endRecord();
+}
+
+void BinaryQLogger::addPacketsLost(
+    PacketNum largestLostPacketNum,
+    uint64_t lostBytes,
+    uint64_t lostPackets) {
+  auto& out = startEvent(BinaryQLogRecordType::PacketsLost);
+  appendVarint(out, largestLostPacketNum);
+  appendVarint(out, lostBytes);
+  appendVarint(out, lostPackets);
+  endRecord();
+}
+
+void BinaryQLogger::addTransportStateUpdate(std::string update) {
+  auto& out = startEvent(BinaryQLogRecordType::TransportStateUpdate);
+  appendString(out, update);
+  endRecord();
+}
+
+void BinaryQLogger::addPacketBuffered(
+    PacketNum packetNum,
+    ProtectionType protectionType,
+    uint64_t packetSize) {
+  auto& out = startEvent(BinaryQLogRecordType::PacketBuffered);
+  appendVarint(out, packetNum);
+  out.push_back(static_cast<char>(protectionType));
+  appendVarint(out, packetSize);
+  endRecord();
+}
+
+void BinaryQLogger::addMetricUpdate(
+    std::chrono::microseconds latestRtt,
+    std::chrono::microseconds mrtt,
+    std::chrono::microseconds srtt,
+    std::chrono::microseconds ackDelay) {
+  auto& out = startEvent(BinaryQLogRecordType::MetricUpdate);
+  appendVarint(out, latestRtt.count());
+  appendVarint(out, mrtt.count());
+  appendVarint(out, srtt.count());
+  appendVarint(out, ackDelay.count());
+  endRecord();
+}
+
+void BinaryQLogger::addStreamStateUpdate(
+    StreamId id,
+    std::string update,
+    folly::Optional<std::chrono::milliseconds> timeSinceStreamCreation) {
+  auto& out = startEvent(BinaryQLogRecordType::StreamStateUpdate);
+  appendVarint(out, id);
+  appendString(out, update);
+  out.push_back(timeSinceStreamCreation.has_value());
+  if (timeSinceStreamCreation) {
+    appendVarint(out, timeSinceStreamCreation->count());
+  }
+  endRecord();
+}
+
+void BinaryQLogger::addConnectionMigrationUpdate(bool intentionalMigration) {
+  auto& out = startEvent(BinaryQLogRecordType::ConnectionMigration);
+  out.push_back(intentionalMigration);
+  endRecord();
+}
+
+void BinaryQLogger::addPathValidationEvent(bool success) {
+  auto& out = startEvent(BinaryQLogRecordType::PathValidation);
+  out.push_back(success);
+  endRecord();
+}
+
+} // namespace quic
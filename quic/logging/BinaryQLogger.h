@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#pragma once
+
+#include <folly/ThreadLocal.h>
+#include <folly/logging/AsyncFileWriter.h>
+#include <quic/logging/QLogger.h>
+#include <quic/logging/QLoggerConstants.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+namespace quic {
+
+/**
+ * Layout of the files written by BinaryQLogSink. A file is a sequence of
+ * chunks, each one the magic followed by the length of the records in it as a
+ * little endian uint32. Every record starts with its BinaryQLogRecordType and
+ * the trace id of the connection it belongs to, followed by the refTime of the
+ * event in microseconds for event records. All integers in records are
+ * LEB128 varints, strings are a varint length followed by the bytes.
+ */
+constexpr uint32_t kBinaryQLogChunkMagic = 0x42474c51; // "QLGB"
+constexpr size_t kBinaryQLogChunkHeaderSize = 8;
+
+enum class BinaryQLogRecordType : uint8_t {
+  TraceStart,
+  Dcid,
+  Scid,
+  PacketReceived,
+  PacketSent,
+  VersionNegotiation,
+  Retry,
+  ConnectionClose,
+  TransportSummary,
+  CongestionMetricUpdate,
+  BandwidthEstUpdate,
+  AppLimitedUpdate,
+  PacingMetricUpdate,
+  PacingObservation,
+  AppIdleUpdate,
+  PacketDrop,
+  DatagramReceived,
+  LossAlarm,
+  PacketsLost,
+  TransportStateUpdate,
+  PacketBuffered,
+  MetricUpdate,
+  StreamStateUpdate,
+  ConnectionMigration,
+  PathValidation,
+};
+
+// The frames of a packet record, terminated by End.
+enum class BinaryQLogFrameType : uint8_t {
+  End,
+  Padding,
+  RstStream,
+  ConnectionClose,
+  MaxData,
+  MaxStreamData,
+  MaxStreams,
+  StreamsBlocked,
+  Ping,
+  DataBlocked,
+  Knob,
+  Datagram,
+  StreamDataBlocked,
+  Ack,
+  Stream,
+  Crypto,
+  StopSending,
+  MinStreamData,
+  ExpiredStreamData,
+  PathChallenge,
+  PathResponse,
+  NewConnectionId,
+  RetireConnectionId,
+  NewToken,
+  HandshakeDone,
+  AckFrequency,
+  ImmediateAck,
+};
+
+/**
+ * A file shared by the BinaryQLoggers of many connections. Each thread encodes
+ * its records into its own chunk, without locks or allocations, and full
+ * chunks are handed to an AsyncFileWriter which writes them from its own
+ * thread. If the disk can't keep up, the writer drops whole chunks once
+ * kBinaryQLogMaxPendingBytes are pending, so logging never blocks the network
+ * threads. A chunk is also handed over once it holds events older than the
+ * flush interval, when a connection logs its transport summary, and when the
+ * thread exits or the sink is destroyed.
+ */
+class BinaryQLogSink {
+ public:
+  explicit BinaryQLogSink(
+      const std::string& path,
+      size_t chunkSize = kBinaryQLogChunkSize,
+      std::chrono::milliseconds flushInterval = kBinaryQLogFlushInterval);
+
+  /**
+   * Returns the chunk of the calling thread to append a record to.
+   */
+  std::string& getChunk() {
+    return chunks_->data;
+  }
+
+  /**
+   * Called after a record is appended to the calling thread's chunk, hands the
+   * chunk to the writer once it is full.
+   */
+  void onRecordAppended() {
+    if (chunks_->data.size() >= chunkSize_) {
+      chunks_->flush();
+    }
+  }
+
+  /**
+   * Called with the time of an event before it is appended to the calling
+   * thread's chunk. Hands the chunk to the writer if its oldest event is older
+   * than the flush interval, so the records of a thread that logs slowly
+   * don't wait for the chunk to fill up.
+   */
+  void onEventStart(std::chrono::steady_clock::time_point eventTime) {
+    auto& chunk = *chunks_;
+    if (chunk.firstEventTime == std::chrono::steady_clock::time_point()) {
+      chunk.firstEventTime = eventTime;
+    } else if (eventTime - chunk.firstEventTime >= flushInterval_) {
+      chunk.flush();
+      chunk.firstEventTime = eventTime;
+    }
+  }
+
+  /**
+   * Hands the calling thread's chunk to the writer even if it isn't full.
+   */
+  void flush() {
+    chunks_->flush();
+  }
+
+  /**
+   * Hands the chunks of all threads to the writer and waits until the file
+   * has been written. Only call it once nothing logs to the sink anymore, e.g.
+   * after the server has shut down.
+   */
+  void flushAll();
+
+  uint64_t newTraceId() {
+    return nextTraceId_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+ private:
+  struct Chunk {
+    Chunk(folly::AsyncFileWriter& writerIn, size_t chunkSizeIn);
+    ~Chunk();
+
+    void flush();
+    void reset();
+
+    folly::AsyncFileWriter& writer;
+    size_t chunkSize;
+    std::string data;
+    // Time of the first event in data, or zero if there is none.
+    std::chrono::steady_clock::time_point firstEventTime;
+  };
+
+  folly::AsyncFileWriter writer_;
+  size_t chunkSize_;
+  std::chrono::milliseconds flushInterval_;
+  std::atomic<uint64_t> nextTraceId_{0};
+  folly::ThreadLocal<Chunk> chunks_;
+};
+
+/**
+ * A QLogger that encodes events straight into a BinaryQLogSink instead of
+ * building a QLogEvent for each of them. Like the connection it logs for, it
+ * must only be used from one thread at a time, and the records of a trace are
+ * only in order if that is always the same thread. Use readBinaryQLog from
+ * BinaryQLogReader.h to convert the file to qlog JSON.
+ */
+class BinaryQLogger : public QLogger {
+ public:
+  BinaryQLogger(
+      VantagePoint vantagePointIn,
+      std::shared_ptr<BinaryQLogSink> sink,
+      std::string protocolTypeIn = kHTTP3ProtocolType);
+
+  ~BinaryQLogger() override = default;
+
+  void addPacket(const RegularQuicPacket& regularPacket, uint64_t packetSize)
+      override;
+  void addPacket(
+      const VersionNegotiationPacket& versionPacket,
+      uint64_t packetSize,
+      bool isPacketRecvd) override;
+  void addPacket(const RegularQuicWritePacket& writePacket, uint64_t packetSize)
+      override;
+  void addPacket(
+      const RetryPacket& retryPacket,
+      uint64_t packetSize,
+      bool isPacketRecvd) override;
+  void addConnectionClose(
+      std::string error,
+      std::string reason,
+      bool drainConnection,
+      bool sendCloseImmediately) override;
+  void addTransportSummary(
+      uint64_t totalBytesSent,
+      uint64_t totalBytesRecvd,
+      uint64_t sumCurWriteOffset,
+      uint64_t sumMaxObservedOffset,
+      uint64_t sumCurStreamBufferLen,
+      uint64_t totalBytesRetransmitted,
+      uint64_t totalStreamBytesCloned,
+      uint64_t totalBytesCloned,
+      uint64_t totalCryptoDataWritten,
+      uint64_t totalCryptoDataRecvd) override;
+  void addCongestionMetricUpdate(
+      uint64_t bytesInFlight,
+      uint64_t currentCwnd,
+      std::string congestionEvent,
+      std::string state = "",
+      std::string recoveryState = "") override;
+  void addPacingMetricUpdate(
+      uint64_t pacingBurstSizeIn,
+      std::chrono::microseconds pacingIntervalIn) override;
+  void addPacingObservation(
+      std::string actual,
+      std::string expected,
+      std::string conclusion) override;
+  void addBandwidthEstUpdate(uint64_t bytes, std::chrono::microseconds interval)
+      override;
+  void addAppLimitedUpdate() override;
+  void addAppUnlimitedUpdate() override;
+  void addAppIdleUpdate(std::string idleEvent, bool idle) override;
+  void addPacketDrop(size_t packetSize, std::string dropReasonIn) override;
+  void addDatagramReceived(uint64_t dataLen) override;
+  void addLossAlarm(
+      PacketNum largestSent,
+      uint64_t alarmCount,
+      uint64_t outstandingPackets,
+      std::string type) override;
+  void addPacketsLost(
+      PacketNum largestLostPacketNum,
+      uint64_t lostBytes,
+      uint64_t lostPackets) override;
+  void addTransportStateUpdate(std::string update) override;
+  void addPacketBuffered(
+      PacketNum packetNum,
+      ProtectionType protectionType,
+      uint64_t packetSize) override;
+  void addMetricUpdate(
+      std::chrono::microseconds latestRtt,
+      std::chrono::microseconds mrtt,
+      std::chrono::microseconds srtt,
+      std::chrono::microseconds ackDelay) override;
+  void addStreamStateUpdate(
+      StreamId id,
+      std::string update,
+      folly::Optional<std::chrono::milliseconds> timeSinceStreamCreation)
+      override;
+  void addConnectionMigrationUpdate(bool intentionalMigration) override;
+  void addPathValidationEvent(bool success) override;
+
+  void setDcid(folly::Optional<ConnectionId> connID) override;
+  void setScid(folly::Optional<ConnectionId> connID) override;
+
+ private:
+  // Starts a record in the calling thread's chunk and returns the chunk.
+  std::string& startRecord(BinaryQLogRecordType type);
+  std::string& startEvent(BinaryQLogRecordType type);
+  void endRecord() {
+    sink_->onRecordAppended();
+  }
+
+  std::shared_ptr<BinaryQLogSink> sink_;
+  uint64_t traceId_;
+  bool traceStarted_{false};
+};
+
+} // namespace quic
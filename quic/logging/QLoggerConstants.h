@@ -35,6 +35,7 @@ constexpr auto kCopaInit = "copa init";
 constexpr auto kCongestionPacketSent = "congestion on packet sent";
 constexpr auto kCopaCheckAndUpdateDirection = "copa check and update direction";
 constexpr auto kCongestionPacketLoss = "congestion packet loss";
+constexpr auto kCongestionEcnCe = "congestion ecn ce";
 constexpr auto kAppLimited = "app limited";
 constexpr auto kAppUnlimited = "app unlimited";
 constexpr uint64_t kDefaultCwnd = 12320;
@@ -82,6 +83,15 @@ constexpr auto kOnHeaders = "on headers";
 constexpr auto kOnError = "on error";
 constexpr auto kPushPromise = "push promise";
 
+// Size of the per-thread chunks a BinaryQLogSink hands to its file writer.
+constexpr size_t kBinaryQLogChunkSize = 64 * 1024;
+// Chunks a BinaryQLogSink has handed over but not yet written to disk, above
+// which new chunks are dropped rather than blocking the network threads.
+constexpr size_t kBinaryQLogMaxPendingBytes = 64 * 1024 * 1024;
+// Age of the oldest event in a BinaryQLogSink chunk after which the chunk is
+// handed over even if it isn't full.
+constexpr std::chrono::milliseconds kBinaryQLogFlushInterval{1000};
+
 constexpr folly::StringPiece kQLogServerVantagePoint = "server";
 constexpr folly::StringPiece kQLogClientVantagePoint = "client";
 
@@ -145,6 +145,15 @@ class KnobFrameLog : public QLogFrame {
   FOLLY_NODISCARD folly::dynamic toDynamic() const override;
 };
 
+class DatagramFrameLog : public QLogFrame {
+ public:
+  uint64_t len;
+
+  explicit DatagramFrameLog(uint64_t lenIn) : len(lenIn) {}
+  ~DatagramFrameLog() override = default;
+  FOLLY_NODISCARD folly::dynamic toDynamic() const override;
+};
+
 class StreamDataBlockedFrameLog : public QLogFrame {
  public:
   StreamId streamId;
@@ -303,6 +312,33 @@ class HandshakeDoneFrameLog : public QLogFrame {
   folly::dynamic toDynamic() const override;
 };
 
+class AckFrequencyFrameLog : public QLogFrame {
+ public:
+  uint64_t sequenceNumber;
+  uint64_t packetTolerance;
+  uint64_t updateMaxAckDelay;
+  uint64_t reorderThreshold;
+
+  AckFrequencyFrameLog(
+      uint64_t sequenceNumberIn,
+      uint64_t packetToleranceIn,
+      uint64_t updateMaxAckDelayIn,
+      uint64_t reorderThresholdIn)
+      : sequenceNumber(sequenceNumberIn),
+        packetTolerance(packetToleranceIn),
+        updateMaxAckDelay(updateMaxAckDelayIn),
+        reorderThreshold(reorderThresholdIn) {}
+  ~AckFrequencyFrameLog() override = default;
+  FOLLY_NODISCARD folly::dynamic toDynamic() const override;
+};
+
+class ImmediateAckFrameLog : public QLogFrame {
+ public:
+  ImmediateAckFrameLog() = default;
+  ~ImmediateAckFrameLog() override = default;
+  FOLLY_NODISCARD folly::dynamic toDynamic() const override;
+};
+
 class VersionNegotiationLog {
  public:
   std::vector<QuicVersion> versions;
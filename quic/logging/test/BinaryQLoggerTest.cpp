@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/logging/BinaryQLogger.h>
+
+#include <boost/filesystem.hpp>
+#include <folly/FileUtil.h>
+#include <folly/Random.h>
+#include <folly/lang/Bits.h>
+#include <gtest/gtest.h>
+#include <quic/common/test/TestUtils.h>
+#include <quic/logging/BinaryQLogReader.h>
+#include <quic/logging/FileQLogger.h>
+
+#include <thread>
+
+using namespace testing;
+
+namespace quic::test {
+
+class BinaryQLoggerTest : public Test {
+ public:
+  void SetUp() override {
+    path = folly::to<std::string>(
+        boost::filesystem::temp_directory_path().string(),
+        "/",
+        folly::Random::rand64(),
+        ".binqlog");
+  }
+
+  void TearDown() override {
+    boost::filesystem::remove(path);
+  }
+
+  // Logs the same events to the binary and the JSON logger.
+  void logEvents(QLogger& q) {
+    q.setDcid(getTestConnectionId(1));
+    q.setScid(getTestConnectionId(2));
+    q.addPacket(createRegularQuicWritePacket(10, 0, 100, true), 1200);
+    q.addPacket(createPacketWithAckFrames(), 1001);
+    q.addPacket(createPacketWithPaddingFrames(), 1300);
+
+    RegularQuicPacket regularQuicPacket(
+        ShortHeader(ProtectionType::KeyPhaseZero, getTestConnectionId(1), 7));
+    regularQuicPacket.frames.emplace_back(ReadStreamFrame(4, 100, false));
+    ReadAckFrame ackFrame;
+    ackFrame.ackBlocks.emplace_back(10, 20);
+    ackFrame.ackBlocks.emplace_back(1, 5);
+    ackFrame.ackDelay = std::chrono::microseconds(250);
+    regularQuicPacket.frames.emplace_back(std::move(ackFrame));
+    regularQuicPacket.frames.emplace_back(
+        QuicSimpleFrame(MaxStreamsFrame(100, true)));
+    regularQuicPacket.frames.emplace_back(ConnectionCloseFrame(
+        QuicErrorCode(TransportErrorCode::PROTOCOL_VIOLATION),
+        "bad frame",
+        FrameType::STREAM));
+    q.addPacket(regularQuicPacket, 500);
+
+    q.addPacket(createVersionNegotiationPacket(), 40, true);
+    q.addCongestionMetricUpdate(2000, 12000, kCongestionPacketAck, "Steady");
+    q.addPacingMetricUpdate(10, std::chrono::microseconds(3000));
+    q.addAppLimitedUpdate();
+    q.addPacketDrop(100, kCipherUnavailable);
+    q.addLossAlarm(99, 2, 5, kPtoAlarm);
+    q.addPacketsLost(98, 2400, 2);
+    q.addTransportStateUpdate(kStart);
+    q.addPacketBuffered(12, ProtectionType::ZeroRtt, 1200);
+    q.addMetricUpdate(
+        std::chrono::microseconds(30),
+        std::chrono::microseconds(20),
+        std::chrono::microseconds(25),
+        std::chrono::microseconds(5));
+    q.addStreamStateUpdate(4, kOnHeaders, std::chrono::milliseconds(12));
+    q.addStreamStateUpdate(4, kEOM, folly::none);
+    q.addPathValidationEvent(true);
+    q.addConnectionClose(kNoError, "done", true, false);
+    q.addTransportSummary(1, 2, 3, 4, 5, 6, 7, 8, 9, 10);
+  }
+
+  std::string path;
+};
+
+TEST_F(BinaryQLoggerTest, ConvertsToSameEvents) {
+  auto sink = std::make_shared<BinaryQLogSink>(path);
+  BinaryQLogger binaryLogger(VantagePoint::Client, sink, "fake-protocol");
+  FileQLogger fileLogger(VantagePoint::Client, "fake-protocol");
+  logEvents(binaryLogger);
+  logEvents(fileLogger);
+  // Destroying the sink writes out everything it holds.
+  sink.reset();
+
+  std::string data;
+  ASSERT_TRUE(folly::readFile(path.c_str(), data));
+  auto traces = readBinaryQLog(folly::StringPiece(data));
+  ASSERT_EQ(traces.size(), 1);
+  auto& trace = *traces[0];
+  EXPECT_EQ(trace.vantagePoint, VantagePoint::Client);
+  EXPECT_EQ(trace.protocolType, "fake-protocol");
+  EXPECT_EQ(trace.dcid, fileLogger.dcid);
+  EXPECT_EQ(trace.scid, fileLogger.scid);
+  ASSERT_EQ(trace.logs.size(), fileLogger.logs.size());
+  for (size_t i = 0; i < trace.logs.size(); i++) {
+    auto got = trace.logs[i]->toDynamic();
+    auto expected = fileLogger.logs[i]->toDynamic();
+    // The loggers were created at different times.
+    got[0] = expected[0] = "0";
+    EXPECT_EQ(got, expected) << "event " << i;
+  }
+}
+
+TEST_F(BinaryQLoggerTest, SkipsDataBetweenChunks) {
+  // Every record fills a chunk.
+  auto sink = std::make_shared<BinaryQLogSink>(path, 1);
+  BinaryQLogger logger(VantagePoint::Server, sink);
+  logEvents(logger);
+  sink.reset();
+
+  std::string data;
+  ASSERT_TRUE(folly::readFile(path.c_str(), data));
+  auto clean = readBinaryQLog(folly::StringPiece(data));
+  ASSERT_EQ(clean.size(), 1);
+
+  // What the file writer writes between chunks when it drops some, and a
+  // chunk cut short at the end of the file.
+  uint32_t firstChunkLen;
+  memcpy(&firstChunkLen, data.data() + 4, sizeof(firstChunkLen));
+  auto boundary =
+      kBinaryQLogChunkHeaderSize + folly::Endian::little(firstChunkLen);
+  auto dirty = folly::to<std::string>(
+      data.substr(0, boundary),
+      "2 log messages discarded: logging faster than we can write\n",
+      data.substr(boundary),
+      data.substr(0, kBinaryQLogChunkHeaderSize + 2));
+  auto traces = readBinaryQLog(folly::StringPiece(dirty));
+  ASSERT_EQ(traces.size(), 1);
+  EXPECT_EQ(traces[0]->logs.size(), clean[0]->logs.size());
+}
+
+TEST_F(BinaryQLoggerTest, SkipsTracesWithoutStart) {
+  // Every record fills a chunk, so the TraceStart is only in the first one.
+  auto sink = std::make_shared<BinaryQLogSink>(path, 1);
+  BinaryQLogger logger(VantagePoint::Client, sink);
+  logEvents(logger);
+  sink.reset();
+
+  std::string data;
+  ASSERT_TRUE(folly::readFile(path.c_str(), data));
+  uint32_t firstChunkLen;
+  memcpy(&firstChunkLen, data.data() + 4, sizeof(firstChunkLen));
+  auto boundary =
+      kBinaryQLogChunkHeaderSize + folly::Endian::little(firstChunkLen);
+  size_t numSkipped = 0;
+  auto traces =
+      readBinaryQLog(folly::StringPiece(data.substr(boundary)), &numSkipped);
+  EXPECT_TRUE(traces.empty());
+  EXPECT_EQ(numSkipped, 1);
+
+  traces = readBinaryQLog(folly::StringPiece(data), &numSkipped);
+  ASSERT_EQ(traces.size(), 1);
+  EXPECT_EQ(traces[0]->vantagePoint, VantagePoint::Client);
+  EXPECT_EQ(numSkipped, 0);
+}
+
+TEST_F(BinaryQLoggerTest, ConnectionsOnManyThreads) {
+  auto sink = std::make_shared<BinaryQLogSink>(path, 256);
+  constexpr size_t kNumThreads = 4;
+  constexpr size_t kNumEvents = 1000;
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < kNumThreads; i++) {
+    threads.emplace_back([&sink, i] {
+      BinaryQLogger logger(VantagePoint::Server, sink);
+      logger.setDcid(getTestConnectionId(i));
+      for (size_t j = 0; j < kNumEvents; j++) {
+        logger.addPacketsLost(j, j * 1000, 1);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  sink.reset();
+
+  std::string data;
+  ASSERT_TRUE(folly::readFile(path.c_str(), data));
+  auto traces = readBinaryQLog(folly::StringPiece(data));
+  ASSERT_EQ(traces.size(), kNumThreads);
+  for (auto& trace : traces) {
+    ASSERT_TRUE(trace->dcid.has_value());
+    ASSERT_EQ(trace->logs.size(), kNumEvents);
+    for (size_t j = 0; j < kNumEvents; j++) {
+      auto event = dynamic_cast<QLogPacketsLostEvent*>(trace->logs[j].get());
+      ASSERT_NE(event, nullptr);
+      EXPECT_EQ(event->largestLostPacketNum, j);
+    }
+  }
+}
+
+TEST_F(BinaryQLoggerTest, FlushesAtTransportSummary) {
+  auto sink = std::make_shared<BinaryQLogSink>(path);
+  BinaryQLogger logger(VantagePoint::Server, sink);
+  logger.addAppLimitedUpdate();
+  EXPECT_GT(sink->getChunk().size(), kBinaryQLogChunkHeaderSize);
+  logger.addTransportSummary(1, 2, 3, 4, 5, 6, 7, 8, 9, 10);
+  EXPECT_EQ(sink->getChunk().size(), kBinaryQLogChunkHeaderSize);
+}
+
+TEST_F(BinaryQLoggerTest, FlushesAfterInterval) {
+  auto sink = std::make_shared<BinaryQLogSink>(
+      path, kBinaryQLogChunkSize, std::chrono::milliseconds(1));
+  BinaryQLogger logger(VantagePoint::Server, sink);
+  logger.addAppLimitedUpdate();
+  auto firstChunkSize = sink->getChunk().size();
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  // The chunk is handed over before the event, which then starts a new one
+  // without the trace start.
+  logger.addAppLimitedUpdate();
+  EXPECT_LT(sink->getChunk().size(), firstChunkSize);
+}
+
+TEST_F(BinaryQLoggerTest, FlushAllWritesTheFile) {
+  auto sink = std::make_shared<BinaryQLogSink>(path);
+  BinaryQLogger logger(VantagePoint::Server, sink);
+  logger.setDcid(getTestConnectionId(1));
+  logger.addAppLimitedUpdate();
+  sink->flushAll();
+
+  // Everything is on disk while the sink is still alive.
+  std::string data;
+  ASSERT_TRUE(folly::readFile(path.c_str(), data));
+  auto traces = readBinaryQLog(folly::StringPiece(data));
+  ASSERT_EQ(traces.size(), 1);
+  EXPECT_EQ(traces[0]->dcid, getTestConnectionId(1));
+  EXPECT_EQ(traces[0]->logs.size(), 1);
+}
+
+} // namespace quic::test
@@ -117,7 +117,8 @@ void markPacketLoss(
                 *stream, frame, *bufferItr->second)) {
           break;
         }
-        stream->insertIntoLossBuffer(std::move(bufferItr->second));
+        conn.streamBufferPool.put(
+            stream->insertIntoLossBuffer(std::move(bufferItr->second)));
         stream->retransmissionBuffer.erase(bufferItr);
         conn.streamManager->updateLossStreams(*stream);
         break;
@@ -138,7 +139,8 @@ void markPacketLoss(
           break;
         }
         DCHECK_EQ(bufferItr->second->offset, frame.offset);
-        cryptoStream->insertIntoLossBuffer(std::move(bufferItr->second));
+        conn.streamBufferPool.put(
+            cryptoStream->insertIntoLossBuffer(std::move(bufferItr->second)));
         cryptoStream->retransmissionBuffer.erase(bufferItr);
         break;
       }
@@ -89,8 +89,7 @@ calculateAlarmDuration(const QuicConnectionStateBase& conn) {
     adjustedAlarmDuration = folly::chrono::ceil<std::chrono::milliseconds>(
         lastSentPacketTime + alarmDuration - now);
   } else {
-    auto lastSentPacketNum =
-        conn.outstandings.packets.back().packet.header.getPacketSequenceNum();
+    auto lastSentPacketNum = conn.outstandings.packets.back().packetNum;
     VLOG(10) << __func__ << " alarm already due method=" << *alarmMethod
              << " lastSentPacketNum=" << lastSentPacketNum
              << " lastSentPacketTime="
@@ -213,11 +212,11 @@ folly::Optional<CongestionController::LossEvent> detectLossPackets(
   bool shouldSetTimer = false;
   while (iter != conn.outstandings.packets.end()) {
     auto& pkt = *iter;
-    auto currentPacketNum = pkt.packet.header.getPacketSequenceNum();
+    auto currentPacketNum = pkt.packetNum;
     if (!largestAcked.has_value() || currentPacketNum >= *largestAcked) {
       break;
     }
-    auto currentPacketNumberSpace = pkt.packet.header.getPacketNumberSpace();
+    auto currentPacketNumberSpace = pkt.packetNumberSpace;
     if (currentPacketNumberSpace != pnSpace || pkt.isD6DProbe) {
       iter++;
       continue;
@@ -68,6 +68,10 @@ class LogQuicStats : public quic::QuicTransportStatsCallback {
     VLOG(2) << prefix_ << "onForwardedPacketProcessed";
   }
 
+  void onPacketMisrouted() override {
+    VLOG(2) << prefix_ << "onPacketMisrouted";
+  }
+
   void onClientInitialReceived(QuicVersion version) override {
     VLOG(2) << prefix_
             << "onClientInitialReceived, version: " << quic::toString(version);
@@ -77,6 +81,10 @@ class LogQuicStats : public quic::QuicTransportStatsCallback {
     VLOG(2) << prefix_ << "onConnectionRateLimited";
   }
 
+  void onRetryPacketSent() override {
+    VLOG(2) << prefix_ << "onRetryPacketSent";
+  }
+
   // connection level metrics:
   void onNewConnection() override {
     VLOG(2) << prefix_ << "onNewConnection";
@@ -122,6 +130,22 @@ class LogQuicStats : public quic::QuicTransportStatsCallback {
     VLOG(2) << prefix_ << "onStreamFlowControlBlocked";
   }
 
+  void onConnFlowControlWindowIncreased() override {
+    VLOG(2) << prefix_ << "onConnFlowControlWindowIncreased";
+  }
+
+  void onStreamFlowControlWindowIncreased() override {
+    VLOG(2) << prefix_ << "onStreamFlowControlWindowIncreased";
+  }
+
+  void onFlowControlWindowBudgetExhausted() override {
+    VLOG(2) << prefix_ << "onFlowControlWindowBudgetExhausted";
+  }
+
+  void onBufferMemoryPoolUsage(uint64_t usedBytes) override {
+    VLOG(2) << prefix_ << "onBufferMemoryPoolUsage usedBytes=" << usedBytes;
+  }
+
   void onCwndBlocked() override {
     VLOG(2) << prefix_ << "onCwndBlocked";
   }
@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/server/ConnectionIdRoutingTable.h>
+
+namespace quic {
+
+bool ConnectionIdRoutingTable::insert(
+    const ConnectionId& connId,
+    uint8_t workerId) {
+  return table_.insert(connId, workerId).second;
+}
+
+bool ConnectionIdRoutingTable::erase(
+    const ConnectionId& connId,
+    uint8_t workerId) {
+  return table_.erase_if_equal(connId, workerId) > 0;
+}
+
+folly::Optional<uint8_t> ConnectionIdRoutingTable::find(
+    const ConnectionId& connId) const {
+  auto it = table_.find(connId);
+  if (it == table_.cend()) {
+    return folly::none;
+  }
+  return it->second;
+}
+
+size_t ConnectionIdRoutingTable::size() const {
+  return table_.size();
+}
+
+} // namespace quic
@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#pragma once
+
+#include <folly/Optional.h>
+#include <folly/concurrency/ConcurrentHashMap.h>
+
+#include <quic/codec/QuicConnectionId.h>
+
+namespace quic {
+
+/**
+ * Server-wide map from a server chosen connection id to the id of the worker
+ * that owns the connection. It is shared by all the workers of a QuicServer so
+ * that whichever worker reads a packet can find the owning worker directly,
+ * without relying on the worker id encoded in the connection id.
+ *
+ * Lookups happen for every routed packet while updates only happen when
+ * connection ids are issued or retired, so the table is a sharded
+ * ConcurrentHashMap: readers are lock-free and protected by hazard pointers,
+ * and writers only lock the shard they update.
+ */
+class ConnectionIdRoutingTable {
+ public:
+  /**
+   * Records that connId belongs to workerId. Returns false if connId is
+   * already owned by a worker, in which case the table is unchanged.
+   */
+  bool insert(const ConnectionId& connId, uint8_t workerId);
+
+  /**
+   * Removes connId if it is owned by workerId. Returns whether it was removed.
+   */
+  bool erase(const ConnectionId& connId, uint8_t workerId);
+
+  folly::Optional<uint8_t> find(const ConnectionId& connId) const;
+
+  size_t size() const;
+
+ private:
+  folly::ConcurrentHashMap<ConnectionId, uint8_t, ConnectionIdHash> table_;
+};
+
+} // namespace quic
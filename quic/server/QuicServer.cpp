@@ -73,6 +73,12 @@ void QuicServer::setRateLimit(uint64_t count, std::chrono::seconds window) {
   rateLimit_ = folly::make_optional<RateLimit>(count, window);
 }
 
+void QuicServer::setRetryRateLimit(
+    uint64_t count,
+    std::chrono::seconds window) {
+  retryRateLimit_ = folly::make_optional<RateLimit>(count, window);
+}
+
 void QuicServer::setSupportedVersion(const std::vector<QuicVersion>& versions) {
   supportedVersions_ = versions;
 }
@@ -135,6 +141,12 @@ void QuicServer::initialize(
     transportSettings_.statelessResetTokenSecret = secret;
   }
 
+  if (!transportSettings_.tokenSecret) {
+    std::array<uint8_t, kTokenSecretLength> secret;
+    folly::Random::secureRandom(secret.data(), secret.size());
+    transportSettings_.tokenSecret = secret;
+  }
+
   // it the connid algo factory is not set, use default impl
   if (!connIdAlgoFactory_) {
     connIdAlgoFactory_ = std::make_unique<DefaultConnectionIdAlgoFactory>();
@@ -199,6 +211,10 @@ void QuicServer::initializeWorkers(
       worker->setRateLimiter(std::make_unique<SlidingWindowRateLimiter>(
           rateLimit_->count, rateLimit_->window));
     }
+    if (retryRateLimit_) {
+      worker->setRetryRateLimiter(std::make_unique<SlidingWindowRateLimiter>(
+          retryRateLimit_->count, retryRateLimit_->window));
+    }
     worker->setWorkerId(i);
     worker->setTransportSettingsOverrideFn(transportSettingsOverrideFn_);
     workers_.push_back(std::move(worker));
@@ -215,6 +231,7 @@ std::unique_ptr<QuicServerWorker> QuicServer::newWorkerWithoutSocket() {
   worker->rejectNewConnections(rejectNewConnections_);
   worker->setProcessId(processId_);
   worker->setHostId(hostId_);
+  worker->setConnectionIdRoutingTable(connIdRoutingTable_);
   return worker;
 }
 
@@ -429,8 +446,19 @@ void QuicServer::routeDataToWorker(
     return;
   }
 
-  auto workerToRunOn =
-      getWorkerToRouteTo(routingData, workers_.size(), connIdAlgo_.get());
+  // Prefer the worker that registered the connection id, it is authoritative
+  // even when the id was not minted by this process' connection id algo.
+  size_t workerToRunOn;
+  auto owner = connIdRoutingTable_->find(routingData.destinationConnId);
+  if (owner && *owner < workers_.size()) {
+    workerToRunOn = *owner;
+  } else {
+    workerToRunOn =
+        getWorkerToRouteTo(routingData, workers_.size(), connIdAlgo_.get());
+  }
+  if (workerPtr_ && workerPtr_->getWorkerId() != workerToRunOn) {
+    QUIC_STATS(workerPtr_->getTransportStatsCallback(), onPacketMisrouted);
+  }
   auto& worker = workers_[workerToRunOn];
   VLOG_IF(4, !worker->getEventBase()->isInEventBaseThread())
       << " Routing to worker in different EVB, to workerId=" << workerToRunOn;
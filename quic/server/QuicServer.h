@@ -20,6 +20,7 @@
 #include <quic/QuicConstants.h>
 #include <quic/codec/ConnectionIdAlgo.h>
 #include <quic/congestion_control/CongestionControllerFactory.h>
+#include <quic/server/ConnectionIdRoutingTable.h>
 #include <quic/server/QuicServerTransportFactory.h>
 #include <quic/server/QuicServerWorker.h>
 #include <quic/server/QuicUDPSocketFactory.h>
@@ -101,6 +102,14 @@ class QuicServer : public QuicServerWorker::WorkerCallback,
 
   void setRateLimit(uint64_t count, std::chrono::seconds window);
 
+  /**
+   * Once a worker sees more than count new connections in window, clients
+   * have to validate their address with a stateless Retry before it creates a
+   * connection for them. Flooded Initials then only cost a Retry packet
+   * instead of a transport and a TLS handshake.
+   */
+  void setRetryRateLimit(uint64_t count, std::chrono::seconds window);
+
   /**
    * Set list of supported QUICVersion for this server. These versions will be
    * used during the 'Version-Negotiation' phase with the client.
@@ -402,6 +411,9 @@ class QuicServer : public QuicServerWorker::WorkerCallback,
   // NOTE: QuicServer still maintains ownership of all the workers and manages
   // their destruction
   folly::ThreadLocalPtr<QuicServerWorker> workerPtr_;
+  // Connection id to owning worker, shared by all the workers.
+  std::shared_ptr<ConnectionIdRoutingTable> connIdRoutingTable_{
+      std::make_shared<ConnectionIdRoutingTable>()};
   folly::F14FastMap<folly::EventBase*, QuicServerWorker*> evbToWorkers_;
   std::unique_ptr<QuicServerTransportFactory> transportFactory_;
   folly::F14FastMap<folly::EventBase*, QuicServerTransportFactory*>
@@ -438,6 +450,7 @@ class QuicServer : public QuicServerWorker::WorkerCallback,
     std::chrono::seconds window;
   };
   folly::Optional<RateLimit> rateLimit_;
+  folly::Optional<RateLimit> retryRateLimit_;
 };
 
 } // namespace quic
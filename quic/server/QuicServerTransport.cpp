@@ -9,9 +9,11 @@
 #include <quic/server/QuicServerTransport.h>
 
 #include <quic/fizz/server/handshake/FizzServerQuicHandshakeContext.h>
+#include <quic/flowcontrol/QuicFlowController.h>
 #include <quic/server/handshake/AppToken.h>
 #include <quic/server/handshake/DefaultAppTokenValidator.h>
 #include <quic/server/handshake/StatelessResetGenerator.h>
+#include <quic/state/QuicPacingFunctions.h>
 
 #include <algorithm>
 
@@ -91,6 +93,24 @@ void QuicServerTransport::setConnectionIdAlgo(
   }
 }
 
+void QuicServerTransport::setBufferMemoryPool(
+    std::shared_ptr<BufferMemoryPool> pool) noexcept {
+  if (conn_) {
+    DCHECK_EQ(conn_->bufferMemoryCharged, 0);
+    conn_->bufferMemoryPool = std::move(pool);
+    conn_->bufferMemoryCallback = this;
+    // Reserve the initial receive window.
+    updateBufferMemoryCharge(*conn_);
+  }
+}
+
+void QuicServerTransport::setTokenGenerator(
+    std::shared_ptr<TokenGenerator> tokenGenerator) noexcept {
+  if (serverConn_) {
+    serverConn_->tokenGenerator = std::move(tokenGenerator);
+  }
+}
+
 void QuicServerTransport::setServerConnectionIdRejector(
     ServerConnectionIdRejector* connIdRejector) noexcept {
   CHECK(connIdRejector);
@@ -205,10 +225,11 @@ void QuicServerTransport::writeData() {
     }
     return;
   }
-  uint64_t packetLimit =
-      (isConnectionPaced(*conn_)
-           ? conn_->pacer->updateAndGetWriteBatchSize(Clock::now())
-           : conn_->transportSettings.writeConnectionDataPacketsLimit);
+  uint64_t packetLimit = isTxTimePaced(*conn_)
+      ? getTxTimeWriteBatchSize(*conn_, Clock::now())
+      : (isConnectionPaced(*conn_)
+             ? conn_->pacer->updateAndGetWriteBatchSize(Clock::now())
+             : conn_->transportSettings.writeConnectionDataPacketsLimit);
   if (conn_->initialWriteCipher) {
     auto& initialCryptoStream =
         *getCryptoStream(*conn_->cryptoState, EncryptionLevel::Initial);
@@ -278,6 +299,10 @@ void QuicServerTransport::writeData() {
 }
 
 void QuicServerTransport::closeTransport() {
+  if (conn_->bufferMemoryPool) {
+    conn_->bufferMemoryPool->cancelNotifyOnRelease(this);
+    conn_->bufferMemoryCallback = nullptr;
+  }
   serverConn_->serverHandshakeLayer->cancel();
   // Clear out pending data.
   serverConn_->pendingZeroRttData.reset();
@@ -325,6 +350,30 @@ void QuicServerTransport::setClientChosenDestConnectionId(
   conn_->clientChosenDestConnectionId.assign(clientChosenDestConnectionId);
 }
 
+void QuicServerTransport::setRetryOriginalDestConnectionId(
+    const ConnectionId& originalDestConnectionId) {
+  serverConn_->retryOriginalDestinationConnectionId.assign(
+      originalDestConnectionId);
+}
+
+void QuicServerTransport::onBufferMemoryReleased() noexcept {
+  if (!getEventBase()) {
+    return;
+  }
+  // Another connection sharing the pool is releasing the memory, advertise
+  // the window the pool held back once it is done.
+  runOnEvbAsync([](auto self) {
+    auto serverPtr = static_cast<QuicServerTransport*>(self.get());
+    if (serverPtr->closeState_ != CloseState::OPEN) {
+      return;
+    }
+    maybeSendConnWindowUpdate(*serverPtr->conn_, Clock::now());
+    if (serverPtr->conn_->pendingEvents.connWindowUpdate) {
+      serverPtr->updateWriteLooper(true);
+    }
+  });
+}
+
 void QuicServerTransport::onCryptoEventAvailable() noexcept {
   try {
     VLOG(10) << "onCryptoEventAvailable " << *this;
@@ -384,7 +433,8 @@ void QuicServerTransport::processPendingData(bool async) {
             pendingPacket.peer,
             NetworkData(
                 std::move(pendingPacket.networkData.data),
-                pendingPacket.networkData.receiveTimePoint));
+                pendingPacket.networkData.receiveTimePoint,
+                pendingPacket.networkData.ecn));
         if (serverPtr->closeState_ == CloseState::CLOSED) {
           // The pending data could potentially contain a connection close, or
           // the app could have triggered a connection close with an error. It
@@ -500,6 +550,12 @@ void QuicServerTransport::setBufAccessor(BufAccessor* bufAccessor) {
   conn_->bufAccessor = bufAccessor;
 }
 
+void QuicServerTransport::setZeroCopySendTracker(
+    ZeroCopySendTracker* zeroCopySendTracker) {
+  CHECK(zeroCopySendTracker);
+  conn_->zeroCopySendTracker = zeroCopySendTracker;
+}
+
 #ifdef CCP_ENABLED
 void QuicServerTransport::setCcpDatapath(struct ccp_datapath* datapath) {
   serverConn_->ccpDatapath = datapath;
@@ -24,6 +24,7 @@ namespace quic {
 class QuicServerTransport
     : public QuicTransportBase,
       public ServerHandshake::HandshakeCallback,
+      public BufferMemoryPool::Callback,
       public std::enable_shared_from_this<QuicServerTransport> {
  public:
   using Ptr = std::shared_ptr<QuicServerTransport>;
@@ -86,6 +87,20 @@ class QuicServerTransport
   void setServerConnectionIdRejector(
       ServerConnectionIdRejector* connIdRejector) noexcept;
 
+  /**
+   * Set the pool the stream buffers of the connection are charged against,
+   * shared with the other connections of the worker. Must be set after the
+   * transport settings and before the connection starts buffering data.
+   */
+  void setBufferMemoryPool(std::shared_ptr<BufferMemoryPool> pool) noexcept;
+
+  /**
+   * Set the generator used to issue and check NEW_TOKEN tokens, shared with
+   * the other connections of the worker.
+   */
+  void setTokenGenerator(
+      std::shared_ptr<TokenGenerator> tokenGenerator) noexcept;
+
   /**
    * Set factory to create specific congestion controller instances
    * for a given connection
@@ -98,6 +113,14 @@ class QuicServerTransport
 
   void setClientChosenDestConnectionId(const ConnectionId& serverCid);
 
+  /**
+   * Set the destination connection id of the client's first Initial, from
+   * the token of the Retry the client answered. The client checks it and the
+   * source connection id of the Retry in our transport parameters.
+   */
+  void setRetryOriginalDestConnectionId(
+      const ConnectionId& originalDestConnectionId);
+
   // From QuicTransportBase
   void onReadData(
       const folly::SocketAddress& peer,
@@ -116,6 +139,9 @@ class QuicServerTransport
 
   virtual void setBufAccessor(BufAccessor* bufAccessor);
 
+  virtual void setZeroCopySendTracker(
+      ZeroCopySendTracker* zeroCopySendTracker);
+
 #ifdef CCP_ENABLED
   /*
    * This function must be called with an initialized ccp_datapath (via
@@ -132,6 +158,9 @@ class QuicServerTransport
   // From ServerHandshake::HandshakeCallback
   virtual void onCryptoEventAvailable() noexcept override;
 
+  // From BufferMemoryPool::Callback
+  void onBufferMemoryReleased() noexcept override;
+
  private:
   void processPendingData(bool async);
   void maybeNotifyTransportReady();
@@ -7,12 +7,14 @@
  */
 
 #include <folly/Format.h>
+#include <folly/ScopeGuard.h>
 #include <folly/io/Cursor.h>
 #include <folly/io/SocketOptionMap.h>
 #include <folly/system/ThreadId.h>
 #include <quic/QuicConstants.h>
 #include <quic/common/SocketUtil.h>
 #include <quic/common/Timers.h>
+#include <quic/fizz/handshake/FizzCryptoFactory.h>
 
 #include <quic/server/AcceptObserver.h>
 #include <quic/server/CCPReader.h>
@@ -63,6 +65,18 @@ void QuicServerWorker::bind(const folly::SocketAddress& address) {
         folly::SocketOptionKey::ApplyPos::POST_BIND);
   }
   socket_->setDFAndTurnOffPMTU();
+  applyTransportSocketOptions(address.getFamily());
+  if (transportSettings_.zeroCopyGSOWrites) {
+    zeroCopySendTracker_ = ZeroCopySendTracker::create(*socket_);
+    if (zeroCopySendTracker_) {
+      // The socket is shared by every client of the worker, ICMP errors of
+      // one of them must not fail the sends to the others.
+      setErrMessageCallbackWithoutRecvErr(*socket_, this);
+    } else {
+      LOG(WARNING) << "SO_ZEROCOPY not supported, copying GSO writes";
+      transportSettings_.zeroCopyGSOWrites = false;
+    }
+  }
   if (transportSettings_.numGROBuffers_ > kDefaultNumGROBuffers) {
     socket_->setGRO(true);
     auto ret = socket_->getGRO();
@@ -88,6 +102,24 @@ void QuicServerWorker::applyAllSocketOptions() {
         getAddress().getFamily(),
         folly::SocketOptionKey::ApplyPos::POST_BIND);
   }
+  applyTransportSocketOptions(getAddress().getFamily());
+}
+
+void QuicServerWorker::applyTransportSocketOptions(sa_family_t family) {
+  if (transportSettings_.ecnMarking != ECNCodepoint::NotECT ||
+      transportSettings_.readEcnOnIngress) {
+    applyEcnSocketOptions(
+        *socket_,
+        family,
+        transportSettings_.ecnMarking,
+        transportSettings_.readEcnOnIngress);
+  }
+  if (transportSettings_.pacingWithTxTime &&
+      !applyTxTimeSocketOption(*socket_)) {
+    LOG(WARNING) << "SO_TXTIME not supported, pacing with the timer instead";
+    txTimeUnsupported_ = true;
+    transportSettings_.pacingWithTxTime = false;
+  }
 }
 
 void QuicServerWorker::setTransportSettingsOverrideFn(
@@ -106,6 +138,11 @@ QuicTransportStatsCallback* QuicServerWorker::getTransportStatsCallback() const
   return statsCallback_.get();
 }
 
+const BufferMemoryPool* QuicServerWorker::getBufferMemoryPool() const
+    noexcept {
+  return bufferMemoryPool_.get();
+}
+
 void QuicServerWorker::setConnectionIdAlgo(
     std::unique_ptr<ConnectionIdAlgo> connIdAlgo) noexcept {
   CHECK(connIdAlgo);
@@ -123,6 +160,18 @@ void QuicServerWorker::setRateLimiter(
   newConnRateLimiter_ = std::move(rateLimiter);
 }
 
+void QuicServerWorker::setRetryRateLimiter(
+    std::unique_ptr<RateLimiter> retryRateLimiter) {
+  CHECK(transportSettings_.tokenSecret.has_value());
+  retryRateLimiter_ = std::move(retryRateLimiter);
+  retryCipher_ = FizzCryptoFactory().makeRetryAead();
+}
+
+void QuicServerWorker::setConnectionIdRoutingTable(
+    std::shared_ptr<ConnectionIdRoutingTable> routingTable) {
+  connIdRoutingTable_ = std::move(routingTable);
+}
+
 void QuicServerWorker::start() {
   CHECK(socket_);
   if (!pacingTimer_) {
@@ -206,6 +255,94 @@ bool QuicServerWorker::maybeSendVersionNegotiationPacketOrDrop(
   return false;
 }
 
+bool QuicServerWorker::maybeSendRetryPacketOrDrop(
+    const folly::SocketAddress& client,
+    const RoutingData& routingData,
+    const NetworkData& networkData,
+    folly::Optional<ConnectionId>& retryOriginalDstConnId) {
+  if (!retryRateLimiter_) {
+    return false;
+  }
+  CHECK(!networkData.packets.empty());
+  folly::io::Cursor cursor(networkData.packets.front().get());
+  uint8_t initialByte = cursor.readBE<uint8_t>();
+  auto parsedHeader = parseLongHeader(initialByte, cursor);
+  if (!parsedHeader || !parsedHeader->parsedLongHeader) {
+    VLOG(3) << "Dropping unparseable initial packet from client=" << client;
+    QUIC_STATS(statsCallback_, onPacketDropped, PacketDropReason::PARSE_ERROR);
+    return true;
+  }
+  const auto& header = parsedHeader->parsedLongHeader->header;
+  // Clients whose address we validated skip the retry rate, and don't count
+  // towards it. A token we can't validate counts as no token, since it may
+  // be from another server.
+  if (!header.getToken().empty() &&
+      isValidAddressToken(header.getToken(), client, retryOriginalDstConnId)) {
+    return false;
+  }
+  if (!retryRateLimiter_->check(networkData.receiveTimePoint)) {
+    return false;
+  }
+
+  // The client sends its next Initial to the connection id we choose here,
+  // which also routes it to this worker like any other Initial.
+  auto retrySrcConnId = ConnectionId::createRandom(kDefaultConnectionIdSize);
+  auto timestampInMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                           std::chrono::system_clock::now().time_since_epoch())
+                           .count();
+  RetryToken retryToken(
+      routingData.destinationConnId,
+      client.getIPAddress(),
+      client.getPort(),
+      timestampInMs);
+  auto encryptedToken = tokenGenerator_->encryptToken(retryToken);
+  if (!encryptedToken) {
+    LOG(ERROR) << "Failed to encrypt retry token";
+    return false;
+  }
+  RetryPacketBuilder builder(
+      retrySrcConnId,
+      routingData.sourceConnId.value_or(ConnectionId(std::vector<uint8_t>())),
+      routingData.destinationConnId,
+      header.getVersion(),
+      (*encryptedToken)->moveToFbString().toStdString(),
+      *retryCipher_);
+  auto retryPacket = std::move(builder).buildPacket();
+  VLOG(4) << "Retry sent to client=" << client;
+  auto len = retryPacket->computeChainDataLength();
+  QUIC_STATS(statsCallback_, onWrite, len);
+  QUIC_STATS(statsCallback_, onPacketProcessed);
+  QUIC_STATS(statsCallback_, onPacketSent);
+  QUIC_STATS(statsCallback_, onRetryPacketSent);
+  socket_->write(client, retryPacket);
+  return true;
+}
+
+bool QuicServerWorker::isValidAddressToken(
+    const std::string& token,
+    const folly::SocketAddress& client,
+    folly::Optional<ConnectionId>& retryOriginalDstConnId) const {
+  auto retryToken =
+      tokenGenerator_->decryptRetryToken(folly::IOBuf::copyBuffer(token));
+  if (!retryToken) {
+    // A NEW_TOKEN token from an earlier connection validates the address as
+    // well.
+    return tokenGenerator_->isValidNewToken(token, client.getIPAddress());
+  }
+  if (retryToken->clientIp != client.getIPAddress() ||
+      retryToken->clientPort != client.getPort()) {
+    return false;
+  }
+  auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::system_clock::now().time_since_epoch());
+  auto age = now - std::chrono::milliseconds(retryToken->timestampInMs);
+  if (age > kRetryTokenValidity) {
+    return false;
+  }
+  retryOriginalDstConnId = retryToken->originalDstConnId;
+  return true;
+}
+
 void QuicServerWorker::onDataAvailable(
     const folly::SocketAddress& client,
     size_t len,
@@ -223,6 +360,18 @@ void QuicServerWorker::onDataAvailable(
   // of it immediately so that if we return early,
   // we've flushed it.
   Buf data = std::move(readBuffer_);
+  auto ecn = readEcn_;
+  readEcn_ = ECNCodepoint::NotECT;
+  // Packets for the same connection are routed together once the whole read
+  // has been parsed, unless the caller is already batching a larger read.
+  bool ownsBatch = !batchingPackets_;
+  batchingPackets_ = true;
+  SCOPE_EXIT {
+    if (ownsBatch) {
+      batchingPackets_ = false;
+      flushPendingPacketBatches();
+    }
+  };
 
   if (params.gro_ <= 0) {
     if (truncated) {
@@ -232,7 +381,7 @@ void QuicServerWorker::onDataAvailable(
     data->append(len);
     QUIC_STATS(statsCallback_, onPacketReceived);
     QUIC_STATS(statsCallback_, onRead, len);
-    handleNetworkData(client, std::move(data), packetReceiveTime);
+    handleNetworkData(client, std::move(data), packetReceiveTime, false, ecn);
   } else {
     // if we receive a truncated packet
     // we still need to consider the prev valid ones
@@ -260,16 +409,147 @@ void QuicServerWorker::onDataAvailable(
 
         offset += params.gro_;
         remaining -= params.gro_;
-        handleNetworkData(client, std::move(tmp), packetReceiveTime);
+        handleNetworkData(
+            client, std::move(tmp), packetReceiveTime, false, ecn);
       } else {
         // do not clone the last packet
         // start at offset, use all the remaining data
         data->trimStart(offset);
         DCHECK_EQ(data->length(), remaining);
         remaining = 0;
-        handleNetworkData(client, std::move(data), packetReceiveTime);
+        handleNetworkData(
+            client, std::move(data), packetReceiveTime, false, ecn);
+      }
+    }
+  }
+}
+
+bool QuicServerWorker::shouldOnlyNotify() {
+  // Only the recvmmsg path asks for the control messages that carry the ECN
+  // codepoint, so reading ECN always goes through it.
+  return transportSettings_.readEcnOnIngress ||
+      (transportSettings_.shouldRecvBatch &&
+       transportSettings_.shouldUseRecvmmsgForBatchRecv);
+}
+
+void QuicServerWorker::onNotifyDataAvailable(
+    folly::AsyncUDPSocket& sock) noexcept {
+  const size_t readBufferSize =
+      transportSettings_.maxRecvPacketSize * numGROBuffers_;
+  const size_t numPackets = transportSettings_.maxRecvBatchSize;
+  const size_t addrLen = sizeof(struct sockaddr_storage);
+
+  recvmmsgStorage_.resize(numPackets);
+  auto& msgs = recvmmsgStorage_.msgs;
+  auto& addrs = recvmmsgStorage_.addrs;
+  auto& readBuffers = recvmmsgStorage_.readBuffers;
+  auto& iovecs = recvmmsgStorage_.iovecs;
+  auto& freeBufs = recvmmsgStorage_.freeBufs;
+  int flags = 0;
+#ifdef FOLLY_HAVE_MSG_ERRQUEUE
+  bool useGRO = numGROBuffers_ > 1;
+  bool useControl = useGRO || transportSettings_.readEcnOnIngress;
+  if (useControl) {
+    recvmmsgControl_.resize(numPackets);
+  }
+  if (useGRO) {
+    // we need to consider MSG_TRUNC too
+    flags |= MSG_TRUNC;
+  }
+#endif
+
+  for (size_t i = 0; i < numPackets; ++i) {
+    Buf readBuffer;
+    if (freeBufs.empty()) {
+      readBuffer = folly::IOBuf::create(readBufferSize);
+    } else {
+      readBuffer = std::move(freeBufs.back());
+      DCHECK(readBuffer != nullptr);
+      freeBufs.pop_back();
+    }
+    iovecs[i].iov_base = readBuffer->writableData();
+    iovecs[i].iov_len = readBufferSize;
+    readBuffers[i] = std::move(readBuffer);
+
+    auto* rawAddr = reinterpret_cast<sockaddr*>(&addrs[i]);
+    rawAddr->sa_family = sock.address().getFamily();
+
+    struct msghdr* msg = &msgs[i].msg_hdr;
+    msg->msg_name = rawAddr;
+    msg->msg_namelen = addrLen;
+    msg->msg_iov = &iovecs[i];
+    msg->msg_iovlen = 1;
+    msg->msg_control = nullptr;
+    msg->msg_controllen = 0;
+    msg->msg_flags = 0;
+#ifdef FOLLY_HAVE_MSG_ERRQUEUE
+    if (useControl) {
+      msg->msg_control = recvmmsgControl_[i].data();
+      msg->msg_controllen = recvmmsgControl_[i].size();
+    }
+#endif
+  }
+
+  int numMsgsRecvd = sock.recvmmsg(msgs.data(), numPackets, flags, nullptr);
+  if (numMsgsRecvd < 0) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      // Exit, socket will notify us again when socket is readable.
+      return;
+    }
+    sock.pauseRead();
+    return onReadError(folly::AsyncSocketException(
+        folly::AsyncSocketException::INTERNAL_ERROR,
+        "::recvmmsg() failed",
+        errno));
+  }
+
+  CHECK_LE(static_cast<size_t>(numMsgsRecvd), numPackets);
+  batchingPackets_ = true;
+  SCOPE_EXIT {
+    batchingPackets_ = false;
+    flushPendingPacketBatches();
+  };
+  // Need to save our position so we can recycle the unused buffers.
+  size_t i;
+  for (i = 0; i < static_cast<size_t>(numMsgsRecvd); ++i) {
+    size_t bytesRead = msgs[i].msg_len;
+    if (bytesRead == 0) {
+      // Empty datagram, nothing to route.
+      freeBufs.emplace_back(std::move(readBuffers[i]));
+      continue;
+    }
+    int gro = -1;
+#ifdef FOLLY_HAVE_MSG_ERRQUEUE
+    if (useControl) {
+      for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msgs[i].msg_hdr);
+           cmsg != nullptr;
+           cmsg = CMSG_NXTHDR(&msgs[i].msg_hdr, cmsg)) {
+        if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+          gro = *((uint16_t*)CMSG_DATA(cmsg));
+        } else if (auto ecn = getEcnFromCmsg(*cmsg)) {
+          readEcn_ = *ecn;
+        }
       }
     }
+#endif
+    bool truncated = (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) != 0;
+    if (bytesRead > readBufferSize) {
+      truncated = true;
+      bytesRead = readBufferSize;
+    }
+
+    folly::SocketAddress client;
+    client.setFromSockaddr(
+        reinterpret_cast<sockaddr*>(&addrs[i]), msgs[i].msg_hdr.msg_namelen);
+
+    OnDataAvailableParams params;
+    params.gro_ = gro;
+    readBuffer_ = std::move(readBuffers[i]);
+    onDataAvailable(client, bytesRead, truncated, params);
+  }
+  for (; i < numPackets; ++i) {
+    freeBufs.emplace_back(std::move(readBuffers[i]));
+    DCHECK(freeBufs.back() != nullptr);
   }
 }
 
@@ -277,7 +557,8 @@ void QuicServerWorker::handleNetworkData(
     const folly::SocketAddress& client,
     Buf data,
     const TimePoint& packetReceiveTime,
-    bool isForwardedData) noexcept {
+    bool isForwardedData,
+    ECNCodepoint ecn) noexcept {
   try {
     if (shutdown_) {
       VLOG(4) << "Packet received after shutdown, dropping";
@@ -321,10 +602,18 @@ void QuicServerWorker::handleNetworkData(
           false,
           std::move(parsedShortHeader->destinationConnId),
           folly::none);
+      if (batchingPackets_ && !isForwardedData) {
+        return batchPacketData(
+            client,
+            std::move(routingData),
+            std::move(data),
+            packetReceiveTime,
+            ecn);
+      }
       return forwardNetworkData(
           client,
           std::move(routingData),
-          NetworkData(std::move(data), packetReceiveTime),
+          NetworkData(std::move(data), packetReceiveTime, ecn),
           isForwardedData);
     }
 
@@ -373,10 +662,12 @@ void QuicServerWorker::handleNetworkData(
         isUsingClientConnId,
         std::move(parsedLongHeader->invariant.dstConnId),
         std::move(parsedLongHeader->invariant.srcConnId));
+    // Keep the packets queued so far ahead of this one.
+    flushPendingPacketBatches();
     return forwardNetworkData(
         client,
         std::move(routingData),
-        NetworkData(std::move(data), packetReceiveTime),
+        NetworkData(std::move(data), packetReceiveTime, ecn),
         isForwardedData);
   } catch (const std::exception& ex) {
     // Drop the packet.
@@ -454,7 +745,9 @@ void QuicServerWorker::forwardNetworkData(
   // if it's not Client initial or ZeroRtt, AND if the connectionId version
   // mismatches: foward if pktForwarding is enabled else dropPacket
   if (!routingData.isUsingClientConnId &&
-      !connIdAlgo_->canParse(routingData.destinationConnId)) {
+      !connIdAlgo_->canParse(routingData.destinationConnId) &&
+      !(connIdRoutingTable_ &&
+        connIdRoutingTable_->find(routingData.destinationConnId))) {
     if (packetForwardingEnabled_ && !isForwardedData) {
       VLOG(3) << folly::format(
           "Forwarding packet with unknown connId version from client={} to another process, routingInfo={}",
@@ -480,6 +773,50 @@ void QuicServerWorker::forwardNetworkData(
       client, std::move(routingData), std::move(networkData), isForwardedData);
 }
 
+void QuicServerWorker::batchPacketData(
+    const folly::SocketAddress& client,
+    RoutingData&& routingData,
+    Buf data,
+    const TimePoint& packetReceiveTime,
+    ECNCodepoint ecn) {
+  // A read batch only holds a handful of connections, a linear scan is
+  // cheaper than hashing the connection id.
+  for (auto& batch : pendingPacketBatches_) {
+    if (batch.routingData.destinationConnId == routingData.destinationConnId &&
+        batch.client == client) {
+      batch.networkData.totalData += data->computeChainDataLength();
+      batch.networkData.addPacket(std::move(data), ecn);
+      return;
+    }
+  }
+  pendingPacketBatches_.push_back(PendingPacketBatch{
+      client,
+      std::move(routingData),
+      NetworkData(std::move(data), packetReceiveTime, ecn)});
+}
+
+void QuicServerWorker::flushPendingPacketBatches() {
+  if (pendingPacketBatches_.empty()) {
+    return;
+  }
+  // Routing can end up closing transports, move the batches out so nothing
+  // observes a half flushed queue.
+  auto batches = std::move(pendingPacketBatches_);
+  pendingPacketBatches_.clear();
+  for (auto& batch : batches) {
+    try {
+      forwardNetworkData(
+          batch.client,
+          std::move(batch.routingData),
+          std::move(batch.networkData));
+    } catch (const std::exception& ex) {
+      QUIC_STATS(
+          statsCallback_, onPacketDropped, PacketDropReason::PARSE_ERROR);
+      VLOG(6) << "Failed to route packet batch " << ex.what();
+    }
+  }
+}
+
 void QuicServerWorker::setPacingTimer(
     TimerHighRes::SharedPtr pacingTimer) noexcept {
   pacingTimer_ = std::move(pacingTimer);
@@ -546,9 +883,13 @@ void QuicServerWorker::dispatchPacketData(
               PacketDropReason::INVALID_PACKET);
           return;
         }
+        folly::Optional<ConnectionId> retryOriginalDstConnId;
+        if (maybeSendRetryPacketOrDrop(
+                client, routingData, networkData, retryOriginalDstConnId)) {
+          return;
+        }
         if (newConnRateLimiter_ &&
             newConnRateLimiter_->check(networkData.receiveTimePoint)) {
-          // TODO RETRY
           VersionNegotiationPacketBuilder builder(
               routingData.destinationConnId,
               routingData.sourceConnId.value_or(
@@ -573,6 +914,9 @@ void QuicServerWorker::dispatchPacketData(
               bufAccessor_) {
             trans->setBufAccessor(bufAccessor_.get());
           }
+          if (zeroCopySendTracker_) {
+            trans->setZeroCopySendTracker(zeroCopySendTracker_.get());
+          }
           trans->setPacingTimer(pacingTimer_);
           trans->setRoutingCallback(this);
           trans->setSupportedVersions(supportedVersions_);
@@ -596,6 +940,9 @@ void QuicServerWorker::dispatchPacketData(
                             ? "ContinuousMemory"
                             : "ChainedMemory");
               }
+              if (txTimeUnsupported_) {
+                overridenTransportSettings->pacingWithTxTime = false;
+              }
               trans->setTransportSettings(*overridenTransportSettings);
             } else {
               trans->setTransportSettings(transportSettings_);
@@ -605,10 +952,19 @@ void QuicServerWorker::dispatchPacketData(
           }
           trans->setConnectionIdAlgo(connIdAlgo_.get());
           trans->setServerConnectionIdRejector(this);
+          if (bufferMemoryPool_) {
+            trans->setBufferMemoryPool(bufferMemoryPool_);
+          }
+          if (tokenGenerator_) {
+            trans->setTokenGenerator(tokenGenerator_);
+          }
           if (routingData.sourceConnId) {
             trans->setClientConnectionId(*routingData.sourceConnId);
           }
           trans->setClientChosenDestConnectionId(routingData.destinationConnId);
+          if (retryOriginalDstConnId) {
+            trans->setRetryOriginalDestConnectionId(*retryOriginalDstConnId);
+          }
           // parameters to create server chosen connection id
           ServerConnectionIdParams serverConnIdParams(
               hostId_, static_cast<uint8_t>(processId_), workerId_);
@@ -801,6 +1157,17 @@ void QuicServerWorker::onReadClosed() noexcept {
   shutdownAllConnections(LocalErrorCode::SHUTTING_DOWN);
 }
 
+void QuicServerWorker::errMessage(const cmsghdr& cmsg) noexcept {
+  if (zeroCopySendTracker_) {
+    zeroCopySendTracker_->onErrMessage(cmsg);
+  }
+}
+
+void QuicServerWorker::errMessageError(
+    const folly::AsyncSocketException& ex) noexcept {
+  VLOG(4) << "QuicServer error queue read error: " << ex.what();
+}
+
 int QuicServerWorker::getTakeoverHandlerSocketFD() {
   CHECK(takeoverCB_);
   return takeoverCB_->getSocketFD();
@@ -859,6 +1226,15 @@ void QuicServerWorker::setFizzContext(
 void QuicServerWorker::setTransportSettings(
     TransportSettings transportSettings) {
   transportSettings_ = transportSettings;
+  if (txTimeUnsupported_) {
+    transportSettings_.pacingWithTxTime = false;
+  }
+  if (transportSettings_.tokenSecret) {
+    tokenGenerator_ =
+        std::make_shared<TokenGenerator>(*transportSettings_.tokenSecret);
+  } else {
+    tokenGenerator_.reset();
+  }
   if (transportSettings_.batchingMode != QuicBatchingMode::BATCHING_MODE_GSO) {
     if (transportSettings_.dataPathType == DataPathType::ContinuousMemory) {
       LOG(ERROR) << "Unsupported data path type and batching mode combinartoin";
@@ -873,6 +1249,16 @@ void QuicServerWorker::setTransportSettings(
         kDefaultMaxUDPPayload * transportSettings_.maxBatchSize);
     VLOG(10) << "GSO write buf accessor created for ContinuousMemory data path";
   }
+  if (transportSettings_.workerBufferMemoryLimit == 0) {
+    bufferMemoryPool_ = nullptr;
+  } else if (
+      !bufferMemoryPool_ ||
+      bufferMemoryPool_->limit() !=
+          transportSettings_.workerBufferMemoryLimit) {
+    // Connections already charging the previous pool keep it until they close.
+    bufferMemoryPool_ = std::make_shared<BufferMemoryPool>(
+        transportSettings_.workerBufferMemoryLimit);
+  }
 }
 
 void QuicServerWorker::rejectNewConnections(bool rejectNewConnections) {
@@ -926,9 +1312,13 @@ void QuicServerWorker::onConnectionIdAvailable(
     LOG(ERROR) << "connectionIdMap_ already has CID=" << id
                << " Is same transport: "
                << (existingTransportPtr == transportPtr);
-  } else if (boundServerTransports_.emplace(transportPtr, weakTransport)
-                 .second) {
-    QUIC_STATS(statsCallback_, onNewConnection);
+  } else {
+    if (connIdRoutingTable_ && !connIdRoutingTable_->insert(id, workerId_)) {
+      LOG(ERROR) << "Routing table already has CID=" << id;
+    }
+    if (boundServerTransports_.emplace(transportPtr, weakTransport).second) {
+      QUIC_STATS(statsCallback_, onNewConnection);
+    }
   }
 }
 
@@ -981,6 +1371,9 @@ void QuicServerWorker::onConnectionUnbound(
       }
     }
     connectionIdMap_.erase(connId.connId);
+    if (connIdRoutingTable_) {
+      connIdRoutingTable_->erase(connId.connId, workerId_);
+    }
     if (incorrectTransportPtr != nullptr) {
       if (boundServerTransports_.find(incorrectTransportPtr) !=
           boundServerTransports_.end()) {
@@ -1005,6 +1398,7 @@ void QuicServerWorker::shutdownAllConnections(LocalErrorCode error) {
   shutdown_ = true;
   if (socket_) {
     socket_->pauseRead();
+    socket_->setErrMessageCallback(nullptr);
   }
   if (takeoverCB_) {
     takeoverCB_->pause();
@@ -1031,6 +1425,11 @@ void QuicServerWorker::shutdownAllConnections(LocalErrorCode error) {
     }
   }
   sourceAddressMap_.clear();
+  if (connIdRoutingTable_) {
+    for (const auto& it : connectionIdMap_) {
+      connIdRoutingTable_->erase(it.first, workerId_);
+    }
+  }
   connectionIdMap_.clear();
   takeoverPktHandler_.stop();
   if (statsCallback_) {
@@ -1046,7 +1445,10 @@ QuicServerWorker::~QuicServerWorker() {
 
 bool QuicServerWorker::rejectConnectionId(const ConnectionId& candidate) const
     noexcept {
-  return connectionIdMap_.find(candidate) != connectionIdMap_.end();
+  // Also reject ids owned by other workers, the routing table can only map a
+  // connection id to a single worker.
+  return connectionIdMap_.find(candidate) != connectionIdMap_.end() ||
+      (connIdRoutingTable_ && connIdRoutingTable_->find(candidate));
 }
 
 std::string QuicServerWorker::logRoutingInfo(const ConnectionId& connId) const {
@@ -16,13 +16,16 @@
 
 #include <quic/codec/ConnectionIdAlgo.h>
 #include <quic/common/BufAccessor.h>
+#include <quic/common/SocketUtil.h>
 #include <quic/common/Timers.h>
 #include <quic/congestion_control/CongestionControllerFactory.h>
 #include <quic/server/CCPReader.h>
+#include <quic/server/ConnectionIdRoutingTable.h>
 #include <quic/server/QuicServerPacketRouter.h>
 #include <quic/server/QuicServerTransportFactory.h>
 #include <quic/server/QuicUDPSocketFactory.h>
 #include <quic/server/RateLimiter.h>
+#include <quic/server/handshake/TokenGenerator.h>
 #include <quic/server/state/ServerConnectionIdRejector.h>
 #include <quic/state/QuicTransportStatsCallback.h>
 
@@ -31,6 +34,7 @@ namespace quic {
 class AcceptObserver;
 
 class QuicServerWorker : public folly::AsyncUDPSocket::ReadCallback,
+                         public folly::AsyncUDPSocket::ErrMessageCallback,
                          public QuicServerTransport::RoutingCallback,
                          public ServerConnectionIdRejector,
                          public folly::EventRecvmsgCallback {
@@ -256,6 +260,10 @@ class QuicServerWorker : public folly::AsyncUDPSocket::ReadCallback,
 
   void setTransportSettings(TransportSettings transportSettings);
 
+  const TransportSettings& getTransportSettings() const {
+    return transportSettings_;
+  }
+
   /**
    * If true, start to reject any new connection during handshake
    */
@@ -285,6 +293,12 @@ class QuicServerWorker : public folly::AsyncUDPSocket::ReadCallback,
    */
   QuicTransportStatsCallback* getTransportStatsCallback() const noexcept;
 
+  /**
+   * Return the pool the stream buffers of all the connections of this worker
+   * are charged against, nullptr when workerBufferMemoryLimit is not set.
+   */
+  const BufferMemoryPool* getBufferMemoryPool() const noexcept;
+
   /**
    * Set ConnectionIdAlgo implementation to encode and decode ConnectionId with
    * various info, such as routing related info.
@@ -305,6 +319,20 @@ class QuicServerWorker : public folly::AsyncUDPSocket::ReadCallback,
    */
   void setRateLimiter(std::unique_ptr<RateLimiter> rateLimiter);
 
+  /**
+   * Set the rate limiter above which client Initials without a valid address
+   * validation token are answered with a Retry instead of a new connection.
+   * The tokens are sealed with transportSettings.tokenSecret.
+   */
+  void setRetryRateLimiter(std::unique_ptr<RateLimiter> retryRateLimiter);
+
+  /**
+   * Set the routing table shared by all the workers of the server. The worker
+   * records the connection ids it owns in it.
+   */
+  void setConnectionIdRoutingTable(
+      std::shared_ptr<ConnectionIdRoutingTable> routingTable);
+
   /*
    * Get a reference to this worker's corresponding CCPReader.
    * Each worker has a CCPReader that handles recieving messages from CCP
@@ -321,6 +349,18 @@ class QuicServerWorker : public folly::AsyncUDPSocket::ReadCallback,
       bool truncated,
       OnDataAvailableParams params) noexcept override;
 
+  /**
+   * Returns true when the worker reads with recvmmsg in notify mode, i.e.
+   * when both shouldRecvBatch and shouldUseRecvmmsgForBatchRecv are set.
+   */
+  bool shouldOnlyNotify() override;
+
+  /**
+   * Reads up to maxRecvBatchSize datagrams (each possibly GRO-coalesced) with
+   * a single recvmmsg call and hands them to onDataAvailable.
+   */
+  void onNotifyDataAvailable(folly::AsyncUDPSocket& sock) noexcept override;
+
   // Routing callback
   /**
    * Called when a connecton id is available for a new connection (i.e flow)
@@ -354,6 +394,13 @@ class QuicServerWorker : public folly::AsyncUDPSocket::ReadCallback,
 
   void onReadClosed() noexcept override;
 
+  // folly::AsyncUDPSocket::ErrMessageCallback, only set up to receive the
+  // completions of zerocopy writes.
+  void errMessage(const cmsghdr& cmsg) noexcept override;
+
+  void errMessageError(
+      const folly::AsyncSocketException& ex) noexcept override;
+
   void dispatchPacketData(
       const folly::SocketAddress& client,
       RoutingData&& routingData,
@@ -391,7 +438,8 @@ class QuicServerWorker : public folly::AsyncUDPSocket::ReadCallback,
       const folly::SocketAddress& client,
       Buf data,
       const TimePoint& receiveTime,
-      bool isForwardedData = false) noexcept;
+      bool isForwardedData = false,
+      ECNCodepoint ecn = ECNCodepoint::NotECT) noexcept;
 
   /**
    * Try handling the data as a health check.
@@ -409,6 +457,23 @@ class QuicServerWorker : public folly::AsyncUDPSocket::ReadCallback,
       NetworkData&& networkData,
       bool isForwardedData = false);
 
+  /**
+   * Queue a short header packet so that it is routed together with the other
+   * packets of the current read that belong to the same connection.
+   */
+  void batchPacketData(
+      const folly::SocketAddress& client,
+      RoutingData&& routingData,
+      Buf data,
+      const TimePoint& receiveTime,
+      ECNCodepoint ecn);
+
+  /**
+   * Route the packets queued by batchPacketData(), handing each connection
+   * all of its packets in a single NetworkData.
+   */
+  void flushPendingPacketBatches();
+
   /**
    * Return Infocallback ptr for various transport stats (such as packet
    * received, dropped etc). Since the callback is invoked very frequently and
@@ -454,6 +519,13 @@ class QuicServerWorker : public folly::AsyncUDPSocket::ReadCallback,
   }
 
  private:
+  /**
+   * Applies the ECN and SO_TXTIME options the transport settings ask for to
+   * the listening socket, falling back to pacing with the timer if SO_TXTIME
+   * isn't supported. Called both after bind and after takeover.
+   */
+  void applyTransportSocketOptions(sa_family_t family);
+
   /**
    * Creates accepting socket from this server's listening address.
    * This socket is powered by the same underlying eventbase
@@ -482,6 +554,29 @@ class QuicServerWorker : public folly::AsyncUDPSocket::ReadCallback,
       bool isInitial,
       LongHeaderInvariant& invariant);
 
+  /**
+   * Answers a client Initial with a Retry if it has no valid address
+   * validation token and new connections arrive above the retry rate. Returns
+   * true if a Retry was sent, or the Initial was dropped, instead of creating a
+   * connection. If the Initial answers an earlier Retry, retryOriginalDstConnId
+   * is set to the destination connection id of the client's first Initial.
+   */
+  bool maybeSendRetryPacketOrDrop(
+      const folly::SocketAddress& client,
+      const RoutingData& routingData,
+      const NetworkData& networkData,
+      folly::Optional<ConnectionId>& retryOriginalDstConnId);
+
+  /**
+   * Whether token is a Retry token for client or a NEW_TOKEN token for its
+   * address. For a Retry token, retryOriginalDstConnId is set to the
+   * destination connection id it was issued for.
+   */
+  bool isValidAddressToken(
+      const std::string& token,
+      const folly::SocketAddress& client,
+      folly::Optional<ConnectionId>& retryOriginalDstConnId) const;
+
   /**
    * Helper method to extract and log routing info from the given (dest) connId
    */
@@ -503,12 +598,16 @@ class QuicServerWorker : public folly::AsyncUDPSocket::ReadCallback,
   // A server transport's membership is exclusive to only one of these maps.
   ConnIdToTransportMap connectionIdMap_;
   SrcToTransportMap sourceAddressMap_;
+  // Server-wide view of connectionIdMap_, shared with the other workers.
+  std::shared_ptr<ConnectionIdRoutingTable> connIdRoutingTable_;
 
   // Contains every unique transport that is mapped in connectionIdMap_.
   folly::F14FastMap<QuicServerTransport*, std::weak_ptr<QuicServerTransport>>
       boundServerTransports_;
 
   Buf readBuffer_;
+  // ECN codepoint of the datagram in readBuffer_, if it was read by recvmmsg.
+  ECNCodepoint readEcn_{ECNCodepoint::NotECT};
   bool shutdown_{false};
   std::vector<QuicVersion> supportedVersions_;
   std::shared_ptr<const fizz::server::FizzServerContext> ctx_;
@@ -538,12 +637,49 @@ class QuicServerWorker : public folly::AsyncUDPSocket::ReadCallback,
   // Output buffer to be used for continuous memory GSO write
   std::unique_ptr<BufAccessor> bufAccessor_;
 
+  // Set once SO_TXTIME failed on socket_. Settings set later can't turn
+  // pacingWithTxTime back on, every send would fail with EINVAL.
+  bool txTimeUnsupported_{false};
+
+  // Zerocopy writes on socket_, shared by all the connections of the worker.
+  std::unique_ptr<ZeroCopySendTracker> zeroCopySendTracker_;
+
+  // Stream buffer memory shared by the connections of this worker.
+  std::shared_ptr<BufferMemoryPool> bufferMemoryPool_;
+
   // Rate limits the creation of new connections for this worker.
   std::unique_ptr<RateLimiter> newConnRateLimiter_;
 
+  // Above this rate, new connections have to validate their address with a
+  // Retry first.
+  std::unique_ptr<RateLimiter> retryRateLimiter_;
+  // Created from the token secret of the transport settings, if any, and
+  // shared with the connections for their NEW_TOKEN tokens.
+  std::shared_ptr<TokenGenerator> tokenGenerator_;
+  std::unique_ptr<Aead> retryCipher_;
+
   // EventRecvmsgCallback data
   std::unique_ptr<MsgHdr> msgHdr_;
 
+  // Storage for the recvmmsg based read path.
+  RecvmmsgStorage recvmmsgStorage_;
+#ifdef FOLLY_HAVE_MSG_ERRQUEUE
+  // Control buffers for the UDP_GRO and ECN cmsgs of each recvmmsg message.
+  std::vector<std::array<char, kRecvCmsgSpace>> recvmmsgControl_;
+#endif
+
+  struct PendingPacketBatch {
+    folly::SocketAddress client;
+    RoutingData routingData;
+    NetworkData networkData;
+  };
+  // Short header packets of the read in progress, grouped by client address
+  // and destination connection id.
+  std::vector<PendingPacketBatch> pendingPacketBatches_;
+  // Whether a read is in progress and short header packets should be queued
+  // instead of being routed one at a time.
+  bool batchingPackets_{false};
+
   // Wrapper around list of AcceptObservers to handle cleanup on destruction
   class AcceptObserverList {
    public:
@@ -149,6 +149,24 @@ ServerHandshake::getZeroRttReadHeaderCipher() {
   return std::move(zeroRttReadHeaderCipher_);
 }
 
+void ServerHandshake::handshakeConfirmed() {
+  // Nothing is read at the Initial or Handshake encryption levels any more.
+  initialReadBuf_.move();
+  handshakeReadBuf_.move();
+  handshakeReadCipher_.reset();
+  handshakeWriteCipher_.reset();
+  handshakeReadHeaderCipher_.reset();
+  handshakeWriteHeaderCipher_.reset();
+  if (actionGuard_) {
+    // Fizz still has actions in flight which may mutate the state.
+    return;
+  }
+  // Session tickets are generated from the resumption secret, the transcript
+  // is not needed after the client finished.
+  state_.handshakeContext().reset();
+  state_.handshakeLogging().reset();
+}
+
 /**
  * The application will not get any more callbacks from the handshake layer
  * after this method returns.
@@ -168,6 +168,14 @@ class ServerHandshake : public Handshake {
    */
   std::unique_ptr<PacketNumberCipher> getZeroRttReadHeaderCipher();
 
+  /**
+   * Releases the state that is only needed to complete the handshake: the
+   * Initial and Handshake read buffers and ciphers, and the transcript and
+   * logging of the fizz state. What is needed to write session tickets is
+   * kept.
+   */
+  void handshakeConfirmed() override;
+
   /**
    * The application will not get any more callbacks from the handshake layer
    * after this method returns.
@@ -30,7 +30,10 @@ class ServerTransportParametersExtension : public fizz::ServerExtensions {
       TransportPartialReliabilitySetting partialReliability,
       const StatelessResetToken& token,
       ConnectionId initialSourceCid,
-      ConnectionId originalDestinationCid)
+      ConnectionId originalDestinationCid,
+      uint64_t maxDatagramFrameSize = 0,
+      folly::Optional<std::chrono::microseconds> minAckDelay = folly::none,
+      folly::Optional<ConnectionId> retrySourceCid = folly::none)
       : encodingVersion_(encodingVersion),
         initialMaxData_(initialMaxData),
         initialMaxStreamDataBidiLocal_(initialMaxStreamDataBidiLocal),
@@ -44,7 +47,10 @@ class ServerTransportParametersExtension : public fizz::ServerExtensions {
         partialReliability_(partialReliability),
         token_(token),
         initialSourceCid_(initialSourceCid),
-        originalDestinationCid_(originalDestinationCid) {}
+        originalDestinationCid_(originalDestinationCid),
+        maxDatagramFrameSize_(maxDatagramFrameSize),
+        minAckDelay_(minAckDelay),
+        retrySourceCid_(std::move(retrySourceCid)) {}
 
   ~ServerTransportParametersExtension() override = default;
 
@@ -107,6 +113,24 @@ class ServerTransportParametersExtension : public fizz::ServerExtensions {
       params.parameters.push_back(encodeConnIdParameter(
           TransportParameterId::initial_source_connection_id,
           initialSourceCid_));
+      if (retrySourceCid_) {
+        params.parameters.push_back(encodeConnIdParameter(
+            TransportParameterId::retry_source_connection_id,
+            *retrySourceCid_));
+      }
+    }
+
+    if (maxDatagramFrameSize_ > 0) {
+      params.parameters.push_back(encodeIntegerParameter(
+          TransportParameterId::max_datagram_frame_size,
+          maxDatagramFrameSize_));
+    }
+
+    // MVFST_D24 encodes parameter ids in 16 bits, which min_ack_delay does not
+    // fit in.
+    if (minAckDelay_ && encodingVersion_ != QuicVersion::MVFST_D24) {
+      params.parameters.push_back(encodeIntegerParameter(
+          TransportParameterId::min_ack_delay, minAckDelay_->count()));
     }
 
     exts.push_back(encodeExtension(params, encodingVersion_));
@@ -133,5 +157,9 @@ class ServerTransportParametersExtension : public fizz::ServerExtensions {
   StatelessResetToken token_;
   ConnectionId initialSourceCid_;
   ConnectionId originalDestinationCid_;
+  uint64_t maxDatagramFrameSize_;
+  folly::Optional<std::chrono::microseconds> minAckDelay_;
+  // Source connection id of the Retry we sent, if any.
+  folly::Optional<ConnectionId> retrySourceCid_;
 };
 } // namespace quic
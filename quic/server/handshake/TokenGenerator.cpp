@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/server/handshake/TokenGenerator.h>
+
+#include <folly/io/Cursor.h>
+#include <quic/codec/Decode.h>
+
+namespace {
+constexpr folly::StringPiece kRetryTokenContext{"Retry token"};
+constexpr folly::StringPiece kNewTokenContext{"New token"};
+} // namespace
+
+namespace quic {
+
+TokenGenerator::TokenGenerator(TokenSecret secret)
+    : retryTokenCipher_(std::vector<std::string>({kRetryTokenContext.str()})),
+      newTokenCipher_(std::vector<std::string>({kNewTokenContext.str()})) {
+  std::vector<folly::ByteRange> secrets{folly::range(secret)};
+  CHECK(retryTokenCipher_.setSecrets(secrets))
+      << "Failed to set retry token secret";
+  CHECK(newTokenCipher_.setSecrets(secrets))
+      << "Failed to set new token secret";
+}
+
+folly::Optional<Buf> TokenGenerator::encryptToken(
+    const RetryToken& token) const {
+  return retryTokenCipher_.encrypt(token.getPlaintextToken());
+}
+
+folly::Optional<Buf> TokenGenerator::encryptToken(const NewToken& token) const {
+  return newTokenCipher_.encrypt(token.getPlaintextToken());
+}
+
+folly::Optional<RetryToken> TokenGenerator::decryptRetryToken(
+    Buf encryptedToken) const {
+  auto plaintext = retryTokenCipher_.decrypt(std::move(encryptedToken));
+  if (!plaintext) {
+    return folly::none;
+  }
+  folly::io::Cursor cursor(plaintext->get());
+  auto token = parsePlaintextRetryToken(cursor);
+  if (token.hasError()) {
+    return folly::none;
+  }
+  return std::move(*token);
+}
+
+folly::Optional<NewToken> TokenGenerator::decryptNewToken(
+    Buf encryptedToken) const {
+  auto plaintext = newTokenCipher_.decrypt(std::move(encryptedToken));
+  if (!plaintext) {
+    return folly::none;
+  }
+  folly::io::Cursor cursor(plaintext->get());
+  auto token = parsePlaintextNewToken(cursor);
+  if (token.hasError()) {
+    return folly::none;
+  }
+  return std::move(*token);
+}
+
+bool TokenGenerator::isValidNewToken(
+    const std::string& token,
+    const folly::IPAddress& clientIp) const {
+  auto newToken = decryptNewToken(folly::IOBuf::copyBuffer(token));
+  if (!newToken || newToken->clientIp != clientIp) {
+    return false;
+  }
+  auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::system_clock::now().time_since_epoch());
+  auto age = now - std::chrono::milliseconds(newToken->timestampInMs);
+  return age <= kNewTokenValidity;
+}
+
+} // namespace quic
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#pragma once
+
+#include <fizz/server/AeadTokenCipher.h>
+#include <quic/codec/Types.h>
+
+namespace quic {
+
+using TokenSecret = std::array<uint8_t, kTokenSecretLength>;
+
+/**
+ * Seals the address validation tokens of Retry packets and NEW_TOKEN frames
+ * with keys derived from a secret, so that any server with the secret can
+ * check a token without having kept any state for it. The two kinds of tokens
+ * use different keys, so one can't be passed off as the other.
+ */
+class TokenGenerator {
+ public:
+  explicit TokenGenerator(TokenSecret secret);
+
+  folly::Optional<Buf> encryptToken(const RetryToken& token) const;
+
+  folly::Optional<Buf> encryptToken(const NewToken& token) const;
+
+  /**
+   * Returns the token if it was sealed with our secret and is well formed. It
+   * is up to the caller to check the address and the age of the token.
+   */
+  folly::Optional<RetryToken> decryptRetryToken(Buf encryptedToken) const;
+
+  folly::Optional<NewToken> decryptNewToken(Buf encryptedToken) const;
+
+  /**
+   * Whether token is the contents of a NEW_TOKEN frame we sent to clientIp at
+   * most kNewTokenValidity ago.
+   */
+  bool isValidNewToken(
+      const std::string& token,
+      const folly::IPAddress& clientIp) const;
+
+ private:
+  fizz::server::Aead128GCMTokenCipher retryTokenCipher_;
+  fizz::server::Aead128GCMTokenCipher newTokenCipher_;
+};
+
+} // namespace quic
@@ -404,6 +404,26 @@ TEST_F(ServerHandshakeTest, TestHandshakeSuccessIgnoreNonHandshake) {
   EXPECT_TRUE(handshakeSuccess);
 }
 
+TEST_F(ServerHandshakeTest, TestHandshakeConfirmedReleasesHandshakeState) {
+  clientServerRound();
+  serverClientRound();
+  clientServerRound();
+  EXPECT_EQ(handshake->getPhase(), ServerHandshake::Phase::Established);
+  if (ex) {
+    std::rethrow_exception(ex);
+  }
+  EXPECT_NE(handshake->getState().handshakeContext(), nullptr);
+
+  handshake->handshakeConfirmed();
+  EXPECT_EQ(handshake->getState().handshakeContext(), nullptr);
+  EXPECT_EQ(handshake->getState().handshakeLogging(), nullptr);
+  EXPECT_EQ(handshake->getHandshakeReadCipher(), nullptr);
+  EXPECT_EQ(handshake->getHandshakeWriteCipher(), nullptr);
+  EXPECT_EQ(handshake->getHandshakeReadHeaderCipher(), nullptr);
+  EXPECT_EQ(handshake->getHandshakeWriteHeaderCipher(), nullptr);
+  EXPECT_EQ(handshake->getPhase(), ServerHandshake::Phase::Established);
+}
+
 TEST_F(ServerHandshakeTest, TestMalformedHandshakeMessage) {
   fizz::WriteToSocket write;
   fizz::TLSContent content;
@@ -519,6 +539,24 @@ TEST_F(ServerHandshakeWriteNSTTest, TestWriteNST) {
   EXPECT_TRUE(cache_->getPsk(kTestHostname.str()));
 }
 
+TEST_F(ServerHandshakeWriteNSTTest, TestWriteNSTAfterHandshakeConfirmed) {
+  clientServerRound();
+  serverClientRound();
+  clientServerRound();
+  EXPECT_EQ(handshake->getPhase(), ServerHandshake::Phase::Established);
+  handshake->handshakeConfirmed();
+
+  EXPECT_FALSE(cache_->getPsk(kTestHostname.str()));
+  EXPECT_CALL(*ticketCipher_, _encrypt(_))
+      .WillOnce(Invoke([](fizz::server::ResumptionState&) {
+        return std::make_pair(folly::IOBuf::copyBuffer("appToken"), 100s);
+      }));
+  handshake->writeNewSessionTicket(AppToken());
+  processCryptoEvents();
+  evb.loop();
+  EXPECT_TRUE(cache_->getPsk(kTestHostname.str()));
+}
+
 class ServerHandshakePskTest : public ServerHandshakeTest {
  public:
   ~ServerHandshakePskTest() override = default;
@@ -21,14 +21,14 @@ using namespace fizz::test;
 namespace quic {
 namespace test {
 
-static ClientHello getClientHello() {
+static ClientHello getClientHello(QuicVersion version = QuicVersion::MVFST) {
   auto chlo = TestMessages::clientHello();
 
   ClientTransportParameters clientParams;
   clientParams.parameters.emplace_back(
       CustomIntegralTransportParameter(0xffff, 0xffff).encode());
 
-  chlo.extensions.push_back(encodeExtension(clientParams, QuicVersion::MVFST));
+  chlo.extensions.push_back(encodeExtension(clientParams, version));
 
   return chlo;
 }
@@ -74,5 +74,42 @@ TEST(ServerTransportParametersTest, TestGetExtensionsMissingClientParams) {
       ConnectionId(std::vector<uint8_t>()));
   EXPECT_THROW(ext.getExtensions(TestMessages::clientHello()), FizzException);
 }
+
+TEST(ServerTransportParametersTest, TestGetExtensionsAfterRetry) {
+  ConnectionId originalDstConnId(std::vector<uint8_t>{1, 2, 3, 4});
+  ConnectionId retrySrcConnId(std::vector<uint8_t>{5, 6, 7, 8});
+  ServerTransportParametersExtension ext(
+      QuicVersion::QUIC_DRAFT,
+      kDefaultConnectionWindowSize,
+      kDefaultStreamWindowSize,
+      kDefaultStreamWindowSize,
+      kDefaultStreamWindowSize,
+      std::numeric_limits<uint32_t>::max(),
+      std::numeric_limits<uint32_t>::max(),
+      kDefaultIdleTimeout,
+      kDefaultAckDelayExponent,
+      kDefaultUDPSendPacketLen,
+      kDefaultPartialReliability,
+      generateStatelessResetToken(),
+      ConnectionId(std::vector<uint8_t>{0xff, 0xfe, 0xfd, 0xfc}),
+      originalDstConnId,
+      0 /* maxDatagramFrameSize */,
+      folly::none /* minAckDelay */,
+      retrySrcConnId);
+  auto extensions = ext.getExtensions(getClientHello(QuicVersion::QUIC_DRAFT));
+
+  auto serverParams = getServerExtension(extensions, QuicVersion::QUIC_DRAFT);
+  ASSERT_TRUE(serverParams.has_value());
+  EXPECT_EQ(
+      originalDstConnId,
+      getConnIdParameter(
+          TransportParameterId::original_destination_connection_id,
+          serverParams->parameters));
+  EXPECT_EQ(
+      retrySrcConnId,
+      getConnIdParameter(
+          TransportParameterId::retry_source_connection_id,
+          serverParams->parameters));
+}
 } // namespace test
 } // namespace quic
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/server/handshake/TokenGenerator.h>
+#include <folly/Random.h>
+#include <folly/portability/GTest.h>
+
+using namespace testing;
+
+namespace quic {
+namespace test {
+
+class TokenGeneratorTest : public Test {
+ public:
+  void SetUp() override {
+    folly::Random::secureRandom(secret.data(), secret.size());
+  }
+
+  TokenSecret secret;
+  RetryToken token{
+      ConnectionId({0x14, 0x35, 0x22, 0x11, 0x01, 0x02, 0x03, 0x04}),
+      folly::IPAddress("1.2.3.4"),
+      8080,
+      1234567890123};
+  NewToken newToken{folly::IPAddress("1.2.3.4"), 1234567890123};
+};
+
+TEST_F(TokenGeneratorTest, RoundTrip) {
+  TokenGenerator generator(secret);
+  auto encrypted = generator.encryptToken(token);
+  ASSERT_TRUE(encrypted.has_value());
+  auto decrypted = generator.decryptRetryToken(std::move(*encrypted));
+  ASSERT_TRUE(decrypted.has_value());
+  EXPECT_EQ(decrypted->originalDstConnId, token.originalDstConnId);
+  EXPECT_EQ(decrypted->clientIp, token.clientIp);
+  EXPECT_EQ(decrypted->clientPort, token.clientPort);
+  EXPECT_EQ(decrypted->timestampInMs, token.timestampInMs);
+}
+
+TEST_F(TokenGeneratorTest, SameSecretDifferentGenerator) {
+  TokenGenerator generator1(secret), generator2(secret);
+  auto encrypted = generator1.encryptToken(token);
+  ASSERT_TRUE(encrypted.has_value());
+  auto decrypted = generator2.decryptRetryToken(std::move(*encrypted));
+  ASSERT_TRUE(decrypted.has_value());
+  EXPECT_EQ(decrypted->clientIp, token.clientIp);
+}
+
+TEST_F(TokenGeneratorTest, DifferentSecret) {
+  TokenSecret otherSecret;
+  folly::Random::secureRandom(otherSecret.data(), otherSecret.size());
+  TokenGenerator generator1(secret), generator2(otherSecret);
+  auto encrypted = generator1.encryptToken(token);
+  ASSERT_TRUE(encrypted.has_value());
+  EXPECT_FALSE(generator2.decryptRetryToken(std::move(*encrypted)).has_value());
+}
+
+TEST_F(TokenGeneratorTest, TamperedToken) {
+  TokenGenerator generator(secret);
+  auto encrypted = generator.encryptToken(token);
+  ASSERT_TRUE(encrypted.has_value());
+  auto tampered = (*encrypted)->cloneCoalesced();
+  tampered->writableData()[tampered->length() - 1] ^= 0x01;
+  EXPECT_FALSE(generator.decryptRetryToken(std::move(tampered)).has_value());
+  EXPECT_FALSE(generator.decryptRetryToken(folly::IOBuf::copyBuffer("garbage"))
+                   .has_value());
+}
+
+TEST_F(TokenGeneratorTest, NewTokenRoundTrip) {
+  TokenGenerator generator(secret);
+  auto encrypted = generator.encryptToken(newToken);
+  ASSERT_TRUE(encrypted.has_value());
+  auto decrypted = generator.decryptNewToken(std::move(*encrypted));
+  ASSERT_TRUE(decrypted.has_value());
+  EXPECT_EQ(decrypted->clientIp, newToken.clientIp);
+  EXPECT_EQ(decrypted->timestampInMs, newToken.timestampInMs);
+}
+
+TEST_F(TokenGeneratorTest, TokenKindsDontMix) {
+  TokenGenerator generator(secret);
+  auto encryptedRetryToken = generator.encryptToken(token);
+  ASSERT_TRUE(encryptedRetryToken.has_value());
+  EXPECT_FALSE(generator.decryptNewToken(std::move(*encryptedRetryToken))
+                   .has_value());
+  auto encryptedNewToken = generator.encryptToken(newToken);
+  ASSERT_TRUE(encryptedNewToken.has_value());
+  EXPECT_FALSE(generator.decryptRetryToken(std::move(*encryptedNewToken))
+                   .has_value());
+}
+
+} // namespace test
+} // namespace quic
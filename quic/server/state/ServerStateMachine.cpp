@@ -16,6 +16,8 @@
 #include <quic/flowcontrol/QuicFlowController.h>
 #include <quic/handshake/TransportParameters.h>
 #include <quic/logging/QLoggerConstants.h>
+#include <quic/server/handshake/TokenGenerator.h>
+#include <quic/state/DatagramHandlers.h>
 #include <quic/state/QuicPacingFunctions.h>
 #include <quic/state/QuicStreamFunctions.h>
 #include <quic/state/QuicTransportStatsCallback.h>
@@ -133,6 +135,10 @@ void processClientInitialParams(
   auto activeConnectionIdLimit = getIntegerParameter(
       TransportParameterId::active_connection_id_limit,
       clientParams.parameters);
+  auto maxDatagramFrameSize = getIntegerParameter(
+      TransportParameterId::max_datagram_frame_size, clientParams.parameters);
+  auto minAckDelay = getIntegerParameter(
+      TransportParameterId::min_ack_delay, clientParams.parameters);
   auto d6dBasePMTU = getIntegerParameter(
       static_cast<TransportParameterId>(kD6DBasePMTUParameterId),
       clientParams.parameters);
@@ -207,6 +213,15 @@ void processClientInitialParams(
   conn.peerActiveConnectionIdLimit =
       activeConnectionIdLimit.value_or(kDefaultActiveConnectionIdLimit);
 
+  // A zero or absent max_datagram_frame_size means the client does not accept
+  // DATAGRAM frames.
+  conn.datagramState.maxWriteFrameSize = maxDatagramFrameSize.value_or(0);
+
+  if (minAckDelay) {
+    conn.ackFrequencyState.peerMinAckDelay =
+        std::chrono::microseconds(*minAckDelay);
+  }
+
   if (partialReliability && *partialReliability != 0 &&
       conn.transportSettings.partialReliabilityEnabled) {
     conn.partialReliabilityEnabled = true;
@@ -340,7 +355,44 @@ void updateHandshakeState(QuicServerConnectionState& conn) {
       sendSimpleFrame(conn, HandshakeDoneFrame());
       conn.sentHandshakeDone = true;
     }
+    if (!conn.sentNewToken) {
+      maybeSendNewToken(conn);
+      conn.sentNewToken = true;
+    }
+  }
+}
+
+void maybeSendNewToken(QuicServerConnectionState& conn) {
+  if (!conn.transportSettings.tokenSecret || !conn.tokenGenerator) {
+    return;
+  }
+  auto timestampInMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                           std::chrono::system_clock::now().time_since_epoch())
+                           .count();
+  NewToken newToken(conn.peerAddress.getIPAddress(), timestampInMs);
+  auto encryptedToken = conn.tokenGenerator->encryptToken(newToken);
+  if (!encryptedToken) {
+    LOG(ERROR) << "Failed to encrypt new token " << conn;
+    return;
+  }
+  sendSimpleFrame(
+      conn,
+      NewTokenFrame((*encryptedToken)->moveToFbString().toStdString()));
+}
+
+bool validateNewToken(
+    QuicServerConnectionState& conn,
+    const std::string& token) {
+  if (token.empty() || !conn.transportSettings.tokenSecret ||
+      !conn.tokenGenerator) {
+    return false;
+  }
+  bool valid = conn.tokenGenerator->isValidNewToken(
+      token, conn.peerAddress.getIPAddress());
+  if (valid) {
+    conn.isClientAddrVerified = true;
   }
+  return valid;
 }
 
 bool validateAndUpdateSourceToken(
@@ -367,15 +419,21 @@ bool validateAndUpdateSourceToken(
     }
     sourceAddresses.push_back(conn.peerAddress.getIPAddress());
 
-    switch (conn.transportSettings.zeroRttSourceTokenMatchingPolicy) {
-      case ZeroRttSourceTokenMatchingPolicy::REJECT_IF_NO_EXACT_MATCH:
-        acceptZeroRtt = false;
-        break;
-      case ZeroRttSourceTokenMatchingPolicy::LIMIT_IF_NO_EXACT_MATCH:
-        acceptZeroRtt = true;
-        conn.writableBytesLimit =
-            conn.transportSettings.limitedCwndInMss * conn.udpSendPacketLen;
-        break;
+    // The client already proved it owns the address with a NEW_TOKEN token,
+    // so its 0-RTT data needs no limit.
+    if (conn.isClientAddrVerified) {
+      acceptZeroRtt = true;
+    } else {
+      switch (conn.transportSettings.zeroRttSourceTokenMatchingPolicy) {
+        case ZeroRttSourceTokenMatchingPolicy::REJECT_IF_NO_EXACT_MATCH:
+          acceptZeroRtt = false;
+          break;
+        case ZeroRttSourceTokenMatchingPolicy::LIMIT_IF_NO_EXACT_MATCH:
+          acceptZeroRtt = true;
+          conn.writableBytesLimit =
+              conn.transportSettings.limitedCwndInMss * conn.udpSendPacketLen;
+          break;
+      }
     }
   }
   // Save the source token so that it can be written to client via NST later
@@ -563,7 +621,9 @@ void handleCipherUnavailable(
     ServerEvents::ReadData pendingReadData;
     pendingReadData.peer = readData.peer;
     pendingReadData.networkData = NetworkDataSingle(
-        std::move(originalData->packet), readData.networkData.receiveTimePoint);
+        std::move(originalData->packet),
+        readData.networkData.receiveTimePoint,
+        readData.networkData.ecn);
     pendingData->emplace_back(std::move(pendingReadData));
     VLOG(10) << "Adding pending data to "
              << toString(originalData->protectionType)
@@ -648,6 +708,16 @@ void onServerReadDataFromOpen(
     CHECK(newServerConnIdData.has_value());
     conn.serverConnectionId = newServerConnIdData->connId;
 
+    // After a Retry this Initial was sent to the source connection id of the
+    // Retry, and the client's first Initial to the one in the Retry token.
+    auto originalDestinationConnectionId = initialDestinationConnectionId;
+    folly::Optional<ConnectionId> retrySourceConnectionId;
+    if (conn.retryOriginalDestinationConnectionId) {
+      originalDestinationConnectionId =
+          *conn.retryOriginalDestinationConnectionId;
+      retrySourceConnectionId = initialDestinationConnectionId;
+    }
+
     QUIC_STATS(conn.statsCallback, onStatelessReset);
     conn.serverHandshakeLayer->accept(
         std::make_shared<ServerTransportParametersExtension>(
@@ -664,7 +734,10 @@ void onServerReadDataFromOpen(
             conn.transportSettings.partialReliabilityEnabled,
             *newServerConnIdData->token,
             conn.serverConnectionId.value(),
-            initialDestinationConnectionId));
+            originalDestinationConnectionId,
+            conn.datagramState.maxReadFrameSize,
+            conn.transportSettings.minAckDelay,
+            std::move(retrySourceConnectionId)));
     conn.transportParametersEncoded = true;
     const CryptoFactory& cryptoFactory =
         conn.serverHandshakeLayer->getCryptoFactory();
@@ -800,6 +873,9 @@ void onServerReadDataFromOpen(
       if (conn.version == QuicVersion::MVFST_EXPERIMENTAL) {
         setExperimentalSettings(conn);
       }
+      if (longHeader->getHeaderType() == LongHeader::Types::Initial) {
+        validateNewToken(conn, longHeader->getToken());
+      }
     }
 
     if (conn.peerAddress != readData.peer) {
@@ -1071,6 +1147,22 @@ void onServerReadDataFromOpen(
               conn, simpleFrame, packetNum, readData.peer != conn.peerAddress);
           break;
         }
+        case QuicFrame::Type::DatagramFrame_E: {
+          DatagramFrame& frame = *quicFrame.asDatagramFrame();
+          VLOG(10) << "Server received datagram len=" << frame.length << " "
+                   << conn;
+          isNonProbingPacket = true;
+          // Datagrams are not retransmitted, but they are ack-eliciting.
+          pktHasRetransmittableData = true;
+          handleDatagram(conn, frame, readData.networkData.receiveTimePoint);
+          break;
+        }
+        case QuicFrame::Type::ReadNewTokenFrame_E: {
+          throw QuicTransportException(
+              "Received NEW_TOKEN from client.",
+              TransportErrorCode::PROTOCOL_VIOLATION,
+              FrameType::NEW_TOKEN);
+        }
         default: {
           break;
         }
@@ -1079,6 +1171,7 @@ void onServerReadDataFromOpen(
 
     if (handshakeConfirmedThisLoop) {
       handshakeConfirmed(conn);
+      conn.serverHandshakeLayer->handshakeConfirmed();
     }
 
     // Update writable limit before processing the handshake data. This is so
@@ -1145,6 +1238,7 @@ void onServerReadDataFromOpen(
         outOfOrder,
         pktHasRetransmittableData,
         pktHasCryptoData);
+    updateEcnCountsOnRecvPacket(ackState, readData.networkData.ecn);
     if (encryptionLevel == EncryptionLevel::Handshake &&
         conn.version != QuicVersion::MVFST_D24 && conn.initialWriteCipher) {
       conn.initialWriteCipher.reset();
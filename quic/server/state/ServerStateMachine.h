@@ -41,6 +41,8 @@
 
 namespace quic {
 
+class TokenGenerator;
+
 enum ServerState {
   Open,
   Closed,
@@ -109,6 +111,10 @@ struct QuicServerConnectionState : public QuicConnectionStateBase {
   // ServerConnectionIdRejector can reject a ConnectionId from ConnectionIdAlgo
   ServerConnectionIdRejector* connIdRejector{nullptr};
 
+  // Generates and validates NEW_TOKEN tokens, shared with the other
+  // connections of the worker.
+  std::shared_ptr<TokenGenerator> tokenGenerator;
+
   // Source address token that can be saved to client via PSK.
   // Address with higher index is more recently used.
   std::vector<folly::IPAddress> tokenSourceAddresses;
@@ -124,12 +130,23 @@ struct QuicServerConnectionState : public QuicConnectionStateBase {
   // limited until CFIN depending on matching policy.
   folly::Optional<bool> sourceTokenMatching;
 
+  // Destination connection id of the client's first Initial, from the token
+  // of the Retry we sent it. Only set if the client was sent a Retry.
+  folly::Optional<ConnectionId> retryOriginalDestinationConnectionId;
+
   // Server address of VIP. Currently used as input for stateless reset token.
   folly::SocketAddress serverAddr;
 
   // Whether we've sent the handshake done signal yet.
   bool sentHandshakeDone{false};
 
+  // Whether we've given the client a token for its next connection yet.
+  bool sentNewToken{false};
+
+  // Whether the client's first Initial carried a valid NEW_TOKEN token, which
+  // validates its address before the handshake completes.
+  bool isClientAddrVerified{false};
+
 #ifdef CCP_ENABLED
   // Pointer to struct that maintains state needed for interacting with libccp.
   // Once instance of this struct is created for each instance of
@@ -205,6 +222,21 @@ bool validateAndUpdateSourceToken(
 
 void updateWritableByteLimitOnRecvPacket(QuicServerConnectionState& conn);
 
+/**
+ * Queues a NEW_TOKEN frame with a token that validates the client's current
+ * address in its next connections, if the server has a token secret.
+ */
+void maybeSendNewToken(QuicServerConnectionState& conn);
+
+/**
+ * Checks the token of the client's first Initial and sets
+ * isClientAddrVerified if it is a valid NEW_TOKEN token. An invalid token
+ * never clears an address that was already verified.
+ */
+bool validateNewToken(
+    QuicServerConnectionState& conn,
+    const std::string& token);
+
 void updateTransportParamsFromTicket(
     QuicServerConnectionState& conn,
     uint64_t idleTimeout,
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/server/ConnectionIdRoutingTable.h>
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <quic/common/test/TestUtils.h>
+
+using namespace testing;
+
+namespace quic {
+namespace test {
+
+TEST(ConnectionIdRoutingTableTest, InsertFindErase) {
+  ConnectionIdRoutingTable table;
+  auto cid1 = getTestConnectionId(1);
+  auto cid2 = getTestConnectionId(2);
+  EXPECT_FALSE(table.find(cid1).has_value());
+
+  EXPECT_TRUE(table.insert(cid1, 3));
+  EXPECT_TRUE(table.insert(cid2, 4));
+  EXPECT_EQ(2, table.size());
+  EXPECT_EQ(3, *table.find(cid1));
+  EXPECT_EQ(4, *table.find(cid2));
+
+  EXPECT_TRUE(table.erase(cid1, 3));
+  EXPECT_FALSE(table.find(cid1).has_value());
+  EXPECT_EQ(4, *table.find(cid2));
+  EXPECT_FALSE(table.erase(cid1, 3));
+  EXPECT_EQ(1, table.size());
+}
+
+TEST(ConnectionIdRoutingTableTest, DuplicateInsertKeepsOwner) {
+  ConnectionIdRoutingTable table;
+  auto cid = getTestConnectionId(1);
+  EXPECT_TRUE(table.insert(cid, 1));
+  EXPECT_FALSE(table.insert(cid, 2));
+  EXPECT_EQ(1, *table.find(cid));
+}
+
+TEST(ConnectionIdRoutingTableTest, EraseByOtherWorker) {
+  ConnectionIdRoutingTable table;
+  auto cid = getTestConnectionId(1);
+  EXPECT_TRUE(table.insert(cid, 1));
+  // Only the owner can remove the id.
+  EXPECT_FALSE(table.erase(cid, 2));
+  EXPECT_EQ(1, *table.find(cid));
+  EXPECT_TRUE(table.erase(cid, 1));
+}
+
+TEST(ConnectionIdRoutingTableTest, ConcurrentReadersAndWriters) {
+  ConnectionIdRoutingTable table;
+  constexpr uint8_t kNumWorkers = 4;
+  constexpr uint16_t kIdsPerWorker = 500;
+  std::atomic<bool> done{false};
+  std::atomic<size_t> wrongOwner{0};
+
+  auto makeId = [](uint8_t workerId, uint16_t i) {
+    return ConnectionId(std::vector<uint8_t>{
+        workerId,
+        static_cast<uint8_t>(i >> 8),
+        static_cast<uint8_t>(i & 0xff),
+        0,
+        0,
+        0,
+        0,
+        0});
+  };
+
+  std::vector<std::thread> readers;
+  for (uint8_t r = 0; r < 2; r++) {
+    readers.emplace_back([&] {
+      while (!done) {
+        for (uint8_t w = 0; w < kNumWorkers; w++) {
+          auto owner = table.find(makeId(w, kIdsPerWorker / 2));
+          if (owner && *owner != w) {
+            wrongOwner++;
+          }
+        }
+      }
+    });
+  }
+  std::vector<std::thread> writers;
+  for (uint8_t w = 0; w < kNumWorkers; w++) {
+    writers.emplace_back([&, w] {
+      for (uint16_t i = 0; i < kIdsPerWorker; i++) {
+        table.insert(makeId(w, i), w);
+      }
+      for (uint16_t i = 0; i < kIdsPerWorker; i += 2) {
+        table.erase(makeId(w, i), w);
+      }
+    });
+  }
+  for (auto& writer : writers) {
+    writer.join();
+  }
+  done = true;
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(0, wrongOwner);
+  EXPECT_EQ(kNumWorkers * kIdsPerWorker / 2, table.size());
+  EXPECT_EQ(2, *table.find(makeId(2, 1)));
+  EXPECT_FALSE(table.find(makeId(2, 0)).has_value());
+}
+
+} // namespace test
+} // namespace quic
@@ -7,6 +7,7 @@
  */
 
 #include <quic/server/QuicServer.h>
+#include <folly/Random.h>
 #include <folly/futures/Promise.h>
 #include <folly/io/IOBuf.h>
 #include <folly/io/async/test/MockAsyncUDPSocket.h>
@@ -14,6 +15,7 @@
 #include <folly/portability/GTest.h>
 #include <quic/api/test/MockQuicSocket.h>
 #include <quic/api/test/Mocks.h>
+#include <quic/codec/Decode.h>
 #include <quic/codec/DefaultConnectionIdAlgo.h>
 #include <quic/codec/QuicHeaderCodec.h>
 #include <quic/codec/test/Mocks.h>
@@ -112,6 +114,59 @@ TEST_F(SimpleQuicServerWorkerTest, RejectCid) {
   EXPECT_FALSE(worker_->rejectConnectionId(excludeCid));
 }
 
+TEST_F(SimpleQuicServerWorkerTest, SharedRoutingTable) {
+  folly::SocketAddress addr("::1", 0);
+  auto mockSock =
+      std::make_unique<folly::test::MockAsyncUDPSocket>(&eventbase_);
+  EXPECT_CALL(*mockSock, address()).WillRepeatedly(ReturnRef(addr));
+  MockConnectionCallback mockConnectionCallback;
+  MockQuicTransport::Ptr transportPtr = std::make_shared<MockQuicTransport>(
+      &eventbase_, std::move(mockSock), mockConnectionCallback, nullptr);
+  auto routingTable = std::make_shared<ConnectionIdRoutingTable>();
+  workerCb_ = std::make_shared<NiceMock<MockWorkerCallback>>();
+  worker_ = std::make_unique<QuicServerWorker>(workerCb_);
+  worker_->setWorkerId(1);
+  worker_->setConnectionIdRoutingTable(routingTable);
+  auto otherWorker = std::make_unique<QuicServerWorker>(workerCb_);
+  otherWorker->setWorkerId(2);
+  otherWorker->setConnectionIdRoutingTable(routingTable);
+
+  auto cid = getTestConnectionId(0);
+  worker_->onConnectionIdAvailable(transportPtr, cid);
+  EXPECT_EQ(1, *routingTable->find(cid));
+  // The id is owned by another worker, it can't be issued again.
+  EXPECT_TRUE(otherWorker->rejectConnectionId(cid));
+
+  QuicServerTransport::SourceIdentity sourceId(addr, cid);
+  std::vector<ConnectionIdData> cidDataVec;
+  cidDataVec.emplace_back(cid, 0);
+  EXPECT_CALL(*transportPtr, setRoutingCallback(nullptr)).Times(1);
+  worker_->onConnectionUnbound(transportPtr.get(), sourceId, cidDataVec);
+  EXPECT_FALSE(routingTable->find(cid).has_value());
+  EXPECT_FALSE(otherWorker->rejectConnectionId(cid));
+}
+
+TEST_F(SimpleQuicServerWorkerTest, BufferMemoryPool) {
+  workerCb_ = std::make_shared<NiceMock<MockWorkerCallback>>();
+  worker_ = std::make_unique<QuicServerWorker>(workerCb_);
+  TransportSettings settings;
+  worker_->setTransportSettings(settings);
+  EXPECT_EQ(nullptr, worker_->getBufferMemoryPool());
+
+  settings.workerBufferMemoryLimit = 1000;
+  worker_->setTransportSettings(settings);
+  auto pool = worker_->getBufferMemoryPool();
+  ASSERT_NE(nullptr, pool);
+  EXPECT_EQ(1000, pool->limit());
+  // Unchanged limit keeps the pool the connections are charging.
+  worker_->setTransportSettings(settings);
+  EXPECT_EQ(pool, worker_->getBufferMemoryPool());
+
+  settings.workerBufferMemoryLimit = 0;
+  worker_->setTransportSettings(settings);
+  EXPECT_EQ(nullptr, worker_->getBufferMemoryPool());
+}
+
 TEST_F(SimpleQuicServerWorkerTest, TurnOffPMTU) {
   auto sock =
       std::make_unique<NiceMock<folly::test::MockAsyncUDPSocket>>(&eventbase_);
@@ -464,6 +519,93 @@ TEST_F(QuicServerWorkerTest, RateLimit) {
   eventbase_.loop();
 }
 
+TEST_F(QuicServerWorkerTest, RetryAboveRate) {
+  TransportSettings settings;
+  settings.statelessResetTokenSecret = getRandSecret();
+  settings.tokenSecret = TokenSecret();
+  folly::Random::secureRandom(
+      settings.tokenSecret->data(), settings.tokenSecret->size());
+  worker_->setTransportSettings(settings);
+  // Every new connection without a token has to retry.
+  worker_->setRetryRateLimiter(
+      std::make_unique<SlidingWindowRateLimiter>(0, 60s));
+
+  auto makeInitial = [](ConnectionId srcConnId,
+                        ConnectionId dstConnId,
+                        const std::string& token) {
+    LongHeader header(
+        LongHeader::Types::Initial,
+        srcConnId,
+        dstConnId,
+        1,
+        QuicVersion::MVFST,
+        token);
+    RegularQuicPacketBuilder builder(
+        kDefaultUDPSendPacketLen, std::move(header), 0 /* largestAcked */);
+    builder.encodePacketHeader();
+    auto packet = packetToBuf(std::move(builder).buildPacket());
+    packet->prependChain(createData(kMinInitialPacketSize));
+    packet->coalesce();
+    return packet;
+  };
+
+  auto clientConnId = getTestConnectionId(0);
+  auto initialDstConnId = getTestConnectionId(1);
+  Buf retryPacket;
+  EXPECT_CALL(*transportInfoCb_, onRetryPacketSent()).Times(1);
+  EXPECT_CALL(*factory_, _make(_, _, _, _)).Times(0);
+  EXPECT_CALL(*socketPtr_, write(kClientAddr, _))
+      .WillOnce(Invoke([&](auto, const std::unique_ptr<folly::IOBuf>& buf) {
+        retryPacket = buf->clone();
+        return buf->computeChainDataLength();
+      }));
+  worker_->handleNetworkData(
+      kClientAddr,
+      makeInitial(clientConnId, initialDstConnId, ""),
+      Clock::now());
+  eventbase_.loop();
+  ASSERT_TRUE(retryPacket);
+
+  folly::io::Cursor cursor(retryPacket.get());
+  auto initialByte = cursor.readBE<uint8_t>();
+  EXPECT_EQ(parseLongHeaderType(initialByte), LongHeader::Types::Retry);
+  auto parsedRetry = parseLongHeader(initialByte, cursor);
+  ASSERT_TRUE(parsedRetry.hasValue());
+  const auto& retryHeader = parsedRetry->parsedLongHeader->header;
+  EXPECT_EQ(retryHeader.getDestinationConnId(), clientConnId);
+  EXPECT_FALSE(retryHeader.getToken().empty());
+  Mock::VerifyAndClearExpectations(factory_.get());
+  Mock::VerifyAndClearExpectations(transportInfoCb_);
+
+  // The Initial with the token creates the connection, without another Retry.
+  EXPECT_CALL(*transportInfoCb_, onRetryPacketSent()).Times(0);
+  expectConnectionCreation(kClientAddr, retryHeader.getSourceConnId());
+  worker_->handleNetworkData(
+      kClientAddr,
+      makeInitial(
+          clientConnId,
+          retryHeader.getSourceConnId(),
+          retryHeader.getToken()),
+      Clock::now());
+  eventbase_.loop();
+
+  // The token is only good for the address it was issued to.
+  auto otherAddr = folly::SocketAddress("2.3.4.5", 1234);
+  EXPECT_CALL(*transportInfoCb_, onRetryPacketSent()).Times(1);
+  EXPECT_CALL(*socketPtr_, write(otherAddr, _))
+      .WillOnce(Invoke([](auto, const std::unique_ptr<folly::IOBuf>& buf) {
+        return buf->computeChainDataLength();
+      }));
+  worker_->handleNetworkData(
+      otherAddr,
+      makeInitial(
+          clientConnId,
+          retryHeader.getSourceConnId(),
+          retryHeader.getToken()),
+      Clock::now());
+  eventbase_.loop();
+}
+
 TEST_F(QuicServerWorkerTest, QuicServerWorkerUnbindBeforeCidAvailable) {
   NiceMock<MockConnectionCallback> connCb;
   auto mockSock =
@@ -1106,6 +1248,244 @@ TEST_F(QuicServerWorkerTest, AcceptObserverRemoveCallbackThenDestroyWorker) {
   worker_ = nullptr;
 }
 
+TEST_F(QuicServerWorkerTest, RecvmmsgBatchRead) {
+  TransportSettings settings;
+  settings.statelessResetTokenSecret = getRandSecret();
+  settings.shouldRecvBatch = true;
+  settings.shouldUseRecvmmsgForBatchRecv = true;
+  settings.maxRecvBatchSize = 4;
+  worker_->setTransportSettings(settings);
+  EXPECT_TRUE(worker_->shouldOnlyNotify());
+
+  const int numDatagrams = 3;
+  auto data = folly::IOBuf::copyBuffer("garbage");
+  EXPECT_CALL(*socketPtr_, address()).WillRepeatedly(ReturnRef(fakeAddress_));
+  EXPECT_CALL(*socketPtr_, recvmmsg(_, 4, _, nullptr))
+      .WillOnce(Invoke([&](struct mmsghdr* msgs,
+                           unsigned int,
+                           unsigned int,
+                           struct timespec*) {
+        for (int i = 0; i < numDatagrams; i++) {
+          auto& msg = msgs[i].msg_hdr;
+          EXPECT_GE(msg.msg_iov->iov_len, data->length());
+          memcpy(msg.msg_iov->iov_base, data->data(), data->length());
+          msgs[i].msg_len = data->length();
+          msg.msg_namelen = kClientAddr.getAddress(
+              reinterpret_cast<sockaddr_storage*>(msg.msg_name));
+        }
+        return numDatagrams;
+      }));
+  EXPECT_CALL(*transportInfoCb_, onPacketReceived()).Times(numDatagrams);
+  EXPECT_CALL(*transportInfoCb_, onRead(data->length())).Times(numDatagrams);
+  EXPECT_CALL(
+      *transportInfoCb_, onPacketDropped(PacketDropReason::PARSE_ERROR))
+      .Times(numDatagrams);
+  worker_->onNotifyDataAvailable(*socketPtr_);
+}
+
+TEST_F(QuicServerWorkerTest, BatchPacketsPerConnection) {
+  TransportSettings settings;
+  settings.statelessResetTokenSecret = getRandSecret();
+  settings.shouldRecvBatch = true;
+  settings.shouldUseRecvmmsgForBatchRecv = true;
+  settings.maxRecvBatchSize = 4;
+  worker_->setTransportSettings(settings);
+  EXPECT_CALL(*socketPtr_, address()).WillRepeatedly(ReturnRef(fakeAddress_));
+
+  auto connId1 = getTestConnectionId(hostId_);
+  auto connId2 = connId1;
+  connId2.data()[7] ^= 0x1;
+  auto makeShortHeaderPacket = [](const ConnectionId& connId) {
+    auto buf = folly::IOBuf::copyBuffer("\x40");
+    buf->prependChain(folly::IOBuf::copyBuffer(connId.data(), connId.size()));
+    buf->prependChain(folly::IOBuf::copyBuffer("payload"));
+    buf->coalesce();
+    return buf;
+  };
+  std::vector<Buf> packets;
+  packets.push_back(makeShortHeaderPacket(connId1));
+  packets.push_back(makeShortHeaderPacket(connId2));
+  packets.push_back(makeShortHeaderPacket(connId1));
+
+  EXPECT_CALL(*socketPtr_, recvmmsg(_, 4, _, nullptr))
+      .WillOnce(Invoke([&](struct mmsghdr* msgs,
+                           unsigned int,
+                           unsigned int,
+                           struct timespec*) {
+        for (size_t i = 0; i < packets.size(); i++) {
+          auto& msg = msgs[i].msg_hdr;
+          memcpy(
+              msg.msg_iov->iov_base, packets[i]->data(), packets[i]->length());
+          msgs[i].msg_len = packets[i]->length();
+          msg.msg_namelen = kClientAddr.getAddress(
+              reinterpret_cast<sockaddr_storage*>(msg.msg_name));
+        }
+        return static_cast<int>(packets.size());
+      }));
+  // The packets of connId1 are delivered together, ahead of connId2 since
+  // its first packet was read first.
+  InSequence s;
+  EXPECT_CALL(*workerCb_, routeDataToWorkerShort(kClientAddr, _, _, false))
+      .WillOnce(Invoke([&](auto&, auto& routingData, auto& networkData, auto) {
+        EXPECT_EQ(routingData->destinationConnId, connId1);
+        ASSERT_EQ(networkData->packets.size(), 2);
+        EXPECT_EQ(networkData->totalData, packets[0]->length() * 2);
+        folly::IOBufEqualTo eq;
+        EXPECT_TRUE(eq(*networkData->packets[0], *packets[0]));
+        EXPECT_TRUE(eq(*networkData->packets[1], *packets[2]));
+      }));
+  EXPECT_CALL(*workerCb_, routeDataToWorkerShort(kClientAddr, _, _, false))
+      .WillOnce(Invoke([&](auto&, auto& routingData, auto& networkData, auto) {
+        EXPECT_EQ(routingData->destinationConnId, connId2);
+        EXPECT_EQ(networkData->packets.size(), 1);
+      }));
+  worker_->onNotifyDataAvailable(*socketPtr_);
+}
+
+TEST_F(QuicServerWorkerTest, ReadEcnUsesRecvmmsg) {
+  TransportSettings settings;
+  settings.statelessResetTokenSecret = getRandSecret();
+  worker_->setTransportSettings(settings);
+  EXPECT_FALSE(worker_->shouldOnlyNotify());
+  settings.readEcnOnIngress = true;
+  worker_->setTransportSettings(settings);
+  EXPECT_TRUE(worker_->shouldOnlyNotify());
+}
+
+TEST_F(QuicServerWorkerTest, TxTimeFallbackIsSticky) {
+  TransportSettings settings;
+  settings.statelessResetTokenSecret = getRandSecret();
+  settings.pacingEnabled = true;
+  settings.pacingWithTxTime = true;
+  worker_->setTransportSettings(settings);
+  EXPECT_CALL(*socketPtr_, address()).WillRepeatedly(ReturnRef(kClientAddr));
+  // The mock socket has no fd, so SO_TXTIME fails on the takeover path too.
+  worker_->applyAllSocketOptions();
+  EXPECT_FALSE(worker_->getTransportSettings().pacingWithTxTime);
+  // Settings set after the socket is set up can't turn it back on.
+  worker_->setTransportSettings(settings);
+  EXPECT_FALSE(worker_->getTransportSettings().pacingWithTxTime);
+  EXPECT_TRUE(worker_->getTransportSettings().pacingEnabled);
+}
+
+TEST_F(QuicServerWorkerTest, TakeoverAppliesEcnSocketOptions) {
+#if defined(IP_RECVTOS) && defined(IPV6_RECVTCLASS)
+  TransportSettings settings;
+  settings.statelessResetTokenSecret = getRandSecret();
+  settings.readEcnOnIngress = true;
+  worker_->setTransportSettings(settings);
+  // A socket bound by another process, as handed over on takeover.
+  auto sock = std::make_unique<folly::AsyncUDPSocket>(&eventbase_);
+  sock->bind(folly::SocketAddress("127.0.0.1", 0));
+  auto fd = sock->getNetworkSocket();
+  worker_->setSocket(std::move(sock));
+  worker_->applyAllSocketOptions();
+  int recvTos = 0;
+  socklen_t len = sizeof(recvTos);
+  ASSERT_EQ(
+      0, folly::netops::getsockopt(fd, IPPROTO_IP, IP_RECVTOS, &recvTos, &len));
+  EXPECT_EQ(1, recvTos);
+#else
+  GTEST_SKIP() << "IP_RECVTOS not supported";
+#endif
+}
+
+#ifdef FOLLY_HAVE_MSG_ERRQUEUE
+TEST_F(QuicServerWorkerTest, BatchKeepsEcnOfFirstPacket) {
+  TransportSettings settings;
+  settings.statelessResetTokenSecret = getRandSecret();
+  settings.shouldRecvBatch = true;
+  settings.shouldUseRecvmmsgForBatchRecv = true;
+  settings.maxRecvBatchSize = 4;
+  settings.readEcnOnIngress = true;
+  worker_->setTransportSettings(settings);
+  EXPECT_CALL(*socketPtr_, address()).WillRepeatedly(ReturnRef(fakeAddress_));
+
+  auto connId1 = getTestConnectionId(hostId_);
+  auto connId2 = connId1;
+  connId2.data()[7] ^= 0x1;
+  auto makeShortHeaderPacket = [](const ConnectionId& connId) {
+    auto buf = folly::IOBuf::copyBuffer("\x40");
+    buf->prependChain(folly::IOBuf::copyBuffer(connId.data(), connId.size()));
+    buf->prependChain(folly::IOBuf::copyBuffer("payload"));
+    buf->coalesce();
+    return buf;
+  };
+  // A single datagram for each connection, so each one starts a batch.
+  std::vector<Buf> packets;
+  packets.push_back(makeShortHeaderPacket(connId1));
+  packets.push_back(makeShortHeaderPacket(connId2));
+  std::vector<ECNCodepoint> marks = {ECNCodepoint::ECT0, ECNCodepoint::CE};
+
+  EXPECT_CALL(*socketPtr_, recvmmsg(_, 4, _, nullptr))
+      .WillOnce(Invoke([&](struct mmsghdr* msgs,
+                           unsigned int,
+                           unsigned int,
+                           struct timespec*) {
+        for (size_t i = 0; i < packets.size(); i++) {
+          auto& msg = msgs[i].msg_hdr;
+          memcpy(
+              msg.msg_iov->iov_base, packets[i]->data(), packets[i]->length());
+          msgs[i].msg_len = packets[i]->length();
+          msg.msg_namelen = kClientAddr.getAddress(
+              reinterpret_cast<sockaddr_storage*>(msg.msg_name));
+          EXPECT_GE(msg.msg_controllen, CMSG_SPACE(sizeof(uint8_t)));
+          auto cmsg = CMSG_FIRSTHDR(&msg);
+          cmsg->cmsg_level = IPPROTO_IP;
+          cmsg->cmsg_type = IP_TOS;
+          cmsg->cmsg_len = CMSG_LEN(sizeof(uint8_t));
+          *CMSG_DATA(cmsg) = static_cast<uint8_t>(marks[i]);
+          msg.msg_controllen = CMSG_SPACE(sizeof(uint8_t));
+        }
+        return static_cast<int>(packets.size());
+      }));
+  InSequence s;
+  EXPECT_CALL(*workerCb_, routeDataToWorkerShort(kClientAddr, _, _, false))
+      .WillOnce(Invoke([&](auto&, auto& routingData, auto& networkData, auto) {
+        EXPECT_EQ(routingData->destinationConnId, connId1);
+        ASSERT_EQ(networkData->packets.size(), 1);
+        EXPECT_EQ(networkData->getEcnMark(0), ECNCodepoint::ECT0);
+      }));
+  EXPECT_CALL(*workerCb_, routeDataToWorkerShort(kClientAddr, _, _, false))
+      .WillOnce(Invoke([&](auto&, auto& routingData, auto& networkData, auto) {
+        EXPECT_EQ(routingData->destinationConnId, connId2);
+        ASSERT_EQ(networkData->packets.size(), 1);
+        EXPECT_EQ(networkData->getEcnMark(0), ECNCodepoint::CE);
+      }));
+  worker_->onNotifyDataAvailable(*socketPtr_);
+}
+#endif
+
+TEST_F(QuicServerWorkerTest, RecvmmsgReadError) {
+  TransportSettings settings;
+  settings.statelessResetTokenSecret = getRandSecret();
+  settings.shouldRecvBatch = true;
+  settings.shouldUseRecvmmsgForBatchRecv = true;
+  settings.maxRecvBatchSize = 2;
+  worker_->setTransportSettings(settings);
+  EXPECT_CALL(*socketPtr_, address()).WillRepeatedly(ReturnRef(fakeAddress_));
+
+  EXPECT_CALL(*socketPtr_, recvmmsg(_, 2, _, nullptr))
+      .WillOnce(Invoke(
+          [](struct mmsghdr*, unsigned int, unsigned int, struct timespec*) {
+            errno = EAGAIN;
+            return -1;
+          }));
+  EXPECT_CALL(*transportInfoCb_, onPacketReceived()).Times(0);
+  EXPECT_CALL(*workerCb_, handleWorkerError(_)).Times(0);
+  worker_->onNotifyDataAvailable(*socketPtr_);
+  Mock::VerifyAndClearExpectations(workerCb_.get());
+
+  EXPECT_CALL(*socketPtr_, recvmmsg(_, 2, _, nullptr))
+      .WillOnce(Invoke(
+          [](struct mmsghdr*, unsigned int, unsigned int, struct timespec*) {
+            errno = EBADF;
+            return -1;
+          }));
+  EXPECT_CALL(*workerCb_, handleWorkerError(LocalErrorCode::INTERNAL_ERROR));
+  worker_->onNotifyDataAvailable(*socketPtr_);
+}
+
 auto createInitialStream(
     ConnectionId srcConnId,
     ConnectionId destConnId,
@@ -21,8 +21,10 @@
 #include <quic/fizz/handshake/FizzCryptoFactory.h>
 #include <quic/fizz/server/handshake/FizzServerHandshake.h>
 #include <quic/fizz/server/handshake/FizzServerQuicHandshakeContext.h>
+#include <quic/flowcontrol/QuicFlowController.h>
 #include <quic/logging/FileQLogger.h>
 #include <quic/server/handshake/ServerHandshake.h>
+#include <quic/server/handshake/TokenGenerator.h>
 #include <quic/server/test/Mocks.h>
 #include <quic/state/QuicStreamFunctions.h>
 #include <quic/state/test/MockQuicStats.h>
@@ -400,7 +402,8 @@ class QuicServerTransportTest : public Test {
 
   void recvClientHello(
       bool writes = true,
-      QuicVersion version = QuicVersion::MVFST) {
+      QuicVersion version = QuicVersion::MVFST,
+      const std::string& token = std::string()) {
     auto chlo = IOBuf::copyBuffer("CHLO");
     auto nextPacketNum = clientNextInitialPacketNum++;
     auto aead = getInitialCipher(version);
@@ -413,7 +416,10 @@ class QuicServerTransportTest : public Test {
             version,
             *chlo,
             *aead,
-            0 /* largestAcked */),
+            0 /* largestAcked */,
+            0 /* offset */,
+            nullptr /* builderProvider */,
+            token),
         *aead,
         *headerCipher,
         nextPacketNum);
@@ -940,6 +946,35 @@ TEST_F(QuicServerTransportTest, RecvDataAfterIdleTimeout) {
       QuicFrame::Type::ConnectionCloseFrame_E));
 }
 
+TEST_F(QuicServerTransportTest, BufferMemoryReleaseReadvertisesWindow) {
+  auto& conn = server->getNonConstConn();
+  // Other connections of the worker already fill the pool.
+  auto pool = std::make_shared<BufferMemoryPool>(1000);
+  pool->charge(1000);
+  server->setBufferMemoryPool(pool);
+  auto advertisedMaxOffset = conn.flowControlState.advertisedMaxOffset;
+  EXPECT_EQ(1000 + advertisedMaxOffset, pool->used());
+
+  // The application reads everything, but the pool holds the window back.
+  conn.flowControlState.sumCurReadOffset = advertisedMaxOffset;
+  updateBufferMemoryCharge(conn);
+  EXPECT_FALSE(maybeSendConnWindowUpdate(conn, Clock::now()));
+  loopForWrites();
+  EXPECT_EQ(advertisedMaxOffset, conn.flowControlState.advertisedMaxOffset);
+
+  // Once the other connections release memory the window is advertised
+  // without anything else happening on this connection.
+  serverWrites.clear();
+  pool->release(1000);
+  loopForWrites();
+  EXPECT_FALSE(serverWrites.empty());
+  EXPECT_EQ(
+      advertisedMaxOffset + std::min<uint64_t>(
+                                1000, conn.flowControlState.windowSize),
+      conn.flowControlState.advertisedMaxOffset);
+  EXPECT_EQ(conn.bufferMemoryCharged, pool->used());
+}
+
 TEST_F(QuicServerTransportTest, TestCloseConnectionWithError) {
   server->close(std::make_pair(
       QuicErrorCode(GenericApplicationErrorCode::UNKNOWN),
@@ -3245,6 +3280,55 @@ TEST_F(QuicServerTransportTest, PingIsTreatedAsRetransmittable) {
   EXPECT_TRUE(server->getConn().pendingEvents.scheduleAckTimeout);
 }
 
+TEST_F(QuicServerTransportTest, RecvDatagramFrames) {
+  auto& conn = server->getNonConstConn();
+  conn.datagramState.maxReadFrameSize = kMaxDatagramFrameSize;
+  conn.datagramState.maxReadBufferSize = 2;
+
+  for (PacketNum packetNum = 1; packetNum <= 3; packetNum++) {
+    ShortHeader header(
+        ProtectionType::KeyPhaseZero, *conn.clientConnectionId, packetNum);
+    RegularQuicPacketBuilder builder(
+        conn.udpSendPacketLen, std::move(header), 0 /* largestAcked */);
+    builder.encodePacketHeader();
+    ASSERT_TRUE(builder.canBuildPacket());
+    auto data = IOBuf::copyBuffer(folly::to<std::string>(packetNum));
+    auto len = data->computeChainDataLength();
+    writeFrame(DatagramFrame(len, std::move(data)), builder);
+    auto packet = std::move(builder).buildPacket();
+    deliverData(packetToBuf(packet), false);
+  }
+
+  // The read buffer is bounded, the oldest datagram made room for the newest.
+  auto datagrams = server->readDatagrams();
+  ASSERT_TRUE(datagrams.hasValue());
+  ASSERT_EQ(2, datagrams->size());
+  EXPECT_EQ("2", datagrams->at(0).data->moveToFbString().toStdString());
+  EXPECT_EQ("3", datagrams->at(1).data->moveToFbString().toStdString());
+}
+
+TEST_F(QuicServerTransportTest, RecvDatagramFrameTooLarge) {
+  auto& conn = server->getNonConstConn();
+  // The payload alone fits, but not with the frame type and length.
+  conn.datagramState.maxReadFrameSize = 100;
+
+  ShortHeader header(ProtectionType::KeyPhaseZero, *conn.clientConnectionId, 1);
+  RegularQuicPacketBuilder builder(
+      conn.udpSendPacketLen, std::move(header), 0 /* largestAcked */);
+  builder.encodePacketHeader();
+  ASSERT_TRUE(builder.canBuildPacket());
+  auto data = IOBuf::copyBuffer(std::string(99, 'a'));
+  writeFrame(DatagramFrame(99, std::move(data)), builder);
+  auto packet = std::move(builder).buildPacket();
+
+  deliverDataWithoutErrorCheck(packetToBuf(packet));
+  ASSERT_TRUE(server->getConn().localConnectionError.has_value());
+  EXPECT_EQ(
+      server->getConn().localConnectionError->first,
+      QuicErrorCode(TransportErrorCode::PROTOCOL_VIOLATION));
+  EXPECT_TRUE(server->getConn().datagramState.readBuffer.empty());
+}
+
 TEST_F(QuicServerTransportTest, RecvNewConnectionIdValid) {
   auto& conn = server->getNonConstConn();
   conn.transportSettings.selfActiveConnectionIdLimit = 2;
@@ -3751,6 +3835,114 @@ TEST_F(QuicUnencryptedServerTransportTest, TestSendHandshakeDone) {
   EXPECT_EQ(numHandshakeDone, 1);
 }
 
+TEST_F(QuicUnencryptedServerTransportTest, TestSendNewToken) {
+  TokenSecret secret;
+  secret.fill(0x42);
+  server->getNonConstConn().transportSettings.tokenSecret = secret;
+  server->setTokenGenerator(std::make_shared<TokenGenerator>(secret));
+  getFakeHandshakeLayer()->allowZeroRttKeys();
+  setupClientReadCodec();
+  recvClientHello();
+  recvClientFinished();
+  std::vector<std::string> tokens;
+  for (auto& p : server->getConn().outstandings.packets) {
+    for (auto& f : p.packet.frames) {
+      auto s = f.asQuicSimpleFrame();
+      if (s && s->asNewTokenFrame()) {
+        tokens.push_back(s->asNewTokenFrame()->token);
+      }
+    }
+  }
+  ASSERT_EQ(tokens.size(), 1);
+  EXPECT_TRUE(server->getConn().sentNewToken);
+  TokenGenerator generator(secret);
+  EXPECT_TRUE(generator.isValidNewToken(tokens[0], clientAddr.getIPAddress()));
+  EXPECT_FALSE(generator.isValidNewToken(
+      tokens[0], folly::IPAddress("127.0.0.2")));
+}
+
+TEST_F(QuicUnencryptedServerTransportTest, TestNoNewTokenWithoutSecret) {
+  getFakeHandshakeLayer()->allowZeroRttKeys();
+  setupClientReadCodec();
+  recvClientHello();
+  recvClientFinished();
+  for (auto& p : server->getConn().outstandings.packets) {
+    for (auto& f : p.packet.frames) {
+      auto s = f.asQuicSimpleFrame();
+      EXPECT_FALSE(s && s->asNewTokenFrame());
+    }
+  }
+}
+
+TEST_F(QuicUnencryptedServerTransportTest, NewTokenSkipsWritableBytesLimit) {
+  TokenSecret secret;
+  secret.fill(0x42);
+  server->getNonConstConn().transportSettings.tokenSecret = secret;
+  server->setTokenGenerator(std::make_shared<TokenGenerator>(secret));
+  server->getNonConstConn().transportSettings.zeroRttSourceTokenMatchingPolicy =
+      ZeroRttSourceTokenMatchingPolicy::LIMIT_IF_NO_EXACT_MATCH;
+  getFakeHandshakeLayer()->allowZeroRttKeys();
+  setupClientReadCodec();
+
+  auto timestampInMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                           std::chrono::system_clock::now().time_since_epoch())
+                           .count();
+  TokenGenerator generator(secret);
+  auto token = generator.encryptToken(
+      NewToken(clientAddr.getIPAddress(), timestampInMs));
+  ASSERT_TRUE(token.has_value());
+  recvClientHello(
+      true, QuicVersion::MVFST, (*token)->moveToFbString().toStdString());
+  EXPECT_TRUE(server->getConn().isClientAddrVerified);
+  EXPECT_FALSE(server->getConn().writableBytesLimit.has_value());
+}
+
+TEST_F(
+    QuicUnencryptedServerTransportTest,
+    NewTokenForOtherAddressKeepsWritableBytesLimit) {
+  TokenSecret secret;
+  secret.fill(0x42);
+  server->getNonConstConn().transportSettings.tokenSecret = secret;
+  server->setTokenGenerator(std::make_shared<TokenGenerator>(secret));
+  server->getNonConstConn().transportSettings.zeroRttSourceTokenMatchingPolicy =
+      ZeroRttSourceTokenMatchingPolicy::LIMIT_IF_NO_EXACT_MATCH;
+  getFakeHandshakeLayer()->allowZeroRttKeys();
+  setupClientReadCodec();
+
+  auto timestampInMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                           std::chrono::system_clock::now().time_since_epoch())
+                           .count();
+  TokenGenerator generator(secret);
+  auto token = generator.encryptToken(
+      NewToken(folly::IPAddress("127.0.0.2"), timestampInMs));
+  ASSERT_TRUE(token.has_value());
+  recvClientHello(
+      true, QuicVersion::MVFST, (*token)->moveToFbString().toStdString());
+  EXPECT_FALSE(server->getConn().isClientAddrVerified);
+  EXPECT_TRUE(server->getConn().writableBytesLimit.has_value());
+}
+
+TEST_F(QuicUnencryptedServerTransportTest, InvalidNewTokenKeepsVerified) {
+  TokenSecret secret;
+  secret.fill(0x42);
+  server->getNonConstConn().transportSettings.tokenSecret = secret;
+  server->setTokenGenerator(std::make_shared<TokenGenerator>(secret));
+  server->getNonConstConn().isClientAddrVerified = true;
+  getFakeHandshakeLayer()->allowZeroRttKeys();
+  setupClientReadCodec();
+
+  auto timestampInMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                           std::chrono::system_clock::now().time_since_epoch())
+                           .count();
+  TokenGenerator generator(secret);
+  auto token = generator.encryptToken(
+      NewToken(folly::IPAddress("127.0.0.2"), timestampInMs));
+  ASSERT_TRUE(token.has_value());
+  recvClientHello(
+      true, QuicVersion::MVFST, (*token)->moveToFbString().toStdString());
+  EXPECT_TRUE(server->getConn().isClientAddrVerified);
+}
+
 TEST_F(
     QuicUnencryptedServerTransportTest,
     IncreaseLimitAfterReceivingNewPacket) {
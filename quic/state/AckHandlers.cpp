@@ -15,6 +15,53 @@
 
 namespace quic {
 
+namespace {
+
+/**
+ * Validates the ECN counts of an ack frame against the packets it newly acks,
+ * and records the number of newly CE marked packets in the AckEvent. Like the
+ * ack blocks, the counts are cumulative, so frames that don't ack a new
+ * largest packet are ignored as they may have been reordered.
+ */
+void processEcnCounts(
+    QuicConnectionStateBase& conn,
+    AckState& ackState,
+    const ReadAckFrame& frame,
+    CongestionController::AckEvent& ack) {
+  if (frame.implicit ||
+      conn.transportSettings.ecnMarking == ECNCodepoint::NotECT ||
+      conn.ecnState.validationFailed || ack.ackedPackets.empty()) {
+    return;
+  }
+  if (ackState.largestAckedByPeer &&
+      frame.largestAcked <= *ackState.largestAckedByPeer) {
+    return;
+  }
+  auto& lastCounts = ackState.peerEcnCounts;
+  // Every packet we sent was marked, so the counts have to go up by at least
+  // the number of packets newly acked.
+  bool valid = frame.ecnCounts.has_value() &&
+      frame.ecnCounts->ect0 >= lastCounts.ect0 &&
+      frame.ecnCounts->ect1 >= lastCounts.ect1 &&
+      frame.ecnCounts->ce >= lastCounts.ce &&
+      (frame.ecnCounts->ect0 - lastCounts.ect0) +
+              (frame.ecnCounts->ect1 - lastCounts.ect1) +
+              (frame.ecnCounts->ce - lastCounts.ce) >=
+          ack.ackedPackets.size();
+  if (!valid) {
+    VLOG(2) << "ECN validation failed, disabling ECN " << conn;
+    conn.ecnState.validationFailed = true;
+    return;
+  }
+  ack.ecnCeMarkedPackets = frame.ecnCounts->ce - lastCounts.ce;
+  if (ack.ecnCeMarkedPackets > 0) {
+    conn.ecnState.ceEvents++;
+  }
+  lastCounts = *frame.ecnCounts;
+}
+
+} // namespace
+
 /**
  * Process ack frame and acked outstanding packets.
  *
@@ -43,11 +90,6 @@ void processAckFrame(
   ack.ackTime = ackReceiveTime;
   ack.implicit = frame.implicit;
   ack.adjustedAckTime = ackReceiveTime - frame.ackDelay;
-  // Using kDefaultRxPacketsBeforeAckAfterInit to reseve for ackedPackets
-  // container is a hueristic. Other quic implementations may have very
-  // different acking policy. It's also possibly that all acked packets are pure
-  // acks which leads to different number of packets being acked usually.
-  ack.ackedPackets.reserve(kDefaultRxPacketsBeforeAckAfterInit);
   auto currentPacketIt = getLastOutstandingPacketIncludingLost(conn, pnSpace);
   uint64_t initialPacketAcked = 0;
   uint64_t handshakePacketAcked = 0;
@@ -64,7 +106,7 @@ void processAckFrame(
         conn.outstandings.packets.rend(),
         ackBlockIt->endPacket,
         [&](const auto& packetWithTime, const auto& val) {
-          return packetWithTime.packet.header.getPacketSequenceNum() > val;
+          return packetWithTime.packetNum > val;
         });
     if (rPacketIt == conn.outstandings.packets.rend()) {
       // This means that all the packets are greater than the end packet.
@@ -83,9 +125,8 @@ void processAckFrame(
     // or equal to crypto protection level.
     auto eraseEnd = rPacketIt;
     while (rPacketIt != conn.outstandings.packets.rend()) {
-      auto currentPacketNum = rPacketIt->packet.header.getPacketSequenceNum();
-      auto currentPacketNumberSpace =
-          rPacketIt->packet.header.getPacketNumberSpace();
+      auto currentPacketNum = rPacketIt->packetNum;
+      auto currentPacketNumberSpace = rPacketIt->packetNumberSpace;
       if (pnSpace != currentPacketNumberSpace) {
         // When the next packet is not in the same packet number space, we need
         // to skip it in current ack processing. If the iterator has moved, that
@@ -220,6 +261,7 @@ void processAckFrame(
       conn.outstandings.handshakePacketsCount +
           conn.outstandings.initialPacketsCount);
   CHECK_GE(updatedOustandingPacketsCount, conn.outstandings.clonedPacketsCount);
+  processEcnCounts(conn, getAckState(conn, pnSpace), frame, ack);
   auto lossEvent = handleAckForLoss(conn, lossVisitor, ack, pnSpace);
   if (conn.congestionController &&
       (ack.largestAckedPacket.has_value() || lossEvent)) {
@@ -256,7 +298,7 @@ void clearOldOutstandingPackets(
       if (time < opItr->time) {
         break;
       }
-      if (opItr->packet.header.getPacketNumberSpace() != pnSpace) {
+      if (opItr->packetNumberSpace != pnSpace) {
         if (eraseBegin != opItr) {
           // We want to keep [eraseBegin, opItr) within a single PN space.
           opItr = conn.outstandings.packets.erase(eraseBegin, opItr);
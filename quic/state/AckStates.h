@@ -27,11 +27,19 @@ struct AckState {
   // Count of outstanding packets received with only non-retransmittable data.
   uint64_t numNonRxPacketsRecvd{0};
   // Count of oustanding packets received with retransmittable data.
-  uint8_t numRxPacketsRecvd{0};
+  uint64_t numRxPacketsRecvd{0};
+  // Set when a packet being processed carries an IMMEDIATE_ACK frame.
+  bool immediateAckRequested{false};
   // The receive time of the largest ack packet
   folly::Optional<TimePoint> largestRecvdPacketTime;
   // Latest packet number acked by peer
   folly::Optional<PacketNum> largestAckedByPeer;
+  // ECN codepoints of the packets received in this space, echoed back to the
+  // peer in ACK_ECN frames.
+  ECNCounts ecnCounts;
+  // The ECN counts from the last ACK_ECN frame the peer sent in this space
+  // that acked a new largest packet.
+  ECNCounts peerEcnCounts;
   // Largest received packet numbers on the connection.
   folly::Optional<PacketNum> largestReceivedPacketNum;
   // Largest received packet number at the time we sent our last close message.
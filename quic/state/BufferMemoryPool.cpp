@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/state/BufferMemoryPool.h>
+
+#include <glog/logging.h>
+
+namespace quic {
+
+BufferMemoryPool::BufferMemoryPool(uint64_t limit) : limit_(limit) {}
+
+void BufferMemoryPool::charge(uint64_t bytes) noexcept {
+  used_ += bytes;
+}
+
+void BufferMemoryPool::release(uint64_t bytes) noexcept {
+  DCHECK_GE(used_, bytes);
+  used_ -= bytes;
+  if (bytes == 0 || releaseCallbacks_.empty()) {
+    return;
+  }
+  // Callbacks may ask to be notified again.
+  auto callbacks = std::move(releaseCallbacks_);
+  releaseCallbacks_.clear();
+  for (auto callback : callbacks) {
+    callback->onBufferMemoryReleased();
+  }
+}
+
+void BufferMemoryPool::notifyOnRelease(Callback* callback) {
+  DCHECK(callback);
+  releaseCallbacks_.insert(callback);
+}
+
+void BufferMemoryPool::cancelNotifyOnRelease(Callback* callback) noexcept {
+  releaseCallbacks_.erase(callback);
+}
+
+uint64_t BufferMemoryPool::used() const noexcept {
+  return used_;
+}
+
+uint64_t BufferMemoryPool::limit() const noexcept {
+  return limit_;
+}
+
+uint64_t BufferMemoryPool::available() const noexcept {
+  return used_ >= limit_ ? 0 : limit_ - used_;
+}
+
+} // namespace quic
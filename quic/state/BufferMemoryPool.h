@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#pragma once
+
+#include <folly/container/F14Set.h>
+
+#include <cstdint>
+
+namespace quic {
+
+/**
+ * Accounts the stream buffer memory of all the connections sharing it,
+ * typically every connection of one server worker. Connections charge the
+ * receive window they have granted their peer but the application hasn't read
+ * yet, which reserves the memory before the peer sends, and the bytes buffered
+ * in their stream write buffers. Connections stop growing their windows and
+ * report less writable buffer space as the pool fills up.
+ *
+ * Not thread safe: all the connections sharing a pool must run on the same
+ * EventBase.
+ */
+class BufferMemoryPool {
+ public:
+  /**
+   * Told that memory was released back to the pool, e.g. so that a connection
+   * whose window was held back by a full pool can advertise a larger one. The
+   * call comes from within the processing of whichever connection released
+   * the memory, so callbacks should defer their work to the EventBase.
+   */
+  class Callback {
+   public:
+    virtual ~Callback() = default;
+
+    virtual void onBufferMemoryReleased() noexcept = 0;
+  };
+
+  explicit BufferMemoryPool(uint64_t limit);
+
+  void charge(uint64_t bytes) noexcept;
+
+  /**
+   * Returns bytes to the pool and tells the callbacks waiting for that.
+   */
+  void release(uint64_t bytes) noexcept;
+
+  /**
+   * Calls the callback once, the next time memory is released.
+   */
+  void notifyOnRelease(Callback* callback);
+
+  void cancelNotifyOnRelease(Callback* callback) noexcept;
+
+  uint64_t used() const noexcept;
+
+  uint64_t limit() const noexcept;
+
+  /**
+   * Bytes left before the pool reaches its limit.
+   */
+  uint64_t available() const noexcept;
+
+ private:
+  const uint64_t limit_;
+  uint64_t used_{0};
+  folly::F14FastSet<Callback*> releaseCallbacks_;
+};
+
+} // namespace quic
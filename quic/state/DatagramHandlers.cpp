@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/state/DatagramHandlers.h>
+
+#include <quic/QuicException.h>
+
+namespace quic {
+
+void handleDatagram(
+    QuicConnectionStateBase& conn,
+    DatagramFrame& frame,
+    TimePoint recvTimePoint) {
+  auto& datagramState = conn.datagramState;
+  // max_datagram_frame_size covers the frame type and length too.
+  if (datagramState.maxReadFrameSize == 0 ||
+      frame.encodedSize() > datagramState.maxReadFrameSize) {
+    throw QuicTransportException(
+        "Received unexpected DATAGRAM frame",
+        TransportErrorCode::PROTOCOL_VIOLATION,
+        FrameType::DATAGRAM);
+  }
+  if (datagramState.maxReadBufferSize == 0) {
+    VLOG(10) << "Dropping datagram, read buffer size is 0 " << conn;
+    return;
+  }
+  // Newer datagrams are usually more useful than older ones, so make room by
+  // dropping from the front.
+  if (datagramState.readBuffer.size() >= datagramState.maxReadBufferSize) {
+    VLOG(10) << "Datagram read buffer full, dropping the oldest one " << conn;
+    datagramState.readBuffer.pop_front();
+  }
+  datagramState.readBuffer.emplace_back(recvTimePoint, std::move(frame.data));
+}
+
+} // namespace quic
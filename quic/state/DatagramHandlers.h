@@ -0,0 +1,26 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#pragma once
+
+#include <quic/codec/Types.h>
+#include <quic/state/StateData.h>
+
+namespace quic {
+
+/*
+ * Buffer a received DATAGRAM frame until the application reads it. Throws a
+ * PROTOCOL_VIOLATION if we did not advertise support for datagrams or the
+ * frame is larger than what we advertised.
+ */
+void handleDatagram(
+    QuicConnectionStateBase& conn,
+    DatagramFrame& frame,
+    TimePoint recvTimePoint);
+
+} // namespace quic
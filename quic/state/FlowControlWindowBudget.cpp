@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/state/FlowControlWindowBudget.h>
+
+#include <glog/logging.h>
+
+namespace quic {
+
+FlowControlWindowBudget::FlowControlWindowBudget(uint64_t limit)
+    : limit_(limit) {}
+
+bool FlowControlWindowBudget::tryCharge(uint64_t bytes) noexcept {
+  auto used = used_.load(std::memory_order_relaxed);
+  do {
+    if (bytes > limit_ - used) {
+      return false;
+    }
+  } while (!used_.compare_exchange_weak(
+      used, used + bytes, std::memory_order_relaxed));
+  return true;
+}
+
+void FlowControlWindowBudget::release(uint64_t bytes) noexcept {
+  auto previous = used_.fetch_sub(bytes, std::memory_order_relaxed);
+  DCHECK_GE(previous, bytes);
+}
+
+uint64_t FlowControlWindowBudget::used() const noexcept {
+  return used_.load(std::memory_order_relaxed);
+}
+
+uint64_t FlowControlWindowBudget::limit() const noexcept {
+  return limit_;
+}
+
+} // namespace quic
@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace quic {
+
+/**
+ * Memory budget for the growth of autotuned connection flow control windows.
+ * All the connections configured with the same budget charge the bytes their
+ * windows grow by against it, and release them when they go away, which bounds
+ * how much data all of them together can make their peers send.
+ */
+class FlowControlWindowBudget {
+ public:
+  explicit FlowControlWindowBudget(uint64_t limit);
+
+  /**
+   * Charges bytes against the budget. Returns false and charges nothing if
+   * that would exceed the limit.
+   */
+  bool tryCharge(uint64_t bytes) noexcept;
+
+  void release(uint64_t bytes) noexcept;
+
+  uint64_t used() const noexcept;
+
+  uint64_t limit() const noexcept;
+
+ private:
+  const uint64_t limit_;
+  std::atomic<uint64_t> used_{0};
+};
+
+} // namespace quic
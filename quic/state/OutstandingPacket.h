@@ -14,20 +14,39 @@
 namespace quic {
 // Data structure to represent outstanding retransmittable packets
 struct OutstandingPacket {
-  // Structure representing the frames that are outstanding including the header
-  // that was sent.
-  RegularQuicWritePacket packet;
-  // Time that the packet was sent.
-  TimePoint time;
-  // Size of the packet sent on the wire.
-  uint32_t encodedSize;
+  // The fields that ack and loss processing read for every outstanding packet
+  // come first so that they share a cache line. The frames in |packet| are
+  // only touched once a packet is acked or lost.
+
+  // Packet number and packet number space of the packet, copied out of the
+  // header so that searching the outstanding packets does not need to look
+  // at the header.
+  PacketNum packetNum;
+  PacketNumberSpace packetNumberSpace;
   // Whether this packet has any data from stream 0
   bool isHandshake;
   // Whether the packet is a d6d probe
   bool isD6DProbe;
+  /**
+   * Whether the packet is sent when congestion controller is in app-limited
+   * state.
+   */
+  bool isAppLimited{false};
+
+  // True if spurious loss detection is enabled and this packet was declared
+  // lost.
+  bool declaredLost{false};
+  // Size of the packet sent on the wire.
+  uint32_t encodedSize;
+  // Time that the packet was sent.
+  TimePoint time;
   // Total sent bytes on this connection including this packet itself when this
   // packet is sent.
   uint64_t totalBytesSent;
+
+  // Structure representing the frames that are outstanding including the header
+  // that was sent.
+  RegularQuicWritePacket packet;
   // Information regarding the last acked packet on this connection when this
   // packet is sent.
   struct LastAckedPacketInfo {
@@ -58,28 +77,19 @@ struct OutstandingPacket {
   // folly::none if the packet isn't a clone and hasn't been cloned.
   folly::Optional<PacketEvent> associatedEvent;
 
-  /**
-   * Whether the packet is sent when congestion controller is in app-limited
-   * state.
-   */
-  bool isAppLimited{false};
-
-  // True if spurious loss detection is enabled and this packet was declared
-  // lost.
-  bool declaredLost{false};
-
   OutstandingPacket(
       RegularQuicWritePacket packetIn,
       TimePoint timeIn,
       uint32_t encodedSizeIn,
       bool isHandshakeIn,
       uint64_t totalBytesSentIn)
-      : packet(std::move(packetIn)),
-        time(std::move(timeIn)),
-        encodedSize(encodedSizeIn),
-        isHandshake(isHandshakeIn),
-        isD6DProbe(false),
-        totalBytesSent(totalBytesSentIn) {}
+      : OutstandingPacket(
+            std::move(packetIn),
+            std::move(timeIn),
+            encodedSizeIn,
+            isHandshakeIn,
+            false,
+            totalBytesSentIn) {}
 
   OutstandingPacket(
       RegularQuicWritePacket packetIn,
@@ -88,11 +98,13 @@ struct OutstandingPacket {
       bool isHandshakeIn,
       bool isD6DProbeIn,
       uint64_t totalBytesSentIn)
-      : packet(std::move(packetIn)),
-        time(std::move(timeIn)),
-        encodedSize(encodedSizeIn),
+      : packetNum(packetIn.header.getPacketSequenceNum()),
+        packetNumberSpace(packetIn.header.getPacketNumberSpace()),
         isHandshake(isHandshakeIn),
         isD6DProbe(isD6DProbeIn),
-        totalBytesSent(totalBytesSentIn) {}
+        encodedSize(encodedSizeIn),
+        time(std::move(timeIn)),
+        totalBytesSent(totalBytesSentIn),
+        packet(std::move(packetIn)) {}
 };
 } // namespace quic
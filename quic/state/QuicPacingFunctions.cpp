@@ -18,4 +18,45 @@ void updatePacingOnClose(QuicConnectionStateBase& conn) {
   conn.canBePaced = false;
 }
 
+TimePoint allocateTxTimeDeparture(
+    QuicConnectionStateBase& conn,
+    TimePoint now) {
+  DCHECK(conn.pacer);
+  auto departure = std::max(now, conn.nextTxTimeDeparture);
+  conn.nextTxTimeDeparture = departure + conn.pacer->getPacingRate().interval;
+  return departure;
+}
+
+uint64_t getTxTimeWriteBatchSize(
+    const QuicConnectionStateBase& conn,
+    TimePoint now) {
+  DCHECK(conn.pacer);
+  auto pacingRate = conn.pacer->getPacingRate();
+  if (pacingRate.interval == 0us) {
+    return pacingRate.burstSize;
+  }
+  auto firstDeparture = std::max(now, conn.nextTxTimeDeparture);
+  auto horizonEnd = now + conn.transportSettings.txTimeHorizon;
+  if (firstDeparture >= horizonEnd) {
+    return 0;
+  }
+  auto queueable = std::chrono::duration_cast<std::chrono::microseconds>(
+      horizonEnd - firstDeparture);
+  uint64_t numBursts =
+      (queueable.count() + pacingRate.interval.count() - 1) /
+      pacingRate.interval.count();
+  return numBursts * pacingRate.burstSize;
+}
+
+std::chrono::microseconds getTxTimeUntilNextWrite(
+    const QuicConnectionStateBase& conn,
+    TimePoint now) {
+  auto resumeAt =
+      conn.nextTxTimeDeparture - conn.transportSettings.txTimeHorizon / 2;
+  if (resumeAt <= now) {
+    return 0us;
+  }
+  return std::chrono::duration_cast<std::chrono::microseconds>(resumeAt - now);
+}
+
 } // namespace quic
@@ -16,4 +16,35 @@ void updatePacingOnKeyEstablished(QuicConnectionStateBase& conn);
 
 void updatePacingOnClose(QuicConnectionStateBase& conn);
 
+/**
+ * With pacingWithTxTime the transport writes bursts ahead of time, each packet
+ * carrying the time it should leave at, and the fq qdisc holds it until then.
+ * These functions keep the departure schedule and require conn.pacer.
+ */
+
+/**
+ * Returns the departure time for the next burst, which is never earlier than
+ * now, and moves the schedule on by one pacing interval.
+ */
+TimePoint allocateTxTimeDeparture(
+    QuicConnectionStateBase& conn,
+    TimePoint now);
+
+/**
+ * Returns how many packets can be written now: all the bursts that would
+ * depart before now + txTimeHorizon.
+ */
+uint64_t getTxTimeWriteBatchSize(
+    const QuicConnectionStateBase& conn,
+    TimePoint now);
+
+/**
+ * Returns how long to wait before writing again. Writing resumes once less
+ * than half of txTimeHorizon is queued, so every write hands the kernel
+ * several bursts.
+ */
+std::chrono::microseconds getTxTimeUntilNextWrite(
+    const QuicConnectionStateBase& conn,
+    TimePoint now);
+
 } // namespace quic
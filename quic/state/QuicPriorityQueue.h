@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#pragma once
+
+#include <folly/container/F14Map.h>
+#include <glog/logging.h>
+#include <quic/QuicConstants.h>
+#include <quic/codec/Types.h>
+#include <quic/common/ContainerUtils.h>
+#include <set>
+#include <vector>
+
+namespace quic {
+
+using PriorityLevel = uint8_t;
+
+/**
+ * Priority of a stream. The level is the urgency, lower is more urgent.
+ * Incremental streams of the same urgency share bandwidth round robin, while
+ * non-incremental streams are sent one after another in stream id order.
+ */
+struct Priority {
+  PriorityLevel level;
+  bool incremental;
+
+  constexpr Priority(PriorityLevel l, bool i) : level(l), incremental(i) {}
+
+  bool operator==(Priority other) const noexcept {
+    return level == other.level && incremental == other.incremental;
+  }
+
+  bool operator!=(Priority other) const noexcept {
+    return !(*this == other);
+  }
+};
+
+constexpr Priority kDefaultPriority(3, true);
+
+/**
+ * Set of writable streams bucketed by priority. Each bucket is a std::set so
+ * the round robin iteration order is stable, and the level of every stream is
+ * tracked in a hash map so moving a stream between buckets does not require a
+ * scan. Insert, erase and priority updates are O(log n) in the number of
+ * streams of a single bucket.
+ */
+struct PriorityQueue {
+  struct Level {
+    std::set<StreamId> streams;
+    // The stream that the round robin should start from the next time this
+    // level gets scheduled. Only used by incremental levels.
+    StreamId next{0};
+    bool incremental{false};
+  };
+
+  // Levels are kept in scheduling order: for each urgency the non-incremental
+  // bucket comes first, followed by the incremental one.
+  std::vector<Level> levels;
+
+  PriorityQueue() : levels(kDefaultPriorityLevels * 2) {
+    for (size_t index = 0; index < levels.size(); index++) {
+      levels[index].incremental = (index % 2 == 1);
+    }
+  }
+
+  static size_t priority2index(Priority pri) {
+    DCHECK_LE(pri.level, kDefaultMaxPriority);
+    return pri.level * 2 + (pri.incremental ? 1 : 0);
+  }
+
+  /**
+   * Add a stream to the queue, or move it to a different bucket if it is
+   * already present with another priority.
+   */
+  void insertOrUpdate(StreamId id, Priority pri) {
+    auto index = priority2index(pri);
+    auto it = writableStreamsToLevel_.find(id);
+    if (it != writableStreamsToLevel_.end()) {
+      if (it->second == index) {
+        return;
+      }
+      levels[it->second].streams.erase(id);
+      it->second = index;
+    } else {
+      writableStreamsToLevel_.emplace(id, index);
+    }
+    levels[index].streams.insert(id);
+  }
+
+  /**
+   * Update the priority of a stream if it is in the queue.
+   */
+  void updateIfExist(StreamId id, Priority pri) {
+    if (writableStreamsToLevel_.count(id) > 0) {
+      insertOrUpdate(id, pri);
+    }
+  }
+
+  void erase(StreamId id) {
+    auto it = writableStreamsToLevel_.find(id);
+    if (it == writableStreamsToLevel_.end()) {
+      return;
+    }
+    levels[it->second].streams.erase(id);
+    writableStreamsToLevel_.erase(it);
+  }
+
+  void clear() {
+    for (auto& level : levels) {
+      level.streams.clear();
+      level.next = 0;
+    }
+    writableStreamsToLevel_.clear();
+  }
+
+  /**
+   * Releases the memory the stream to level map kept from when more streams
+   * were writable.
+   */
+  void compact() {
+    shrinkToFit(writableStreamsToLevel_);
+  }
+
+  size_t count(StreamId id) const {
+    return writableStreamsToLevel_.count(id);
+  }
+
+  bool empty() const {
+    return writableStreamsToLevel_.empty();
+  }
+
+  size_t size() const {
+    return writableStreamsToLevel_.size();
+  }
+
+  /**
+   * Round robin position of the given incremental priority bucket.
+   */
+  StreamId getNextScheduledStream(Priority pri = kDefaultPriority) const {
+    return levels[priority2index(pri)].next;
+  }
+
+  void setNextScheduledStream(StreamId id, Priority pri = kDefaultPriority) {
+    levels[priority2index(pri)].next = id;
+  }
+
+ private:
+  folly::F14FastMap<StreamId, size_t> writableStreamsToLevel_;
+};
+
+} // namespace quic
@@ -9,29 +9,29 @@
 #include <quic/state/QuicStateFunctions.h>
 #include <quic/state/QuicStreamFunctions.h>
 
+#include <quic/common/ContainerUtils.h>
 #include <quic/common/TimeUtil.h>
 #include <quic/logging/QuicLogger.h>
 
 namespace {
-std::deque<quic::OutstandingPacket>::reverse_iterator
+quic::CircularDeque<quic::OutstandingPacket>::reverse_iterator
 getPreviousOutstandingPacket(
     quic::QuicConnectionStateBase& conn,
     quic::PacketNumberSpace packetNumberSpace,
-    std::deque<quic::OutstandingPacket>::reverse_iterator from) {
+    quic::CircularDeque<quic::OutstandingPacket>::reverse_iterator from) {
   return std::find_if(
       from, conn.outstandings.packets.rend(), [=](const auto& op) {
-        return !op.declaredLost &&
-            packetNumberSpace == op.packet.header.getPacketNumberSpace();
+        return !op.declaredLost && packetNumberSpace == op.packetNumberSpace;
       });
 }
-std::deque<quic::OutstandingPacket>::reverse_iterator
+quic::CircularDeque<quic::OutstandingPacket>::reverse_iterator
 getPreviousOutstandingPacketIncludingLost(
     quic::QuicConnectionStateBase& conn,
     quic::PacketNumberSpace packetNumberSpace,
-    std::deque<quic::OutstandingPacket>::reverse_iterator from) {
+    quic::CircularDeque<quic::OutstandingPacket>::reverse_iterator from) {
   return std::find_if(
       from, conn.outstandings.packets.rend(), [=](const auto& op) {
-        return packetNumberSpace == op.packet.header.getPacketNumberSpace();
+        return packetNumberSpace == op.packetNumberSpace;
       });
 }
 
@@ -88,27 +88,41 @@ void updateAckSendStateOnRecvPacket(
     bool pktHasRetransmittableData,
     bool pktHasCryptoData) {
   DCHECK(!pktHasCryptoData || pktHasRetransmittableData);
-  auto thresh = kNonRtxRxPacketsPendingBeforeAck;
+  // The ack policy requested by the peer with ACK_FREQUENCY only applies to
+  // the AppData packet number space.
+  const auto& peerRequest = conn.ackFrequencyState.peerRequest;
+  bool usePeerRequest =
+      peerRequest && &ackState == &conn.ackStates.appDataAckState;
+  uint64_t thresh = kNonRtxRxPacketsPendingBeforeAck;
   if (pktHasRetransmittableData || ackState.numRxPacketsRecvd) {
-    thresh = ackState.largestReceivedPacketNum.value_or(0) >
-            conn.transportSettings.rxPacketsBeforeAckInitThreshold
-        ? conn.transportSettings.rxPacketsBeforeAckAfterInit
-        : conn.transportSettings.rxPacketsBeforeAckBeforeInit;
+    if (usePeerRequest) {
+      thresh = peerRequest->packetTolerance;
+    } else {
+      thresh = ackState.largestReceivedPacketNum.value_or(0) >
+              conn.transportSettings.rxPacketsBeforeAckInitThreshold
+          ? conn.transportSettings.rxPacketsBeforeAckAfterInit
+          : conn.transportSettings.rxPacketsBeforeAckBeforeInit;
+    }
+  }
+  if (usePeerRequest && peerRequest->reorderThreshold == 0) {
+    pktOutOfOrder = false;
   }
   if (pktHasRetransmittableData) {
-    if (pktHasCryptoData || pktOutOfOrder ||
+    if (pktHasCryptoData || pktOutOfOrder || ackState.immediateAckRequested ||
         ++ackState.numRxPacketsRecvd + ackState.numNonRxPacketsRecvd >=
             thresh) {
       VLOG(10) << conn
                << " ack immediately because packet threshold pktHasCryptoData="
                << pktHasCryptoData << " pktHasRetransmittableData="
                << static_cast<int>(pktHasRetransmittableData)
+               << " immediateAckRequested=" << ackState.immediateAckRequested
                << " numRxPacketsRecvd="
                << static_cast<int>(ackState.numRxPacketsRecvd)
                << " numNonRxPacketsRecvd="
                << static_cast<int>(ackState.numNonRxPacketsRecvd);
       conn.pendingEvents.scheduleAckTimeout = false;
       ackState.needsToSendAckImmediately = true;
+      ackState.immediateAckRequested = false;
       ackState.numRxPacketsRecvd = 0;
       ackState.numNonRxPacketsRecvd = 0;
     } else {
@@ -138,6 +152,22 @@ void updateAckSendStateOnRecvPacket(
   }
 }
 
+void updateEcnCountsOnRecvPacket(AckState& ackState, ECNCodepoint ecn) {
+  switch (ecn) {
+    case ECNCodepoint::NotECT:
+      break;
+    case ECNCodepoint::ECT0:
+      ackState.ecnCounts.ect0++;
+      break;
+    case ECNCodepoint::ECT1:
+      ackState.ecnCounts.ect1++;
+      break;
+    case ECNCodepoint::CE:
+      ackState.ecnCounts.ce++;
+      break;
+  }
+}
+
 void updateAckStateOnAckTimeout(QuicConnectionStateBase& conn) {
   VLOG(10) << conn << " ack immediately due to ack timeout";
   conn.ackStates.appDataAckState.needsToSendAckImmediately = true;
@@ -146,6 +176,54 @@ void updateAckStateOnAckTimeout(QuicConnectionStateBase& conn) {
   conn.pendingEvents.scheduleAckTimeout = false;
 }
 
+bool requestPeerAckFrequencyChange(
+    QuicConnectionStateBase& conn,
+    uint64_t packetTolerance,
+    std::chrono::microseconds maxAckDelay,
+    uint64_t reorderThreshold) {
+  auto& ackFrequencyState = conn.ackFrequencyState;
+  if (!ackFrequencyState.peerMinAckDelay) {
+    return false;
+  }
+  // The peer caps the delay at its own ack timer, see kMaxAckTimeout.
+  maxAckDelay = timeMax(
+      timeMin(maxAckDelay, kMaxAckTimeout), *ackFrequencyState.peerMinAckDelay);
+  // The peer may hold its ACKs this long as soon as the request arrives, so
+  // account for it in the PTO right away rather than waiting for a late ACK
+  // to show up in the ack delay samples.
+  conn.lossState.maxAckDelay = timeMax(conn.lossState.maxAckDelay, maxAckDelay);
+  AckFrequencyFrame frame(
+      ackFrequencyState.nextSequenceNumber++,
+      std::max<uint64_t>(packetTolerance, 1),
+      maxAckDelay.count(),
+      reorderThreshold);
+  VLOG(10) << conn << " request ack frequency seq=" << frame.sequenceNumber
+           << " packetTolerance=" << frame.packetTolerance
+           << " maxAckDelay=" << frame.updateMaxAckDelay << "us"
+           << " reorderThreshold=" << frame.reorderThreshold;
+  // A pending request that has not been written yet is superseded.
+  auto& frames = conn.pendingEvents.frames;
+  frames.erase(
+      std::remove_if(
+          frames.begin(),
+          frames.end(),
+          [](const QuicSimpleFrame& pending) {
+            return pending.asAckFrequencyFrame() != nullptr;
+          }),
+      frames.end());
+  ackFrequencyState.lastRequested = frame;
+  frames.emplace_back(std::move(frame));
+  return true;
+}
+
+bool requestPeerImmediateAck(QuicConnectionStateBase& conn) {
+  if (!conn.ackFrequencyState.peerMinAckDelay) {
+    return false;
+  }
+  conn.pendingEvents.frames.emplace_back(ImmediateAckFrame());
+  return true;
+}
+
 void updateAckSendStateOnSentPacketWithAcks(
     QuicConnectionStateBase& conn,
     AckState& ackState,
@@ -169,6 +247,12 @@ bool isConnectionPaced(const QuicConnectionStateBase& conn) noexcept {
       conn.transportSettings.pacingEnabled && conn.canBePaced && conn.pacer);
 }
 
+bool isTxTimePaced(const QuicConnectionStateBase& conn) noexcept {
+  return conn.transportSettings.pacingWithTxTime &&
+      conn.transportSettings.dataPathType == DataPathType::ChainedMemory &&
+      isConnectionPaced(conn);
+}
+
 AckState& getAckState(
     QuicConnectionStateBase& conn,
     PacketNumberSpace pnSpace) noexcept {
@@ -220,21 +304,21 @@ void increaseNextPacketNum(
   }
 }
 
-std::deque<OutstandingPacket>::iterator getFirstOutstandingPacket(
+CircularDeque<OutstandingPacket>::iterator getFirstOutstandingPacket(
     QuicConnectionStateBase& conn,
     PacketNumberSpace packetNumberSpace) {
   return getNextOutstandingPacket(
       conn, packetNumberSpace, conn.outstandings.packets.begin());
 }
 
-std::deque<OutstandingPacket>::reverse_iterator getLastOutstandingPacket(
+CircularDeque<OutstandingPacket>::reverse_iterator getLastOutstandingPacket(
     QuicConnectionStateBase& conn,
     PacketNumberSpace packetNumberSpace) {
   return getPreviousOutstandingPacket(
       conn, packetNumberSpace, conn.outstandings.packets.rbegin());
 }
 
-std::deque<OutstandingPacket>::reverse_iterator
+CircularDeque<OutstandingPacket>::reverse_iterator
 getLastOutstandingPacketIncludingLost(
     QuicConnectionStateBase& conn,
     PacketNumberSpace packetNumberSpace) {
@@ -242,14 +326,13 @@ getLastOutstandingPacketIncludingLost(
       conn, packetNumberSpace, conn.outstandings.packets.rbegin());
 }
 
-std::deque<OutstandingPacket>::iterator getNextOutstandingPacket(
+CircularDeque<OutstandingPacket>::iterator getNextOutstandingPacket(
     QuicConnectionStateBase& conn,
     PacketNumberSpace packetNumberSpace,
-    std::deque<OutstandingPacket>::iterator from) {
+    CircularDeque<OutstandingPacket>::iterator from) {
   return std::find_if(
       from, conn.outstandings.packets.end(), [=](const auto& op) {
-        return !op.declaredLost &&
-            packetNumberSpace == op.packet.header.getPacketNumberSpace();
+        return !op.declaredLost && packetNumberSpace == op.packetNumberSpace;
       });
 }
 
@@ -334,4 +417,22 @@ std::pair<folly::Optional<TimePoint>, PacketNumberSpace> earliestTimeAndSpace(
   return res;
 }
 
+void compactIdleConnectionState(QuicConnectionStateBase& conn) {
+  conn.streamManager->compact();
+  if (conn.cryptoState) {
+    conn.cryptoState->initialStream.compactBuffers();
+    conn.cryptoState->handshakeStream.compactBuffers();
+    conn.cryptoState->oneRttStream.compactBuffers();
+  }
+  conn.outstandings.packets.shrink_to_fit();
+  shrinkToFit(conn.outstandings.packetEvents);
+  conn.streamBufferPool.clear();
+  shrinkToFit(conn.pendingEvents.resets);
+  shrinkToFit(conn.pendingEvents.frames);
+  shrinkToFit(conn.selfConnectionIds);
+  shrinkToFit(conn.peerConnectionIds);
+  conn.datagramState.readBuffer.shrink_to_fit();
+  conn.datagramState.writeBuffer.shrink_to_fit();
+}
+
 } // namespace quic
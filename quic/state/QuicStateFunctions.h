@@ -21,8 +21,34 @@ void updateAckSendStateOnRecvPacket(
     bool pktHasRetransmittableData,
     bool pktHasCryptoData);
 
+/**
+ * Counts the ECN codepoint of a received packet, to be echoed back to the peer
+ * in the next ACK_ECN frame of the packet number space.
+ */
+void updateEcnCountsOnRecvPacket(AckState& ackState, ECNCodepoint ecn);
+
 void updateAckStateOnAckTimeout(QuicConnectionStateBase& conn);
 
+/**
+ * Asks the peer to ack every packetTolerance ack-eliciting packets or after
+ * maxAckDelay, whichever comes first, by sending an ACK_FREQUENCY frame. A
+ * reorderThreshold of 0 asks the peer not to ack out of order packets
+ * immediately. maxAckDelay is capped at kMaxAckTimeout and the PTO accounts
+ * for it from now on. Returns false if the peer does not support the ack
+ * frequency extension.
+ */
+bool requestPeerAckFrequencyChange(
+    QuicConnectionStateBase& conn,
+    uint64_t packetTolerance,
+    std::chrono::microseconds maxAckDelay,
+    uint64_t reorderThreshold);
+
+/**
+ * Asks the peer to ack the packet carrying this request right away. Returns
+ * false if the peer does not support the ack frequency extension.
+ */
+bool requestPeerImmediateAck(QuicConnectionStateBase& conn);
+
 void updateAckSendStateOnSentPacketWithAcks(
     QuicConnectionStateBase& conn,
     AckState& ackState,
@@ -35,6 +61,13 @@ void updateRtt(
 
 bool isConnectionPaced(const QuicConnectionStateBase& conn) noexcept;
 
+/**
+ * Whether a paced connection leaves the spacing of its bursts to the kernel
+ * by stamping them with SO_TXTIME departure times. Only the chained memory
+ * data path supports this.
+ */
+bool isTxTimePaced(const QuicConnectionStateBase& conn) noexcept;
+
 AckState& getAckState(
     QuicConnectionStateBase& conn,
     PacketNumberSpace pnSpace) noexcept;
@@ -77,18 +110,18 @@ bool updateLargestReceivedPacketNum(
   return expectedNextPacket != packetNum;
 }
 
-std::deque<OutstandingPacket>::iterator getNextOutstandingPacket(
+CircularDeque<OutstandingPacket>::iterator getNextOutstandingPacket(
     QuicConnectionStateBase& conn,
     PacketNumberSpace packetNumberSpace,
-    std::deque<OutstandingPacket>::iterator from);
-std::deque<OutstandingPacket>::iterator getFirstOutstandingPacket(
+    CircularDeque<OutstandingPacket>::iterator from);
+CircularDeque<OutstandingPacket>::iterator getFirstOutstandingPacket(
     QuicConnectionStateBase& conn,
     PacketNumberSpace packetNumberSpace);
 
-std::deque<OutstandingPacket>::reverse_iterator getLastOutstandingPacket(
+CircularDeque<OutstandingPacket>::reverse_iterator getLastOutstandingPacket(
     QuicConnectionStateBase& conn,
     PacketNumberSpace packetNumberSpace);
-std::deque<OutstandingPacket>::reverse_iterator
+CircularDeque<OutstandingPacket>::reverse_iterator
 getLastOutstandingPacketIncludingLost(
     QuicConnectionStateBase& conn,
     PacketNumberSpace packetNumberSpace);
@@ -117,4 +150,13 @@ std::pair<folly::Optional<TimePoint>, PacketNumberSpace> earliestTimeAndSpace(
     const EnumArray<PacketNumberSpace, folly::Optional<TimePoint>>& times,
     bool considerAppData) noexcept;
 
+/**
+ * Releases the memory the connection kept from when it was busier: the stream
+ * sets and buffers, the outstanding packet list, pooled stream buffers and
+ * pending frame containers. Nothing that is still in use is dropped, so this
+ * is safe to call at any time, but it is meant for connections that have been
+ * quiet for a while, as the memory is allocated again once they get busy.
+ */
+void compactIdleConnectionState(QuicConnectionStateBase& conn);
+
 } // namespace quic
@@ -503,6 +503,26 @@ void QuicStreamManager::updateWritableStreams(QuicStreamState& stream) {
   }
 }
 
+bool QuicStreamManager::setStreamPriority(
+    StreamId id,
+    PriorityLevel level,
+    bool incremental) {
+  if (level > kDefaultMaxPriority) {
+    level = kDefaultMaxPriority;
+  }
+  auto stream = findStream(id);
+  if (!stream) {
+    return false;
+  }
+  Priority newPriority(level, incremental);
+  if (stream->priority == newPriority) {
+    return false;
+  }
+  stream->priority = newPriority;
+  writableStreams_.updateIfExist(id, newPriority);
+  return true;
+}
+
 void QuicStreamManager::updatePeekableStreams(QuicStreamState& stream) {
   if (stream.hasPeekableData() && !stream.streamReadError.has_value()) {
     peekableStreams_.emplace(stream.id);
@@ -538,4 +558,31 @@ bool QuicStreamManager::isAppIdle() const {
   return isAppIdle_;
 }
 
+void QuicStreamManager::compact() {
+  for (auto& stream : streams_) {
+    stream.second.compactBuffers();
+  }
+  if (streams_.empty()) {
+    shrinkToFit(streams_);
+  }
+  shrinkToFit(openBidirectionalPeerStreams_);
+  shrinkToFit(openUnidirectionalPeerStreams_);
+  shrinkToFit(openBidirectionalLocalStreams_);
+  shrinkToFit(openUnidirectionalLocalStreams_);
+  shrinkToFit(newPeerStreams_);
+  shrinkToFit(blockedStreams_);
+  shrinkToFit(stopSendingStreams_);
+  shrinkToFit(dataExpiredStreams_);
+  shrinkToFit(dataRejectedStreams_);
+  shrinkToFit(windowUpdates_);
+  shrinkToFit(flowControlUpdated_);
+  shrinkToFit(lossStreams_);
+  shrinkToFit(readableStreams_);
+  shrinkToFit(peekableStreams_);
+  writableStreams_.compact();
+  shrinkToFit(txStreams_);
+  shrinkToFit(deliverableStreams_);
+  shrinkToFit(closedStreams_);
+}
+
 } // namespace quic
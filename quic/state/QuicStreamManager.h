@@ -12,6 +12,7 @@
 #include <folly/container/F14Set.h>
 #include <quic/QuicConstants.h>
 #include <quic/codec/Types.h>
+#include <quic/state/QuicPriorityQueue.h>
 #include <quic/state/StreamData.h>
 #include <quic/state/TransportSettings.h>
 #include <numeric>
@@ -167,6 +168,14 @@ class QuicStreamManager {
     newPeerStreams_.clear();
   }
 
+  /*
+   * Release the memory the stream sets and the buffers of every stream kept
+   * from when the connection was busier. The stream state itself is kept. The
+   * map of streams is only released once there are no streams left, as
+   * rebuilding it would move the stream states.
+   */
+  void compact();
+
   /*
    * Clear all the currently open streams.
    */
@@ -209,8 +218,8 @@ class QuicStreamManager {
 
   // TODO figure out a better interface here.
   /*
-   * Returns a mutable reference to the container holding the writable stream
-   * IDs.
+   * Returns a mutable reference to the priority queue holding the writable
+   * non-control stream IDs.
    */
   auto& writableStreams() {
     return writableStreams_;
@@ -247,7 +256,7 @@ class QuicStreamManager {
     if (stream.isControl) {
       writableControlStreams_.insert(stream.id);
     } else {
-      writableStreams_.insert(stream.id);
+      writableStreams_.insertOrUpdate(stream.id, stream.priority);
     }
   }
 
@@ -262,6 +271,12 @@ class QuicStreamManager {
     }
   }
 
+  /*
+   * Update the priority of a stream. Returns true if the priority of the
+   * stream changed. Levels above kDefaultMaxPriority are capped to it.
+   */
+  bool setStreamPriority(StreamId id, PriorityLevel level, bool incremental);
+
   /*
    * Clear the writable streams.
    */
@@ -888,8 +903,8 @@ class QuicStreamManager {
   // Set of streams that have pending peeks
   folly::F14FastSet<StreamId> peekableStreams_;
 
-  // Set of !control streams that have writable data
-  std::set<StreamId> writableStreams_;
+  // Priority queue of !control streams that have writable data
+  PriorityQueue writableStreams_;
 
   // Set of control streams that have writable data
   std::set<StreamId> writableControlStreams_;
@@ -94,10 +94,14 @@ class QuicTransportStatsCallback {
 
   virtual void onForwardedPacketProcessed() = 0;
 
+  virtual void onPacketMisrouted() = 0;
+
   virtual void onClientInitialReceived(QuicVersion version) = 0;
 
   virtual void onConnectionRateLimited() = 0;
 
+  virtual void onRetryPacketSent() = 0;
+
   // connection level metrics:
   virtual void onNewConnection() = 0;
 
@@ -122,6 +126,14 @@ class QuicTransportStatsCallback {
 
   virtual void onStreamFlowControlBlocked() = 0;
 
+  virtual void onConnFlowControlWindowIncreased() = 0;
+
+  virtual void onStreamFlowControlWindowIncreased() = 0;
+
+  virtual void onFlowControlWindowBudgetExhausted() = 0;
+
+  virtual void onBufferMemoryPoolUsage(uint64_t usedBytes) = 0;
+
   virtual void onCwndBlocked() = 0;
 
   // retransmission timeout counter
@@ -51,11 +51,23 @@ folly::Optional<QuicSimpleFrame> updateSimpleFrameOnPacketClone(
     case QuicSimpleFrame::Type::PathResponseFrame_E:
       // Do not clone PATH_RESPONSE to avoid buffering
       return folly::none;
+    case QuicSimpleFrame::Type::AckFrequencyFrame_E:
+      // A newer request supersedes this one.
+      if (!conn.ackFrequencyState.lastRequested ||
+          !(*frame.asAckFrequencyFrame() ==
+            *conn.ackFrequencyState.lastRequested)) {
+        return folly::none;
+      }
+      return QuicSimpleFrame(frame);
+    case QuicSimpleFrame::Type::ImmediateAckFrame_E:
+      // The ACK triggered by the original packet is good enough.
+      return folly::none;
     case QuicSimpleFrame::Type::NewConnectionIdFrame_E:
     case QuicSimpleFrame::Type::MaxStreamsFrame_E:
     case QuicSimpleFrame::Type::HandshakeDoneFrame_E:
     case QuicSimpleFrame::Type::KnobFrame_E:
     case QuicSimpleFrame::Type::RetireConnectionIdFrame_E:
+    case QuicSimpleFrame::Type::NewTokenFrame_E:
       // TODO junqiw
       return QuicSimpleFrame(frame);
   }
@@ -124,6 +136,18 @@ void updateSimpleFrameOnPacketLoss(
       // Do not retransmit PATH_RESPONSE to avoid buffering
       break;
     }
+    case QuicSimpleFrame::Type::AckFrequencyFrame_E: {
+      const AckFrequencyFrame& ackFrequency = *frame.asAckFrequencyFrame();
+      if (conn.ackFrequencyState.lastRequested &&
+          ackFrequency == *conn.ackFrequencyState.lastRequested) {
+        conn.pendingEvents.frames.push_back(ackFrequency);
+      }
+      break;
+    }
+    case QuicSimpleFrame::Type::ImmediateAckFrame_E: {
+      // The loss itself elicits an ACK, no need to ask again.
+      break;
+    }
     case QuicSimpleFrame::Type::HandshakeDoneFrame_E: {
       const auto& handshakeDoneFrame = *frame.asHandshakeDoneFrame();
       conn.pendingEvents.frames.push_back(handshakeDoneFrame);
@@ -132,6 +156,7 @@ void updateSimpleFrameOnPacketLoss(
     case QuicSimpleFrame::Type::MaxStreamsFrame_E:
     case QuicSimpleFrame::Type::RetireConnectionIdFrame_E:
     case QuicSimpleFrame::Type::KnobFrame_E:
+    case QuicSimpleFrame::Type::NewTokenFrame_E:
       conn.pendingEvents.frames.push_back(frame);
       break;
   }
@@ -293,6 +318,51 @@ bool updateSimpleFrameOnPacketReceived(
           knobFrame.knobSpace, knobFrame.id, knobFrame.blob->clone());
       return true;
     }
+    case QuicSimpleFrame::Type::AckFrequencyFrame_E: {
+      const AckFrequencyFrame& ackFrequency = *frame.asAckFrequencyFrame();
+      if (!conn.transportSettings.minAckDelay) {
+        throw QuicTransportException(
+            "Received ACK_FREQUENCY without advertising min_ack_delay.",
+            TransportErrorCode::PROTOCOL_VIOLATION,
+            FrameType::ACK_FREQUENCY);
+      }
+      if (ackFrequency.updateMaxAckDelay <
+          static_cast<uint64_t>(conn.transportSettings.minAckDelay->count())) {
+        throw QuicTransportException(
+            "ACK_FREQUENCY max ack delay below min_ack_delay.",
+            TransportErrorCode::PROTOCOL_VIOLATION,
+            FrameType::ACK_FREQUENCY);
+      }
+      auto& peerRequest = conn.ackFrequencyState.peerRequest;
+      if (peerRequest &&
+          ackFrequency.sequenceNumber <= peerRequest->sequenceNumber) {
+        // Reordered or retransmitted older request.
+        return true;
+      }
+      peerRequest = ackFrequency;
+      peerRequest->packetTolerance = std::min(
+          std::max<uint64_t>(peerRequest->packetTolerance, 1),
+          kMaxAckFrequencyPacketTolerance);
+      // Never hold an ACK longer than our own ack timer allows.
+      peerRequest->updateMaxAckDelay = std::min<uint64_t>(
+          peerRequest->updateMaxAckDelay, kMaxAckTimeout.count());
+      return true;
+    }
+    case QuicSimpleFrame::Type::ImmediateAckFrame_E: {
+      if (!conn.transportSettings.minAckDelay) {
+        throw QuicTransportException(
+            "Received IMMEDIATE_ACK without advertising min_ack_delay.",
+            TransportErrorCode::PROTOCOL_VIOLATION,
+            FrameType::IMMEDIATE_ACK);
+      }
+      conn.ackStates.appDataAckState.immediateAckRequested = true;
+      return true;
+    }
+    case QuicSimpleFrame::Type::NewTokenFrame_E: {
+      // NEW_TOKEN is decoded into a ReadNewTokenFrame, which the client
+      // transport handles.
+      return true;
+    }
   }
   folly::assume_unreachable();
 }
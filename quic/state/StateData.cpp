@@ -94,6 +94,19 @@ PacingRate PacingRate::Builder::build() && {
   return PacingRate(interval_, burstSize_);
 }
 
+QuicConnectionStateBase::~QuicConnectionStateBase() {
+  if (bufferMemoryPool) {
+    if (bufferMemoryCallback) {
+      bufferMemoryPool->cancelNotifyOnRelease(bufferMemoryCallback);
+    }
+    bufferMemoryPool->release(bufferMemoryCharged);
+  }
+  if (flowControlState.windowBudget) {
+    flowControlState.windowBudget->release(
+        flowControlState.windowBudgetCharged);
+  }
+}
+
 CongestionController::AckEvent::AckPacket::AckPacket(
     TimePoint sentTimeIn,
     uint32_t encodedSizeIn,
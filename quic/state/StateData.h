@@ -15,16 +15,21 @@
 #include <quic/codec/QuicWriteCodec.h>
 #include <quic/codec/Types.h>
 #include <quic/common/BufAccessor.h>
+#include <quic/common/CircularDeque.h>
 #include <quic/common/EnumArray.h>
+#include <quic/common/SmallVec.h>
+#include <quic/common/ZeroCopySendTracker.h>
 #include <quic/d6d/ProbeSizeRaiser.h>
 #include <quic/handshake/HandshakeLayer.h>
 #include <quic/logging/QLogger.h>
 #include <quic/state/AckStates.h>
+#include <quic/state/BufferMemoryPool.h>
 #include <quic/state/OutstandingPacket.h>
 #include <quic/state/PacketEvent.h>
 #include <quic/state/PendingPathRateLimiter.h>
 #include <quic/state/QuicStreamManager.h>
 #include <quic/state/QuicTransportStatsCallback.h>
+#include <quic/state/StreamBufferPool.h>
 #include <quic/state/StreamData.h>
 #include <quic/state/TransportSettings.h>
 
@@ -65,17 +70,38 @@ struct RecvmmsgStorage {
 struct NetworkData {
   TimePoint receiveTimePoint;
   std::vector<Buf> packets;
+  // ECN codepoints of the packets, in the same order. Empty if none of the
+  // packets carried an ECN codepoint.
+  std::vector<ECNCodepoint> ecnMarks;
   size_t totalData{0};
 
   NetworkData() = default;
-  NetworkData(Buf&& buf, const TimePoint& receiveTime)
+  NetworkData(
+      Buf&& buf,
+      const TimePoint& receiveTime,
+      ECNCodepoint ecn = ECNCodepoint::NotECT)
       : receiveTimePoint(receiveTime) {
     if (buf) {
       totalData = buf->computeChainDataLength();
-      packets.emplace_back(std::move(buf));
+      addPacket(std::move(buf), ecn);
     }
   }
 
+  /**
+   * Append a packet without updating totalData.
+   */
+  void addPacket(Buf&& buf, ECNCodepoint ecn = ECNCodepoint::NotECT) {
+    if (ecn != ECNCodepoint::NotECT || !ecnMarks.empty()) {
+      ecnMarks.resize(packets.size(), ECNCodepoint::NotECT);
+      ecnMarks.push_back(ecn);
+    }
+    packets.emplace_back(std::move(buf));
+  }
+
+  ECNCodepoint getEcnMark(size_t index) const {
+    return index < ecnMarks.size() ? ecnMarks[index] : ECNCodepoint::NotECT;
+  }
+
   std::unique_ptr<folly::IOBuf> moveAllData() && {
     std::unique_ptr<folly::IOBuf> buf;
     for (size_t i = 0; i < packets.size(); ++i) {
@@ -93,13 +119,15 @@ struct NetworkDataSingle {
   Buf data;
   TimePoint receiveTimePoint;
   size_t totalData{0};
+  ECNCodepoint ecn{ECNCodepoint::NotECT};
 
   NetworkDataSingle() = default;
 
   NetworkDataSingle(
       std::unique_ptr<folly::IOBuf> buf,
-      const TimePoint& receiveTime)
-      : data(std::move(buf)), receiveTimePoint(receiveTime) {
+      const TimePoint& receiveTime,
+      ECNCodepoint ecnIn = ECNCodepoint::NotECT)
+      : data(std::move(buf)), receiveTimePoint(receiveTime), ecn(ecnIn) {
     if (data) {
       totalData += data->computeChainDataLength();
     }
@@ -108,7 +136,7 @@ struct NetworkDataSingle {
 
 struct OutstandingsInfo {
   // Sent packets which have not been acked. These are sorted by PacketNum.
-  std::deque<OutstandingPacket> packets;
+  CircularDeque<OutstandingPacket> packets;
 
   // All PacketEvents of this connection. If a OutstandingPacket doesn't have an
   // associatedEvent or if it's not in this set, there is no need to process its
@@ -136,6 +164,24 @@ struct OutstandingsInfo {
   }
 };
 
+struct PacingRate {
+  std::chrono::microseconds interval{0us};
+  uint64_t burstSize{0};
+
+  struct Builder {
+    Builder&& setInterval(std::chrono::microseconds interval) &&;
+    Builder&& setBurstSize(uint64_t burstSize) &&;
+    PacingRate build() &&;
+
+   private:
+    std::chrono::microseconds interval_{0us};
+    uint64_t burstSize_{0};
+  };
+
+ private:
+  PacingRate(std::chrono::microseconds interval, uint64_t burstSize);
+};
+
 struct Pacer {
   virtual ~Pacer() = default;
 
@@ -186,28 +232,17 @@ struct Pacer {
    */
   virtual uint64_t getCachedWriteBatchSize() const = 0;
 
+  /**
+   * The current burst size and the interval between bursts, for transports
+   * that schedule departures ahead of time instead of waiting for the interval
+   * to pass.
+   */
+  virtual PacingRate getPacingRate() const = 0;
+
   virtual void onPacketSent() = 0;
   virtual void onPacketsLoss() = 0;
 };
 
-struct PacingRate {
-  std::chrono::microseconds interval{0us};
-  uint64_t burstSize{0};
-
-  struct Builder {
-    Builder&& setInterval(std::chrono::microseconds interval) &&;
-    Builder&& setBurstSize(uint64_t burstSize) &&;
-    PacingRate build() &&;
-
-   private:
-    std::chrono::microseconds interval_{0us};
-    uint64_t burstSize_{0};
-  };
-
- private:
-  PacingRate(std::chrono::microseconds interval, uint64_t burstSize);
-};
-
 struct CongestionController {
   // Helper struct to group multiple lost packets into one event
   struct LossEvent {
@@ -237,7 +272,7 @@ struct CongestionController {
             "LossEvent: lostBytes overflow",
             LocalErrorCode::LOST_BYTES_OVERFLOW);
       }
-      PacketNum packetNum = packet.packet.header.getPacketSequenceNum();
+      PacketNum packetNum = packet.packetNum;
       largestLostPacketNum =
           std::max(packetNum, largestLostPacketNum.value_or(packetNum));
       lostBytes += packet.encodedSize;
@@ -266,6 +301,9 @@ struct CongestionController {
     folly::Optional<std::chrono::microseconds> mrttSample;
     // If this AckEvent came from an implicit ACK rather than a real one.
     bool implicit{false};
+    // Number of packets the peer newly reported as CE marked in the ACK_ECN
+    // frame, a congestion signal that does not come with any loss.
+    uint64_t ecnCeMarkedPackets{0};
 
     struct AckPacket {
       // Packet sent time when this acked pakcet was first sent.
@@ -313,7 +351,8 @@ struct CongestionController {
           bool isAppLimitedIn);
     };
 
-    std::vector<AckPacket> ackedPackets;
+    // Sized for a typical ACK frame so that processing one does not allocate.
+    SmallVec<AckPacket, kDefaultRxPacketsBeforeAckAfterInit> ackedPackets;
   };
 
   virtual ~CongestionController() = default;
@@ -397,6 +436,18 @@ struct RstStreamEvent {
   ApplicationErrorCode errorCode;
 };
 
+/**
+ * A received datagram along with the time the packet carrying it was
+ * received.
+ */
+struct ReadDatagram {
+  ReadDatagram(TimePoint recvTimePoint, Buf dataIn)
+      : receiveTimePoint(recvTimePoint), data(std::move(dataIn)) {}
+
+  TimePoint receiveTimePoint;
+  Buf data;
+};
+
 using Resets = folly::F14FastMap<StreamId, RstStreamFrame>;
 
 using FrameList = std::vector<QuicSimpleFrame>;
@@ -475,7 +526,7 @@ class LoopDetectorCallback;
 class PendingPathRateLimiter;
 
 struct QuicConnectionStateBase : public folly::DelayedDestruction {
-  virtual ~QuicConnectionStateBase() = default;
+  ~QuicConnectionStateBase() override;
 
   explicit QuicConnectionStateBase(QuicNodeType type) : nodeType(type) {}
 
@@ -485,6 +536,10 @@ struct QuicConnectionStateBase : public folly::DelayedDestruction {
   // Accessor to output buffer for continuous memory GSO writes
   BufAccessor* bufAccessor{nullptr};
 
+  // Sends GSO writes with MSG_ZEROCOPY when zeroCopyGSOWrites is set. Owned by
+  // whoever owns the socket, a server worker shares it between connections.
+  ZeroCopySendTracker* zeroCopySendTracker{nullptr};
+
   std::unique_ptr<Handshake> handshakeLayer;
 
   // Crypto stream
@@ -496,6 +551,10 @@ struct QuicConnectionStateBase : public folly::DelayedDestruction {
   // Pacer
   std::unique_ptr<Pacer> pacer;
 
+  // Departure time of the next burst when the kernel paces the connection with
+  // SO_TXTIME. This runs ahead of now by up to txTimeHorizon.
+  TimePoint nextTxTimeDeparture;
+
   // Congestion Controller factory to create specific impl of cc algorithm
   std::shared_ptr<CongestionControllerFactory> congestionControllerFactory;
 
@@ -512,6 +571,9 @@ struct QuicConnectionStateBase : public folly::DelayedDestruction {
   // class
   OutstandingsInfo outstandings;
 
+  // Recycled retransmission buffer nodes for the stream frames written next.
+  StreamBufferPool streamBufferPool{kMaxPooledStreamBuffers};
+
   // The read codec to decrypt and decode packets.
   std::unique_ptr<QuicReadCodec> readCodec;
 
@@ -654,6 +716,10 @@ struct QuicConnectionStateBase : public folly::DelayedDestruction {
   struct ConnectionFlowControlState {
     // The size of the connection flow control window.
     uint64_t windowSize{0};
+    // Budget the window growth from autotuning was charged against, and how
+    // much was charged. Released when the connection goes away.
+    std::shared_ptr<FlowControlWindowBudget> windowBudget;
+    uint64_t windowBudgetCharged{0};
     // The max data we have advertised to the peer.
     uint64_t advertisedMaxOffset{0};
     // The max data the peer has advertised on the connection.
@@ -707,7 +773,6 @@ struct QuicConnectionStateBase : public folly::DelayedDestruction {
   uint64_t udpSendPacketLen{kDefaultUDPSendPacketLen};
 
   struct PacketSchedulingState {
-    StreamId nextScheduledStream{0};
     StreamId nextScheduledControlStream{0};
   };
 
@@ -722,6 +787,14 @@ struct QuicConnectionStateBase : public folly::DelayedDestruction {
   // Track stats for various server events
   QuicTransportStatsCallback* statsCallback{nullptr};
 
+  // Pool the stream buffers of this connection are charged against, shared
+  // with the other connections of the same worker, and the bytes charged.
+  std::shared_ptr<BufferMemoryPool> bufferMemoryPool;
+  uint64_t bufferMemoryCharged{0};
+  // Told when the pool frees up memory while the connection's window is held
+  // back by it.
+  BufferMemoryPool::Callback* bufferMemoryCallback{nullptr};
+
   struct HappyEyeballsState {
     // Delay timer
     folly::HHWheelTimer::Callback* connAttemptDelayTimeout{nullptr};
@@ -791,6 +864,49 @@ struct QuicConnectionStateBase : public folly::DelayedDestruction {
 
   D6DState d6d;
 
+  struct DatagramState {
+    // Max DATAGRAM frame size we accept, 0 means datagrams are disabled.
+    uint64_t maxReadFrameSize{0};
+    // Max DATAGRAM frame size the peer accepts, 0 means the peer does not
+    // support datagrams.
+    uint64_t maxWriteFrameSize{0};
+    uint32_t maxReadBufferSize{kDefaultMaxDatagramsBuffered};
+    uint32_t maxWriteBufferSize{kDefaultMaxDatagramsBuffered};
+    // Received datagrams that have not been read by the application yet.
+    CircularDeque<ReadDatagram> readBuffer;
+    // Datagrams waiting to be written.
+    CircularDeque<Buf> writeBuffer;
+  };
+
+  DatagramState datagramState;
+
+  struct AckFrequencyState {
+    // min_ack_delay advertised by the peer. Only set if the peer accepts
+    // ACK_FREQUENCY frames.
+    folly::Optional<std::chrono::microseconds> peerMinAckDelay;
+    // Sequence number of the next ACK_FREQUENCY frame we send.
+    uint64_t nextSequenceNumber{0};
+    // The latest ACK_FREQUENCY frame we asked the peer for. Older ones are
+    // neither cloned nor retransmitted.
+    folly::Optional<AckFrequencyFrame> lastRequested;
+    // The ack policy the peer asked us to use for the AppData packet number
+    // space, i.e. the ACK_FREQUENCY frame with the largest sequence number.
+    folly::Optional<AckFrequencyFrame> peerRequest;
+  };
+
+  AckFrequencyState ackFrequencyState;
+
+  struct ECNState {
+    // Set once the peer's ACK_ECN feedback fails to account for the packets
+    // we marked, e.g. because the path drops or bleaches the codepoint. ECN
+    // is not used by the connection after that.
+    bool validationFailed{false};
+    // Number of times the peer reported newly CE marked packets.
+    uint64_t ceEvents{0};
+  };
+
+  ECNState ecnState;
+
   // Whether a connection can be paced based on its handshake and close states.
   // For example, we may not want to pace a connection that's still handshaking.
   bool canBePaced{false};
@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/state/StreamBufferPool.h>
+
+namespace quic {
+
+StreamBufferPool::StreamBufferPool(size_t maxPooled) : maxPooled_(maxPooled) {
+  buffers_.reserve(maxPooled_);
+}
+
+std::unique_ptr<StreamBuffer>
+StreamBufferPool::get(Buf data, uint64_t offset, bool eof) {
+  if (buffers_.empty()) {
+    return std::make_unique<StreamBuffer>(std::move(data), offset, eof);
+  }
+  auto buffer = std::move(buffers_.back());
+  buffers_.pop_back();
+  buffer->data = BufQueue(std::move(data));
+  buffer->offset = offset;
+  buffer->eof = eof;
+  return buffer;
+}
+
+void StreamBufferPool::put(std::unique_ptr<StreamBuffer> buffer) {
+  if (!buffer) {
+    return;
+  }
+  buffer->data.move();
+  if (buffers_.size() < maxPooled_) {
+    buffers_.push_back(std::move(buffer));
+  }
+}
+
+size_t StreamBufferPool::size() const noexcept {
+  return buffers_.size();
+}
+
+void StreamBufferPool::clear() {
+  buffers_.clear();
+}
+
+} // namespace quic
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#pragma once
+
+#include <quic/state/StreamData.h>
+
+#include <memory>
+#include <vector>
+
+namespace quic {
+
+/**
+ * Recycles the StreamBuffer nodes of the retransmission buffers of one
+ * connection. Every stream frame written puts a node into a retransmission
+ * buffer and every ack takes one out, so handing the acked nodes back to the
+ * next write keeps the send path from allocating a node per frame once the
+ * connection reaches a steady state.
+ */
+class StreamBufferPool {
+ public:
+  explicit StreamBufferPool(size_t maxPooled);
+
+  /**
+   * Returns a buffer holding data, reusing a pooled node when there is one.
+   */
+  std::unique_ptr<StreamBuffer>
+  get(Buf data, uint64_t offset, bool eof = false);
+
+  /**
+   * Takes back a buffer that is no longer needed. Its data is freed right away,
+   * only the node itself is kept for reuse.
+   */
+  void put(std::unique_ptr<StreamBuffer> buffer);
+
+  size_t size() const noexcept;
+
+  /**
+   * Frees all the pooled nodes.
+   */
+  void clear();
+
+ private:
+  const size_t maxPooled_;
+  std::vector<std::unique_ptr<StreamBuffer>> buffers_;
+};
+
+} // namespace quic
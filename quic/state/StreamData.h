@@ -11,7 +11,9 @@
 #include <folly/container/F14Map.h>
 #include <quic/QuicConstants.h>
 #include <quic/codec/Types.h>
+#include <quic/common/ContainerUtils.h>
 #include <quic/common/SmallVec.h>
+#include <quic/state/QuicPriorityQueue.h>
 
 namespace quic {
 
@@ -98,9 +100,10 @@ struct QuicStreamLike {
 
   /*
    * Either insert a new entry into the loss buffer, or merge the buffer with
-   * an existing entry.
+   * an existing entry. Returns the emptied node of buf so it can be reused.
    */
-  void insertIntoLossBuffer(std::unique_ptr<StreamBuffer> buf) {
+  std::unique_ptr<StreamBuffer> insertIntoLossBuffer(
+      std::unique_ptr<StreamBuffer> buf) {
     // We assume here that we won't try to insert an overlapping buffer, as
     // that should never happen in the loss buffer.
     auto lossItr = std::upper_bound(
@@ -116,6 +119,17 @@ struct QuicStreamLike {
     } else {
       lossBuffer.insert(lossItr, std::move(*buf));
     }
+    return buf;
+  }
+
+  /*
+   * Release the memory the buffers kept from when more data was in flight on
+   * the stream. The buffered data itself is kept.
+   */
+  void compactBuffers() {
+    readBuffer.shrink_to_fit();
+    lossBuffer.shrink_to_fit();
+    shrinkToFit(retransmissionBuffer);
   }
 };
 
@@ -199,6 +213,10 @@ struct QuicStreamState : public QuicStreamLike {
   // congestion control with control streams still active.
   bool isControl{false};
 
+  // Send priority of the stream, set by the app via setStreamPriority. Used by
+  // the stream frame scheduler to order non-control streams.
+  Priority priority{kDefaultPriority};
+
   // The last time we detected we were head of line blocked on the stream.
   folly::Optional<Clock::time_point> lastHolbTime;
 
@@ -10,7 +10,9 @@
 
 #include <quic/QuicConstants.h>
 #include <quic/codec/QuicConnectionId.h>
+#include <quic/state/FlowControlWindowBudget.h>
 #include <chrono>
+#include <memory>
 
 namespace quic {
 
@@ -37,6 +39,13 @@ struct BbrConfig {
    * haven't reached the drain target.
    */
   bool drainToTarget{false};
+
+  /**
+   * Number of ACKs per RTT that BBR asks the peer for with ACK_FREQUENCY once
+   * it reaches ProbeBw. 0 keeps the peer's default ack policy. Only takes
+   * effect if the peer supports the ack frequency extension.
+   */
+  uint32_t ackFrequencyAcksPerRtt{0};
 };
 
 struct D6DConfig {
@@ -90,6 +99,17 @@ struct D6DConfig {
   ProbeSizeRaiserType raiserType{ProbeSizeRaiserType::ConstantStep};
 };
 
+struct DatagramConfig {
+  // Whether to advertise support for, and accept, DATAGRAM frames.
+  bool enabled{false};
+  // Max number of received datagrams buffered until the application reads
+  // them. The oldest datagram is dropped when the buffer is full.
+  uint32_t readBufSize{kDefaultMaxDatagramsBuffered};
+  // Max number of datagrams buffered for sending. Writes are refused when the
+  // buffer is full.
+  uint32_t writeBufSize{kDefaultMaxDatagramsBuffered};
+};
+
 struct TransportSettings {
   // The initial connection window advertised to the peer.
   uint64_t advertisedInitialConnectionWindowSize{kDefaultConnectionWindowSize};
@@ -104,6 +124,9 @@ struct TransportSettings {
   uint32_t maxPacketsToBuffer{kDefaultMaxBufferedPackets};
   // Idle timeout to advertise to the peer.
   std::chrono::milliseconds idleTimeout{kDefaultIdleTimeout};
+  // How long the connection has to be quiet before the memory its containers
+  // kept from busier times is released. 0 disables compaction.
+  std::chrono::milliseconds idleCompactionTimeout{0ms};
   // Ack delay exponent to use.
   uint64_t ackDelayExponent{kDefaultAckDelayExponent};
   // Default congestion controller type.
@@ -136,6 +159,13 @@ struct TransportSettings {
   // Pacing timer tick interval
   std::chrono::microseconds pacingTimerTickInterval{
       kDefaultPacingTimerTickInterval};
+  // Whether a paced connection stamps every packet with its departure time
+  // (SO_TXTIME) and leaves the spacing to the fq qdisc instead of the pacing
+  // timer. Turned off again if the socket rejects SO_TXTIME.
+  bool pacingWithTxTime{false};
+  // How far ahead of their departure time packets are written with
+  // pacingWithTxTime.
+  std::chrono::microseconds txTimeHorizon{kDefaultTxTimeHorizon};
   ZeroRttSourceTokenMatchingPolicy zeroRttSourceTokenMatchingPolicy{
       ZeroRttSourceTokenMatchingPolicy::REJECT_IF_NO_EXACT_MATCH};
   bool attemptEarlyData{false};
@@ -151,8 +181,35 @@ struct TransportSettings {
   // Frequency of sending flow control updates. We can send one update every
   // flowControlWindowFrequency * window if the flow control changes.
   uint16_t flowControlWindowFrequency{2};
+  // Whether to double the receive windows of streams and of the connection
+  // when an update is due less than flowControlRttFrequency * RTT after the
+  // previous one, i.e. when the window rather than the RTT paces the peer.
+  // Windows start at the advertisedInitial sizes.
+  bool autotuneFlowControlWindows{false};
+  // Caps of the autotuned stream and connection windows.
+  uint64_t maxAutotuneStreamWindowSize{kDefaultMaxAutotuneStreamWindowSize};
+  uint64_t maxAutotuneConnectionWindowSize{
+      kDefaultMaxAutotuneConnectionWindowSize};
+  // Budget the growth of the autotuned connection windows is charged against.
+  // Connections given the same budget share it. No limit when null.
+  std::shared_ptr<FlowControlWindowBudget> flowControlWindowBudget;
+  // Memory the stream buffers of all the connections of a server worker may
+  // use together. 0 means no limit.
+  uint64_t workerBufferMemoryLimit{0};
+  // ECN codepoint outgoing packets are marked with, NotECT disables ECN
+  // marking. ECT(1) is meant for L4S style networks.
+  ECNCodepoint ecnMarking{ECNCodepoint::NotECT};
+  // Whether to read the ECN codepoint of received packets and report it back
+  // to the peer in ACK_ECN frames. Server workers read with recvmmsg when this
+  // is set, whatever shouldRecvBatch says.
+  bool readEcnOnIngress{false};
   // batching mode
   QuicBatchingMode batchingMode{QuicBatchingMode::BATCHING_MODE_NONE};
+  // Whether large GSO batches are sent with MSG_ZEROCOPY rather than copied
+  // into the kernel. Needs BATCHING_MODE_GSO and the socket error message
+  // callback, which delivers the completions. Turned off again if the socket
+  // rejects SO_ZEROCOPY.
+  bool zeroCopyGSOWrites{false};
   // use thread local batcher - currently it works only with
   // BATCHING_MODE_SENDMMSG_GSO it will not be enabled if the mode is different
   bool useThreadLocalBatching{false};
@@ -177,6 +234,9 @@ struct TransportSettings {
       kDefaultRxPacketsBeforeAckInitThreshold};
   uint16_t rxPacketsBeforeAckBeforeInit{kDefaultRxPacketsBeforeAckBeforeInit};
   uint16_t rxPacketsBeforeAckAfterInit{kDefaultRxPacketsBeforeAckAfterInit};
+  // The min_ack_delay transport parameter sent to the peer. When set, the peer
+  // may change our ack policy with ACK_FREQUENCY and IMMEDIATE_ACK frames.
+  folly::Optional<std::chrono::microseconds> minAckDelay;
   // Limits the amount of data that should be buffered in a QuicSocket.
   // If the amount of data in the buffer equals or exceeds this amount, then
   // the callback registered through notifyPendingWriteOnConnection() will
@@ -191,6 +251,10 @@ struct TransportSettings {
   // default stateless reset secret for stateless reset token
   folly::Optional<std::array<uint8_t, kStatelessResetTokenSecretLength>>
       statelessResetTokenSecret;
+  // Secret sealing the address validation tokens of Retry packets and
+  // NEW_TOKEN frames. Servers that should accept each other's tokens need the
+  // same secret. Without one, the server doesn't send NEW_TOKEN frames.
+  folly::Optional<std::array<uint8_t, kTokenSecretLength>> tokenSecret;
   // Default initial RTT
   std::chrono::microseconds initialRtt{kDefaultInitialRtt};
   // The active_connection_id_limit that is sent to the peer.
@@ -219,6 +283,8 @@ struct TransportSettings {
   bool orderedReadCallbacks{false};
   // Config struct for D6D
   D6DConfig d6dConfig;
+  // Config struct for unreliable datagrams
+  DatagramConfig datagramConfig;
 };
 
 } // namespace quic
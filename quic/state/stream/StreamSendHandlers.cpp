@@ -103,6 +103,7 @@ void sendAckSMHandler(
               ackedBuffer->second->offset,
               ackedBuffer->second->offset +
                   ackedBuffer->second->data.chainLength());
+          stream.conn.streamBufferPool.put(std::move(ackedBuffer->second));
           stream.retransmissionBuffer.erase(ackedBuffer);
         } else {
           VLOG(10)
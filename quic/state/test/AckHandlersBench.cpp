@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <folly/Benchmark.h>
+#include <folly/init/Init.h>
+
+#include <quic/common/test/TestUtils.h>
+#include <quic/fizz/server/handshake/FizzServerQuicHandshakeContext.h>
+#include <quic/server/state/ServerStateMachine.h>
+#include <quic/state/AckHandlers.h>
+
+using namespace quic;
+using namespace quic::test;
+
+namespace {
+
+void sendPacket(QuicConnectionStateBase& conn, PacketNum packetNum) {
+  auto packet = createNewPacket(packetNum, PacketNumberSpace::AppData);
+  packet.frames.emplace_back(
+      WriteStreamFrame(4, packetNum * 1000, 1000, false));
+  conn.outstandings.packets.emplace_back(
+      std::move(packet), Clock::now(), 1000, false, packetNum * 1000);
+}
+
+std::unique_ptr<QuicServerConnectionState> makeConnWithOutstandings(
+    size_t numOutstanding) {
+  auto conn = std::make_unique<QuicServerConnectionState>(
+      FizzServerQuicHandshakeContext::Builder().build());
+  // Keep loss detection from declaring anything lost.
+  conn->lossState.srtt = std::chrono::seconds(10);
+  conn->lossState.reorderingThreshold = std::numeric_limits<uint32_t>::max();
+  for (PacketNum packetNum = 0; packetNum < numOutstanding; packetNum++) {
+    sendPacket(*conn, packetNum);
+  }
+  return conn;
+}
+
+/**
+ * Steady state of a connection with numOutstanding packets in flight: each ACK
+ * acknowledges the two oldest packets, and two new packets are sent so that
+ * the number of outstanding packets stays the same.
+ */
+void ackOldestBench(uint32_t iters, size_t numOutstanding) {
+  std::unique_ptr<QuicServerConnectionState> conn;
+  BENCHMARK_SUSPEND {
+    conn = makeConnWithOutstandings(numOutstanding);
+  }
+  PacketNum nextToAck = 0;
+  PacketNum nextToSend = numOutstanding;
+  for (uint32_t i = 0; i < iters; i++) {
+    ReadAckFrame ackFrame;
+    ackFrame.largestAcked = nextToAck + 1;
+    ackFrame.ackBlocks.emplace_back(nextToAck, nextToAck + 1);
+    processAckFrame(
+        *conn,
+        PacketNumberSpace::AppData,
+        ackFrame,
+        [](const auto&, const auto& packetFrame, const auto&) {
+          folly::doNotOptimizeAway(packetFrame);
+        },
+        [](auto&, auto&, bool) {},
+        Clock::now());
+    nextToAck += 2;
+    BENCHMARK_SUSPEND {
+      sendPacket(*conn, nextToSend++);
+      sendPacket(*conn, nextToSend++);
+    }
+  }
+}
+
+/**
+ * An ACK with one block per every other packet, i.e. every second packet is
+ * missing, covering the whole window.
+ */
+void ackEveryOtherBench(uint32_t iters, size_t numOutstanding) {
+  for (uint32_t i = 0; i < iters; i++) {
+    std::unique_ptr<QuicServerConnectionState> conn;
+    ReadAckFrame ackFrame;
+    BENCHMARK_SUSPEND {
+      conn = makeConnWithOutstandings(numOutstanding);
+      ackFrame.largestAcked = numOutstanding - 1;
+      for (size_t offset = 0; offset < numOutstanding; offset += 2) {
+        PacketNum packetNum = numOutstanding - 1 - offset;
+        ackFrame.ackBlocks.emplace_back(packetNum, packetNum);
+      }
+    }
+    processAckFrame(
+        *conn,
+        PacketNumberSpace::AppData,
+        ackFrame,
+        [](const auto&, const auto& packetFrame, const auto&) {
+          folly::doNotOptimizeAway(packetFrame);
+        },
+        [](auto&, auto&, bool) {},
+        Clock::now());
+    BENCHMARK_SUSPEND {
+      conn.reset();
+    }
+  }
+}
+
+} // namespace
+
+BENCHMARK_PARAM(ackOldestBench, 1000)
+BENCHMARK_PARAM(ackOldestBench, 10000)
+BENCHMARK_PARAM(ackOldestBench, 100000)
+BENCHMARK_DRAW_LINE();
+BENCHMARK_PARAM(ackEveryOtherBench, 1000)
+BENCHMARK_PARAM(ackEveryOtherBench, 10000)
+BENCHMARK_PARAM(ackEveryOtherBench, 100000)
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
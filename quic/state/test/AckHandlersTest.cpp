@@ -1107,6 +1107,80 @@ TEST_P(AckHandlersTest, ImplictAckEventCreation) {
       ackTime);
 }
 
+TEST_P(AckHandlersTest, EcnCountsValidation) {
+  QuicServerConnectionState conn(
+      FizzServerQuicHandshakeContext::Builder().build());
+  conn.transportSettings.ecnMarking = ECNCodepoint::ECT0;
+  auto mockCongestionController = std::make_unique<MockCongestionController>();
+  auto rawCongestionController = mockCongestionController.get();
+  conn.congestionController = std::move(mockCongestionController);
+
+  for (PacketNum packetNum = 0; packetNum < 15; packetNum++) {
+    auto regularPacket = createNewPacket(packetNum, GetParam());
+    regularPacket.frames.emplace_back(WriteStreamFrame(0, 0, 0, true));
+    conn.outstandings.packets.emplace_back(
+        std::move(regularPacket), Clock::now(), 1, false, packetNum);
+  }
+
+  // The peer saw 5 marked packets, one of them CE.
+  ReadAckFrame ackFrame;
+  ackFrame.largestAcked = 4;
+  ackFrame.ackBlocks.emplace_back(0, 4);
+  ackFrame.ecnCounts = ECNCounts();
+  ackFrame.ecnCounts->ect0 = 4;
+  ackFrame.ecnCounts->ce = 1;
+  EXPECT_CALL(*rawCongestionController, onPacketAckOrLoss(_, _))
+      .WillOnce(Invoke([&](auto ack, auto /* loss */) {
+        EXPECT_EQ(1, ack->ecnCeMarkedPackets);
+      }));
+  processAckFrame(
+      conn,
+      GetParam(),
+      ackFrame,
+      [](const auto&, const auto&, const auto&) {},
+      [](auto&, auto&, bool) {},
+      Clock::now());
+  EXPECT_FALSE(conn.ecnState.validationFailed);
+  EXPECT_EQ(1, conn.ecnState.ceEvents);
+
+  // No new CE marks.
+  ackFrame.largestAcked = 9;
+  ackFrame.ackBlocks.clear();
+  ackFrame.ackBlocks.emplace_back(5, 9);
+  ackFrame.ecnCounts->ect0 = 9;
+  EXPECT_CALL(*rawCongestionController, onPacketAckOrLoss(_, _))
+      .WillOnce(Invoke([&](auto ack, auto /* loss */) {
+        EXPECT_EQ(0, ack->ecnCeMarkedPackets);
+      }));
+  processAckFrame(
+      conn,
+      GetParam(),
+      ackFrame,
+      [](const auto&, const auto&, const auto&) {},
+      [](auto&, auto&, bool) {},
+      Clock::now());
+  EXPECT_FALSE(conn.ecnState.validationFailed);
+
+  // The counts don't account for all of the newly acked packets, the marks
+  // got lost on the path.
+  ackFrame.largestAcked = 14;
+  ackFrame.ackBlocks.clear();
+  ackFrame.ackBlocks.emplace_back(10, 14);
+  ackFrame.ecnCounts->ect0 = 10;
+  EXPECT_CALL(*rawCongestionController, onPacketAckOrLoss(_, _))
+      .WillOnce(Invoke([&](auto ack, auto /* loss */) {
+        EXPECT_EQ(0, ack->ecnCeMarkedPackets);
+      }));
+  processAckFrame(
+      conn,
+      GetParam(),
+      ackFrame,
+      [](const auto&, const auto&, const auto&) {},
+      [](auto&, auto&, bool) {},
+      Clock::now());
+  EXPECT_TRUE(conn.ecnState.validationFailed);
+}
+
 INSTANTIATE_TEST_CASE_P(
     AckHandlersTests,
     AckHandlersTest,
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <quic/common/test/AllocationTracker.h>
+#include <quic/fizz/server/handshake/FizzServerQuicHandshakeContext.h>
+#include <quic/server/state/ServerStateMachine.h>
+#include <quic/state/QuicStateFunctions.h>
+
+namespace quic {
+namespace test {
+
+class ConnectionMemoryTest : public testing::Test {
+ public:
+  void SetUp() override {
+    auto heapBefore = liveHeapBytes();
+    conn = std::make_unique<QuicServerConnectionState>(
+        FizzServerQuicHandshakeContext::Builder().build());
+    conn->streamManager->setMaxLocalBidirectionalStreams(
+        kDefaultMaxStreamsBidirectional);
+    newConnectionHeapBytes = liveHeapBytes() - heapBefore;
+  }
+
+  std::unique_ptr<QuicServerConnectionState> conn;
+  int64_t newConnectionHeapBytes{0};
+};
+
+TEST_F(ConnectionMemoryTest, Footprint) {
+  // Not a limit, but reported so changes to the footprint of a connection show
+  // up in the test results.
+  RecordProperty(
+      "sizeof_QuicServerConnectionState", sizeof(QuicServerConnectionState));
+  RecordProperty("sizeof_QuicStreamManager", sizeof(QuicStreamManager));
+  RecordProperty("sizeof_QuicStreamState", sizeof(QuicStreamState));
+  RecordProperty("sizeof_AckStates", sizeof(AckStates));
+  RecordProperty(
+      "sizeof_PendingEvents", sizeof(QuicConnectionStateBase::PendingEvents));
+  RecordProperty("new_connection_heap_bytes", newConnectionHeapBytes);
+  LOG(INFO) << "sizeof(QuicServerConnectionState)="
+            << sizeof(QuicServerConnectionState)
+            << " sizeof(QuicStreamManager)=" << sizeof(QuicStreamManager)
+            << " sizeof(QuicStreamState)=" << sizeof(QuicStreamState)
+            << " new connection heap bytes=" << newConnectionHeapBytes;
+  EXPECT_GT(newConnectionHeapBytes, 0);
+}
+
+TEST_F(ConnectionMemoryTest, CompactReleasesStreamSets) {
+  auto& manager = *conn->streamManager;
+  auto heapBefore = liveHeapBytes();
+  for (StreamId id = 0; id < 4000; id += 4) {
+    manager.queueWindowUpdate(id);
+    manager.addTx(id);
+    manager.addDeliverable(id);
+  }
+  for (StreamId id = 4; id < 4000; id += 4) {
+    manager.removeWindowUpdate(id);
+    manager.removeTx(id);
+    manager.removeDeliverable(id);
+  }
+  auto heapBusy = liveHeapBytes();
+  EXPECT_GT(heapBusy, heapBefore);
+
+  compactIdleConnectionState(*conn);
+  EXPECT_LT(liveHeapBytes(), heapBusy);
+  EXPECT_TRUE(manager.pendingWindowUpdate(0));
+  EXPECT_FALSE(manager.pendingWindowUpdate(4));
+  EXPECT_TRUE(manager.hasTx());
+  EXPECT_TRUE(manager.hasDeliverable());
+
+  manager.removeWindowUpdate(0);
+  manager.removeTx(0);
+  manager.removeDeliverable(0);
+  compactIdleConnectionState(*conn);
+  EXPECT_LE(liveHeapBytes(), heapBefore);
+}
+
+TEST_F(ConnectionMemoryTest, CompactKeepsStreamData) {
+  auto stream = conn->streamManager->createNextBidirectionalStream().value();
+  auto buf = folly::IOBuf::copyBuffer("idle");
+  for (uint64_t offset = 0; offset < 4000; offset += 4) {
+    stream->retransmissionBuffer.emplace(
+        offset, std::make_unique<StreamBuffer>(buf->clone(), offset));
+  }
+  for (uint64_t offset = 4; offset < 4000; offset += 4) {
+    stream->retransmissionBuffer.erase(offset);
+  }
+  auto heapBusy = liveHeapBytes();
+
+  compactIdleConnectionState(*conn);
+  EXPECT_LT(liveHeapBytes(), heapBusy);
+  ASSERT_EQ(stream->retransmissionBuffer.size(), 1);
+  auto& remaining = stream->retransmissionBuffer.at(0);
+  EXPECT_EQ(remaining->offset, 0);
+  EXPECT_EQ(remaining->data.chainLength(), buf->computeChainDataLength());
+  EXPECT_EQ(conn->streamManager->getStream(stream->id), stream);
+}
+
+TEST_F(ConnectionMemoryTest, CompactEmptiesStreamBufferPool) {
+  for (int i = 0; i < 10; i++) {
+    conn->streamBufferPool.put(
+        std::make_unique<StreamBuffer>(nullptr, 0, false));
+  }
+  EXPECT_EQ(conn->streamBufferPool.size(), 10);
+  compactIdleConnectionState(*conn);
+  EXPECT_EQ(conn->streamBufferPool.size(), 0);
+}
+
+} // namespace test
+} // namespace quic
@@ -29,8 +29,10 @@ class MockQuicStats : public QuicTransportStatsCallback {
   MOCK_METHOD0(onPacketForwarded, void());
   MOCK_METHOD0(onForwardedPacketReceived, void());
   MOCK_METHOD0(onForwardedPacketProcessed, void());
+  MOCK_METHOD0(onPacketMisrouted, void());
   MOCK_METHOD1(onClientInitialReceived, void(QuicVersion));
   MOCK_METHOD0(onConnectionRateLimited, void());
+  MOCK_METHOD0(onRetryPacketSent, void());
   MOCK_METHOD0(onNewConnection, void());
   MOCK_METHOD1(onConnectionClose, void(folly::Optional<ConnectionCloseReason>));
   MOCK_METHOD0(onNewQuicStream, void());
@@ -41,6 +43,10 @@ class MockQuicStats : public QuicTransportStatsCallback {
   MOCK_METHOD0(onStatelessReset, void());
   MOCK_METHOD0(onStreamFlowControlUpdate, void());
   MOCK_METHOD0(onStreamFlowControlBlocked, void());
+  MOCK_METHOD0(onConnFlowControlWindowIncreased, void());
+  MOCK_METHOD0(onStreamFlowControlWindowIncreased, void());
+  MOCK_METHOD0(onFlowControlWindowBudgetExhausted, void());
+  MOCK_METHOD1(onBufferMemoryPoolUsage, void(uint64_t));
   MOCK_METHOD0(onCwndBlocked, void());
   MOCK_METHOD0(onPTO, void());
   MOCK_METHOD1(onRead, void(size_t));
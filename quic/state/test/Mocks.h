@@ -42,6 +42,7 @@ class MockPacer : public Pacer {
   MOCK_CONST_METHOD0(getTimeUntilNextWrite, std::chrono::microseconds());
   MOCK_METHOD1(updateAndGetWriteBatchSize, uint64_t(TimePoint));
   MOCK_CONST_METHOD0(getCachedWriteBatchSize, uint64_t());
+  MOCK_CONST_METHOD0(getPacingRate, PacingRate());
   MOCK_METHOD1(setAppLimited, void(bool));
   MOCK_METHOD0(onPacketSent, void());
   MOCK_METHOD0(onPacketsLoss, void());
@@ -9,6 +9,7 @@
 #include <quic/state/QuicPacingFunctions.h>
 
 #include <folly/portability/GTest.h>
+#include <quic/state/test/Mocks.h>
 
 using namespace testing;
 
@@ -31,5 +32,57 @@ TEST_F(QuicPacingFunctionsTest, OnClose) {
   EXPECT_FALSE(conn.canBePaced);
 }
 
+TEST_F(QuicPacingFunctionsTest, TxTimeDepartures) {
+  QuicConnectionStateBase conn(QuicNodeType::Client);
+  auto mockPacer = std::make_unique<MockPacer>();
+  EXPECT_CALL(*mockPacer, getPacingRate())
+      .WillRepeatedly(Return(
+          PacingRate::Builder().setInterval(1ms).setBurstSize(4).build()));
+  conn.pacer = std::move(mockPacer);
+  auto now = Clock::now();
+  EXPECT_EQ(now, allocateTxTimeDeparture(conn, now));
+  EXPECT_EQ(now + 1ms, allocateTxTimeDeparture(conn, now));
+  EXPECT_EQ(now + 2ms, allocateTxTimeDeparture(conn, now + 500us));
+  // The schedule doesn't fall behind now after an idle period.
+  EXPECT_EQ(now + 10ms, allocateTxTimeDeparture(conn, now + 10ms));
+  EXPECT_EQ(now + 11ms, conn.nextTxTimeDeparture);
+}
+
+TEST_F(QuicPacingFunctionsTest, TxTimeWriteBatchSize) {
+  QuicConnectionStateBase conn(QuicNodeType::Client);
+  conn.transportSettings.txTimeHorizon = 4ms;
+  auto mockPacer = std::make_unique<MockPacer>();
+  EXPECT_CALL(*mockPacer, getPacingRate())
+      .WillRepeatedly(Return(
+          PacingRate::Builder().setInterval(1ms).setBurstSize(4).build()));
+  conn.pacer = std::move(mockPacer);
+  auto now = Clock::now();
+  // Nothing queued, four bursts fit in the horizon.
+  EXPECT_EQ(16, getTxTimeWriteBatchSize(conn, now));
+  EXPECT_EQ(0us, getTxTimeUntilNextWrite(conn, now));
+
+  conn.nextTxTimeDeparture = now + 2500us;
+  EXPECT_EQ(8, getTxTimeWriteBatchSize(conn, now));
+  EXPECT_EQ(500us, getTxTimeUntilNextWrite(conn, now));
+
+  conn.nextTxTimeDeparture = now + 4ms;
+  EXPECT_EQ(0, getTxTimeWriteBatchSize(conn, now));
+  EXPECT_EQ(2ms, getTxTimeUntilNextWrite(conn, now));
+}
+
+TEST_F(QuicPacingFunctionsTest, TxTimeUnpacedRate) {
+  QuicConnectionStateBase conn(QuicNodeType::Client);
+  auto mockPacer = std::make_unique<MockPacer>();
+  EXPECT_CALL(*mockPacer, getPacingRate())
+      .WillRepeatedly(Return(
+          PacingRate::Builder().setInterval(0us).setBurstSize(10).build()));
+  conn.pacer = std::move(mockPacer);
+  auto now = Clock::now();
+  EXPECT_EQ(10, getTxTimeWriteBatchSize(conn, now));
+  EXPECT_EQ(now, allocateTxTimeDeparture(conn, now));
+  EXPECT_EQ(now, allocateTxTimeDeparture(conn, now));
+  EXPECT_EQ(0us, getTxTimeUntilNextWrite(conn, now));
+}
+
 } // namespace test
 } // namespace quic
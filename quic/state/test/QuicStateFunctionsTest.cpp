@@ -13,6 +13,7 @@
 #include <quic/fizz/server/handshake/FizzServerQuicHandshakeContext.h>
 #include <quic/server/state/ServerStateMachine.h>
 #include <quic/state/QuicStateFunctions.h>
+#include <quic/state/SimpleFrameFunctions.h>
 #include <quic/state/stream/StreamReceiveHandlers.h>
 #include <quic/state/stream/StreamSendHandlers.h>
 #include <quic/state/test/Mocks.h>
@@ -361,6 +362,37 @@ TEST_P(UpdateAckStateTest, UpdateAckSendStateOnRecvPacketsNonRxOutOfOrder) {
   EXPECT_FALSE(verifyToScheduleAckTimeout(conn));
 }
 
+TEST_P(UpdateAckStateTest, UpdateAckSendStateOnRecvPacketsImmediateAck) {
+  QuicConnectionStateBase conn(QuicNodeType::Client);
+  auto& ackState = getAckState(conn, GetParam());
+  ackState.immediateAckRequested = true;
+  updateAckSendStateOnRecvPacket(conn, ackState, false, true, false);
+  EXPECT_TRUE(verifyToAckImmediately(conn, ackState));
+  EXPECT_FALSE(ackState.immediateAckRequested);
+}
+
+TEST_P(UpdateAckStateTest, UpdateAckSendStateOnRecvPacketsPeerAckFrequency) {
+  QuicConnectionStateBase conn(QuicNodeType::Client);
+  conn.ackFrequencyState.peerRequest =
+      AckFrequencyFrame(0, 30, 20000, 0 /* reorderThreshold */);
+  auto& ackState = getAckState(conn, GetParam());
+  if (GetParam() != PacketNumberSpace::AppData) {
+    // Only AppData follows the peer's request.
+    updateAckSendStateOnRecvPacket(conn, ackState, true, true, false);
+    EXPECT_TRUE(verifyToAckImmediately(conn, ackState));
+    return;
+  }
+  for (size_t i = 0; i < 29; i++) {
+    // Out of order packets don't trigger an ack with a 0 reorder threshold.
+    updateAckSendStateOnRecvPacket(conn, ackState, i % 2, true, false);
+    EXPECT_FALSE(verifyToAckImmediately(conn, ackState));
+    EXPECT_TRUE(verifyToScheduleAckTimeout(conn));
+  }
+  updateAckSendStateOnRecvPacket(conn, ackState, false, true, false);
+  EXPECT_TRUE(verifyToAckImmediately(conn, ackState));
+  EXPECT_FALSE(verifyToScheduleAckTimeout(conn));
+}
+
 INSTANTIATE_TEST_CASE_P(
     UpdateAckStateTests,
     UpdateAckStateTest,
@@ -666,6 +698,76 @@ TEST_P(QuicStateFunctionsTest, CloseTranportStateChange) {
   EXPECT_TRUE(conn.pendingEvents.closeTransport);
 }
 
+TEST_F(QuicStateFunctionsTest, RequestPeerAckFrequencyChange) {
+  QuicConnectionStateBase conn(QuicNodeType::Server);
+  // Peer does not support the extension.
+  EXPECT_FALSE(requestPeerAckFrequencyChange(conn, 10, 10ms, 1));
+  EXPECT_FALSE(requestPeerImmediateAck(conn));
+  EXPECT_TRUE(conn.pendingEvents.frames.empty());
+
+  conn.ackFrequencyState.peerMinAckDelay = 5ms;
+  EXPECT_TRUE(requestPeerAckFrequencyChange(conn, 10, 1ms, 1));
+  // A second request replaces the one that has not been written yet.
+  EXPECT_TRUE(requestPeerAckFrequencyChange(conn, 20, 10ms, 1));
+  ASSERT_EQ(1, conn.pendingEvents.frames.size());
+  auto frame = conn.pendingEvents.frames.front().asAckFrequencyFrame();
+  ASSERT_NE(frame, nullptr);
+  EXPECT_EQ(1, frame->sequenceNumber);
+  EXPECT_EQ(20, frame->packetTolerance);
+  EXPECT_EQ(10000, frame->updateMaxAckDelay);
+  EXPECT_EQ(*frame, *conn.ackFrequencyState.lastRequested);
+
+  conn.pendingEvents.frames.clear();
+  // The max ack delay is clamped to the peer's min_ack_delay.
+  EXPECT_TRUE(requestPeerAckFrequencyChange(conn, 10, 1ms, 1));
+  EXPECT_EQ(
+      5000,
+      conn.pendingEvents.frames.front()
+          .asAckFrequencyFrame()
+          ->updateMaxAckDelay);
+
+  EXPECT_TRUE(requestPeerImmediateAck(conn));
+  EXPECT_NE(conn.pendingEvents.frames.back().asImmediateAckFrame(), nullptr);
+}
+
+TEST_F(QuicStateFunctionsTest, RequestPeerAckFrequencyChangeMaxAckDelay) {
+  QuicConnectionStateBase conn(QuicNodeType::Server);
+  conn.ackFrequencyState.peerMinAckDelay = 1ms;
+  conn.lossState.maxAckDelay = 2ms;
+  EXPECT_TRUE(requestPeerAckFrequencyChange(conn, 10, 10ms, 1));
+  // The PTO accounts for the requested delay before the peer acks with it.
+  EXPECT_EQ(10ms, conn.lossState.maxAckDelay);
+
+  conn.pendingEvents.frames.clear();
+  // Never ask for more than the peer's ack timer will honor.
+  EXPECT_TRUE(requestPeerAckFrequencyChange(conn, 10, 100ms, 1));
+  EXPECT_EQ(
+      kMaxAckTimeout.count(),
+      conn.pendingEvents.frames.front()
+          .asAckFrequencyFrame()
+          ->updateMaxAckDelay);
+  EXPECT_EQ(kMaxAckTimeout, conn.lossState.maxAckDelay);
+
+  // A smaller request does not lower the delay used for the PTO.
+  EXPECT_TRUE(requestPeerAckFrequencyChange(conn, 10, 5ms, 1));
+  EXPECT_EQ(kMaxAckTimeout, conn.lossState.maxAckDelay);
+}
+
+TEST_F(QuicStateFunctionsTest, ReceiveAckFrequencyCapsMaxAckDelay) {
+  QuicConnectionStateBase conn(QuicNodeType::Client);
+  conn.transportSettings.minAckDelay = 1ms;
+  updateSimpleFrameOnPacketReceived(
+      conn, AckFrequencyFrame(0, 10, 1000000 /* 1s */, 1), 0, false);
+  ASSERT_TRUE(conn.ackFrequencyState.peerRequest.has_value());
+  EXPECT_EQ(
+      kMaxAckTimeout.count(),
+      conn.ackFrequencyState.peerRequest->updateMaxAckDelay);
+
+  updateSimpleFrameOnPacketReceived(
+      conn, AckFrequencyFrame(1, 10, 5000, 1), 1, false);
+  EXPECT_EQ(5000, conn.ackFrequencyState.peerRequest->updateMaxAckDelay);
+}
+
 INSTANTIATE_TEST_CASE_P(
     QuicStateFunctionsTests,
     QuicStateFunctionsTest,
@@ -309,5 +309,35 @@ TEST_F(QuicStreamManagerTest, TestClearActionable) {
   EXPECT_TRUE(manager.peekableStreams().empty());
 }
 
+TEST_F(QuicStreamManagerTest, WritableStreamPriority) {
+  auto& manager = *conn.streamManager;
+  auto stream = manager.createNextBidirectionalStream().value();
+  EXPECT_EQ(stream->priority, kDefaultPriority);
+  stream->writeBuffer.append(folly::IOBuf::copyBuffer("blah blah"));
+  manager.updateWritableStreams(*stream);
+  EXPECT_TRUE(manager.writableContains(stream->id));
+
+  auto& queue = manager.writableStreams();
+  auto defaultIndex = PriorityQueue::priority2index(kDefaultPriority);
+  EXPECT_EQ(queue.levels[defaultIndex].streams.count(stream->id), 1);
+
+  // Levels above the max are capped.
+  EXPECT_TRUE(manager.setStreamPriority(stream->id, 100, false));
+  EXPECT_EQ(stream->priority, Priority(kDefaultMaxPriority, false));
+  EXPECT_EQ(queue.levels[defaultIndex].streams.count(stream->id), 0);
+  auto newIndex =
+      PriorityQueue::priority2index(Priority(kDefaultMaxPriority, false));
+  EXPECT_EQ(queue.levels[newIndex].streams.count(stream->id), 1);
+  EXPECT_EQ(queue.size(), 1);
+  EXPECT_FALSE(manager.setStreamPriority(stream->id, 100, false));
+  EXPECT_FALSE(manager.setStreamPriority(stream->id + 4, 0, false));
+
+  stream->sendState = StreamSendState::Closed_E;
+  stream->recvState = StreamRecvState::Closed_E;
+  manager.removeClosedStream(stream->id);
+  EXPECT_TRUE(queue.empty());
+  EXPECT_TRUE(queue.levels[newIndex].streams.empty());
+}
+
 } // namespace test
 } // namespace quic
@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/state/StreamBufferPool.h>
+
+#include <folly/portability/GTest.h>
+#include <quic/api/QuicTransportFunctions.h>
+#include <quic/common/test/AllocationTracker.h>
+#include <quic/common/test/TestUtils.h>
+#include <quic/fizz/server/handshake/FizzServerQuicHandshakeContext.h>
+#include <quic/loss/QuicLossFunctions.h>
+#include <quic/server/state/ServerStateMachine.h>
+#include <quic/state/StateData.h>
+#include <quic/state/stream/StreamSendHandlers.h>
+
+namespace quic {
+namespace test {
+
+TEST(StreamBufferPoolTest, ReusesReturnedBuffers) {
+  StreamBufferPool pool(kMaxPooledStreamBuffers);
+  auto buffer = pool.get(folly::IOBuf::copyBuffer("hello"), 10, false);
+  EXPECT_EQ(buffer->data.chainLength(), 5);
+  EXPECT_EQ(buffer->offset, 10);
+  EXPECT_FALSE(buffer->eof);
+  auto node = buffer.get();
+  pool.put(std::move(buffer));
+  EXPECT_EQ(pool.size(), 1);
+
+  auto reused = pool.get(folly::IOBuf::copyBuffer("quic"), 15, true);
+  EXPECT_EQ(reused.get(), node);
+  EXPECT_EQ(reused->data.chainLength(), 4);
+  EXPECT_EQ(reused->offset, 15);
+  EXPECT_TRUE(reused->eof);
+  EXPECT_EQ(pool.size(), 0);
+}
+
+TEST(StreamBufferPoolTest, PutFreesData) {
+  StreamBufferPool pool(kMaxPooledStreamBuffers);
+  auto data = folly::IOBuf::copyBuffer("hello");
+  auto shared = data->clone();
+  pool.put(pool.get(std::move(data), 0));
+  EXPECT_FALSE(shared->isShared());
+}
+
+TEST(StreamBufferPoolTest, Bounded) {
+  StreamBufferPool pool(2);
+  for (int i = 0; i < 3; i++) {
+    pool.put(pool.get(folly::IOBuf::copyBuffer("hello"), 0));
+  }
+  std::vector<std::unique_ptr<StreamBuffer>> buffers;
+  for (int i = 0; i < 3; i++) {
+    buffers.push_back(pool.get(folly::IOBuf::copyBuffer("hello"), i * 5));
+  }
+  for (auto& buffer : buffers) {
+    pool.put(std::move(buffer));
+  }
+  EXPECT_EQ(pool.size(), 2);
+  pool.clear();
+  EXPECT_EQ(pool.size(), 0);
+}
+
+TEST(StreamBufferPoolTest, SteadyStateDoesNotAllocate) {
+  constexpr size_t kFramesPerRound = 8;
+  constexpr size_t kRounds = 100;
+  StreamBufferPool pool(kMaxPooledStreamBuffers);
+  std::vector<std::unique_ptr<StreamBuffer>> inflight;
+  inflight.reserve(kFramesPerRound);
+  std::vector<Buf> data;
+  for (size_t i = 0; i < kFramesPerRound * (kRounds + 1); i++) {
+    data.push_back(folly::IOBuf::copyBuffer("stream data"));
+  }
+  auto sendAndAckRound = [&](size_t round) {
+    for (size_t i = 0; i < kFramesPerRound; i++) {
+      auto index = round * kFramesPerRound + i;
+      inflight.push_back(pool.get(std::move(data[index]), index * 11));
+    }
+    for (auto& buffer : inflight) {
+      pool.put(std::move(buffer));
+    }
+    inflight.clear();
+  };
+  // The first round fills the pool.
+  sendAndAckRound(0);
+  AllocationCounter counter;
+  for (size_t round = 1; round <= kRounds; round++) {
+    sendAndAckRound(round);
+  }
+  EXPECT_EQ(counter.count(), 0);
+}
+
+TEST(StreamBufferPoolTest, AckEventDoesNotAllocate) {
+  AllocationCounter counter;
+  CongestionController::AckEvent ack;
+  for (uint16_t i = 0; i < kDefaultRxPacketsBeforeAckAfterInit; i++) {
+    ack.ackedPackets.push_back(
+        CongestionController::AckEvent::AckPacket::Builder()
+            .setSentTime(Clock::now())
+            .setEncodedSize(kDefaultUDPSendPacketLen)
+            .setTotalBytesSentThen(i * kDefaultUDPSendPacketLen)
+            .build());
+  }
+  EXPECT_EQ(counter.count(), 0);
+}
+
+class StreamBufferPoolWriteTest : public testing::Test {
+ public:
+  static constexpr size_t kFramesPerRound = 8;
+  static constexpr uint64_t kFrameLen = 100;
+
+  void SetUp() override {
+    conn = std::make_unique<QuicServerConnectionState>(
+        FizzServerQuicHandshakeContext::Builder().build());
+    conn->streamManager->setMaxLocalBidirectionalStreams(
+        kDefaultMaxStreamsBidirectional);
+    stream = conn->streamManager->createNextBidirectionalStream().value();
+  }
+
+  // Queues the data of numFrames frames on the stream, one buffer per frame
+  // so that writing a frame does not need to split a buffer.
+  void queueData(size_t numFrames) {
+    for (size_t i = 0; i < numFrames; i++) {
+      auto buf = folly::IOBuf::create(kFrameLen);
+      buf->append(kFrameLen);
+      stream->writeBuffer.append(std::move(buf));
+    }
+  }
+
+  RegularQuicWritePacket writeFrame(uint64_t offset) {
+    auto packetNum = nextPacketNum++;
+    handleStreamWritten(
+        *conn,
+        *stream,
+        offset,
+        kFrameLen,
+        false /* fin */,
+        packetNum,
+        PacketNumberSpace::AppData);
+    auto packet = createNewPacket(packetNum, PacketNumberSpace::AppData);
+    packet.frames.emplace_back(
+        WriteStreamFrame(stream->id, offset, kFrameLen, false));
+    return packet;
+  }
+
+  void ackFrame(uint64_t offset) {
+    sendAckSMHandler(
+        *stream, WriteStreamFrame(stream->id, offset, kFrameLen, false));
+  }
+
+  std::unique_ptr<QuicServerConnectionState> conn;
+  QuicStreamState* stream{nullptr};
+  PacketNum nextPacketNum{0};
+};
+
+TEST_F(StreamBufferPoolWriteTest, WriteAndAckDoesNotAllocate) {
+  constexpr size_t kRounds = 100;
+  queueData(kFramesPerRound * (kRounds + 1));
+  auto writeAndAckRound = [&]() {
+    auto firstOffset = stream->currentWriteOffset;
+    for (size_t i = 0; i < kFramesPerRound; i++) {
+      writeFrame(stream->currentWriteOffset);
+    }
+    for (size_t i = 0; i < kFramesPerRound; i++) {
+      ackFrame(firstOffset + i * kFrameLen);
+    }
+  };
+  // The first round fills the pool and sizes the retransmission buffer.
+  writeAndAckRound();
+  EXPECT_EQ(conn->streamBufferPool.size(), kFramesPerRound);
+  AllocationCounter counter;
+  for (size_t round = 0; round < kRounds; round++) {
+    writeAndAckRound();
+  }
+  EXPECT_EQ(counter.count(), 0);
+  EXPECT_TRUE(stream->retransmissionBuffer.empty());
+}
+
+TEST_F(StreamBufferPoolWriteTest, LossAndRetransmissionReuseNodes) {
+  queueData(kFramesPerRound * 2);
+  for (size_t i = 0; i < kFramesPerRound; i++) {
+    auto offset = stream->currentWriteOffset;
+    writeFrame(offset);
+    ackFrame(offset);
+  }
+  ASSERT_EQ(conn->streamBufferPool.size(), kFramesPerRound);
+
+  std::vector<RegularQuicWritePacket> packets;
+  for (size_t i = 0; i < kFramesPerRound; i++) {
+    packets.push_back(writeFrame(stream->currentWriteOffset));
+  }
+  EXPECT_EQ(conn->streamBufferPool.size(), 0);
+  // The nodes of lost frames go back to the pool, their data moves to the loss
+  // buffer.
+  for (auto& packet : packets) {
+    markPacketLoss(*conn, packet, false /* processed */);
+  }
+  EXPECT_EQ(conn->streamBufferPool.size(), kFramesPerRound);
+  EXPECT_TRUE(stream->retransmissionBuffer.empty());
+  EXPECT_FALSE(stream->lossBuffer.empty());
+
+  // Retransmissions take them out again.
+  auto firstOffset = stream->lossBuffer.front().offset;
+  for (size_t i = 0; i < kFramesPerRound; i++) {
+    writeFrame(firstOffset + i * kFrameLen);
+  }
+  EXPECT_EQ(conn->streamBufferPool.size(), 0);
+  EXPECT_TRUE(stream->lossBuffer.empty());
+  for (size_t i = 0; i < kFramesPerRound; i++) {
+    ackFrame(firstOffset + i * kFrameLen);
+  }
+  EXPECT_EQ(conn->streamBufferPool.size(), kFramesPerRound);
+}
+
+} // namespace test
+} // namespace quic
@@ -0,0 +1,988 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <glog/logging.h>
+
+#include <fizz/crypto/Utils.h>
+#include <folly/init/Init.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/HHWheelTimer.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <folly/portability/GFlags.h>
+#include <folly/portability/SysResource.h>
+#include <folly/portability/Unistd.h>
+#include <folly/stats/Histogram.h>
+
+#include <quic/client/QuicClientTransport.h>
+#include <quic/common/test/TestUtils.h>
+#include <quic/fizz/client/handshake/FizzClientQuicHandshakeContext.h>
+#include <quic/fizz/handshake/FizzCryptoFactory.h>
+#include <quic/server/QuicServer.h>
+#include <quic/server/QuicServerTransport.h>
+
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+DEFINE_string(host, "::1", "Load generator server hostname/IP");
+DEFINE_int32(port, 6667, "Load generator server port");
+DEFINE_string(
+    mode,
+    "loopback",
+    "Mode to run in: 'client', 'server' or 'loopback', which runs both in "
+    "this process");
+DEFINE_int32(
+    duration,
+    30,
+    "Duration of the client run in seconds, including the ramp up");
+DEFINE_int32(report_interval, 1, "Seconds between two reports");
+DEFINE_int32(
+    num_server_worker,
+    1,
+    "Max number of mvfst server worker threads");
+DEFINE_int32(
+    client_threads,
+    4,
+    "Number of client EventBase threads the connections are spread over");
+DEFINE_int64(
+    connections,
+    1000,
+    "Number of client connections to open. Every connection has its own UDP "
+    "socket, raise the open file limit accordingly.");
+DEFINE_int64(
+    handshake_rate,
+    0,
+    "Connections opened per second. 0 (the default) opens them all at once.");
+DEFINE_string(
+    workload,
+    "request",
+    "request: each connection sends requests on new bidirectional streams and "
+    "waits for the response. idle: connections only send keepalive PINGs.");
+DEFINE_int64(request_size, 100, "Bytes sent by the client per request");
+DEFINE_int64(response_size, 1000, "Bytes sent by the server per response");
+DEFINE_int64(
+    request_interval_ms,
+    1000,
+    "Time between the response to a request and the next request of the same "
+    "connection. 0 sends the next request as soon as the response arrives.");
+DEFINE_int64(
+    keepalive_interval_ms,
+    15000,
+    "Time between two PINGs of a connection of the idle workload. 0 disables "
+    "keepalives.");
+DEFINE_int64(idle_timeout_ms, 60000, "Idle timeout of both endpoints");
+DEFINE_int64(
+    retry_rate,
+    0,
+    "New connections per second per server worker above which clients have "
+    "to validate their address with a Retry. 0 (the default) never sends a "
+    "Retry.");
+DEFINE_int64(
+    initial_flood_pps,
+    0,
+    "Spoofed-looking client Initials per second the client sends next to its "
+    "connections, each to a new connection id and none ever answering a "
+    "Retry");
+
+namespace quic {
+namespace loadgen {
+
+namespace {
+
+constexpr std::chrono::milliseconds kConnectInterval = 10ms;
+constexpr std::chrono::seconds kPingTimeout = 5s;
+constexpr size_t kFloodSockets = 64;
+
+std::chrono::microseconds getProcessCpuTime() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return std::chrono::seconds(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+      std::chrono::microseconds(
+             usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+}
+
+uint64_t getResidentSetSize() {
+  std::ifstream statm("/proc/self/statm");
+  uint64_t size = 0;
+  uint64_t resident = 0;
+  statm >> size >> resident;
+  return resident * sysconf(_SC_PAGESIZE);
+}
+
+Buf makeBuffer(uint64_t size) {
+  auto buf = folly::IOBuf::create(size);
+  std::memset(buf->writableData(), 'a', size);
+  buf->append(size);
+  return buf;
+}
+
+uint64_t microsecondsSince(TimePoint start) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             Clock::now() - start)
+      .count();
+}
+
+double percentOf(uint64_t part, uint64_t whole) {
+  return whole > 0 ? 100.0 * part / whole : 0;
+}
+
+std::string formatBusyPercentages(
+    const std::vector<uint64_t>& busyTimes,
+    const std::vector<uint64_t>& lastBusyTimes,
+    uint64_t intervalUs) {
+  std::string result = "[";
+  for (size_t i = 0; i < busyTimes.size(); i++) {
+    auto last = i < lastBusyTimes.size() ? lastBusyTimes[i] : 0;
+    folly::toAppend(
+        i > 0 ? " " : "",
+        folly::sformat("{:.1f}%", percentOf(busyTimes[i] - last, intervalUs)),
+        &result);
+  }
+  result += "]";
+  return result;
+}
+
+} // namespace
+
+/**
+ * Accumulates the time the EventBase threads it observes spend busy, i.e. not
+ * waiting for events, which is the CPU time of an EventBase thread that does
+ * not block.
+ */
+class BusyTimeObserver : public folly::EventBaseObserver {
+ public:
+  uint32_t getSampleRate() const override {
+    return 1;
+  }
+
+  void loopSample(int64_t busyTime, int64_t /* idleTime */) override {
+    threadBusyTime().fetch_add(busyTime, std::memory_order_relaxed);
+  }
+
+  /**
+   * Busy time of each observed thread in microseconds, in the order they
+   * first ran a loop.
+   */
+  std::vector<uint64_t> busyTimes() const {
+    std::lock_guard<std::mutex> guard(mutex_);
+    std::vector<uint64_t> result;
+    for (const auto& busyTime : threads_) {
+      result.push_back(busyTime->load(std::memory_order_relaxed));
+    }
+    return result;
+  }
+
+ private:
+  std::atomic<uint64_t>& threadBusyTime() {
+    thread_local std::pair<const BusyTimeObserver*, std::atomic<uint64_t>*>
+        cached{nullptr, nullptr};
+    if (cached.first != this) {
+      std::lock_guard<std::mutex> guard(mutex_);
+      threads_.push_back(std::make_unique<std::atomic<uint64_t>>(0));
+      cached = {this, threads_.back().get()};
+    }
+    return *cached.second;
+  }
+
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<std::atomic<uint64_t>>> threads_;
+};
+
+struct ServerStats {
+  std::atomic<uint64_t> accepted{0};
+  std::atomic<uint64_t> liveConnections{0};
+  std::atomic<uint64_t> requests{0};
+};
+
+/**
+ * Answers every request, a bidirectional stream the client finished, with
+ * --response_size bytes. Frees itself once the connection is closed.
+ */
+class ServerConnectionHandler : public QuicSocket::ConnectionCallback,
+                                public QuicSocket::ReadCallback {
+ public:
+  ServerConnectionHandler(
+      folly::EventBase* evb,
+      ServerStats& stats,
+      uint64_t responseSize)
+      : evb_(evb), stats_(stats), responseSize_(responseSize) {}
+
+  void setQuicSocket(std::shared_ptr<QuicSocket> sock) {
+    sock_ = std::move(sock);
+  }
+
+  void onNewBidirectionalStream(StreamId id) noexcept override {
+    sock_->setReadCallback(id, this);
+  }
+
+  void onNewUnidirectionalStream(StreamId id) noexcept override {
+    sock_->setReadCallback(id, this);
+  }
+
+  void onStopSending(StreamId id, ApplicationErrorCode error) noexcept
+      override {
+    VLOG(4) << "Got StopSending stream id=" << id << " error=" << error;
+  }
+
+  void onConnectionEnd() noexcept override {
+    finish();
+  }
+
+  void onConnectionError(
+      std::pair<QuicErrorCode, std::string> error) noexcept override {
+    VLOG(4) << "Conn errorCoded=" << toString(error.first)
+            << ", errorMsg=" << error.second;
+    finish();
+  }
+
+  void readAvailable(StreamId id) noexcept override {
+    auto readData = sock_->read(id, 0);
+    if (readData.hasError()) {
+      VLOG(4) << "Failed read from stream=" << id
+              << ", error=" << toString(readData.error());
+      return;
+    }
+    if (!readData->second) {
+      return;
+    }
+    stats_.requests++;
+    auto res = sock_->writeChain(id, makeBuffer(responseSize_), true, false);
+    if (res.hasError()) {
+      VLOG(4) << "Got error on write: " << toString(res.error());
+    }
+  }
+
+  void readError(
+      StreamId id,
+      std::pair<QuicErrorCode, folly::Optional<folly::StringPiece>>
+          error) noexcept override {
+    VLOG(4) << "Got read error on stream=" << id
+            << " error=" << toString(error);
+  }
+
+ private:
+  void finish() {
+    if (finished_) {
+      return;
+    }
+    finished_ = true;
+    stats_.liveConnections--;
+    // The transport is still calling into this handler, free it afterwards.
+    evb_->runInLoop([this] { delete this; });
+  }
+
+  folly::EventBase* evb_;
+  ServerStats& stats_;
+  uint64_t responseSize_;
+  std::shared_ptr<QuicSocket> sock_;
+  bool finished_{false};
+};
+
+class LoadGenServerTransportFactory : public QuicServerTransportFactory {
+ public:
+  LoadGenServerTransportFactory(ServerStats& stats, uint64_t responseSize)
+      : stats_(stats), responseSize_(responseSize) {}
+
+  ~LoadGenServerTransportFactory() override = default;
+
+  QuicServerTransport::Ptr make(
+      folly::EventBase* evb,
+      std::unique_ptr<folly::AsyncUDPSocket> sock,
+      const folly::SocketAddress&,
+      std::shared_ptr<const fizz::server::FizzServerContext> ctx) noexcept
+      override {
+    CHECK_EQ(evb, sock->getEventBase());
+    auto handler = new ServerConnectionHandler(evb, stats_, responseSize_);
+    auto transport =
+        QuicServerTransport::make(evb, std::move(sock), *handler, ctx);
+    handler->setQuicSocket(transport);
+    stats_.accepted++;
+    stats_.liveConnections++;
+    return transport;
+  }
+
+ private:
+  ServerStats& stats_;
+  uint64_t responseSize_;
+};
+
+class LoadGenServer {
+ public:
+  LoadGenServer(const std::string& host, uint16_t port)
+      : host_(host),
+        port_(port),
+        server_(QuicServer::createQuicServer()),
+        observer_(std::make_shared<BusyTimeObserver>()) {
+    server_->setQuicServerTransportFactory(
+        std::make_unique<LoadGenServerTransportFactory>(
+            stats_, FLAGS_response_size));
+    auto serverCtx = test::createServerCtx();
+    serverCtx->setClock(std::make_shared<fizz::SystemClock>());
+    server_->setFizzContext(serverCtx);
+    TransportSettings settings;
+    settings.idleTimeout = std::chrono::milliseconds(FLAGS_idle_timeout_ms);
+    server_->setTransportSettings(settings);
+    if (FLAGS_retry_rate > 0) {
+      server_->setRetryRateLimit(FLAGS_retry_rate, 1s);
+    }
+  }
+
+  void start() {
+    folly::SocketAddress addr(host_.c_str(), port_);
+    addr.setFromHostPort(host_, port_);
+    server_->start(addr, FLAGS_num_server_worker);
+    server_->waitUntilInitialized();
+    server_->setEventBaseObserver(observer_);
+    LOG(INFO) << "loadgen server started at: " << addr.describe();
+  }
+
+  void shutdown() {
+    server_->shutdown();
+  }
+
+  const ServerStats& getStats() const {
+    return stats_;
+  }
+
+  std::vector<uint64_t> getWorkerBusyTimes() const {
+    return observer_->busyTimes();
+  }
+
+ private:
+  std::string host_;
+  uint16_t port_;
+  ServerStats stats_;
+  std::shared_ptr<QuicServer> server_;
+  std::shared_ptr<BusyTimeObserver> observer_;
+};
+
+struct ClientStats {
+  uint64_t handshakes{0};
+  uint64_t handshakeFailures{0};
+  uint64_t connectionErrors{0};
+  uint64_t requests{0};
+  uint64_t requestErrors{0};
+  uint64_t pings{0};
+  folly::Histogram<uint64_t> handshakeLatencyUs{1000, 0, 10000000};
+  folly::Histogram<uint64_t> requestLatencyUs{100, 0, 1000000};
+
+  void merge(const ClientStats& other) {
+    handshakes += other.handshakes;
+    handshakeFailures += other.handshakeFailures;
+    connectionErrors += other.connectionErrors;
+    requests += other.requests;
+    requestErrors += other.requestErrors;
+    pings += other.pings;
+    handshakeLatencyUs.merge(other.handshakeLatencyUs);
+    requestLatencyUs.merge(other.requestLatencyUs);
+  }
+};
+
+struct ClientConfig {
+  folly::SocketAddress serverAddr;
+  std::shared_ptr<FizzClientQuicHandshakeContext> handshakeContext;
+  TransportSettings transportSettings;
+  bool idleWorkload{false};
+  uint64_t requestSize{0};
+  std::chrono::milliseconds requestInterval{0};
+  std::chrono::milliseconds keepaliveInterval{0};
+};
+
+/**
+ * One client connection. Runs the request workload, one request at a time, or
+ * the idle workload.
+ */
+class ClientConnection : public QuicSocket::ConnectionCallback,
+                         public QuicSocket::ReadCallback,
+                         public QuicSocket::PingCallback,
+                         public folly::HHWheelTimer::Callback {
+ public:
+  ClientConnection(
+      folly::EventBase* evb,
+      const ClientConfig& config,
+      ClientStats& stats)
+      : evb_(evb), config_(config), stats_(stats) {}
+
+  ~ClientConnection() override {
+    close();
+  }
+
+  void start() {
+    auto sock = std::make_unique<folly::AsyncUDPSocket>(evb_);
+    transport_ = std::make_shared<QuicClientTransport>(
+        evb_, std::move(sock), config_.handshakeContext);
+    transport_->setHostname("loadgen");
+    transport_->addNewPeerAddress(config_.serverAddr);
+    transport_->setTransportSettings(config_.transportSettings);
+    startTime_ = Clock::now();
+    transport_->start(this);
+  }
+
+  void close() {
+    cancelTimeout();
+    if (transport_) {
+      auto transport = std::move(transport_);
+      transport->closeNow(folly::none);
+    }
+  }
+
+  bool isReady() const {
+    return ready_ && transport_;
+  }
+
+  void onTransportReady() noexcept override {
+    ready_ = true;
+    stats_.handshakes++;
+    stats_.handshakeLatencyUs.addValue(microsecondsSince(startTime_));
+    if (!config_.idleWorkload) {
+      sendRequest();
+    } else if (config_.keepaliveInterval.count() > 0) {
+      evb_->timer().scheduleTimeout(this, config_.keepaliveInterval);
+    }
+  }
+
+  void timeoutExpired() noexcept override {
+    if (!transport_) {
+      return;
+    }
+    if (!config_.idleWorkload) {
+      sendRequest();
+      return;
+    }
+    transport_->sendPing(this, kPingTimeout);
+    evb_->timer().scheduleTimeout(this, config_.keepaliveInterval);
+  }
+
+  void callbackCanceled() noexcept override {}
+
+  void pingAcknowledged() noexcept override {
+    stats_.pings++;
+  }
+
+  void pingTimeout() noexcept override {}
+
+  void readAvailable(StreamId id) noexcept override {
+    auto readData = transport_->read(id, 0);
+    if (readData.hasError()) {
+      stats_.requestErrors++;
+      transport_->setReadCallback(id, nullptr);
+      scheduleNextRequest();
+      return;
+    }
+    if (readData->second) {
+      stats_.requests++;
+      stats_.requestLatencyUs.addValue(microsecondsSince(requestStartTime_));
+      scheduleNextRequest();
+    }
+  }
+
+  void readError(
+      StreamId /* id */,
+      std::pair<QuicErrorCode, folly::Optional<folly::StringPiece>>
+      /* error */) noexcept override {
+    stats_.requestErrors++;
+    scheduleNextRequest();
+  }
+
+  void onNewBidirectionalStream(StreamId /* id */) noexcept override {}
+
+  void onNewUnidirectionalStream(StreamId /* id */) noexcept override {}
+
+  void onStopSending(
+      StreamId /* id */,
+      ApplicationErrorCode /* error */) noexcept override {}
+
+  void onConnectionEnd() noexcept override {
+    cancelTimeout();
+    transport_.reset();
+  }
+
+  void onConnectionError(
+      std::pair<QuicErrorCode, std::string> error) noexcept override {
+    VLOG(4) << "Client connection error: " << toString(error.first) << " "
+            << error.second;
+    if (ready_) {
+      stats_.connectionErrors++;
+    } else {
+      stats_.handshakeFailures++;
+    }
+    cancelTimeout();
+    transport_.reset();
+  }
+
+ private:
+  void sendRequest() {
+    auto stream = transport_->createBidirectionalStream();
+    if (stream.hasError()) {
+      stats_.requestErrors++;
+      scheduleNextRequest();
+      return;
+    }
+    transport_->setReadCallback(*stream, this);
+    requestStartTime_ = Clock::now();
+    auto res = transport_->writeChain(
+        *stream, makeBuffer(config_.requestSize), true, false);
+    if (res.hasError()) {
+      stats_.requestErrors++;
+    }
+  }
+
+  void scheduleNextRequest() {
+    if (!transport_) {
+      return;
+    }
+    if (config_.requestInterval.count() == 0) {
+      sendRequest();
+      return;
+    }
+    evb_->timer().scheduleTimeout(this, config_.requestInterval);
+  }
+
+  folly::EventBase* evb_;
+  const ClientConfig& config_;
+  ClientStats& stats_;
+  std::shared_ptr<QuicClientTransport> transport_;
+  TimePoint startTime_;
+  TimePoint requestStartTime_;
+  bool ready_{false};
+};
+
+/**
+ * The connections of one client EventBase thread. Opens them at its share of
+ * --handshake_rate and owns their stats, which are only touched on the thread.
+ */
+class ClientThread : public folly::HHWheelTimer::Callback {
+ public:
+  ClientThread(
+      size_t index,
+      const ClientConfig& config,
+      uint64_t numConnections,
+      double handshakesPerSecond,
+      std::shared_ptr<BusyTimeObserver> observer)
+      : thread_(folly::to<std::string>("loadgen_client", index)),
+        config_(config),
+        numConnections_(numConnections),
+        handshakesPerSecond_(handshakesPerSecond) {
+    connections_.reserve(numConnections_);
+    thread_.getEventBase()->runInEventBaseThreadAndWait(
+        [&] { thread_.getEventBase()->setObserver(std::move(observer)); });
+  }
+
+  void start() {
+    thread_.getEventBase()->runInEventBaseThread([this] {
+      startTime_ = Clock::now();
+      openConnections();
+    });
+  }
+
+  void stop() {
+    thread_.getEventBase()->runInEventBaseThreadAndWait([this] {
+      cancelTimeout();
+      connections_.clear();
+    });
+  }
+
+  /**
+   * Returns the stats since the last call and the number of established
+   * connections.
+   */
+  std::pair<ClientStats, uint64_t> takeStats() {
+    std::pair<ClientStats, uint64_t> result;
+    thread_.getEventBase()->runInEventBaseThreadAndWait([&] {
+      result.first = std::exchange(stats_, ClientStats());
+      result.second = std::count_if(
+          connections_.begin(), connections_.end(), [](const auto& conn) {
+            return conn->isReady();
+          });
+    });
+    return result;
+  }
+
+  void timeoutExpired() noexcept override {
+    openConnections();
+  }
+
+  void callbackCanceled() noexcept override {}
+
+ private:
+  void openConnections() {
+    auto target = numConnections_;
+    if (handshakesPerSecond_ > 0) {
+      auto elapsed = std::chrono::duration<double>(Clock::now() - startTime_);
+      target = std::min<uint64_t>(
+          numConnections_, 1 + handshakesPerSecond_ * elapsed.count());
+    }
+    auto evb = thread_.getEventBase();
+    while (connections_.size() < target) {
+      connections_.push_back(
+          std::make_unique<ClientConnection>(evb, config_, stats_));
+      connections_.back()->start();
+    }
+    if (connections_.size() < numConnections_) {
+      evb->timer().scheduleTimeout(this, kConnectInterval);
+    }
+  }
+
+  folly::ScopedEventBaseThread thread_;
+  const ClientConfig& config_;
+  uint64_t numConnections_;
+  double handshakesPerSecond_;
+  TimePoint startTime_;
+  ClientStats stats_;
+  std::vector<std::unique_ptr<ClientConnection>> connections_;
+};
+
+/**
+ * Sends --initial_flood_pps client Initials from kFloodSockets sockets and
+ * never reads the replies, like a flood from spoofed addresses. The Initials
+ * are encrypted with the real initial keys of their random destination
+ * connection id and carry a junk ClientHello, so the server creates a
+ * connection for each of them unless it answers with a Retry.
+ */
+class InitialFlooder : public folly::HHWheelTimer::Callback {
+ public:
+  InitialFlooder(
+      const folly::SocketAddress& serverAddr,
+      double packetsPerSecond)
+      : thread_("loadgen_flood"),
+        serverAddr_(serverAddr),
+        packetsPerSecond_(packetsPerSecond),
+        cryptoData_(makeBuffer(kMinInitialPacketSize)) {}
+
+  void start() {
+    auto evb = thread_.getEventBase();
+    evb->runInEventBaseThreadAndWait([&] {
+      for (size_t i = 0; i < kFloodSockets; i++) {
+        auto sock = std::make_unique<folly::AsyncUDPSocket>(evb);
+        sock->bind(folly::SocketAddress(
+            serverAddr_.getIPAddress().isV6() ? "::" : "0.0.0.0", 0));
+        sockets_.push_back(std::move(sock));
+      }
+      startTime_ = Clock::now();
+      evb->timer().scheduleTimeout(this, kConnectInterval);
+    });
+  }
+
+  void stop() {
+    thread_.getEventBase()->runInEventBaseThreadAndWait([this] {
+      cancelTimeout();
+      sockets_.clear();
+    });
+  }
+
+  /**
+   * Returns the number of Initials sent since the last call.
+   */
+  uint64_t takeSent() {
+    return sent_.exchange(0, std::memory_order_relaxed);
+  }
+
+  void timeoutExpired() noexcept override {
+    auto elapsed = std::chrono::duration<double>(Clock::now() - startTime_);
+    uint64_t target = packetsPerSecond_ * elapsed.count();
+    while (totalSent_ < target) {
+      sendInitial();
+      totalSent_++;
+      sent_.fetch_add(1, std::memory_order_relaxed);
+    }
+    thread_.getEventBase()->timer().scheduleTimeout(this, kConnectInterval);
+  }
+
+  void callbackCanceled() noexcept override {}
+
+ private:
+  void sendInitial() {
+    auto srcConnId = ConnectionId::createRandom(kDefaultConnectionIdSize);
+    auto dstConnId = ConnectionId::createRandom(kDefaultConnectionIdSize);
+    auto aead =
+        cryptoFactory_.getClientInitialCipher(dstConnId, QuicVersion::MVFST);
+    auto headerCipher = cryptoFactory_.makeClientInitialHeaderCipher(
+        dstConnId, QuicVersion::MVFST);
+    // The CRYPTO frame fills the packet up to the minimum Initial size.
+    auto packet = test::createInitialCryptoPacket(
+        srcConnId,
+        dstConnId,
+        0 /* packetNum */,
+        QuicVersion::MVFST,
+        *cryptoData_,
+        *aead,
+        0 /* largestAcked */);
+    auto buf = test::packetToBufCleartext(packet, *aead, *headerCipher, 0);
+    sockets_[totalSent_ % sockets_.size()]->write(serverAddr_, buf);
+  }
+
+  folly::ScopedEventBaseThread thread_;
+  folly::SocketAddress serverAddr_;
+  double packetsPerSecond_;
+  Buf cryptoData_;
+  FizzCryptoFactory cryptoFactory_;
+  std::vector<std::unique_ptr<folly::AsyncUDPSocket>> sockets_;
+  TimePoint startTime_;
+  uint64_t totalSent_{0};
+  std::atomic<uint64_t> sent_{0};
+};
+
+/**
+ * Drives the client threads for --duration seconds and reports every
+ * --report_interval seconds. In loopback mode the server runs in the same
+ * process and its worker load is reported as well.
+ */
+class LoadGenClient {
+ public:
+  LoadGenClient(const std::string& host, uint16_t port, LoadGenServer* server)
+      : server_(server), observer_(std::make_shared<BusyTimeObserver>()) {
+    config_.serverAddr = folly::SocketAddress(host.c_str(), port);
+    config_.handshakeContext =
+        FizzClientQuicHandshakeContext::Builder()
+            .setCertificateVerifier(test::createTestCertificateVerifier())
+            .build();
+    config_.transportSettings.idleTimeout =
+        std::chrono::milliseconds(FLAGS_idle_timeout_ms);
+    config_.transportSettings.connectUDP = true;
+    config_.idleWorkload = FLAGS_workload == "idle";
+    config_.requestSize = FLAGS_request_size;
+    config_.requestInterval =
+        std::chrono::milliseconds(FLAGS_request_interval_ms);
+    config_.keepaliveInterval =
+        std::chrono::milliseconds(FLAGS_keepalive_interval_ms);
+  }
+
+  void run() {
+    auto baselineRss = getResidentSetSize();
+    auto numThreads = std::max<int32_t>(1, FLAGS_client_threads);
+    for (int32_t i = 0; i < numThreads; i++) {
+      // Spread the connections and the handshake rate evenly.
+      uint64_t numConnections = FLAGS_connections / numThreads +
+          (i < FLAGS_connections % numThreads ? 1 : 0);
+      threads_.push_back(std::make_unique<ClientThread>(
+          i,
+          config_,
+          numConnections,
+          static_cast<double>(FLAGS_handshake_rate) / numThreads,
+          observer_));
+    }
+    LOG(INFO) << "loadgen opening " << FLAGS_connections << " connections to "
+              << config_.serverAddr.describe() << " from " << numThreads
+              << " threads, workload=" << FLAGS_workload;
+    for (auto& thread : threads_) {
+      thread->start();
+    }
+    if (FLAGS_initial_flood_pps > 0) {
+      flooder_ = std::make_unique<InitialFlooder>(
+          config_.serverAddr, FLAGS_initial_flood_pps);
+      flooder_->start();
+      LOG(INFO) << "loadgen flooding " << config_.serverAddr.describe()
+                << " with " << FLAGS_initial_flood_pps << " Initials/s";
+    }
+
+    auto start = Clock::now();
+    auto lastReport = start;
+    auto lastCpuTime = getProcessCpuTime();
+    auto reportInterval =
+        std::chrono::seconds(std::max<int32_t>(1, FLAGS_report_interval));
+    ClientStats total;
+    uint64_t lastServerRequests = 0;
+    std::vector<uint64_t> lastClientBusy;
+    std::vector<uint64_t> lastServerBusy;
+    while (Clock::now() - start < std::chrono::seconds(FLAGS_duration)) {
+      std::this_thread::sleep_for(reportInterval);
+      auto now = Clock::now();
+      auto intervalUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                            now - lastReport)
+                            .count();
+      auto intervalSeconds = intervalUs / 1e6;
+      lastReport = now;
+
+      ClientStats interval;
+      uint64_t established = 0;
+      for (auto& thread : threads_) {
+        auto threadStats = thread->takeStats();
+        interval.merge(threadStats.first);
+        established += threadStats.second;
+      }
+      total.merge(interval);
+      auto cpuTime = getProcessCpuTime();
+      auto rss = getResidentSetSize();
+      auto clientBusy = observer_->busyTimes();
+
+      std::string report = folly::sformat(
+          "t={}s established={} handshakes/s={:.0f} handshake_failures={} "
+          "conn_errors={} requests/s={:.0f} request_errors={} pings={} "
+          "p50={}us p99={}us rss/conn={}B process_cpu={:.1f}% client_threads={}",
+          std::chrono::duration_cast<std::chrono::seconds>(now - start)
+              .count(),
+          established,
+          interval.handshakes / intervalSeconds,
+          interval.handshakeFailures,
+          interval.connectionErrors,
+          interval.requests / intervalSeconds,
+          interval.requestErrors,
+          interval.pings,
+          interval.requestLatencyUs.getPercentileEstimate(0.5),
+          interval.requestLatencyUs.getPercentileEstimate(0.99),
+          established > 0 && rss > baselineRss
+              ? (rss - baselineRss) / established
+              : 0,
+          percentOf((cpuTime - lastCpuTime).count(), intervalUs),
+          formatBusyPercentages(clientBusy, lastClientBusy, intervalUs));
+      if (server_) {
+        auto serverRequests = server_->getStats().requests.load();
+        auto serverBusy = server_->getWorkerBusyTimes();
+        folly::toAppend(
+            folly::sformat(
+                " server_conns={} server_requests/s={:.0f} server_workers={}",
+                server_->getStats().liveConnections.load(),
+                (serverRequests - lastServerRequests) / intervalSeconds,
+                formatBusyPercentages(serverBusy, lastServerBusy, intervalUs)),
+            &report);
+        lastServerRequests = serverRequests;
+        lastServerBusy = std::move(serverBusy);
+      }
+      if (flooder_) {
+        folly::toAppend(
+            folly::sformat(
+                " flood_initials/s={:.0f}",
+                flooder_->takeSent() / intervalSeconds),
+            &report);
+      }
+      LOG(INFO) << report;
+      lastCpuTime = cpuTime;
+      lastClientBusy = std::move(clientBusy);
+    }
+
+    if (flooder_) {
+      flooder_->stop();
+    }
+    for (auto& thread : threads_) {
+      thread->stop();
+    }
+    LOG(INFO) << "Total: handshakes=" << total.handshakes
+              << " handshake_failures=" << total.handshakeFailures
+              << " handshake p50="
+              << total.handshakeLatencyUs.getPercentileEstimate(0.5)
+              << "us p99="
+              << total.handshakeLatencyUs.getPercentileEstimate(0.99)
+              << "us requests=" << total.requests
+              << " request p50="
+              << total.requestLatencyUs.getPercentileEstimate(0.5)
+              << "us p99="
+              << total.requestLatencyUs.getPercentileEstimate(0.99) << "us";
+  }
+
+ private:
+  LoadGenServer* server_;
+  ClientConfig config_;
+  std::shared_ptr<BusyTimeObserver> observer_;
+  std::vector<std::unique_ptr<ClientThread>> threads_;
+  std::unique_ptr<InitialFlooder> flooder_;
+};
+
+/**
+ * Reports the server side every --report_interval seconds when the server runs
+ * on its own.
+ */
+class ServerReporter : public folly::HHWheelTimer::Callback {
+ public:
+  ServerReporter(folly::EventBase& evb, LoadGenServer& server)
+      : evb_(evb),
+        server_(server),
+        interval_(std::max<int32_t>(1, FLAGS_report_interval)),
+        baselineRss_(getResidentSetSize()),
+        lastReport_(Clock::now()),
+        lastCpuTime_(getProcessCpuTime()) {}
+
+  void start() {
+    evb_.timer().scheduleTimeout(this, interval_);
+  }
+
+  void timeoutExpired() noexcept override {
+    auto now = Clock::now();
+    auto intervalUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                          now - lastReport_)
+                          .count();
+    lastReport_ = now;
+    const auto& stats = server_.getStats();
+    auto accepted = stats.accepted.load();
+    auto requests = stats.requests.load();
+    auto liveConnections = stats.liveConnections.load();
+    auto rss = getResidentSetSize();
+    auto cpuTime = getProcessCpuTime();
+    auto busyTimes = server_.getWorkerBusyTimes();
+    LOG(INFO) << folly::sformat(
+        "conns={} accepted/s={:.0f} requests/s={:.0f} rss/conn={}B "
+        "process_cpu={:.1f}% workers={}",
+        liveConnections,
+        (accepted - lastAccepted_) * 1e6 / intervalUs,
+        (requests - lastRequests_) * 1e6 / intervalUs,
+        liveConnections > 0 && rss > baselineRss_
+            ? (rss - baselineRss_) / liveConnections
+            : 0,
+        percentOf((cpuTime - lastCpuTime_).count(), intervalUs),
+        formatBusyPercentages(busyTimes, lastBusyTimes_, intervalUs));
+    lastAccepted_ = accepted;
+    lastRequests_ = requests;
+    lastCpuTime_ = cpuTime;
+    lastBusyTimes_ = std::move(busyTimes);
+    evb_.timer().scheduleTimeout(this, interval_);
+  }
+
+  void callbackCanceled() noexcept override {}
+
+ private:
+  folly::EventBase& evb_;
+  LoadGenServer& server_;
+  std::chrono::seconds interval_;
+  uint64_t baselineRss_;
+  TimePoint lastReport_;
+  std::chrono::microseconds lastCpuTime_;
+  uint64_t lastAccepted_{0};
+  uint64_t lastRequests_{0};
+  std::vector<uint64_t> lastBusyTimes_;
+};
+
+} // namespace loadgen
+} // namespace quic
+
+using namespace quic::loadgen;
+
+int main(int argc, char* argv[]) {
+#if FOLLY_HAVE_LIBGFLAGS
+  // Enable glog logging to stderr by default.
+  gflags::SetCommandLineOptionWithMode(
+      "logtostderr", "1", gflags::SET_FLAGS_DEFAULT);
+#endif
+  gflags::ParseCommandLineFlags(&argc, &argv, false);
+  folly::Init init(&argc, &argv);
+  fizz::CryptoUtils::init();
+
+  if (FLAGS_workload != "request" && FLAGS_workload != "idle") {
+    LOG(ERROR) << "Unknown workload " << FLAGS_workload;
+    return 1;
+  }
+  if (FLAGS_mode == "server") {
+    folly::EventBase evb;
+    evb.setName("loadgen_server");
+    LoadGenServer server(FLAGS_host, FLAGS_port);
+    server.start();
+    ServerReporter reporter(evb, server);
+    reporter.start();
+    evb.loopForever();
+  } else if (FLAGS_mode == "client") {
+    LoadGenClient(FLAGS_host, FLAGS_port, nullptr).run();
+  } else if (FLAGS_mode == "loopback") {
+    LoadGenServer server(FLAGS_host, FLAGS_port);
+    server.start();
+    LoadGenClient(FLAGS_host, FLAGS_port, &server).run();
+    server.shutdown();
+  } else {
+    LOG(ERROR) << "Unknown mode " << FLAGS_mode;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <glog/logging.h>
+
+#include <folly/FileUtil.h>
+#include <folly/init/Init.h>
+#include <folly/portability/GFlags.h>
+#include <quic/logging/BinaryQLogReader.h>
+
+DEFINE_string(input, "", "Binary qlog file written by a BinaryQLogSink");
+DEFINE_string(
+    output_dir,
+    ".",
+    "Directory to write the qlog JSON to. Each connection is written to"
+    " <DCID>.qlog, like FileQLogger does.");
+DEFINE_bool(pretty_json, true, "Write pretty printed JSON");
+
+int main(int argc, char* argv[]) {
+#if FOLLY_HAVE_LIBGFLAGS
+  // Enable glog logging to stderr by default.
+  gflags::SetCommandLineOptionWithMode(
+      "logtostderr", "1", gflags::SET_FLAGS_DEFAULT);
+#endif
+  gflags::ParseCommandLineFlags(&argc, &argv, false);
+  folly::Init init(&argc, &argv);
+
+  std::string data;
+  if (FLAGS_input.empty() || !folly::readFile(FLAGS_input.c_str(), data)) {
+    LOG(ERROR) << "Can't read binary qlog file '" << FLAGS_input << "'";
+    return 1;
+  }
+  size_t numSkipped = 0;
+  auto traces = quic::readBinaryQLog(folly::StringPiece(data), &numSkipped);
+  if (numSkipped > 0) {
+    LOG(WARNING) << "Skipped " << numSkipped
+                 << " traces whose start was dropped from the file";
+  }
+  size_t numWritten = 0;
+  for (auto& trace : traces) {
+    // Connections that never got a dcid have no file name, and
+    // outputLogsToFile needs at least one event.
+    if (!trace->dcid || trace->logs.empty()) {
+      continue;
+    }
+    trace->outputLogsToFile(FLAGS_output_dir, FLAGS_pretty_json);
+    numWritten++;
+  }
+  LOG(INFO) << "Wrote " << numWritten << " of " << traces.size()
+            << " traces to " << FLAGS_output_dir;
+  return 0;
+}
@@ -10,14 +10,19 @@
 
 #include <fizz/crypto/Utils.h>
 #include <folly/init/Init.h>
+#include <folly/io/Cursor.h>
+#include <folly/io/async/AsyncSignalHandler.h>
 #include <folly/io/async/HHWheelTimer.h>
 #include <folly/portability/GFlags.h>
+#include <folly/portability/SysResource.h>
 #include <folly/stats/Histogram.h>
 
 #include <quic/client/QuicClientTransport.h>
 #include <quic/common/test/TestUtils.h>
 #include <quic/congestion_control/ServerCongestionControllerFactory.h>
 #include <quic/fizz/client/handshake/FizzClientQuicHandshakeContext.h>
+#include <quic/logging/BinaryQLogger.h>
+#include <quic/samples/echo/LogQuicStats.h>
 #include <quic/server/QuicServer.h>
 #include <quic/server/QuicServerTransport.h>
 #include <quic/server/QuicSharedUDPSocketFactory.h>
@@ -34,10 +39,30 @@ DEFINE_int64(
     "Amount of data written to stream each iteration");
 DEFINE_int64(writes_per_loop, 5, "Amount of socket writes per event loop");
 DEFINE_int64(window, 64 * 1024, "Flow control window size");
+DEFINE_bool(
+    autotune_window,
+    false,
+    "Let the client grow its flow control windows, starting at --window, "
+    "instead of keeping them fixed");
 DEFINE_string(congestion, "newreno", "newreno/cubic/bbr/ccp/none");
 DEFINE_string(ccp_config, "", "Additional args to pass to ccp");
 DEFINE_bool(pacing, false, "Enable pacing");
+DEFINE_bool(
+    pacing_txtime,
+    false,
+    "Stamp paced packets with SO_TXTIME departure times and leave the spacing "
+    "to the fq qdisc instead of the pacing timer");
+DEFINE_bool(
+    packet_spacing,
+    false,
+    "Client only: report the spacing of received packets. Packets are read "
+    "one at a time so batched reads don't hide the gaps");
 DEFINE_bool(gso, false, "Enable GSO writes to the socket");
+DEFINE_bool(
+    zerocopy,
+    false,
+    "With --gso, send large GSO batches with MSG_ZEROCOPY instead of copying "
+    "them into the kernel");
 DEFINE_int32(
     client_transport_timer_resolution_ms,
     1,
@@ -47,6 +72,12 @@ DEFINE_string(
     "",
     "Path to the directory where qlog files will be written. File will be named"
     " as <CID>.qlog where CID is the DCID from client's perspective.");
+DEFINE_bool(
+    server_qlogger_binary,
+    false,
+    "Log all connections in the binary qlog format to tperf.binqlog in "
+    "--server_qlogger_path instead, which qlogconvert turns into qlog JSON. "
+    "Pacing observers are not supported with it.");
 DEFINE_int32(
     max_cwnd_mss,
     quic::kLargeMaxCwndInMss,
@@ -73,10 +104,86 @@ DEFINE_int32(
     num_server_worker,
     1,
     "Max number of mvfst server worker threads");
+DEFINE_int32(
+    datagram_size,
+    0,
+    "Send DATAGRAM frames of this size instead of stream data. "
+    "0 (the default) means stream mode. Latency is only meaningful when the "
+    "client and server run on the same host.");
+DEFINE_int32(
+    ack_frequency,
+    0,
+    "Number of ACKs per RTT the BBR sender asks the receiver for with "
+    "ACK_FREQUENCY. 0 (the default) keeps the receiver's ack policy.");
+DEFINE_bool(
+    ecn,
+    false,
+    "Mark packets with ECT(0) and report the ECN marks of received packets");
 
 namespace quic {
 namespace tperf {
 
+namespace {
+
+constexpr double kBytesPerGigabyte = 1024 * 1024 * 1024;
+
+std::chrono::microseconds getProcessCpuTime() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return std::chrono::seconds(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+      std::chrono::microseconds(
+             usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+}
+
+std::string pacingMode(const quic::TransportSettings& settings) {
+  if (!settings.pacingEnabled) {
+    return "off";
+  }
+  return settings.pacingWithTxTime ? "txtime" : "timer";
+}
+
+/**
+ * Records the gaps between the packets the client receives, which is the
+ * spacing the sender's pacing achieved on the path.
+ */
+class PacketSpacingStats : public quic::samples::LogQuicStats {
+ public:
+  PacketSpacingStats() : LogQuicStats("tperf") {}
+
+  void onPacketReceived() override {
+    auto now = quic::Clock::now();
+    if (lastPacketTime_) {
+      auto gap = std::chrono::duration_cast<std::chrono::microseconds>(
+                     now - *lastPacketTime_)
+                     .count();
+      gapHistogram_.addValue(gap);
+      gapSum_ += gap;
+      ++numGaps_;
+    }
+    lastPacketTime_ = now;
+  }
+
+  void report() const {
+    if (numGaps_ == 0) {
+      return;
+    }
+    LOG(INFO) << "Inter-packet spacing in us: mean="
+              << static_cast<double>(gapSum_) / numGaps_
+              << " p10=" << gapHistogram_.getPercentileEstimate(0.1)
+              << " p50=" << gapHistogram_.getPercentileEstimate(0.5)
+              << " p90=" << gapHistogram_.getPercentileEstimate(0.9)
+              << " p99=" << gapHistogram_.getPercentileEstimate(0.99);
+  }
+
+ private:
+  folly::Optional<quic::TimePoint> lastPacketTime_;
+  folly::Histogram<uint64_t> gapHistogram_{5, 0, 10000};
+  uint64_t gapSum_{0};
+  uint64_t numGaps_{0};
+};
+
+} // namespace
+
 class ServerStreamHandler : public quic::QuicSocket::ConnectionCallback,
                             public quic::QuicSocket::ReadCallback,
                             public quic::QuicSocket::WriteCallback {
@@ -113,9 +220,40 @@ class ServerStreamHandler : public quic::QuicSocket::ConnectionCallback,
 
   void onConnectionEnd() noexcept override {
     LOG(INFO) << "Socket closed";
+    if (bytesSent_ > 0) {
+      auto cpuTime = getProcessCpuTime() - startCpuTime_;
+      LOG(INFO) << "Sent " << bytesSent_ << " bytes, pacing "
+                << pacingMode(sock_->getTransportSettings())
+                << ", process CPU time per GB: "
+                << cpuTime.count() / (bytesSent_ / kBytesPerGigabyte) << "us";
+    }
+    logZeroCopyStats();
     sock_.reset();
   }
 
+  // The tracker belongs to the worker's socket, so these count the writes of
+  // every connection on the worker.
+  void logZeroCopyStats() {
+    auto serverSock =
+        std::dynamic_pointer_cast<quic::QuicServerTransport>(sock_);
+    if (!serverSock || !serverSock->getState()->zeroCopySendTracker) {
+      return;
+    }
+    const auto& stats =
+        serverSock->getState()->zeroCopySendTracker->getStats();
+    auto totalBytes = stats.zeroCopyBytes + stats.copiedBytes;
+    if (totalBytes == 0) {
+      return;
+    }
+    LOG(INFO) << "Zerocopy writes=" << stats.zeroCopyWrites
+              << " bytes=" << stats.zeroCopyBytes
+              << " (copied by kernel=" << stats.kernelCopiedWrites
+              << "), copied writes=" << stats.copiedWrites
+              << " bytes=" << stats.copiedBytes << ", copies per GB: "
+              << (stats.copiedWrites + stats.kernelCopiedWrites) /
+            (totalBytes / kBytesPerGigabyte);
+  }
+
   void onConnectionError(
       std::pair<quic::QuicErrorCode, std::string> error) noexcept override {
     LOG(ERROR) << "Conn errorCoded=" << toString(error.first)
@@ -124,6 +262,11 @@ class ServerStreamHandler : public quic::QuicSocket::ConnectionCallback,
 
   void onTransportReady() noexcept override {
     LOG(INFO) << "Starting sends to client.";
+    startCpuTime_ = getProcessCpuTime();
+    if (FLAGS_datagram_size > 0) {
+      sendDatagrams();
+      return;
+    }
     for (uint32_t i = 0; i < numStreams_; i++) {
       createNewStream();
     }
@@ -154,6 +297,45 @@ class ServerStreamHandler : public quic::QuicSocket::ConnectionCallback,
     });
   }
 
+  /**
+   * Fills the datagram write buffer, then tries again on the next loop once
+   * the transport had a chance to drain it. Each datagram starts with the
+   * steady clock time it was created at so the client can compute latency.
+   */
+  void sendDatagrams() noexcept {
+    if (!sock_) {
+      VLOG(4) << __func__ << ": socket is closed.";
+      return;
+    }
+    auto datagramSize = std::min<uint64_t>(
+        FLAGS_datagram_size, sock_->getDatagramSizeLimit());
+    if (datagramSize < sizeof(uint64_t)) {
+      LOG(ERROR) << "Peer does not support datagrams of size "
+                 << FLAGS_datagram_size;
+      return;
+    }
+    while (true) {
+      auto buf = folly::IOBuf::create(datagramSize);
+      std::memset(buf->writableData(), 0, datagramSize);
+      buf->append(datagramSize);
+      folly::io::RWPrivateCursor cursor(buf.get());
+      cursor.writeBE<uint64_t>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              std::chrono::steady_clock::now().time_since_epoch())
+              .count());
+      auto res = sock_->writeDatagram(std::move(buf));
+      if (res.hasError()) {
+        if (res.error() != LocalErrorCode::DATAGRAM_BUFFER_FULL) {
+          LOG(ERROR) << "Got error on datagram write: "
+                     << quic::toString(res.error());
+          return;
+        }
+        break;
+      }
+    }
+    evb_->runInEventBaseThread([&]() { sendDatagrams(); });
+  }
+
   void readAvailable(quic::StreamId id) noexcept override {
     LOG(INFO) << "read available for stream id=" << id;
   }
@@ -187,6 +369,7 @@ class ServerStreamHandler : public quic::QuicSocket::ConnectionCallback,
       curBuf->append(curBuf->capacity());
       curBuf = curBuf->next();
     } while (curBuf != buf.get());
+    bytesSent_ += toSend;
     auto res = sock_->writeChain(id, std::move(buf), eof, true, nullptr);
     if (res.hasError()) {
       LOG(FATAL) << "Got error on write: " << quic::toString(res.error());
@@ -218,6 +401,8 @@ class ServerStreamHandler : public quic::QuicSocket::ConnectionCallback,
   uint32_t numStreams_;
   uint64_t maxBytesPerStream_;
   std::unordered_map<quic::StreamId, uint64_t> bytesPerStream_;
+  uint64_t bytesSent_{0};
+  std::chrono::microseconds startCpuTime_{0};
 };
 
 class TPerfServerTransportFactory : public quic::QuicServerTransportFactory {
@@ -227,8 +412,10 @@ class TPerfServerTransportFactory : public quic::QuicServerTransportFactory {
   explicit TPerfServerTransportFactory(
       uint64_t blockSize,
       uint32_t numStreams,
-      uint64_t maxBytesPerStream)
-      : blockSize_(blockSize),
+      uint64_t maxBytesPerStream,
+      std::shared_ptr<BinaryQLogSink> binaryQLogSink)
+      : binaryQLogSink_(std::move(binaryQLogSink)),
+        blockSize_(blockSize),
         numStreams_(numStreams),
         maxBytesPerStream_(maxBytesPerStream) {}
 
@@ -243,7 +430,10 @@ class TPerfServerTransportFactory : public quic::QuicServerTransportFactory {
         evb, blockSize_, numStreams_, maxBytesPerStream_);
     auto transport = quic::QuicServerTransport::make(
         evb, std::move(sock), *serverHandler, ctx);
-    if (!FLAGS_server_qlogger_path.empty()) {
+    if (binaryQLogSink_) {
+      transport->setQLogger(std::make_shared<BinaryQLogger>(
+          VantagePoint::Server, binaryQLogSink_));
+    } else if (!FLAGS_server_qlogger_path.empty()) {
       auto qlogger = std::make_shared<TperfQLogger>(
           VantagePoint::Server, FLAGS_server_qlogger_path);
       setPacingObserver(qlogger, transport.get(), FLAGS_pacing_observer);
@@ -271,6 +461,7 @@ class TPerfServerTransportFactory : public quic::QuicServerTransportFactory {
   }
 
   std::vector<std::unique_ptr<ServerStreamHandler>> handlers_;
+  std::shared_ptr<BinaryQLogSink> binaryQLogSink_;
   uint64_t blockSize_;
   uint32_t numStreams_;
   uint64_t maxBytesPerStream_;
@@ -291,11 +482,18 @@ class TPerfServer {
       uint64_t maxBytesPerStream,
       uint32_t maxReceivePacketSize,
       bool useInplaceWrite)
-      : host_(host), port_(port), server_(QuicServer::createQuicServer()) {
+      : host_(host),
+        port_(port),
+        server_(QuicServer::createQuicServer()),
+        shutdownHandler_(*this) {
     eventBase_.setName("tperf_server");
+    if (!FLAGS_server_qlogger_path.empty() && FLAGS_server_qlogger_binary) {
+      binaryQLogSink_ = std::make_shared<BinaryQLogSink>(
+          folly::to<std::string>(FLAGS_server_qlogger_path, "/tperf.binqlog"));
+    }
     server_->setQuicServerTransportFactory(
         std::make_unique<TPerfServerTransportFactory>(
-            blockSize, numStreams, maxBytesPerStream));
+            blockSize, numStreams, maxBytesPerStream, binaryQLogSink_));
     auto serverCtx = quic::test::createServerCtx();
     serverCtx->setClock(std::make_shared<fizz::SystemClock>());
     server_->setFizzContext(serverCtx);
@@ -311,14 +509,25 @@ class TPerfServer {
     settings.pacingEnabled = pacing;
     if (pacing) {
       settings.pacingTimerTickInterval = 200us;
+      settings.pacingWithTxTime = FLAGS_pacing_txtime;
     }
     if (gso) {
       settings.batchingMode = QuicBatchingMode::BATCHING_MODE_GSO;
       settings.maxBatchSize = 16;
+      settings.zeroCopyGSOWrites = FLAGS_zerocopy;
     }
     settings.maxRecvPacketSize = maxReceivePacketSize;
     settings.canIgnorePathMTU = true;
     settings.copaDeltaParam = FLAGS_latency_factor;
+    settings.datagramConfig.enabled = FLAGS_datagram_size > 0;
+    if (FLAGS_ack_frequency > 0) {
+      settings.bbrConfig.ackFrequencyAcksPerRtt = FLAGS_ack_frequency;
+      settings.minAckDelay = 1ms;
+    }
+    if (FLAGS_ecn) {
+      settings.ecnMarking = ECNCodepoint::ECT0;
+      settings.readEcnOnIngress = true;
+    }
     server_->setCongestionControllerFactory(
         std::make_shared<ServerCongestionControllerFactory>());
     server_->setTransportSettings(settings);
@@ -331,19 +540,48 @@ class TPerfServer {
     addr1.setFromHostPort(host_, port_);
     server_->start(addr1, FLAGS_num_server_worker);
     LOG(INFO) << "tperf server started at: " << addr1.describe();
+    shutdownHandler_.registerSignalHandler(SIGINT);
+    shutdownHandler_.registerSignalHandler(SIGTERM);
     eventBase_.loopForever();
   }
 
  private:
+  class ShutdownHandler : public folly::AsyncSignalHandler {
+   public:
+    explicit ShutdownHandler(TPerfServer& server)
+        : folly::AsyncSignalHandler(&server.eventBase_), server_(server) {}
+
+    void signalReceived(int signum) noexcept override {
+      LOG(INFO) << "tperf server shutting down on signal " << signum;
+      server_.shutdown();
+    }
+
+   private:
+    TPerfServer& server_;
+  };
+
+  void shutdown() {
+    // Closing the connections logs their transport summaries, after which
+    // nothing logs to the sink and what it holds can be written out.
+    server_->shutdown();
+    if (binaryQLogSink_) {
+      binaryQLogSink_->flushAll();
+    }
+    eventBase_.terminateLoopSoon();
+  }
+
   std::string host_;
   uint16_t port_;
   folly::EventBase eventBase_;
   std::shared_ptr<quic::QuicServer> server_;
+  std::shared_ptr<BinaryQLogSink> binaryQLogSink_;
+  ShutdownHandler shutdownHandler_;
 };
 
 class TPerfClient : public quic::QuicSocket::ConnectionCallback,
                     public quic::QuicSocket::ReadCallback,
                     public quic::QuicSocket::WriteCallback,
+                    public quic::QuicSocket::DatagramCallback,
                     public folly::HHWheelTimer::Callback {
  public:
   TPerfClient(
@@ -374,6 +612,28 @@ class TPerfClient : public quic::QuicSocket::ConnectionCallback,
     LOG(INFO) << "Overall throughput: "
               << (receivedBytes_ / bytesPerMegabit) / duration_.count()
               << "Mb/s";
+    if (receivedBytes_ > 0) {
+      auto cpuTime = getProcessCpuTime() - startCpuTime_;
+      LOG(INFO) << "Process CPU time per GB: "
+                << cpuTime.count() / (receivedBytes_ / kBytesPerGigabyte)
+                << "us";
+    }
+    if (packetSpacingStats_) {
+      packetSpacingStats_->report();
+    }
+    if (FLAGS_datagram_size > 0) {
+      LOG(INFO) << "Received " << receivedDatagrams_ << " datagrams";
+      LOG(INFO) << "Histogram of datagram latency in us: " << std::endl;
+      LOG(INFO) << "Lo\tHi\tNum\tSum";
+      std::ostringstream os;
+      datagramLatencyHistogram_.toTSV(os);
+      std::vector<std::string> lines;
+      folly::split("\n", os.str(), lines);
+      for (const auto& line : lines) {
+        LOG(INFO) << line;
+      }
+      return;
+    }
     // Per Stream Stats
     LOG(INFO) << "Average per Stream throughput: "
               << ((receivedBytes_ / receivedStreams_) / bytesPerMegabit) /
@@ -422,6 +682,32 @@ class TPerfClient : public quic::QuicSocket::ConnectionCallback,
     // resetStream
   }
 
+  void onDatagramsAvailable() noexcept override {
+    auto datagrams = quicClient_->readDatagrams();
+    if (datagrams.hasError()) {
+      LOG(FATAL) << "TPerfClient failed to read datagrams, error="
+                 << (uint32_t)datagrams.error();
+    }
+    if (!timerScheduled_) {
+      timerScheduled_ = true;
+      startCpuTime_ = getProcessCpuTime();
+      eventBase_.timer().scheduleTimeout(this, duration_);
+    }
+    auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+                   .count();
+    for (const auto& datagram : *datagrams) {
+      auto len = datagram.data->computeChainDataLength();
+      receivedBytes_ += len;
+      receivedDatagrams_++;
+      folly::io::Cursor cursor(datagram.data.get());
+      uint64_t sentTime;
+      if (cursor.tryReadBE(sentTime) && sentTime <= (uint64_t)now) {
+        datagramLatencyHistogram_.addValue((now - sentTime) / 1000);
+      }
+    }
+  }
+
   void onNewBidirectionalStream(quic::StreamId id) noexcept override {
     LOG(INFO) << "TPerfClient: new bidirectional stream=" << id;
     quicClient_->setReadCallback(id, this);
@@ -431,6 +717,7 @@ class TPerfClient : public quic::QuicSocket::ConnectionCallback,
     VLOG(5) << "TPerfClient: new unidirectional stream=" << id;
     if (!timerScheduled_) {
       timerScheduled_ = true;
+      startCpuTime_ = getProcessCpuTime();
       eventBase_.timer().scheduleTimeout(this, duration_);
     }
     quicClient_->setReadCallback(id, this);
@@ -439,6 +726,9 @@ class TPerfClient : public quic::QuicSocket::ConnectionCallback,
 
   void onTransportReady() noexcept override {
     LOG(INFO) << "TPerfClient: onTransportReady";
+    if (FLAGS_datagram_size > 0) {
+      quicClient_->setDatagramCallback(this);
+    }
   }
 
   void onStopSending(
@@ -493,19 +783,35 @@ class TPerfClient : public quic::QuicSocket::ConnectionCallback,
     // limit.
     settings.advertisedInitialConnectionWindowSize =
         std::numeric_limits<uint32_t>::max();
+    settings.autotuneFlowControlWindows = FLAGS_autotune_window;
     settings.connectUDP = true;
     settings.shouldRecvBatch = true;
     settings.defaultCongestionController = congestionControlType_;
     if (congestionControlType_ == quic::CongestionControlType::BBR) {
       settings.pacingEnabled = true;
       settings.pacingTimerTickInterval = 200us;
+      settings.pacingWithTxTime = FLAGS_pacing_txtime;
+    }
+    if (FLAGS_packet_spacing) {
+      settings.shouldRecvBatch = false;
+      packetSpacingStats_ = std::make_shared<PacketSpacingStats>();
+      quicClient_->setTransportStatsCallback(packetSpacingStats_);
     }
     if (gso_) {
       settings.batchingMode = QuicBatchingMode::BATCHING_MODE_GSO;
       settings.maxBatchSize = 16;
+      settings.zeroCopyGSOWrites = FLAGS_zerocopy;
     }
     settings.maxRecvPacketSize = maxReceivePacketSize_;
     settings.canIgnorePathMTU = true;
+    settings.datagramConfig.enabled = FLAGS_datagram_size > 0;
+    if (FLAGS_ack_frequency > 0) {
+      settings.minAckDelay = 1ms;
+    }
+    if (FLAGS_ecn) {
+      settings.ecnMarking = ECNCodepoint::ECT0;
+      settings.readEcnOnIngress = true;
+    }
     quicClient_->setTransportSettings(settings);
 
     LOG(INFO) << "TPerfClient connecting to " << addr.describe();
@@ -517,17 +823,21 @@ class TPerfClient : public quic::QuicSocket::ConnectionCallback,
 
  private:
   bool timerScheduled_{false};
+  std::chrono::microseconds startCpuTime_{0};
   std::string host_;
   uint16_t port_;
   std::shared_ptr<quic::QuicClientTransport> quicClient_;
   folly::EventBase eventBase_;
   uint64_t receivedBytes_{0};
   uint64_t receivedStreams_{0};
+  uint64_t receivedDatagrams_{0};
   std::map<quic::StreamId, uint64_t> bytesPerStream_;
   folly::Histogram<uint64_t> bytesPerStreamHistogram_{
       1024,
       0,
       1024 * 1024 * 1024};
+  folly::Histogram<uint64_t> datagramLatencyHistogram_{100, 0, 100000};
+  std::shared_ptr<PacketSpacingStats> packetSpacingStats_;
   std::chrono::seconds duration_;
   uint64_t window_;
   bool gso_;